@@ -0,0 +1,5 @@
+#include "crust-bench.h"
+
+int main(int argc, char ** argv) {
+  return bench_main(argc, argv);
+}
@@ -0,0 +1,281 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+/* For clock_gettime(). */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "crust-bench.h"
+
+/* Upper limit for calibrated number of iterations, for empty benchmarks. */
+#define BENCH_MAX_ITERATIONS ((size_t)1000000000)
+
+/* Registered benchmarks, in order of registration. */
+static _Bench_entry * bench_head = NULL;
+static _Bench_entry * bench_tail = NULL;
+
+void _bench_register(_Bench_entry * entry) {
+  entry->next = NULL;
+  if(bench_tail) {
+    bench_tail->next = entry;
+  } else {
+    bench_head = entry;
+  }
+  bench_tail = entry;
+}
+
+uint64_t bench_now_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static int bench_double_cmp(const void * left, const void * right) {
+  double l = *(const double *)left, r = *(const double *)right;
+  return (l > r) - (l < r);
+}
+
+void bench_stats_compute(double * samples, size_t count, size_t iterations, BenchStats * out) {
+  qsort(samples, count, sizeof(double), bench_double_cmp);
+
+  double sum = 0;
+  for(size_t i = 0; i < count; i++) {
+    sum += samples[i];
+  }
+
+  // Nearest rank: smallest sample, which is not less than 99% of samples
+  size_t p99_rank = (99 * count + 99) / 100;
+
+  *out = (BenchStats) {
+    .iterations = iterations,
+    .samples = count,
+    .median_ns = count % 2 == 1 ? samples[count / 2] : (samples[count / 2 - 1] + samples[count / 2]) / 2,
+    .p99_ns = samples[p99_rank - 1],
+    .min_ns = samples[0],
+    .mean_ns = sum / count,
+  };
+}
+
+BenchOptions bench_options_default(void) {
+  return (BenchOptions) {
+    .format = BENCH_FORMAT_TEXT,
+    .filters = NULL,
+    .filter_count = 0,
+    .samples = 31,
+    .sample_ns = 5000000,
+    .warmup_ns = 50000000,
+  };
+}
+
+static bool bench_matches(const BenchOptions * options, const char * name) {
+  if(options->filter_count == 0) {
+    return true;
+  }
+  for(size_t i = 0; i < options->filter_count; i++) {
+    if(strstr(name, options->filters[i]) != NULL) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint64_t bench_run_once(const _Bench_entry * entry, Bench * b) {
+  b->start_ns = bench_now_ns();
+  entry->fn(b);
+  return bench_now_ns() - b->start_ns;
+}
+
+/* Find number of iterations, which run for at least sample_ns. */
+static size_t bench_calibrate(const _Bench_entry * entry, uint64_t sample_ns) {
+  Bench b = { .iterations = 1 };
+
+  for(;;) {
+    uint64_t elapsed = bench_run_once(entry, &b);
+    if(elapsed >= sample_ns || b.iterations >= BENCH_MAX_ITERATIONS) {
+      return b.iterations;
+    }
+
+    // Predict number of iterations from measured time, but grow at most 10 times per step,
+    // because first runs are slowed down by cold caches
+    size_t next = b.iterations * 10;
+    if(elapsed > 0) {
+      double predicted = (double)b.iterations * sample_ns / elapsed * 1.2;
+      if(predicted < next) {
+        next = (size_t)predicted;
+      }
+    }
+    if(next <= b.iterations) {
+      next = b.iterations + 1;
+    }
+    b.iterations = next < BENCH_MAX_ITERATIONS ? next : BENCH_MAX_ITERATIONS;
+  }
+}
+
+static void bench_measure(const _Bench_entry * entry, const BenchOptions * options, BenchStats * stats) {
+  size_t iterations = bench_calibrate(entry, options->sample_ns);
+  Bench b = { .iterations = iterations };
+
+  uint64_t warmup_start = bench_now_ns();
+  while(bench_now_ns() - warmup_start < options->warmup_ns) {
+    (void)bench_run_once(entry, &b);
+  }
+
+  size_t count = options->samples > 0 ? options->samples : 1;
+  double * samples = mem_malloc(count, sizeof(double));
+  for(size_t i = 0; i < count; i++) {
+    samples[i] = (double)bench_run_once(entry, &b) / iterations;
+  }
+
+  bench_stats_compute(samples, count, iterations, stats);
+  mem_free(samples);
+}
+
+static void bench_print_csv_string(FILE * out, const char * value) {
+  fputc('"', out);
+  for(const char * p = value; *p; p++) {
+    if(*p == '"') {
+      fputc('"', out);
+    }
+    fputc(*p, out);
+  }
+  fputc('"', out);
+}
+
+static void bench_print_json_string(FILE * out, const char * value) {
+  fputc('"', out);
+  for(const unsigned char * p = (const unsigned char *)value; *p; p++) {
+    if(*p == '"' || *p == '\\') {
+      fprintf(out, "\\%c", *p);
+    } else if(*p < 0x20) {
+      fprintf(out, "\\u%04x", *p);
+    } else {
+      fputc(*p, out);
+    }
+  }
+  fputc('"', out);
+}
+
+static void bench_print(FILE * out, BenchFormat format, const _Bench_entry * entry, const BenchStats * stats, bool first) {
+  switch(format) {
+    case BENCH_FORMAT_CSV:
+      fprintf(out, "%s,", entry->name);
+      bench_print_csv_string(out, entry->description);
+      fprintf(out, ",%zu,%zu,%.3f,%.3f,%.3f,%.3f\n", stats->iterations, stats->samples,
+        stats->median_ns, stats->p99_ns, stats->min_ns, stats->mean_ns);
+    break;
+
+    case BENCH_FORMAT_JSON:
+      fprintf(out, "%s  {\"name\": ", first ? "" : ",\n");
+      bench_print_json_string(out, entry->name);
+      fprintf(out, ", \"description\": ");
+      bench_print_json_string(out, entry->description);
+      fprintf(out, ", \"iterations\": %zu, \"samples\": %zu, \"median_ns\": %.3f, \"p99_ns\": %.3f, \"min_ns\": %.3f, \"mean_ns\": %.3f}",
+        stats->iterations, stats->samples, stats->median_ns, stats->p99_ns, stats->min_ns, stats->mean_ns);
+    break;
+
+    default:
+      fprintf(out, "%-40s %12zu %12.2f %12.2f %12.2f %12.2f  %s\n", entry->name, stats->iterations,
+        stats->median_ns, stats->p99_ns, stats->min_ns, stats->mean_ns, entry->description);
+  }
+  fflush(out);
+}
+
+size_t bench_run(const BenchOptions * options, FILE * out) {
+  switch(options->format) {
+    case BENCH_FORMAT_CSV:
+      fprintf(out, "name,description,iterations,samples,median_ns,p99_ns,min_ns,mean_ns\n");
+    break;
+
+    case BENCH_FORMAT_JSON:
+      fprintf(out, "[\n");
+    break;
+
+    default:
+      fprintf(out, "%-40s %12s %12s %12s %12s %12s  %s\n", "name", "iterations", "median ns", "p99 ns", "min ns", "mean ns", "description");
+  }
+
+  size_t count = 0;
+  for(const _Bench_entry * entry = bench_head; entry != NULL; entry = entry->next) {
+    if(!bench_matches(options, entry->name)) {
+      continue;
+    }
+
+    BenchStats stats;
+    bench_measure(entry, options, &stats);
+    bench_print(out, options->format, entry, &stats, count == 0);
+    count++;
+  }
+
+  if(options->format == BENCH_FORMAT_JSON) {
+    fprintf(out, "%s]\n", count > 0 ? "\n" : "");
+  }
+
+  return count;
+}
+
+/* Parse decimal number, which is not less than minimum. */
+static bool bench_parse_size(const char * text, size_t minimum, size_t * out) {
+  char * end;
+  unsigned long long value = strtoull(text, &end, 10);
+  if(*text < '0' || *text > '9' || *end != '\0' || value < minimum) {
+    return false;
+  }
+  *out = (size_t)value;
+  return true;
+}
+
+static int bench_usage(const char * program) {
+  fprintf(stderr, "Usage: %s [--csv | --json] [--samples N] [--sample-ms N] [--warmup-ms N] [FILTER...]\n", program);
+  return 2;
+}
+
+int bench_main(int argc, char ** argv) {
+  BenchOptions options = bench_options_default();
+  const char ** filters = mem_calloc((size_t)argc, sizeof(const char *));
+  size_t value;
+  int i;
+
+  for(i = 1; i < argc; i++) {
+    const char * arg = argv[i];
+
+    if(strcmp(arg, "--csv") == 0) {
+      options.format = BENCH_FORMAT_CSV;
+    } else if(strcmp(arg, "--json") == 0) {
+      options.format = BENCH_FORMAT_JSON;
+    } else if(i + 1 < argc && strcmp(arg, "--samples") == 0 && bench_parse_size(argv[i + 1], 1, &value)) {
+      options.samples = value;
+      i++;
+    } else if(i + 1 < argc && strcmp(arg, "--sample-ms") == 0 && bench_parse_size(argv[i + 1], 1, &value)) {
+      options.sample_ns = (uint64_t)value * 1000000u;
+      i++;
+    } else if(i + 1 < argc && strcmp(arg, "--warmup-ms") == 0 && bench_parse_size(argv[i + 1], 0, &value)) {
+      options.warmup_ns = (uint64_t)value * 1000000u;
+      i++;
+    } else if(arg[0] == '-') {
+      fprintf(stderr, "ERROR: Bench: Unknown option or bad value: \"%s\".\n", arg);
+      mem_free(filters);
+      return bench_usage(argv[0]);
+    } else {
+      filters[options.filter_count++] = arg;
+    }
+  }
+  options.filters = filters;
+
+  size_t count = bench_run(&options, stdout);
+  mem_free(filters);
+
+  if(count == 0) {
+    fprintf(stderr, "ERROR: Bench: No benchmarks match filters.\n");
+    return 1;
+  }
+
+  return 0;
+}
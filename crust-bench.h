@@ -0,0 +1,208 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#ifndef CRUST_BENCH_H_
+#define CRUST_BENCH_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "crust-mem.h"
+
+#ifdef _CRUST_TESTS
+#include <string.h>
+#include "crust-unittest.h"
+#endif
+
+//
+// Micro-benchmarks.
+//
+// Benchmark is declared like test, and its body repeats measured operation
+// b->iterations times:
+//
+//   bench(vec_int_push, "push 1000 ints into new vector") {
+//     for(size_t i = 0; i < b->iterations; i++) {
+//       defer(vec_int_destroy) Vec_int vec = vec_int_new();
+//       for(int j = 0; j < 1000; j++) {
+//         vec_int_push(&vec, j);
+//       }
+//       bench_do_not_optimize(vec_int_as_ptr(&vec));
+//     }
+//   }
+//
+// Number of iterations is calibrated, so one sample runs for about
+// sample_ns. After warmup, samples are collected and median, p99, min and
+// mean time per iteration are printed as text table, CSV or JSON.
+//
+// Benchmarks live in *-bench.c files, which are built by `make bench`
+// with -O2, and are not linked into tests.
+//
+
+/** State of running benchmark. */
+typedef struct {
+  /** Number of times to repeat measured operation. */
+  size_t iterations;
+  /** Start of measurement, in nanoseconds. */
+  uint64_t start_ns;
+} Bench;
+
+/** Registered benchmark. */
+typedef struct _Bench_entry {
+  const char * name;
+  const char * description;
+  void (*fn)(Bench * b);
+  struct _Bench_entry * next;
+} _Bench_entry;
+
+/** Add benchmark to list of benchmarks. Called by bench() at start of the program. */
+NN void _bench_register(_Bench_entry * entry);
+
+/**
+ * Generator for benchmark function, which is registered at start of the program,
+ * before tests are run.
+ */
+#define bench(name, description) \
+static void bench_##name(Bench * b); \
+static _Bench_entry _bench_entry_##name = { #name, description, bench_##name, NULL }; \
+__attribute__((constructor(150))) static void _bench_register_##name(void) { _bench_register(&_bench_entry_##name); } \
+static void bench_##name(Bench * b)
+
+/** Return monotonic time in nanoseconds. */
+WUR uint64_t bench_now_ns(void);
+
+/** Restart measurement, so setup code before this call is not measured. */
+NN MU SI void bench_reset_timer(Bench * b) {
+  b->start_ns = bench_now_ns();
+}
+
+/** Make compiler believe that value behind pointer is used, so computation
+ * of value is not removed as dead code. */
+MU SI void bench_do_not_optimize(const void * ptr) {
+  __asm__ volatile("" : : "r"(ptr) : "memory");
+}
+
+/** Make compiler believe that all memory is read and written, so stores
+ * before this point are not removed or moved. */
+MU SI void bench_clobber(void) {
+  __asm__ volatile("" : : : "memory");
+}
+
+/** Statistics of benchmark, in nanoseconds per iteration. */
+typedef struct {
+  size_t iterations;
+  size_t samples;
+  double median_ns;
+  double p99_ns;
+  double min_ns;
+  double mean_ns;
+} BenchStats;
+
+/** Sort samples (nanoseconds per iteration) and compute statistics.
+ * Percentiles use nearest rank. */
+NN void bench_stats_compute(double * samples, size_t count, size_t iterations, BenchStats * out);
+#ifdef _CRUST_TESTS
+it(bench_stats_compute, "must compute median, p99, min and mean") {
+  double samples[100];
+  for(int i = 0; i < 100; i++) {
+    samples[i] = 100 - i;
+  }
+
+  BenchStats stats;
+  bench_stats_compute(samples, 100, 7, &stats);
+  assert_true(stats.median_ns == 50.5, "Median of even number of samples must be mean of two middle samples");
+  assert_true(stats.p99_ns == 99, "Unexpected p99");
+  assert_true(stats.min_ns == 1, "Unexpected min");
+  assert_true(stats.mean_ns == 50.5, "Unexpected mean");
+  assert_equal_int(7, stats.iterations, "Unexpected number of iterations");
+
+  double one[] = { 3 };
+  bench_stats_compute(one, 1, 1, &stats);
+  assert_true(stats.median_ns == 3 && stats.p99_ns == 3, "Statistics of single sample must be equal to sample");
+}
+#endif
+
+/** Output format of benchmark results. */
+typedef enum {
+  BENCH_FORMAT_TEXT = 0,
+  BENCH_FORMAT_CSV,
+  BENCH_FORMAT_JSON,
+} BenchFormat;
+
+typedef struct {
+  BenchFormat format;
+  /** Run only benchmarks, which names contain any of filters. Run all benchmarks, when there are no filters. */
+  const char * const * filters;
+  size_t filter_count;
+  /** Number of samples to collect. */
+  size_t samples;
+  /** Calibrated duration of one sample. */
+  uint64_t sample_ns;
+  /** Duration of warmup before samples are collected. */
+  uint64_t warmup_ns;
+} BenchOptions;
+
+/** Return default options: text output, 31 samples of 5 ms, 50 ms of warmup. */
+WUR BenchOptions bench_options_default(void);
+
+/** Run registered benchmarks, which match filters, and print results into out.
+ * Return number of benchmarks, which are run. */
+NN size_t bench_run(const BenchOptions * options, FILE * out);
+#ifdef _CRUST_TESTS
+bench(bench_self_test, "empty loop, used by tests of bench_run()") {
+  for(size_t i = 0; i < b->iterations; i++) {
+    bench_clobber();
+  }
+}
+
+it(bench_run, "must calibrate, filter benchmarks, and print CSV and JSON") {
+  const char * filters[] = { "bench_self" };
+  BenchOptions options = bench_options_default();
+  options.filters = filters;
+  options.filter_count = 1;
+  options.samples = 3;
+  options.sample_ns = 100000;
+  options.warmup_ns = 0;
+
+  char text[1024];
+  FILE * out;
+
+  options.format = BENCH_FORMAT_CSV;
+  out = tmpfile();
+  assert_equal_int(1, bench_run(&options, out), "Only benchmark, which matches filter, must run");
+  rewind(out);
+  size_t length = fread(text, 1, sizeof(text) - 1, out);
+  text[length] = '\0';
+  fclose(out);
+  assert_true(strncmp(text, "name,description,iterations,samples,median_ns,p99_ns,min_ns,mean_ns\n", 68) == 0, "Unexpected CSV header");
+  assert_true(strstr(text, "\nbench_self_test,\"empty loop, used by tests of bench_run()\",") != NULL, "CSV must contain quoted description");
+
+  options.format = BENCH_FORMAT_JSON;
+  out = tmpfile();
+  assert_equal_int(1, bench_run(&options, out), "Only benchmark, which matches filter, must run");
+  rewind(out);
+  length = fread(text, 1, sizeof(text) - 1, out);
+  text[length] = '\0';
+  fclose(out);
+  assert_true(text[0] == '[' && strstr(text, "\"name\": \"bench_self_test\"") != NULL, "Unexpected JSON");
+
+  filters[0] = "no such benchmark";
+  out = tmpfile();
+  assert_equal_int(0, bench_run(&options, out), "No benchmark must run, when filter doesn't match");
+  fclose(out);
+}
+#endif
+
+/** Parse command line and run benchmarks. Usage:
+ *
+ *   bench.out [--csv | --json] [--samples N] [--sample-ms N] [--warmup-ms N] [FILTER...]
+ *
+ * --warmup-ms 0 disables warmup. Return exit code for main(). */
+NN int bench_main(int argc, char ** argv);
+
+#endif /* CRUST_BENCH_H_ */
@@ -0,0 +1,42 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#include <stdbool.h>
+
+#include "crust-cpu.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+// __builtin_cpu_init() is required, because tests are run from constructors.
+// Results are cached in statics, -1 means unknown yet. Threads, which race
+// on first call, store same value.
+
+bool cpu_has_avx2(void) {
+  static int has_avx2 = -1;
+  int has = __atomic_load_n(&has_avx2, __ATOMIC_RELAXED);
+  if(has < 0) {
+    __builtin_cpu_init();
+    has = __builtin_cpu_supports("avx2") != 0;
+    __atomic_store_n(&has_avx2, has, __ATOMIC_RELAXED);
+  }
+  return has;
+}
+
+bool cpu_has_popcnt(void) {
+  static int has_popcnt = -1;
+  int has = __atomic_load_n(&has_popcnt, __ATOMIC_RELAXED);
+  if(has < 0) {
+    __builtin_cpu_init();
+    has = __builtin_cpu_supports("popcnt") != 0;
+    __atomic_store_n(&has_popcnt, has, __ATOMIC_RELAXED);
+  }
+  return has;
+}
+#else
+// Other CPUs use scalar code only
+bool cpu_has_avx2(void) { return false; }
+bool cpu_has_popcnt(void) { return false; }
+#endif
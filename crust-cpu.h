@@ -0,0 +1,27 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#ifndef CRUST_CPU_H_
+#define CRUST_CPU_H_
+
+#include <stdbool.h>
+
+#include "crust-mem.h"
+
+//
+// Run-time detection of CPU features, so binary works on any x86 CPU and
+// SIMD code is selected when it is called. Each feature is checked once,
+// and result is cached for all callers. Other CPUs report no features.
+//
+
+/** Return true when CPU supports AVX2 instructions. */
+WUR bool cpu_has_avx2(void);
+
+/** Return true when CPU supports POPCNT instruction. */
+WUR bool cpu_has_popcnt(void);
+
+#endif /* CRUST_CPU_H_ */
@@ -0,0 +1,64 @@
+#include "crust-hash.h"
+
+#include "crust-bench.h"
+
+#define HASH_BENCH_MAX_LENGTH 4096
+
+static unsigned char hash_bench_data[HASH_BENCH_MAX_LENGTH];
+
+static void hash_bench_init(void) {
+  for(size_t i = 0; i < sizeof(hash_bench_data); i++) {
+    hash_bench_data[i] = (unsigned char)(i * 131 + 7);
+  }
+}
+
+/* Baseline: FNV-1a, which hashes one byte at a time. */
+static uint64_t hash_bench_fnv1a(const void * data, size_t length) {
+  const unsigned char * p = data;
+  uint64_t hash = 0xCBF29CE484222325ULL;
+  for(size_t i = 0; i < length; i++) {
+    hash = (hash ^ p[i]) * 0x100000001B3ULL;
+  }
+  return hash;
+}
+
+// Key is changed at every iteration, so hash can't be hoisted out of loop
+#define DEFINE_HASH_BENCH(LENGTH) \
+bench(hash_bytes_##LENGTH, "hash key of " #LENGTH " bytes with hash_bytes()") { \
+  hash_bench_init(); \
+  bench_reset_timer(b); \
+  uint64_t sum = 0; \
+  for(size_t i = 0; i < b->iterations; i++) { \
+    hash_bench_data[0] = (unsigned char)i; \
+    sum += hash_bytes(hash_bench_data, LENGTH); \
+  } \
+  bench_do_not_optimize(&sum); \
+} \
+\
+bench(hash_fnv1a_##LENGTH, "hash key of " #LENGTH " bytes with byte-at-a-time FNV-1a") { \
+  hash_bench_init(); \
+  bench_reset_timer(b); \
+  uint64_t sum = 0; \
+  for(size_t i = 0; i < b->iterations; i++) { \
+    hash_bench_data[0] = (unsigned char)i; \
+    sum += hash_bench_fnv1a(hash_bench_data, LENGTH); \
+  } \
+  bench_do_not_optimize(&sum); \
+}
+
+DEFINE_HASH_BENCH(4)
+DEFINE_HASH_BENCH(8)
+DEFINE_HASH_BENCH(16)
+DEFINE_HASH_BENCH(32)
+DEFINE_HASH_BENCH(64)
+DEFINE_HASH_BENCH(256)
+DEFINE_HASH_BENCH(1024)
+DEFINE_HASH_BENCH(4096)
+
+bench(hash_u64, "hash 64-bit integer with hash_u64()") {
+  uint64_t sum = 0;
+  for(size_t i = 0; i < b->iterations; i++) {
+    sum += hash_u64(i);
+  }
+  bench_do_not_optimize(&sum);
+}
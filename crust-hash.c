@@ -0,0 +1,96 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+// For getrandom()
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/random.h>
+
+#include "crust-hash.h"
+
+uint64_t _hash_seed;
+
+// Priority 101 runs this constructor before unit tests, which are constructors too
+__attribute__((constructor(101)))
+static void hash_init_seed(void) {
+  uint64_t seed = 0;
+
+  if(getrandom(&seed, sizeof(seed), GRND_NONBLOCK) != sizeof(seed)) {
+    // No entropy yet, so use time and address of stack, which is randomized by ASLR
+    struct timespec now = { 0 };
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    seed = _hash_mix((uint64_t)now.tv_nsec ^ _HASH_SECRET0, (uint64_t)(uintptr_t)&now ^ (uint64_t)now.tv_sec);
+  }
+
+  _hash_seed = seed;
+}
+
+void hash_set_seed(uint64_t seed) {
+  _hash_seed = seed;
+}
+
+static inline uint64_t _hash_read8(const uint8_t * p) { uint64_t v; memcpy(&v, p, 8); return v; }
+static inline uint64_t _hash_read4(const uint8_t * p) { uint32_t v; memcpy(&v, p, 4); return v; }
+// Read 1 to 3 bytes
+static inline uint64_t _hash_read3(const uint8_t * p, size_t k) { return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1]; }
+
+uint64_t hash_bytes_with_seed(const void * data, size_t length, uint64_t seed) {
+  const uint8_t * p = data;
+  uint64_t a, b;
+
+  seed ^= _hash_mix(seed ^ _HASH_SECRET0, _HASH_SECRET1);
+
+  if(length <= 16) {
+    if(length >= 4) {
+      // Two pairs of overlapping 4-byte loads cover 4..16 bytes
+      size_t shift = (length >> 3) << 2;
+      a = (_hash_read4(p) << 32) | _hash_read4(p + shift);
+      b = (_hash_read4(p + length - 4) << 32) | _hash_read4(p + length - 4 - shift);
+    } else if(length > 0) {
+      a = _hash_read3(p, length);
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = length;
+
+    if(i > 48) {
+      // Three independent lanes keep multiplier busy
+      uint64_t see1 = seed, see2 = seed;
+      do {
+        seed = _hash_mix(_hash_read8(p) ^ _HASH_SECRET1, _hash_read8(p + 8) ^ seed);
+        see1 = _hash_mix(_hash_read8(p + 16) ^ _HASH_SECRET2, _hash_read8(p + 24) ^ see1);
+        see2 = _hash_mix(_hash_read8(p + 32) ^ _HASH_SECRET3, _hash_read8(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while(i > 48);
+      seed ^= see1 ^ see2;
+    }
+
+    while(i > 16) {
+      seed = _hash_mix(_hash_read8(p) ^ _HASH_SECRET1, _hash_read8(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+
+    // Last 16 bytes, which can overlap with already hashed ones
+    a = _hash_read8(p + i - 16);
+    b = _hash_read8(p + i - 8);
+  }
+
+  a ^= _HASH_SECRET1;
+  b ^= seed;
+  _hash_u128 r = (_hash_u128)a * b;
+  a = (uint64_t)r;
+  b = (uint64_t)(r >> 64);
+
+  return _hash_mix(a ^ _HASH_SECRET0 ^ length, b ^ _HASH_SECRET1);
+}
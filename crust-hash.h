@@ -0,0 +1,147 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#ifndef CRUST_HASH_H_
+#define CRUST_HASH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "crust-mem.h"
+
+#ifdef _CRUST_TESTS
+#include "crust-unittest.h"
+#endif
+
+//
+// Hash functions for hash tables, Bloom filters, deduplication, etc.
+//
+// Bytes are hashed with wyhash: 64x64->128 bit multiplications mix 16
+// bytes at once, and short keys are read with few overlapping loads and no
+// loops. All hashes depend on global seed, which is random for every run
+// of program, so attacker cannot prepare keys, which collide in hash table.
+//
+
+__extension__ typedef unsigned __int128 _hash_u128;
+
+/** Seed for all hash functions. Set at start of program. */
+extern uint64_t _hash_seed;
+
+/** Secret constants of wyhash. */
+#define _HASH_SECRET0 0xa0761d6478bd642fULL
+#define _HASH_SECRET1 0xe7037ed1a0b428dbULL
+#define _HASH_SECRET2 0x8ebc6af09c88c6e3ULL
+#define _HASH_SECRET3 0x589965cc75374cc3ULL
+
+/** Replace seed of hash functions, e.g. to make hashes reproducible.
+ * Must be called before any hash is stored, because stored hashes become invalid. */
+void hash_set_seed(uint64_t seed);
+
+/** Return current seed of hash functions. */
+WUR MU SI uint64_t hash_get_seed() { return _hash_seed; }
+
+/** Multiply and fold 128-bit result into 64 bits. */
+WUR MU SI uint64_t _hash_mix(uint64_t a, uint64_t b) {
+  _hash_u128 r = (_hash_u128)a * b;
+  return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+/** Return hash of bytes for given seed. */
+WUR uint64_t hash_bytes_with_seed(const void * data, size_t length, uint64_t seed);
+
+/** Return hash of bytes. */
+WUR MU SI uint64_t hash_bytes(const void * data, size_t length) {
+  return hash_bytes_with_seed(data, length, _hash_seed);
+}
+#ifdef _CRUST_TESTS
+it(hash_bytes, "must return same hash for same bytes and different hashes for different bytes") {
+  char a[100], b[100];
+  for(size_t i=0; i<sizeof(a); i++) {
+    a[i] = b[i] = (char)i;
+  }
+
+  // Every length goes through different code path
+  for(size_t length=0; length<=sizeof(a); length++) {
+    assert_true(hash_bytes(a, length) == hash_bytes(b, length), "hash must depend on content only");
+    if(length > 0) {
+      b[length-1] ^= 1;
+      assert_true(hash_bytes(a, length) != hash_bytes(b, length), "hash must depend on every byte");
+      b[length-1] ^= 1;
+      assert_true(hash_bytes(a, length) != hash_bytes(a, length-1), "hash must depend on length");
+    }
+  }
+
+  assert_true(hash_bytes_with_seed(a, 10, 1) != hash_bytes_with_seed(a, 10, 2), "hash must depend on seed");
+}
+#endif
+
+/** Return hash of 64-bit integer. */
+WUR MU SI uint64_t hash_u64(uint64_t value) {
+  return _hash_mix(value ^ _hash_seed ^ _HASH_SECRET0, _HASH_SECRET1 ^ (value >> 32));
+}
+#ifdef _CRUST_TESTS
+it(hash_u64, "must spread near values over all bits of hash") {
+  assert_true(hash_u64(1) == hash_u64(1), "hash must depend on value only");
+  assert_true(hash_u64(1) != hash_u64(2), "near values must have different hashes");
+  assert_true((hash_u64(1) >> 57) != (hash_u64(2) >> 57) || (hash_u64(1) & 0xFFFF) != (hash_u64(2) & 0xFFFF), "both high and low bits must depend on value");
+}
+#endif
+
+/**
+ * Streaming hasher for composite keys.
+ *
+ * Write fields one by one, then call finish(). Every write is mixed with
+ * length, so ("ab", "c") and ("a", "bc") produce different hashes.
+ */
+typedef struct {
+  uint64_t state;
+  uint64_t count;
+} Hasher;
+
+/** Create new hasher with global seed. */
+WUR MU SI Hasher hasher_new() { return (Hasher) { .state = _hash_seed, .count = 0 }; }
+
+/** Add bytes to hash. */
+NN MU SI void hasher_write(Hasher * self, const void * data, size_t length) {
+  self->state = hash_bytes_with_seed(data, length, self->state);
+  self->count++;
+}
+
+/** Add 64-bit integer to hash. */
+NN MU SI void hasher_write_u64(Hasher * self, uint64_t value) {
+  self->state = _hash_mix(self->state ^ value ^ _HASH_SECRET2, _HASH_SECRET1 ^ (value >> 32));
+  self->count++;
+}
+
+/** Return hash of all written data. Hasher can be used further. */
+NN WUR MU SI uint64_t hasher_finish(const Hasher * self) {
+  return _hash_mix(self->state ^ _HASH_SECRET3, self->count ^ _HASH_SECRET0);
+}
+#ifdef _CRUST_TESTS
+it(hasher, "must hash composite keys with respect to boundaries of fields") {
+  Hasher a = hasher_new();
+  hasher_write(&a, "ab", 2);
+  hasher_write(&a, "c", 1);
+  hasher_write_u64(&a, 42);
+
+  Hasher b = hasher_new();
+  hasher_write(&b, "ab", 2);
+  hasher_write(&b, "c", 1);
+  hasher_write_u64(&b, 42);
+
+  Hasher c = hasher_new();
+  hasher_write(&c, "a", 1);
+  hasher_write(&c, "bc", 2);
+  hasher_write_u64(&c, 42);
+
+  assert_true(hasher_finish(&a) == hasher_finish(&b), "same fields must produce same hash");
+  assert_true(hasher_finish(&a) != hasher_finish(&c), "boundaries of fields must change hash");
+}
+#endif
+
+#endif /* CRUST_HASH_H_ */
@@ -0,0 +1,70 @@
+#include "crust-iter.h"
+#include "crust-type-vec.h"
+#include "crust-type-slice.h"
+#include "crust-type-array.h"
+#include "crust-type-int.h"
+
+#include "crust-bench.h"
+
+VEC_BY_VALUE_TEMPLATE(Vec_int, vec_int, int)
+DEFINE_SLICE_BY_VALUE_TEMPLATE(Slice_int, slice_int, int, int)
+VEC_TO_SLICE(Vec_int, vec_int, int, Slice_int, slice_int)
+VEC_BY_VALUE_TEMPLATE(Vec_long, vec_long, long)
+
+static inline bool iter_bench_is_even(const int * value) { return *value % 2 == 0; }
+static inline long iter_bench_square(int value) { return (long)value * value; }
+static inline long iter_bench_sum(long accumulator, long value) { return accumulator + value; }
+
+DEFINE_SLICE_ITER(SliceIter_int, slice_iter_int, Slice_int, slice_int, int)
+DEFINE_ITER_FILTER(IterEven_int, iter_even_int, SliceIter_int, slice_iter_int, int, iter_bench_is_even)
+DEFINE_ITER_MAP(IterSquare_int, iter_square_int, IterEven_int, iter_even_int, int, long, iter_bench_square)
+DEFINE_ITER_FOLD(IterSquare_int, iter_square_int, long, iter_square_int_sum, long, iter_bench_sum)
+
+#define ITER_BENCH_LENGTH 10000
+
+static Vec_int iter_bench_data(void) {
+  Vec_int vec = vec_int_with_capacity(ITER_BENCH_LENGTH);
+  for(int j = 0; j < ITER_BENCH_LENGTH; j++) {
+    vec_int_push(&vec, j);
+  }
+  return vec;
+}
+
+bench(iter_filter_map_fold, "sum squares of even ints in 10000 ints with lazy iterators") {
+  defer(vec_int_destroy) Vec_int vec = iter_bench_data();
+  Slice_int slice = vec_int_as_slice(&vec);
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    bench_clobber();
+    IterSquare_int squares = iter_square_int_new(iter_even_int_new(slice_iter_int_new(&slice)));
+    long sum = iter_square_int_sum(&squares, 0);
+    bench_do_not_optimize(&sum);
+  }
+}
+
+bench(iter_filter_map_fold_vec, "sum squares of even ints in 10000 ints with intermediate vectors") {
+  defer(vec_int_destroy) Vec_int vec = iter_bench_data();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    defer(vec_int_destroy) Vec_int even = vec_int_new();
+    for(size_t j = 0; j < vec_int_len(&vec); j++) {
+      int value = vec_int_get(&vec, j);
+      if(iter_bench_is_even(&value)) {
+        vec_int_push(&even, value);
+      }
+    }
+
+    defer(vec_long_destroy) Vec_long squares = vec_long_new();
+    for(size_t j = 0; j < vec_int_len(&even); j++) {
+      vec_long_push(&squares, iter_bench_square(vec_int_get(&even, j)));
+    }
+
+    long sum = 0;
+    for(size_t j = 0; j < vec_long_len(&squares); j++) {
+      sum = iter_bench_sum(sum, vec_long_get(&squares, j));
+    }
+    bench_do_not_optimize(&sum);
+  }
+}
@@ -0,0 +1,78 @@
+#include "crust-iter.h"
+#include "crust-type-vec.h"
+#include "crust-type-slice.h"
+#include "crust-type-array.h"
+#include "crust-type-int.h"
+#include "crust-unittest.h"
+
+VEC_BY_VALUE_TEMPLATE(Vec_int, vec_int, int)
+DEFINE_SLICE_BY_VALUE_TEMPLATE(Slice_int, slice_int, int, int)
+VEC_TO_SLICE(Vec_int, vec_int, int, Slice_int, slice_int)
+
+static inline bool iter_test_is_even(const int * value) { return *value % 2 == 0; }
+static inline long iter_test_square(int value) { return (long)value * value; }
+static inline long iter_test_sum(long accumulator, long value) { return accumulator + value; }
+
+DEFINE_SLICE_ITER(SliceIter_int, slice_iter_int, Slice_int, slice_int, int)
+DEFINE_ITER_FILTER(IterEven_int, iter_even_int, SliceIter_int, slice_iter_int, int, iter_test_is_even)
+DEFINE_ITER_MAP(IterSquare_int, iter_square_int, IterEven_int, iter_even_int, int, long, iter_test_square)
+DEFINE_ITER_FOLD(IterSquare_int, iter_square_int, long, iter_square_int_sum, long, iter_test_sum)
+DEFINE_ITER_SKIP(IterSkip_int, iter_skip_int, SliceIter_int, slice_iter_int, int)
+DEFINE_ITER_TAKE(IterTake_int, iter_take_int, IterSkip_int, iter_skip_int, int)
+DEFINE_ITER_COLLECT_INTO_VEC(IterTake_int, iter_take_int, int, Vec_int, vec_int)
+DEFINE_ITER_COUNT(SliceIter_int, slice_iter_int, int)
+DEFINE_ITER_ENUMERATE(IterEnumerate_int, iter_enumerate_int, Indexed_int, IterEven_int, iter_even_int, int)
+DEFINE_ITER_ZIP(IterZip_int, iter_zip_int, Pair_int, SliceIter_int, slice_iter_int, int, IterSkip_int, iter_skip_int, int)
+
+it(iter_filter_map_fold, "must combine filter, map and fold without intermediate vectors") {
+  int data[] = { 1, 2, 3, 4, 5, 6 };
+  Slice_int slice = slice_int_from_raw_parts(data, LENGTH_OF_ARRAY(data));
+
+  IterSquare_int squares = iter_square_int_new(iter_even_int_new(slice_iter_int_new(&slice)));
+  assert_equal_int(4 + 16 + 36, iter_square_int_sum(&squares, 0), "Unexpected sum of squares of even numbers");
+
+  long item;
+  assert_true(!iter_square_int_next(&squares, &item), "Iterator must be exhausted after fold");
+}
+
+it(iter_skip_take_collect, "must skip and take items and collect them into vector") {
+  int data[] = { 1, 2, 3, 4, 5, 6 };
+  Slice_int slice = slice_int_from_raw_parts(data, LENGTH_OF_ARRAY(data));
+  defer(vec_int_destroy) Vec_int vec = vec_int_new();
+
+  IterTake_int middle = iter_take_int_new(iter_skip_int_new(slice_iter_int_new(&slice), 2), 3);
+  assert_equal_int(3, iter_take_int_collect_into_vec(&middle, &vec), "Unexpected number of collected items");
+  assert_equal_int(3, vec_int_len(&vec), "Unexpected length of vector");
+  for(int i=0; i<3; i++) {
+    assert_equal_int(i+3, vec_int_get(&vec, i), "Unexpected collected item");
+  }
+
+  IterTake_int past_end = iter_take_int_new(iter_skip_int_new(slice_iter_int_new(&slice), 10), 3);
+  assert_equal_int(0, iter_take_int_collect_into_vec(&past_end, &vec), "Skip past end must yield nothing");
+
+  SliceIter_int all = slice_iter_int_new(&slice);
+  assert_equal_int(6, slice_iter_int_count(&all), "Unexpected number of items");
+}
+
+it(iter_enumerate_zip, "must pair items with indexes and with items of other iterator") {
+  int data[] = { 1, 2, 3, 4, 5, 6 };
+  Slice_int slice = slice_int_from_raw_parts(data, LENGTH_OF_ARRAY(data));
+
+  IterEnumerate_int evens = iter_enumerate_int_new(iter_even_int_new(slice_iter_int_new(&slice)));
+  Indexed_int indexed;
+  for(size_t i=0; i<3; i++) {
+    assert_true(iter_enumerate_int_next(&evens, &indexed), "Unexpected end of iterator");
+    assert_equal_int(i, indexed.index, "Unexpected index");
+    assert_equal_int((i+1)*2, indexed.value, "Unexpected value");
+  }
+  assert_true(!iter_enumerate_int_next(&evens, &indexed), "Iterator must be exhausted");
+
+  IterZip_int pairs = iter_zip_int_new(slice_iter_int_new(&slice), iter_skip_int_new(slice_iter_int_new(&slice), 1));
+  Pair_int pair;
+  int count = 0;
+  while(iter_zip_int_next(&pairs, &pair)) {
+    assert_equal_int(pair.first+1, pair.second, "Unexpected pair");
+    count++;
+  }
+  assert_equal_int(5, count, "Zip must stop when shorter iterator is exhausted");
+}
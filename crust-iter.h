@@ -0,0 +1,221 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#ifndef CRUST_ITER_H_
+#define CRUST_ITER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "crust-mem.h"
+
+//
+// Lazy iterators.
+//
+// Iterator is a structure with function
+//
+//   bool PREFIX_next(NAME * self, CTYPE * item)
+//
+// which stores next item and returns true, or returns false when iterator is
+// exhausted. Adaptors wrap source iterator by value and call its next()
+// function directly, and functions for map(), filter() and fold() are passed
+// to templates by name, so all calls are static inline. Compiler inlines
+// whole chain into single loop: no intermediate vectors are allocated and no
+// calls via pointers are made.
+//
+// Example:
+//
+//   DEFINE_SLICE_ITER(SliceIter_int, slice_iter_int, Slice_int, slice_int, int)
+//   DEFINE_ITER_FILTER(IsEven_int, is_even_int, SliceIter_int, slice_iter_int, int, int_is_even)
+//   DEFINE_ITER_MAP(Square_int, square_int, IsEven_int, is_even_int, int, int, int_square)
+//   DEFINE_ITER_COLLECT_INTO_VEC(Square_int, square_int, int, Vec_int, vec_int)
+//
+//   Square_int squares = square_int_new(is_even_int_new(slice_iter_int_new(&slice)));
+//   square_int_collect_into_vec(&squares, &vec);
+//
+// Vectors are iterated via their slices (see VEC_TO_SLICE).
+//
+
+/** Define iterator over elements of slice. Slice must outlive iterator. */
+#define DEFINE_SLICE_ITER(ITERNAME, ITERPREFIX, SLICENAME, SLICEPREFIX, CTYPE) \
+typedef struct { \
+  const CTYPE * ptr; \
+  const CTYPE * end; \
+} ITERNAME; \
+\
+NN WUR MU SI ITERNAME ITERPREFIX##_new(const SLICENAME * slice) { \
+  const CTYPE * data = SLICEPREFIX##_as_ptr(slice); \
+  return (ITERNAME) { .ptr = data, .end = data + SLICEPREFIX##_len(slice) }; \
+} \
+\
+NN WUR MU SI bool ITERPREFIX##_next(ITERNAME * self, CTYPE * item) { \
+  if(self->ptr == self->end) { \
+    return false; \
+  } \
+  *item = *self->ptr++; \
+  return true; \
+}
+
+/** Define iterator, which yields FN(item) for every item of source iterator.
+ * FN must be function or macro: OUT_CTYPE FN(IN_CTYPE). */
+#define DEFINE_ITER_MAP(ITERNAME, ITERPREFIX, SOURCENAME, SOURCEPREFIX, IN_CTYPE, OUT_CTYPE, FN) \
+typedef struct { \
+  SOURCENAME source; \
+} ITERNAME; \
+\
+WUR MU SI ITERNAME ITERPREFIX##_new(SOURCENAME source) { return (ITERNAME) { .source = source }; } \
+\
+NN WUR MU SI bool ITERPREFIX##_next(ITERNAME * self, OUT_CTYPE * item) { \
+  IN_CTYPE value; \
+  if(!SOURCEPREFIX##_next(&self->source, &value)) { \
+    return false; \
+  } \
+  *item = FN(value); \
+  return true; \
+}
+
+/** Define iterator, which yields only items of source iterator, for which
+ * PREDICATE(const CTYPE *) returns true. */
+#define DEFINE_ITER_FILTER(ITERNAME, ITERPREFIX, SOURCENAME, SOURCEPREFIX, CTYPE, PREDICATE) \
+typedef struct { \
+  SOURCENAME source; \
+} ITERNAME; \
+\
+WUR MU SI ITERNAME ITERPREFIX##_new(SOURCENAME source) { return (ITERNAME) { .source = source }; } \
+\
+NN WUR MU SI bool ITERPREFIX##_next(ITERNAME * self, CTYPE * item) { \
+  while(SOURCEPREFIX##_next(&self->source, item)) { \
+    if(PREDICATE(item)) { \
+      return true; \
+    } \
+  } \
+  return false; \
+}
+
+/** Define iterator, which yields at most limit first items of source iterator. */
+#define DEFINE_ITER_TAKE(ITERNAME, ITERPREFIX, SOURCENAME, SOURCEPREFIX, CTYPE) \
+typedef struct { \
+  SOURCENAME source; \
+  size_t remaining; \
+} ITERNAME; \
+\
+WUR MU SI ITERNAME ITERPREFIX##_new(SOURCENAME source, size_t limit) { \
+  return (ITERNAME) { .source = source, .remaining = limit }; \
+} \
+\
+NN WUR MU SI bool ITERPREFIX##_next(ITERNAME * self, CTYPE * item) { \
+  if(self->remaining == 0 || !SOURCEPREFIX##_next(&self->source, item)) { \
+    return false; \
+  } \
+  self->remaining--; \
+  return true; \
+}
+
+/** Define iterator, which skips count first items of source iterator. */
+#define DEFINE_ITER_SKIP(ITERNAME, ITERPREFIX, SOURCENAME, SOURCEPREFIX, CTYPE) \
+typedef struct { \
+  SOURCENAME source; \
+  size_t skip; \
+} ITERNAME; \
+\
+WUR MU SI ITERNAME ITERPREFIX##_new(SOURCENAME source, size_t count) { \
+  return (ITERNAME) { .source = source, .skip = count }; \
+} \
+\
+NN WUR MU SI bool ITERPREFIX##_next(ITERNAME * self, CTYPE * item) { \
+  for(; self->skip > 0; self->skip--) { \
+    if(!SOURCEPREFIX##_next(&self->source, item)) { \
+      self->skip = 0; \
+      return false; \
+    } \
+  } \
+  return SOURCEPREFIX##_next(&self->source, item); \
+}
+
+/** Define iterator, which yields pairs of items of two iterators, until any of them is exhausted.
+ * Pair is ITEMNAME { A_CTYPE first; B_CTYPE second; }. */
+#define DEFINE_ITER_ZIP(ITERNAME, ITERPREFIX, ITEMNAME, A_NAME, A_PREFIX, A_CTYPE, B_NAME, B_PREFIX, B_CTYPE) \
+typedef struct { \
+  A_CTYPE first; \
+  B_CTYPE second; \
+} ITEMNAME; \
+\
+typedef struct { \
+  A_NAME a; \
+  B_NAME b; \
+} ITERNAME; \
+\
+WUR MU SI ITERNAME ITERPREFIX##_new(A_NAME a, B_NAME b) { return (ITERNAME) { .a = a, .b = b }; } \
+\
+NN WUR MU SI bool ITERPREFIX##_next(ITERNAME * self, ITEMNAME * item) { \
+  return A_PREFIX##_next(&self->a, &item->first) && B_PREFIX##_next(&self->b, &item->second); \
+}
+
+/** Define iterator, which yields items of source iterator with their indexes.
+ * Pair is ITEMNAME { size_t index; CTYPE value; }. */
+#define DEFINE_ITER_ENUMERATE(ITERNAME, ITERPREFIX, ITEMNAME, SOURCENAME, SOURCEPREFIX, CTYPE) \
+typedef struct { \
+  size_t index; \
+  CTYPE value; \
+} ITEMNAME; \
+\
+typedef struct { \
+  SOURCENAME source; \
+  size_t index; \
+} ITERNAME; \
+\
+WUR MU SI ITERNAME ITERPREFIX##_new(SOURCENAME source) { return (ITERNAME) { .source = source, .index = 0 }; } \
+\
+NN WUR MU SI bool ITERPREFIX##_next(ITERNAME * self, ITEMNAME * item) { \
+  if(!SOURCEPREFIX##_next(&self->source, &item->value)) { \
+    return false; \
+  } \
+  item->index = self->index++; \
+  return true; \
+}
+
+//
+// Consumers
+//
+
+/** Define function FNNAME(self, init), which combines all items of iterator
+ * with FN: ACC_CTYPE FN(ACC_CTYPE accumulator, CTYPE item). */
+#define DEFINE_ITER_FOLD(ITERNAME, ITERPREFIX, CTYPE, FNNAME, ACC_CTYPE, FN) \
+NN WUR MU SI ACC_CTYPE FNNAME(ITERNAME * self, ACC_CTYPE init) { \
+  ACC_CTYPE accumulator = init; \
+  CTYPE item; \
+  while(ITERPREFIX##_next(self, &item)) { \
+    accumulator = FN(accumulator, item); \
+  } \
+  return accumulator; \
+}
+
+/** Define function, which appends all items of iterator to vector and
+ * returns number of appended items. */
+#define DEFINE_ITER_COLLECT_INTO_VEC(ITERNAME, ITERPREFIX, CTYPE, VECNAME, VECPREFIX) \
+NN MU SI size_t ITERPREFIX##_collect_into_vec(ITERNAME * self, VECNAME * vec) { \
+  size_t count = 0; \
+  CTYPE item; \
+  while(ITERPREFIX##_next(self, &item)) { \
+    VECPREFIX##_push(vec, item); \
+    count++; \
+  } \
+  return count; \
+}
+
+/** Define function, which consumes iterator and returns number of items. */
+#define DEFINE_ITER_COUNT(ITERNAME, ITERPREFIX, CTYPE) \
+NN WUR MU SI size_t ITERPREFIX##_count(ITERNAME * self) { \
+  size_t count = 0; \
+  CTYPE item; \
+  while(ITERPREFIX##_next(self, &item)) { \
+    count++; \
+  } \
+  return count; \
+}
+
+#endif /* CRUST_ITER_H_ */
@@ -13,6 +13,7 @@
 
 #ifdef _CRUST_TESTS
 #include <stdint.h>
+#include <string.h>
 /* Includes for built-in tests. */
 #include "crust-unittest.h"
 #endif
@@ -39,18 +40,50 @@
  * from the function with pointer to given function as argument.
  */
 #define defer(func) __attribute__((cleanup(func)))
+
+//
+// Debug allocator
+//
+// When CRUST_DEBUG_ALLOC is defined, mem_malloc(), mem_calloc(),
+// mem_realloc() and mem_free() are replaced by macros, which record call
+// site of every block. Every block is surrounded by guard bytes, which are
+// checked when block is freed. Freed block is poisoned and kept in
+// quarantine for a while, so writes after free are detected when block
+// leaves quarantine. Double free and free of foreign pointer abort program
+// with both call sites. Blocks, which are not freed at exit, are reported with
+// their call sites, and program exits with error.
+//
+// Names of real functions are written in parentheses, so they are not
+// expanded by these macros.
+//
+#ifdef CRUST_DEBUG_ALLOC
+WUR void * _mem_debug_realloc(void * ptr, size_t length, size_t element_size, const char * file, int line);
+WUR void * _mem_debug_calloc(size_t length, size_t element_size, const char * file, int line);
+void _mem_debug_free(void * ptr, const char * file, int line);
+
+/** Number of blocks, which are allocated and not freed yet. */
+WUR size_t mem_debug_live_blocks(void);
+
+#define mem_realloc(ptr, length, element_size) _mem_debug_realloc((ptr), (length), (element_size), __FILE__, __LINE__)
+#define mem_malloc(length, element_size) _mem_debug_realloc(NULL, (length), (element_size), __FILE__, __LINE__)
+#define mem_calloc(length, element_size) _mem_debug_calloc((length), (element_size), __FILE__, __LINE__)
+#define mem_free(ptr) _mem_debug_free((ptr), __FILE__, __LINE__)
+#endif
+
+/**
+ * Free memory, which is allocated by mem_malloc(), mem_calloc() or mem_realloc().
+ */
+MU SI void (mem_free)(void * ptr) {
+  free(ptr);
+}
+
 #ifdef _CRUST_TESTS
 NN MU SI void mem_charp_destroy(char * * value) {
   if(*value) {
-    free(*value);
+    mem_free(*value);
     *value = NULL;
   }
 }
-
-it(defer, "must deallocate object at the end of the function") {
-  defer(mem_charp_destroy) char * s = calloc(1, sizeof(char));
-  (void)s;
-}
 #endif
 
 /**
@@ -59,8 +92,13 @@ it(defer, "must deallocate object at the end of the function") {
 enum Mem_error_codes {
   MEM_ERROR_INTEGER_OVERFLOW = 1,//!< MEM_ERROR_INTEGER_OVERFLOW
   MEM_ERROR_OUT_OF_MEM = 2,      //!< MEM_ERROR_OUT_OF_MEM
+  MEM_ERROR_INVALID_FREE = 3,    //!< MEM_ERROR_INVALID_FREE
+  MEM_ERROR_DOUBLE_FREE = 4,     //!< MEM_ERROR_DOUBLE_FREE
+  MEM_ERROR_BUFFER_OVERFLOW = 5, //!< MEM_ERROR_BUFFER_OVERFLOW
+  MEM_ERROR_USE_AFTER_FREE = 6,  //!< MEM_ERROR_USE_AFTER_FREE
 };
 
+
 /**
  * Print error message and abort program.
  */
@@ -76,7 +114,7 @@ void mem_panic(int error_code, size_t value);
 /**
  * Checks for integer overflow and out of memory.
  */
-WUR void * mem_realloc(void *ptr, size_t length, size_t element_size);
+WUR void * (mem_realloc)(void *ptr, size_t length, size_t element_size);
 #ifdef _CRUST_TESTS
   it(mem_realloc__1, "must allocate new memory") {
     defer(mem_charp_destroy) char * s = mem_realloc(NULL, 100, 3);
@@ -106,7 +144,7 @@ WUR void * mem_realloc(void *ptr, size_t length, size_t element_size);
 /**
  * Checks for integer overflow and out of memory.
  */
-WUR MU SI void * mem_malloc(size_t length, size_t element_size) {
+WUR MU SI void * (mem_malloc)(size_t length, size_t element_size) {
   return mem_realloc(NULL, length, element_size);
 }
 #ifdef _CRUST_TESTS
@@ -119,7 +157,7 @@ WUR MU SI void * mem_malloc(size_t length, size_t element_size) {
 /**
  * Checks for integer overflow and out of memory.
  */
-WUR void * mem_calloc(size_t length, size_t element_size);
+WUR void * (mem_calloc)(size_t length, size_t element_size);
 #ifdef _CRUST_TESTS
   it(mem_calloc__1, "must allocate new memory") {
     defer(mem_charp_destroy) char * s = mem_calloc(100, 3);
@@ -138,6 +176,46 @@ WUR void * mem_calloc(size_t length, size_t element_size);
 //    assert_abort(s = mem_calloc(SIZE_MAX, 1), "must abort at out of memory");
 //    (void)s;
 //  }
+
+  it(defer, "must deallocate object at the end of the function") {
+    defer(mem_charp_destroy) char * s = mem_calloc(1, sizeof(char));
+    (void)s;
+  }
+#endif
+
+#ifdef CRUST_DEBUG_ALLOC
+/** Check guard bytes of all live blocks and poison of all blocks in
+ * quarantine. Abort program at first damaged block. */
+void mem_debug_check(void);
+#ifdef _CRUST_TESTS
+  it(mem_debug_live_blocks, "must count allocated blocks") {
+    size_t before = mem_debug_live_blocks();
+    char * s = mem_malloc(10, 1);
+    assert_equal_int(before + 1, mem_debug_live_blocks(), "Block must be counted");
+    mem_free(s);
+    assert_equal_int(before, mem_debug_live_blocks(), "Freed block must not be counted");
+  }
+
+  it(mem_debug_realloc, "must keep data and guard new size") {
+    char * s = mem_malloc(4, 1);
+    memcpy(s, "abc", 4);
+    s = mem_realloc(s, 100, 1);
+    assert_equal_charp("abc", s, "Data must be copied into new block");
+    s[99] = 'x';
+    mem_debug_check();
+    mem_free(s);
+  }
+
+  it(mem_debug_free, "must abort at overflow, double free and use after free") {
+    char * s = mem_malloc(8, 1);
+    assert_abort((s[8] = 'x', mem_free(s)), "must abort at write past end of block");
+    assert_abort((s[-1] = 'x', mem_free(s)), "must abort at write before start of block");
+    assert_abort((mem_free(s), mem_free(s)), "must abort at double free");
+    assert_abort((mem_free(s), s[0] = 'x', mem_debug_check()), "must abort at write into freed block");
+    assert_abort(mem_free(s + 1), "must abort at free of foreign pointer");
+    mem_free(s);
+  }
+#endif
 #endif
 
 #endif
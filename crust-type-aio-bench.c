@@ -0,0 +1,161 @@
+// For fileno()
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "crust-type-array.h"
+#include "crust-type-aio.h"
+
+#include "crust-bench.h"
+
+//
+// Read 1000 small files of 4 KB each, and one 64 MB file in chunks of 1 MB.
+// Files are written once into temporary files, so they are read from page
+// cache, and cost of syscalls and of waiting for completions is measured.
+//
+
+#define AIO_BENCH_FILES 1000
+#define AIO_BENCH_SMALL_FILE 4096
+#define AIO_BENCH_LARGE_FILE ((size_t)64 << 20)
+#define AIO_BENCH_CHUNK ((size_t)1 << 20)
+#define AIO_BENCH_ENTRIES 64
+
+static FILE * aio_bench_files[AIO_BENCH_FILES];
+static String aio_bench_buffers[AIO_BENCH_FILES];
+static FILE * aio_bench_large_file = NULL;
+static String aio_bench_large_buffer;
+
+static FILE * aio_bench_create_file(size_t length) {
+  FILE * file = tmpfile();
+  if(!file) {
+    perror("ERROR: Aio bench: Cannot create temporary file");
+    abort();
+  }
+  for(size_t i = 0; i < length; i++) {
+    putc('a' + (int)(i % 26), file);
+  }
+  fflush(file);
+  return file;
+}
+
+static void aio_bench_init_small(void) {
+  if(aio_bench_files[0]) {
+    return;
+  }
+  for(int i = 0; i < AIO_BENCH_FILES; i++) {
+    aio_bench_files[i] = aio_bench_create_file(AIO_BENCH_SMALL_FILE);
+    aio_bench_buffers[i] = string_with_capacity(AIO_BENCH_SMALL_FILE);
+  }
+}
+
+static void aio_bench_init_large(void) {
+  if(aio_bench_large_file) {
+    return;
+  }
+  aio_bench_large_file = aio_bench_create_file(AIO_BENCH_LARGE_FILE);
+  aio_bench_large_buffer = string_with_capacity(AIO_BENCH_LARGE_FILE);
+}
+
+/* Wait for all requests in flight and return number of bytes read. */
+static size_t aio_bench_wait(Aio * aio, bool all) {
+  AioCompletion completions[AIO_BENCH_ENTRIES];
+  size_t bytes = 0;
+  do {
+    size_t count = aio_poll(aio, completions, LENGTH_OF_ARRAY(completions), true);
+    for(size_t j = 0; j < count; j++) {
+      if(completions[j].result < 0) {
+        abort();
+      }
+      bytes += (size_t)completions[j].result;
+    }
+  } while(all && aio_in_flight(aio) > 0);
+  return bytes;
+}
+
+#define DEFINE_AIO_BENCH(NAME, BACKEND, DESCRIPTION) \
+bench(aio_small_files_##NAME, "read 1000 files of 4 KB with Aio and " DESCRIPTION) { \
+  aio_bench_init_small(); \
+  defer(aio_destroy) Aio aio = aio_with_backend(AIO_BENCH_ENTRIES, AIO_BACKEND_##BACKEND); \
+  bench_reset_timer(b); \
+  \
+  for(size_t i = 0; i < b->iterations; i++) { \
+    size_t bytes = 0; \
+    for(int j = 0; j < AIO_BENCH_FILES; j++) { \
+      string_set_len_unsafe(&aio_bench_buffers[j], 0); \
+      while(!aio_read_string(&aio, fileno(aio_bench_files[j]), 0, &aio_bench_buffers[j], AIO_BENCH_SMALL_FILE, (uint64_t)j)) { \
+        bytes += aio_bench_wait(&aio, false); \
+      } \
+    } \
+    bytes += aio_bench_wait(&aio, true); \
+    if(bytes != (size_t)AIO_BENCH_FILES * AIO_BENCH_SMALL_FILE) { \
+      abort(); \
+    } \
+  } \
+} \
+\
+bench(aio_large_file_##NAME, "read 64 MB file in chunks of 1 MB with Aio and " DESCRIPTION) { \
+  aio_bench_init_large(); \
+  int fd = fileno(aio_bench_large_file); \
+  defer(aio_destroy) Aio aio = aio_with_backend(AIO_BENCH_ENTRIES, AIO_BACKEND_##BACKEND); \
+  bench_reset_timer(b); \
+  \
+  for(size_t i = 0; i < b->iterations; i++) { \
+    string_set_len_unsafe(&aio_bench_large_buffer, 0); \
+    size_t bytes = 0; \
+    for(size_t offset = 0; offset < AIO_BENCH_LARGE_FILE; offset += AIO_BENCH_CHUNK) { \
+      while(!aio_read_string(&aio, fd, offset, &aio_bench_large_buffer, AIO_BENCH_CHUNK, offset)) { \
+        bytes += aio_bench_wait(&aio, false); \
+      } \
+    } \
+    bytes += aio_bench_wait(&aio, true); \
+    if(bytes != AIO_BENCH_LARGE_FILE || string_len(&aio_bench_large_buffer) != AIO_BENCH_LARGE_FILE) { \
+      abort(); \
+    } \
+  } \
+}
+
+DEFINE_AIO_BENCH(auto, AUTO, "best backend")
+DEFINE_AIO_BENCH(threads, THREADS, "thread pool")
+
+bench(aio_small_files_pread, "read 1000 files of 4 KB with blocking pread(), as baseline") {
+  aio_bench_init_small();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    size_t bytes = 0;
+    for(int j = 0; j < AIO_BENCH_FILES; j++) {
+      ssize_t result = pread(fileno(aio_bench_files[j]), string_as_ptr(&aio_bench_buffers[j]), AIO_BENCH_SMALL_FILE, 0);
+      if(result < 0) {
+        abort();
+      }
+      string_set_len_unsafe(&aio_bench_buffers[j], (size_t)result);
+      bytes += (size_t)result;
+    }
+    if(bytes != (size_t)AIO_BENCH_FILES * AIO_BENCH_SMALL_FILE) {
+      abort();
+    }
+  }
+}
+
+bench(aio_large_file_pread, "read 64 MB file in chunks of 1 MB with blocking pread(), as baseline") {
+  aio_bench_init_large();
+  int fd = fileno(aio_bench_large_file);
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    size_t bytes = 0;
+    for(size_t offset = 0; offset < AIO_BENCH_LARGE_FILE; offset += AIO_BENCH_CHUNK) {
+      ssize_t result = pread(fd, string_as_ptr(&aio_bench_large_buffer) + offset, AIO_BENCH_CHUNK, (off_t)offset);
+      if(result < 0) {
+        abort();
+      }
+      bytes += (size_t)result;
+    }
+    string_set_len_unsafe(&aio_bench_large_buffer, bytes);
+    if(bytes != AIO_BENCH_LARGE_FILE) {
+      abort();
+    }
+  }
+}
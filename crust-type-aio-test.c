@@ -0,0 +1,155 @@
+// For fileno()
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "crust-type-array.h"
+#include "crust-type-aio.h"
+#include "crust-unittest.h"
+
+/* Write and read back file through given backend. */
+static void aio_test_backend(Aio_backend backend) {
+  FILE * file = tmpfile();
+  int fd = fileno(file);
+
+  defer(aio_destroy) Aio aio = aio_with_backend(8, backend);
+  assert_true(backend == AIO_BACKEND_AUTO || aio_backend(&aio) == backend, "must use requested backend");
+
+  // Write 100 records of 4 bytes, with queue, which is smaller than number of records
+  char records[100][5];
+  size_t completed = 0;
+  AioCompletion completions[8];
+  for(size_t i = 0; i < LENGTH_OF_ARRAY(records); i++) {
+    snprintf(records[i], sizeof(records[i]), "%04zu", i);
+    Str record = str_from_raw_parts(records[i], 4);
+    while(!aio_write_str(&aio, fd, i * 4, &record, i)) {
+      size_t count = aio_poll(&aio, completions, LENGTH_OF_ARRAY(completions), true);
+      for(size_t j = 0; j < count; j++) {
+        assert_equal_int(4, completions[j].result, "must write whole record");
+      }
+      completed += count;
+    }
+  }
+  while(aio_in_flight(&aio) > 0) {
+    completed += aio_poll(&aio, completions, LENGTH_OF_ARRAY(completions), true);
+  }
+  assert_equal_int(LENGTH_OF_ARRAY(records), completed, "all writes must complete");
+
+  // Read file in 4 parts into separate strings
+  String parts[4];
+  for(size_t i = 0; i < LENGTH_OF_ARRAY(parts); i++) {
+    parts[i] = string_from_charp("part:");
+    assert_true(aio_read_string(&aio, fd, i * 100, &parts[i], 100, 1000 + i), "must queue read");
+  }
+  assert_equal_int(4, aio_in_flight(&aio), "reads must be in flight");
+
+  bool seen[4] = { false };
+  while(aio_in_flight(&aio) > 0) {
+    size_t count = aio_poll(&aio, completions, LENGTH_OF_ARRAY(completions), true);
+    for(size_t j = 0; j < count; j++) {
+      assert_equal_int(100, completions[j].result, "must read whole part");
+      seen[completions[j].user_data - 1000] = true;
+    }
+  }
+  assert_true(seen[0] && seen[1] && seen[2] && seen[3], "all reads must complete");
+
+  assert_equal_int(105, string_len(&parts[0]), "read must increase length of string");
+  string_end_with_zero(&parts[0]);
+  assert_true(strncmp(string_as_ptr(&parts[0]), "part:000000010002", 17) == 0, "read must append data after existing text");
+  string_end_with_zero(&parts[3]);
+  assert_true(strncmp(string_as_ptr(&parts[3]), "part:0075", 9) == 0, "read must use offset");
+
+  // Read past end of file
+  assert_true(aio_read_string(&aio, fd, 10000, &parts[1], 10, 7), "must queue read");
+  assert_equal_int(1, aio_poll(&aio, completions, 1, true), "must complete read");
+  assert_equal_int(0, completions[0].result, "must read nothing at end of file");
+
+  // Error is reported as negative errno
+  assert_true(aio_read_string(&aio, -1, 0, &parts[1], 10, 8), "must queue read");
+  assert_equal_int(1, aio_poll(&aio, completions, 1, true), "must complete read");
+  assert_true(completions[0].result < 0, "must report error");
+
+  for(size_t i = 0; i < LENGTH_OF_ARRAY(parts); i++) {
+    string_destroy(&parts[i]);
+  }
+  fclose(file);
+}
+
+/* Read file in several chunks into one string through given backend. */
+static void aio_test_chunks(Aio_backend backend) {
+  FILE * file = tmpfile();
+  int fd = fileno(file);
+  for(int i = 0; i < 1024; i++) {
+    fprintf(file, "%04d", i);
+  }
+  fflush(file);
+
+  defer(aio_destroy) Aio aio = aio_with_backend(4, backend);
+  AioCompletion completions[4];
+
+  // 8 chunks of 512 bytes, with queue of 4 entries, so completions come in any order
+  defer(string_destroy) String text = string_with_capacity(4096);
+  for(size_t i = 0; i < 8; i++) {
+    while(!aio_read_string(&aio, fd, i * 512, &text, 512, i)) {
+      (void)aio_poll(&aio, completions, LENGTH_OF_ARRAY(completions), true);
+    }
+  }
+  while(aio_in_flight(&aio) > 0) {
+    (void)aio_poll(&aio, completions, LENGTH_OF_ARRAY(completions), true);
+  }
+  assert_equal_int(4096, string_len(&text), "all chunks must be appended");
+  assert_true(string_capacity(&text) >= string_len(&text), "length must not exceed capacity");
+  for(int i = 0; i < 1024; i++) {
+    char expected[5];
+    snprintf(expected, sizeof(expected), "%04d", i);
+    assert_true(strncmp(string_as_ptr(&text) + i * 4, expected, 4) == 0, "chunks must be placed in queue order");
+  }
+
+  // Short read in the middle drops data of later reads
+  defer(string_destroy) String tail = string_with_capacity(600);
+  assert_true(aio_read_string(&aio, fd, 0, &tail, 200, 1), "must queue read");
+  assert_true(aio_read_string(&aio, fd, 3996, &tail, 200, 2), "must queue read");
+  assert_true(aio_read_string(&aio, fd, 0, &tail, 200, 3), "must queue read");
+  while(aio_in_flight(&aio) > 0) {
+    (void)aio_poll(&aio, completions, LENGTH_OF_ARRAY(completions), true);
+  }
+  assert_equal_int(300, string_len(&tail), "count must end at short read");
+  assert_true(strncmp(string_as_ptr(&tail) + 200, "0999", 4) == 0, "short read must follow first read");
+
+  // Vector with read in flight cannot grow
+  defer(string_destroy) String small = string_with_capacity(100);
+  assert_true(aio_read_string(&aio, fd, 0, &small, 100, 4), "must queue read");
+  assert_abort((void)(0 == aio_read_string(&aio, fd, 100, &small, 100, 5)), "must abort, when vector has no room for next read");
+  while(aio_in_flight(&aio) > 0) {
+    (void)aio_poll(&aio, completions, LENGTH_OF_ARRAY(completions), true);
+  }
+  assert_equal_int(100, string_len(&small), "must read first chunk");
+
+  fclose(file);
+}
+
+it(aio_chunks, "must read several chunks into one vector in order with best backend") {
+  aio_test_chunks(AIO_BACKEND_AUTO);
+}
+
+it(aio_chunks_threads, "must read several chunks into one vector in order with thread pool") {
+  aio_test_chunks(AIO_BACKEND_THREADS);
+}
+
+it(aio_io_uring, "must write and read files in batches with best backend") {
+  aio_test_backend(AIO_BACKEND_AUTO);
+}
+
+it(aio_threads, "must write and read files in batches with thread pool") {
+  aio_test_backend(AIO_BACKEND_THREADS);
+}
+
+it(aio_poll_empty, "must return immediately, when nothing is in flight") {
+  defer(aio_destroy) Aio aio = aio_new(4);
+  AioCompletion completions[4];
+
+  assert_equal_int(0, aio_poll(&aio, completions, LENGTH_OF_ARRAY(completions), true), "must not wait without requests");
+  assert_abort((void)(0 == aio_new(0).entries), "must abort on zero entries");
+}
@@ -0,0 +1,582 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+// For syscall(), pread() and pwrite()
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "crust-type-array.h"
+#include "crust-type-aio.h"
+
+void aio_panic(int error_code, size_t value) {
+  switch(error_code) {
+    case AIO_ERROR_ZERO_ENTRIES:
+      fprintf(stderr, "ERROR: Aio: Number of entries must be greater than zero.\n");
+    break;
+
+    case AIO_ERROR_IO_URING_UNAVAILABLE:
+      fprintf(stderr, "ERROR: Aio: io_uring is not available. Error: %zu.\n", value);
+    break;
+
+    case AIO_ERROR_THREAD_CREATE:
+      fprintf(stderr, "ERROR: Aio: Cannot create thread. Error: %zu.\n", value);
+    break;
+
+    case AIO_ERROR_VEC_CAPACITY:
+      fprintf(stderr, "ERROR: Aio: Vector has reads in flight, so it cannot grow. Reserve capacity before first read. Count: %zu.\n", value);
+    break;
+
+    default:
+      fprintf(stderr, "ERROR: aio_panic(): Unknown error code: %d.\n", error_code);
+  }
+
+  abort();
+}
+
+/* Largest request, which kernel performs in single read() or write(). */
+#define _AIO_MAX_LENGTH 0x7FFFF000
+
+//
+// io_uring backend, with raw syscalls, so no library is required.
+//
+
+static int _aio_io_uring_setup(unsigned entries, struct io_uring_params * params) {
+  return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int _aio_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+/* Set up ring. Return 0 or errno. */
+static int _aio_ring_init(_AioRing * ring, size_t entries) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+
+  int fd = _aio_io_uring_setup((unsigned)entries, &params);
+  if(fd < 0) {
+    return errno;
+  }
+
+  ring->fd = fd;
+  ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+  // Both rings share single mapping on kernels with IORING_FEAT_SINGLE_MMAP
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if(single_mmap && ring->cq_ring_size > ring->sq_ring_size) {
+    ring->sq_ring_size = ring->cq_ring_size;
+  }
+
+  ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if(ring->sq_ring == MAP_FAILED) {
+    int error = errno;
+    close(fd);
+    return error;
+  }
+
+  if(single_mmap) {
+    ring->cq_ring = ring->sq_ring;
+  } else {
+    ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if(ring->cq_ring == MAP_FAILED) {
+      int error = errno;
+      munmap(ring->sq_ring, ring->sq_ring_size);
+      close(fd);
+      return error;
+    }
+  }
+
+  ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if(ring->sqes == MAP_FAILED) {
+    int error = errno;
+    if(!single_mmap) {
+      munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    munmap(ring->sq_ring, ring->sq_ring_size);
+    close(fd);
+    return error;
+  }
+
+  char * sq = ring->sq_ring;
+  ring->sq_head = (uint32_t *)(sq + params.sq_off.head);
+  ring->sq_tail = (uint32_t *)(sq + params.sq_off.tail);
+  ring->sq_mask = *(uint32_t *)(sq + params.sq_off.ring_mask);
+  ring->sq_array = (uint32_t *)(sq + params.sq_off.array);
+
+  char * cq = ring->cq_ring;
+  ring->cq_head = (uint32_t *)(cq + params.cq_off.head);
+  ring->cq_tail = (uint32_t *)(cq + params.cq_off.tail);
+  ring->cq_mask = *(uint32_t *)(cq + params.cq_off.ring_mask);
+  ring->cqes = cq + params.cq_off.cqes;
+
+  return 0;
+}
+
+static void _aio_ring_destroy(_AioRing * ring) {
+  munmap(ring->sqes, ring->sqes_size);
+  if(ring->cq_ring != ring->sq_ring) {
+    munmap(ring->cq_ring, ring->cq_ring_size);
+  }
+  munmap(ring->sq_ring, ring->sq_ring_size);
+  close(ring->fd);
+}
+
+/* Put request into submission ring. Kernel sees it after io_uring_enter(). */
+static void _aio_ring_queue(_AioRing * ring, const _AioRequest * request, uint32_t slot) {
+  uint32_t tail = *ring->sq_tail;
+  uint32_t index = tail & ring->sq_mask;
+  struct io_uring_sqe * sqe = &((struct io_uring_sqe *)ring->sqes)[index];
+
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = request->is_write ? IORING_OP_WRITE : IORING_OP_READ;
+  sqe->fd = request->fd;
+  sqe->off = request->offset;
+  sqe->addr = (uint64_t)(uintptr_t)request->buf;
+  sqe->len = (uint32_t)request->length;
+  sqe->user_data = slot;
+
+  ring->sq_array[index] = index;
+  // Entry must be visible before new tail
+  __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/* Submit queued entries and optionally wait for one completion. Return number of submitted entries. */
+static size_t _aio_ring_enter(_AioRing * ring, size_t to_submit, bool wait) {
+  for(;;) {
+    int result = _aio_io_uring_enter(ring->fd, (unsigned)to_submit, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0);
+    if(result >= 0) {
+      return (size_t)result;
+    }
+    if(errno != EINTR) {
+      // EAGAIN or EBUSY: kernel is out of resources, so entries are submitted later
+      return 0;
+    }
+  }
+}
+
+/* Move completed entries into requests and return their slots. */
+static size_t _aio_ring_reap(_AioRing * ring, _AioRequest * requests, uint32_t * slots, size_t max) {
+  uint32_t head = *ring->cq_head;
+  // Completions must be read after tail
+  uint32_t tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+  size_t count = 0;
+
+  for(; head != tail && count < max; head++) {
+    const struct io_uring_cqe * cqe = &((const struct io_uring_cqe *)ring->cqes)[head & ring->cq_mask];
+    uint32_t slot = (uint32_t)cqe->user_data;
+    requests[slot].result = cqe->res;
+    slots[count++] = slot;
+  }
+
+  // Completions must be read before kernel reuses them
+  __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+  return count;
+}
+
+//
+// Thread pool backend.
+//
+
+typedef struct _Aio_pool_s {
+  pthread_mutex_t mutex;
+  pthread_cond_t work_ready;
+  pthread_cond_t done_ready;
+  _AioRequest * requests;
+  size_t entries;
+  /** Ring of submitted slots. */
+  uint32_t * work;
+  size_t work_head;
+  size_t work_count;
+  /** Ring of completed slots. */
+  uint32_t * done;
+  size_t done_head;
+  size_t done_count;
+  bool stop;
+  pthread_t threads[AIO_THREADS];
+} _Aio_pool;
+
+static void _aio_perform(_AioRequest * request) {
+  for(;;) {
+    ssize_t result = request->is_write
+      ? pwrite(request->fd, request->buf, request->length, (off_t)request->offset)
+      : pread(request->fd, request->buf, request->length, (off_t)request->offset);
+    if(result >= 0 || errno != EINTR) {
+      request->result = result >= 0 ? result : -errno;
+      return;
+    }
+  }
+}
+
+static void * _aio_pool_worker(void * arg) {
+  _Aio_pool * pool = arg;
+
+  pthread_mutex_lock(&pool->mutex);
+  for(;;) {
+    while(pool->work_count == 0 && !pool->stop) {
+      pthread_cond_wait(&pool->work_ready, &pool->mutex);
+    }
+    if(pool->work_count == 0) {
+      break;
+    }
+
+    uint32_t slot = pool->work[pool->work_head];
+    pool->work_head = (pool->work_head + 1) % pool->entries;
+    pool->work_count--;
+
+    pthread_mutex_unlock(&pool->mutex);
+    _aio_perform(&pool->requests[slot]);
+    pthread_mutex_lock(&pool->mutex);
+
+    // Rings have room for all requests in flight, so they never overflow
+    pool->done[(pool->done_head + pool->done_count) % pool->entries] = slot;
+    pool->done_count++;
+    pthread_cond_signal(&pool->done_ready);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+
+  return NULL;
+}
+
+static _Aio_pool * _aio_pool_new(_AioRequest * requests, size_t entries) {
+  _Aio_pool * pool = mem_malloc(1, sizeof(_Aio_pool));
+
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->work_ready, NULL);
+  pthread_cond_init(&pool->done_ready, NULL);
+  pool->requests = requests;
+  pool->entries = entries;
+  pool->work = mem_malloc(entries, sizeof(uint32_t));
+  pool->work_head = pool->work_count = 0;
+  pool->done = mem_malloc(entries, sizeof(uint32_t));
+  pool->done_head = pool->done_count = 0;
+  pool->stop = false;
+
+  for(size_t i = 0; i < AIO_THREADS; i++) {
+    int error = pthread_create(&pool->threads[i], NULL, _aio_pool_worker, pool);
+    if(error != 0) {
+      aio_panic(AIO_ERROR_THREAD_CREATE, (size_t)error);
+    }
+  }
+
+  return pool;
+}
+
+static void _aio_pool_destroy(_Aio_pool * pool) {
+  pthread_mutex_lock(&pool->mutex);
+  pool->stop = true;
+  pthread_cond_broadcast(&pool->work_ready);
+  pthread_mutex_unlock(&pool->mutex);
+
+  for(size_t i = 0; i < AIO_THREADS; i++) {
+    pthread_join(pool->threads[i], NULL);
+  }
+
+  pthread_cond_destroy(&pool->done_ready);
+  pthread_cond_destroy(&pool->work_ready);
+  pthread_mutex_destroy(&pool->mutex);
+  mem_free(pool->done);
+  mem_free(pool->work);
+  mem_free(pool);
+}
+
+/* Pass slots to workers. */
+static void _aio_pool_submit(_Aio_pool * pool, const uint32_t * slots, size_t count) {
+  pthread_mutex_lock(&pool->mutex);
+  for(size_t i = 0; i < count; i++) {
+    pool->work[(pool->work_head + pool->work_count) % pool->entries] = slots[i];
+    pool->work_count++;
+  }
+  pthread_cond_broadcast(&pool->work_ready);
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+/* Take up to max completed slots, and wait for first one, when asked. */
+static size_t _aio_pool_reap(_Aio_pool * pool, uint32_t * slots, size_t max, bool wait) {
+  size_t count = 0;
+
+  pthread_mutex_lock(&pool->mutex);
+  while(wait && pool->done_count == 0) {
+    pthread_cond_wait(&pool->done_ready, &pool->mutex);
+  }
+  for(; count < max && pool->done_count > 0; count++) {
+    slots[count] = pool->done[pool->done_head];
+    pool->done_head = (pool->done_head + 1) % pool->entries;
+    pool->done_count--;
+  }
+  pthread_mutex_unlock(&pool->mutex);
+
+  return count;
+}
+
+//
+// Common part.
+//
+
+Aio aio_with_backend(size_t entries, Aio_backend backend) {
+  if(entries == 0) {
+    aio_panic(AIO_ERROR_ZERO_ENTRIES, entries);
+  }
+
+  Aio self = {
+    .backend = backend,
+    .entries = entries,
+    .requests = mem_calloc(entries, sizeof(_AioRequest)),
+    .free_slots = mem_malloc(entries, sizeof(uint32_t)),
+    .free_count = entries,
+    .pending = mem_malloc(entries, sizeof(uint32_t)),
+    .pending_count = 0,
+    .in_flight = 0,
+    .cursors = mem_malloc(entries, sizeof(_AioVecCursor)),
+    .cursor_count = 0,
+    .ring = { .fd = -1 },
+    .pool = NULL,
+  };
+
+  // Lowest slots are taken first
+  for(size_t i = 0; i < entries; i++) {
+    self.free_slots[i] = (uint32_t)(entries - 1 - i);
+  }
+
+  if(backend != AIO_BACKEND_THREADS) {
+    int error = _aio_ring_init(&self.ring, entries);
+    if(error == 0) {
+      self.backend = AIO_BACKEND_IO_URING;
+    } else if(backend == AIO_BACKEND_IO_URING) {
+      aio_panic(AIO_ERROR_IO_URING_UNAVAILABLE, (size_t)error);
+    } else {
+      self.backend = AIO_BACKEND_THREADS;
+    }
+  }
+
+  if(self.backend == AIO_BACKEND_THREADS) {
+    self.pool = _aio_pool_new(self.requests, entries);
+  }
+
+  return self;
+}
+
+void aio_destroy(Aio * self) {
+  if(self->requests == NULL) {
+    return;
+  }
+
+  // Kernel or threads can still write into buffers of requests
+  AioCompletion completions[16];
+  while(self->in_flight > 0) {
+    (void)aio_poll(self, completions, LENGTH_OF_ARRAY(completions), true);
+  }
+
+  if(self->backend == AIO_BACKEND_IO_URING) {
+    _aio_ring_destroy(&self->ring);
+  } else {
+    _aio_pool_destroy(self->pool);
+  }
+
+  mem_free(self->cursors);
+  mem_free(self->pending);
+  mem_free(self->free_slots);
+  mem_free(self->requests);
+  *self = (Aio) { .requests = NULL, .ring = { .fd = -1 } };
+}
+
+/* Take free slot and queue request. Return false, when all slots are taken. */
+static bool _aio_queue(Aio * self, const _AioRequest * request) {
+  if(self->free_count == 0) {
+    return false;
+  }
+
+  uint32_t slot = self->free_slots[--self->free_count];
+  self->requests[slot] = *request;
+  if(self->requests[slot].length > _AIO_MAX_LENGTH) {
+    // Longer request is completed partially, like read() and write() do
+    self->requests[slot].length = _AIO_MAX_LENGTH;
+  }
+
+  if(self->backend == AIO_BACKEND_IO_URING) {
+    _aio_ring_queue(&self->ring, &self->requests[slot], slot);
+  }
+  self->pending[self->pending_count++] = slot;
+  self->in_flight++;
+
+  return true;
+}
+
+static _AioVecCursor * _aio_find_cursor(Aio * self, const _Vec * vec) {
+  for(size_t i = 0; i < self->cursor_count; i++) {
+    if(self->cursors[i].vec == vec) {
+      return &self->cursors[i];
+    }
+  }
+  return NULL;
+}
+
+bool aio_read_vec(Aio * self, int fd, uint64_t offset, _Vec * vec, size_t element_size, size_t count, uint64_t user_data) {
+  if(self->free_count == 0) {
+    return false;
+  }
+
+  _AioVecCursor * cursor = _aio_find_cursor(self, vec);
+  if(cursor == NULL) {
+    // Vector can be moved only while no read into it is in flight
+    if(vec->capacity - vec->count < count) {
+      _vec_reserve(vec, element_size, count);
+    }
+    // Every cursor has read in flight, so there are no more cursors than entries
+    cursor = &self->cursors[self->cursor_count++];
+    *cursor = (_AioVecCursor) { .vec = vec, .end = vec->count, .applied = vec->count, .reads = 0, .truncated = false };
+  } else if(vec->capacity - cursor->end < count) {
+    aio_panic(AIO_ERROR_VEC_CAPACITY, count);
+  }
+
+  _AioRequest request = {
+    .is_write = false,
+    .fd = fd,
+    .offset = offset,
+    .buf = (char *)vec->data + cursor->end * element_size,
+    .length = count * element_size,
+    .vec = vec,
+    .element_size = element_size,
+    .start = cursor->end,
+    .count = count,
+    .parked = false,
+    .user_data = user_data,
+    .result = 0,
+  };
+  cursor->end += count;
+  cursor->reads++;
+
+  return _aio_queue(self, &request);
+}
+
+/* Increase count of vector by completed read, which follows applied reads. */
+static void _aio_apply_read(_AioVecCursor * cursor, const _AioRequest * request) {
+  size_t read = request->result > 0 ? (size_t)request->result / request->element_size : 0;
+
+  if(!cursor->truncated) {
+    // Bytes of partially read element are not counted
+    cursor->vec->count = request->start + read;
+    cursor->truncated = read < request->count;
+  }
+  cursor->applied = request->start + request->count;
+  cursor->reads--;
+}
+
+/* Apply completed read into vector, then parked reads, which follow it.
+ * Read, which is completed before earlier reads, is parked in its slot. */
+static void _aio_complete_read(Aio * self, uint32_t slot) {
+  _AioRequest * request = &self->requests[slot];
+  _AioVecCursor * cursor = _aio_find_cursor(self, request->vec);
+
+  if(request->start != cursor->applied) {
+    request->parked = true;
+    return;
+  }
+
+  _aio_apply_read(cursor, request);
+  self->free_slots[self->free_count++] = slot;
+
+  for(size_t i = 0; i < self->entries; i++) {
+    _AioRequest * parked = &self->requests[i];
+    if(parked->parked && parked->vec == cursor->vec && parked->start == cursor->applied) {
+      parked->parked = false;
+      _aio_apply_read(cursor, parked);
+      self->free_slots[self->free_count++] = (uint32_t)i;
+      // Start again, because parked reads are not sorted
+      i = (size_t)-1;
+    }
+  }
+
+  if(cursor->reads == 0) {
+    *cursor = self->cursors[--self->cursor_count];
+  }
+}
+
+bool aio_write_slice(Aio * self, int fd, uint64_t offset, const void * data, size_t length, uint64_t user_data) {
+  _AioRequest request = {
+    .is_write = true,
+    .fd = fd,
+    .offset = offset,
+    .buf = (void *)data,
+    .length = length,
+    .vec = NULL,
+    .element_size = 1,
+    .user_data = user_data,
+    .result = 0,
+  };
+  return _aio_queue(self, &request);
+}
+
+void aio_submit(Aio * self) {
+  if(self->pending_count == 0) {
+    return;
+  }
+
+  if(self->backend == AIO_BACKEND_IO_URING) {
+    size_t submitted = _aio_ring_enter(&self->ring, self->pending_count, false);
+    // Kernel consumes entries in order, so unsubmitted ones stay at end of queue
+    memmove(self->pending, self->pending + submitted, (self->pending_count - submitted) * sizeof(uint32_t));
+    self->pending_count -= submitted;
+  } else {
+    _aio_pool_submit(self->pool, self->pending, self->pending_count);
+    self->pending_count = 0;
+  }
+}
+
+size_t aio_poll(Aio * self, AioCompletion * completions, size_t max, bool wait) {
+  aio_submit(self);
+
+  // Nothing can complete, when nothing is submitted
+  size_t submitted = self->in_flight - self->pending_count;
+  wait = wait && submitted > 0;
+  if(max > submitted) {
+    max = submitted;
+  }
+
+  uint32_t slots[64];
+  if(max > LENGTH_OF_ARRAY(slots)) {
+    max = LENGTH_OF_ARRAY(slots);
+  }
+
+  size_t count;
+  if(self->backend == AIO_BACKEND_IO_URING) {
+    count = _aio_ring_reap(&self->ring, self->requests, slots, max);
+    if(count == 0 && wait) {
+      // Submit rest of queue and wait for completion with same syscall
+      size_t submitted_now = _aio_ring_enter(&self->ring, self->pending_count, true);
+      memmove(self->pending, self->pending + submitted_now, (self->pending_count - submitted_now) * sizeof(uint32_t));
+      self->pending_count -= submitted_now;
+      count = _aio_ring_reap(&self->ring, self->requests, slots, max);
+    }
+  } else {
+    count = _aio_pool_reap(self->pool, slots, max, wait);
+  }
+
+  for(size_t i = 0; i < count; i++) {
+    _AioRequest * request = &self->requests[slots[i]];
+    completions[i] = (AioCompletion) { .user_data = request->user_data, .result = request->result };
+
+    if(request->is_write) {
+      self->free_slots[self->free_count++] = slots[i];
+    } else {
+      _aio_complete_read(self, slots[i]);
+    }
+  }
+  self->in_flight -= count;
+
+  return count;
+}
@@ -0,0 +1,196 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#ifndef CRUST_TYPE_AIO_H_
+#define CRUST_TYPE_AIO_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "crust-mem.h"
+#include "crust-type-vec.h"
+#include "crust-type-string.h"
+
+#ifdef _CRUST_TESTS
+#include "crust-unittest.h"
+#endif
+
+enum Aio_error_codes {
+  AIO_ERROR_ZERO_ENTRIES = 1,
+  AIO_ERROR_IO_URING_UNAVAILABLE = 2,
+  AIO_ERROR_THREAD_CREATE = 3,
+  AIO_ERROR_VEC_CAPACITY = 4,
+};
+
+void aio_panic(int error_code, size_t value);
+#ifdef _CRUST_TESTS
+it(aio_panic, "must abort program using abort()") {
+  assert_abort(aio_panic(AIO_ERROR_ZERO_ENTRIES, 0), "must abort");
+  assert_abort(aio_panic(AIO_ERROR_IO_URING_UNAVAILABLE, 38), "must abort");
+  assert_abort(aio_panic(AIO_ERROR_THREAD_CREATE, 11), "must abort");
+  assert_abort(aio_panic(AIO_ERROR_VEC_CAPACITY, 100), "must abort");
+  assert_abort(aio_panic(12312, 1), "must abort");
+}
+#endif
+
+/** Implementation of asynchronous I/O. */
+typedef enum Aio_backend_e {
+  /** io_uring, when kernel supports it, or threads otherwise. */
+  AIO_BACKEND_AUTO = 0,
+  /** Linux io_uring. */
+  AIO_BACKEND_IO_URING = 1,
+  /** Pool of threads, which call blocking pread() and pwrite(). */
+  AIO_BACKEND_THREADS = 2,
+} Aio_backend;
+
+/** Number of threads of thread pool backend. */
+#define AIO_THREADS 4
+
+/** Result of finished request. */
+typedef struct {
+  /** Value, which is passed with request. */
+  uint64_t user_data;
+  /** Number of transferred bytes, or negative errno. */
+  ssize_t result;
+} AioCompletion;
+
+/** Request in flight. */
+typedef struct {
+  bool is_write;
+  int fd;
+  uint64_t offset;
+  void * buf;
+  size_t length;
+  /** Vector, which count is increased after read, or NULL. */
+  _Vec * vec;
+  size_t element_size;
+  /** Index of first element and number of elements of read into vector. */
+  size_t start;
+  size_t count;
+  /** Read is completed, but waits for earlier reads into same vector. */
+  bool parked;
+  uint64_t user_data;
+  ssize_t result;
+} _AioRequest;
+
+/** Reads in flight into one vector. */
+typedef struct {
+  _Vec * vec;
+  /** End of space, which is taken by queued reads, in elements. */
+  size_t end;
+  /** End of reads, which are applied to count of vector, in elements. */
+  size_t applied;
+  /** Number of reads, which are not applied yet. */
+  size_t reads;
+  /** Earlier read is short, so data of later reads is dropped. */
+  bool truncated;
+} _AioVecCursor;
+
+/** Submission and completion rings of io_uring, mapped into memory of process. */
+typedef struct {
+  int fd;
+  void * sq_ring;
+  size_t sq_ring_size;
+  void * cq_ring;
+  size_t cq_ring_size;
+  void * sqes;
+  size_t sqes_size;
+  uint32_t * sq_head;
+  uint32_t * sq_tail;
+  uint32_t sq_mask;
+  uint32_t * sq_array;
+  uint32_t * cq_head;
+  uint32_t * cq_tail;
+  uint32_t cq_mask;
+  void * cqes;
+} _AioRing;
+
+/**
+ * Asynchronous file reader and writer.
+ *
+ * Reads go straight into spare capacity of vectors and writes come from
+ * slices, so data is never copied. Requests are queued, then submitted in
+ * batch with single syscall by aio_submit(), and results are collected by
+ * aio_poll(). On Linux with io_uring, kernel performs requests; otherwise,
+ * pool of threads calls pread() and pwrite().
+ *
+ * At most entries requests can be in flight. Buffers of requests must not be
+ * moved or freed until requests are completed, so vector must not be
+ * modified while read into it is in flight.
+ *
+ * Several reads can be queued into same vector: each read takes space after
+ * previous one, and count of vector grows in queue order, as earlier reads
+ * complete. Vector is reserved by first read only, so capacity for all reads
+ * must be reserved before first read is queued.
+ */
+typedef struct {
+  Aio_backend backend;
+  size_t entries;
+  _AioRequest * requests;
+  /** Stack of free indexes of requests. */
+  uint32_t * free_slots;
+  size_t free_count;
+  /** Requests, which are queued, but not submitted yet. */
+  uint32_t * pending;
+  size_t pending_count;
+  /** Requests, which are queued or submitted, but not collected by aio_poll(). */
+  size_t in_flight;
+  /** Vectors with reads in flight. */
+  _AioVecCursor * cursors;
+  size_t cursor_count;
+  _AioRing ring;
+  struct _Aio_pool_s * pool;
+} Aio;
+
+/** Create asynchronous I/O with given backend for up to entries requests in flight.
+ * Panics, when io_uring is requested, but not supported by kernel. */
+WUR Aio aio_with_backend(size_t entries, Aio_backend backend);
+
+/** Create asynchronous I/O with best available backend. */
+WUR MU SI Aio aio_new(size_t entries) { return aio_with_backend(entries, AIO_BACKEND_AUTO); }
+
+/** Wait for all requests in flight, then release ring or stop threads. It's safe to call destroy() twice. */
+NN void aio_destroy(Aio * self);
+
+/** Return backend, which is used. */
+NN WUR MU SI Aio_backend aio_backend(const Aio * self) { return self->backend; }
+
+/** Return number of requests, which are queued or submitted, but not collected yet. */
+NN WUR MU SI size_t aio_in_flight(const Aio * self) { return self->in_flight; }
+
+/** Queue read of up to count elements at given offset into spare capacity of vector,
+ * after space of reads into same vector, which are in flight. When earlier reads are
+ * completed, count of vector is increased by number of whole elements read. When read
+ * is short, data of later reads into same vector is dropped.
+ * Return false, when queue is full, so aio_poll() must be called first.
+ * Panics, when vector has reads in flight and not enough spare capacity. */
+NN WUR bool aio_read_vec(Aio * self, int fd, uint64_t offset, _Vec * vec, size_t element_size, size_t count, uint64_t user_data);
+
+/** Queue read of up to length bytes at given offset to end of string. */
+NN WUR MU SI bool aio_read_string(Aio * self, int fd, uint64_t offset, String * string, size_t length, uint64_t user_data) {
+  return aio_read_vec(self, fd, offset, &string->super, sizeof(char), length, user_data);
+}
+
+/** Queue write of bytes at given offset. Return false, when queue is full. */
+WUR bool aio_write_slice(Aio * self, int fd, uint64_t offset, const void * data, size_t length, uint64_t user_data);
+
+/** Queue write of text of Str at given offset. Return false, when queue is full. */
+NN WUR MU SI bool aio_write_str(Aio * self, int fd, uint64_t offset, const Str * str, uint64_t user_data) {
+  return aio_write_slice(self, fd, offset, str_as_ptr(str), str_len(str), user_data);
+}
+
+/** Submit all queued requests with single syscall. */
+NN void aio_submit(Aio * self);
+
+/** Submit queued requests, then store up to max results of completed requests
+ * and return their number. When wait is true and no request is completed,
+ * wait for at least one, unless nothing is in flight. */
+NN size_t aio_poll(Aio * self, AioCompletion * completions, size_t max, bool wait);
+
+#endif /* CRUST_TYPE_AIO_H_ */
@@ -0,0 +1,95 @@
+#include "crust-type-bitvec.h"
+
+#include "crust-bench.h"
+
+#define BITVEC_BENCH_BITS ((size_t)1000000000)
+
+// Bit vectors of 1e9 bits (125 MB each) are filled once and shared by all samples
+static BitVec bitvec_bench_left;
+static BitVec bitvec_bench_right;
+
+static void bitvec_bench_init(void) {
+  if(bitvec_len(&bitvec_bench_left) != 0) {
+    return;
+  }
+
+  bitvec_bench_left = bitvec_zeros(BITVEC_BENCH_BITS);
+  bitvec_bench_right = bitvec_zeros(BITVEC_BENCH_BITS);
+  uint64_t * left = bitvec_as_words(&bitvec_bench_left);
+  uint64_t * right = bitvec_as_words(&bitvec_bench_right);
+  uint64_t seed = 0x9E3779B97F4A7C15ULL;
+  for(size_t i = 0; i < bitvec_words_for(BITVEC_BENCH_BITS); i++) {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    left[i] = seed;
+    right[i] = seed >> 3;
+  }
+  // Length is multiple of 64, so there are no bits above length to clear
+}
+
+bench(bitvec_count_ones_1e9, "count ones in bit vector of 1e9 bits") {
+  bitvec_bench_init();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    size_t ones = bitvec_count_ones(&bitvec_bench_left);
+    bench_do_not_optimize(&ones);
+  }
+}
+
+bench(bitvec_rank_1e9, "count ones below last bit of bit vector of 1e9 bits") {
+  bitvec_bench_init();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    size_t ones = bitvec_rank(&bitvec_bench_left, BITVEC_BENCH_BITS - 1);
+    bench_do_not_optimize(&ones);
+  }
+}
+
+bench(bitvec_select_1e9, "find position of middle one in bit vector of 1e9 bits") {
+  bitvec_bench_init();
+  size_t middle = bitvec_count_ones(&bitvec_bench_left) / 2;
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    Option_sizet position = bitvec_select(&bitvec_bench_left, middle);
+    bench_do_not_optimize(&position);
+  }
+}
+
+// Result is stored into left operand, so each sample works on result of previous one, which costs the same
+bench(bitvec_and_1e9, "AND two bit vectors of 1e9 bits in place") {
+  bitvec_bench_init();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    bitvec_and(&bitvec_bench_left, &bitvec_bench_right);
+    bench_clobber();
+  }
+}
+
+bench(bitvec_xor_1e9, "XOR two bit vectors of 1e9 bits in place") {
+  bitvec_bench_init();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    bitvec_xor(&bitvec_bench_left, &bitvec_bench_right);
+    bench_clobber();
+  }
+}
+
+bench(bitvec_and_words_1e9, "AND two bit vectors of 1e9 bits with plain loop over words, as baseline") {
+  bitvec_bench_init();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    uint64_t * left = bitvec_as_words(&bitvec_bench_left);
+    const uint64_t * right = bitvec_as_words(&bitvec_bench_right);
+    for(size_t j = 0; j < bitvec_words_for(BITVEC_BENCH_BITS); j++) {
+      left[j] &= right[j];
+    }
+    bench_clobber();
+  }
+}
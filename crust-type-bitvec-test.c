@@ -0,0 +1,101 @@
+#include "crust-type-bitvec.h"
+#include "crust-unittest.h"
+
+it(bitvec_push_get_set, "must store bits packed into words") {
+  defer(bitvec_destroy) BitVec bits = bitvec_new();
+
+  for(size_t i=0; i<200; i++) {
+    assert_equal_int(i, bitvec_push(&bits, i % 3 == 0), "bitvec_push() must return index of bit");
+  }
+
+  assert_equal_int(200, bitvec_len(&bits), "Unexpected length after bitvec_push()");
+  assert_equal_int(4, bits.super.count, "200 bits must be packed into 4 words");
+  for(size_t i=0; i<200; i++) {
+    assert_equal_int(i % 3 == 0, bitvec_get(&bits, i), "Unexpected value of bit");
+  }
+
+  assert_true(!bitvec_set(&bits, 1, true), "bitvec_set() must return previous value");
+  assert_true(bitvec_get(&bits, 1), "bitvec_set() must set bit");
+  assert_true(bitvec_set(&bits, 1, false), "bitvec_set() must return previous value");
+  assert_true(!bitvec_get(&bits, 1), "bitvec_set() must clear bit");
+
+  assert_abort((void)(0 == bitvec_get(&bits, 200)), "bitvec_get() must abort on index out of bounds");
+  assert_abort(bitvec_set(&bits, 200, true), "bitvec_set() must abort on index out of bounds");
+}
+
+it(bitvec_count_ones_rank, "must count set bits in whole vector and in prefix") {
+  defer(bitvec_destroy) BitVec bits = bitvec_zeros(1000);
+
+  for(size_t i=0; i<1000; i+=7) {
+    bitvec_set(&bits, i, true);
+  }
+
+  assert_equal_int(143, bitvec_count_ones(&bits), "Unexpected number of set bits");
+  assert_equal_int(0, bitvec_rank(&bits, 0), "Unexpected rank");
+  assert_equal_int(1, bitvec_rank(&bits, 1), "Unexpected rank");
+  assert_equal_int(10, bitvec_rank(&bits, 64), "Unexpected rank");
+  assert_equal_int(143, bitvec_rank(&bits, 1000), "Unexpected rank");
+  assert_abort((void)(0 == bitvec_rank(&bits, 1001)), "bitvec_rank() must abort on index out of bounds");
+
+  bitvec_truncate(&bits, 8);
+  assert_equal_int(2, bitvec_count_ones(&bits), "bitvec_truncate() must clear bits above length");
+}
+
+it(bitvec_find_select, "must find set bits by position and by number") {
+  defer(bitvec_destroy) BitVec bits = bitvec_zeros(300);
+
+  assert_equal_int(1, option_sizet_unwrap_or(bitvec_find_first_set(&bits), 1), "Empty vector has no set bits");
+
+  bitvec_set(&bits, 70, true);
+  bitvec_set(&bits, 130, true);
+  bitvec_set(&bits, 299, true);
+
+  assert_equal_int(70, option_sizet_unwrap(bitvec_find_first_set(&bits)), "Unexpected first set bit");
+  assert_equal_int(130, option_sizet_unwrap(bitvec_find_next_set(&bits, 71)), "Unexpected next set bit");
+  assert_equal_int(299, option_sizet_unwrap(bitvec_find_next_set(&bits, 131)), "Unexpected next set bit");
+  assert_equal_int(1, option_sizet_unwrap_or(bitvec_find_next_set(&bits, 300), 1), "No bits after end of vector");
+
+  assert_equal_int(70, option_sizet_unwrap(bitvec_select(&bits, 0)), "Unexpected 0th set bit");
+  assert_equal_int(130, option_sizet_unwrap(bitvec_select(&bits, 1)), "Unexpected 1st set bit");
+  assert_equal_int(299, option_sizet_unwrap(bitvec_select(&bits, 2)), "Unexpected 2nd set bit");
+  assert_equal_int(1, option_sizet_unwrap_or(bitvec_select(&bits, 3), 1), "Vector has only 3 set bits");
+
+  for(size_t n=0; n<3; n++) {
+    assert_equal_int(n, bitvec_rank(&bits, option_sizet_unwrap(bitvec_select(&bits, n))), "rank(select(n)) must be equal to n");
+  }
+}
+
+it(bitvec_bulk_operations, "must combine bit vectors word by word") {
+  // 1000 bits is not multiple of 256, so both vector and tail loops are used
+  defer(bitvec_destroy) BitVec a = bitvec_zeros(1000);
+  defer(bitvec_destroy) BitVec b = bitvec_zeros(1000);
+  for(size_t i=0; i<1000; i++) {
+    bitvec_set(&a, i, i % 2 == 0);
+    bitvec_set(&b, i, i % 3 == 0);
+  }
+
+  defer(bitvec_destroy) BitVec and = bitvec_zeros(1000);
+  defer(bitvec_destroy) BitVec or = bitvec_zeros(1000);
+  defer(bitvec_destroy) BitVec xor = bitvec_zeros(1000);
+  defer(bitvec_destroy) BitVec andnot = bitvec_zeros(1000);
+  bitvec_or(&and, &a);
+  bitvec_or(&or, &a);
+  bitvec_or(&xor, &a);
+  bitvec_or(&andnot, &a);
+
+  bitvec_and(&and, &b);
+  bitvec_or(&or, &b);
+  bitvec_xor(&xor, &b);
+  bitvec_andnot(&andnot, &b);
+
+  for(size_t i=0; i<1000; i++) {
+    bool x = i % 2 == 0, y = i % 3 == 0;
+    assert_equal_int(x && y, bitvec_get(&and, i), "Unexpected result of bitvec_and()");
+    assert_equal_int(x || y, bitvec_get(&or, i), "Unexpected result of bitvec_or()");
+    assert_equal_int(x != y, bitvec_get(&xor, i), "Unexpected result of bitvec_xor()");
+    assert_equal_int(x && !y, bitvec_get(&andnot, i), "Unexpected result of bitvec_andnot()");
+  }
+
+  defer(bitvec_destroy) BitVec short_bits = bitvec_zeros(10);
+  assert_abort(bitvec_and(&a, &short_bits), "must abort when length of vectors is different");
+}
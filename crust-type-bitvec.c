@@ -0,0 +1,193 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BITVEC_X86
+#endif
+
+#include "crust-cpu.h"
+#include "crust-type-bitvec.h"
+
+void bitvec_panic(int error_code, size_t value) {
+  switch(error_code) {
+    case BITVEC_ERROR_INDEX_OUT_OF_BOUNDS:
+      fprintf(stderr, "ERROR: BitVec: Index is out of bound. Index: %zu.\n", value);
+    break;
+
+    case BITVEC_ERROR_LENGTH_MISMATCH:
+      fprintf(stderr, "ERROR: BitVec: Bit vectors have different length. Length: %zu.\n", value);
+    break;
+
+    default:
+      fprintf(stderr, "ERROR: bitvec_panic(): Unknown error code: %d.\n", error_code);
+  }
+
+  abort();
+}
+
+void bitvec_truncate(BitVec * self, size_t bits) {
+  if(bits >= self->len) {
+    return;
+  }
+
+  self->len = bits;
+  self->super.count = bitvec_words_for(bits);
+
+  // Keep bits above length cleared
+  if(bits % BITVEC_WORD_BITS != 0) {
+    bitvec_as_words(self)[self->super.count - 1] &= ((uint64_t)1 << (bits % BITVEC_WORD_BITS)) - 1;
+  }
+}
+
+static size_t bitvec_popcount_generic(const uint64_t * words, size_t count) {
+  size_t ones = 0;
+  for(size_t i = 0; i < count; i++) {
+    ones += __builtin_popcountll(words[i]);
+  }
+  return ones;
+}
+
+#ifdef BITVEC_X86
+__attribute__((target("popcnt")))
+static size_t bitvec_popcount_popcnt(const uint64_t * words, size_t count) {
+  size_t ones = 0;
+  for(size_t i = 0; i < count; i++) {
+    ones += __builtin_popcountll(words[i]);
+  }
+  return ones;
+}
+#else
+#define bitvec_popcount_popcnt bitvec_popcount_generic
+#endif
+
+static size_t bitvec_popcount(const uint64_t * words, size_t count) {
+  if(cpu_has_popcnt()) {
+    return bitvec_popcount_popcnt(words, count);
+  }
+  return bitvec_popcount_generic(words, count);
+}
+
+size_t bitvec_count_ones(const BitVec * self) {
+  return bitvec_popcount(bitvec_as_words(self), self->super.count);
+}
+
+size_t bitvec_rank(const BitVec * self, size_t index) {
+  if(index > self->len) {
+    bitvec_panic(BITVEC_ERROR_INDEX_OUT_OF_BOUNDS, index);
+  }
+
+  const uint64_t * words = bitvec_as_words(self);
+  size_t ones = bitvec_popcount(words, index / BITVEC_WORD_BITS);
+
+  if(index % BITVEC_WORD_BITS != 0) {
+    uint64_t mask = ((uint64_t)1 << (index % BITVEC_WORD_BITS)) - 1;
+    ones += __builtin_popcountll(words[index / BITVEC_WORD_BITS] & mask);
+  }
+
+  return ones;
+}
+
+Option_sizet bitvec_find_next_set(const BitVec * self, size_t from) {
+  if(from >= self->len) {
+    return option_sizet_none();
+  }
+
+  const uint64_t * words = bitvec_as_words(self);
+  size_t i = from / BITVEC_WORD_BITS;
+  uint64_t word = words[i] & (~(uint64_t)0 << (from % BITVEC_WORD_BITS));
+
+  for(;;) {
+    if(word != 0) {
+      return option_sizet_some(i * BITVEC_WORD_BITS + __builtin_ctzll(word));
+    }
+    if(++i >= self->super.count) {
+      return option_sizet_none();
+    }
+    word = words[i];
+  }
+}
+
+Option_sizet bitvec_select(const BitVec * self, size_t n) {
+  const uint64_t * words = bitvec_as_words(self);
+
+  for(size_t i = 0; i < self->super.count; i++) {
+    uint64_t word = words[i];
+    size_t ones = __builtin_popcountll(word);
+
+    if(n < ones) {
+      // Clear n lowest set bits, then position of lowest remaining bit is the answer
+      for(; n > 0; n--) {
+        word &= word - 1;
+      }
+      return option_sizet_some(i * BITVEC_WORD_BITS + __builtin_ctzll(word));
+    }
+
+    n -= ones;
+  }
+
+  return option_sizet_none();
+}
+
+// Each bulk operation has scalar loop and AVX2 loop, which processes 4 words
+// at once and finishes tail with scalar code.
+#ifdef BITVEC_X86
+#define BITVEC_BULK_OP_AVX2(NAME, SCALAR_OP, AVX2_OP) \
+__attribute__((target("avx2"))) \
+static void bitvec_##NAME##_avx2(uint64_t * dst, const uint64_t * src, size_t count) { \
+  size_t i = 0; \
+  for(; i + 4 <= count; i += 4) { \
+    __m256i a = _mm256_loadu_si256((const __m256i *)(dst + i)); \
+    __m256i b = _mm256_loadu_si256((const __m256i *)(src + i)); \
+    _mm256_storeu_si256((__m256i *)(dst + i), AVX2_OP(a, b)); \
+  } \
+  for(; i < count; i++) { \
+    dst[i] = SCALAR_OP(dst[i], src[i]); \
+  } \
+}
+#else
+// AVX2 loop is never called, because cpu_has_avx2() returns false
+#define BITVEC_BULK_OP_AVX2(NAME, SCALAR_OP, AVX2_OP) \
+static void bitvec_##NAME##_avx2(uint64_t * dst, const uint64_t * src, size_t count) { \
+  bitvec_##NAME##_generic(dst, src, count); \
+}
+#endif
+
+#define BITVEC_BULK_OP(NAME, SCALAR_OP, AVX2_OP) \
+static void bitvec_##NAME##_generic(uint64_t * dst, const uint64_t * src, size_t count) { \
+  for(size_t i = 0; i < count; i++) { \
+    dst[i] = SCALAR_OP(dst[i], src[i]); \
+  } \
+} \
+\
+BITVEC_BULK_OP_AVX2(NAME, SCALAR_OP, AVX2_OP) \
+\
+void bitvec_##NAME(BitVec * self, const BitVec * other) { \
+  if(self->len != other->len) { \
+    bitvec_panic(BITVEC_ERROR_LENGTH_MISMATCH, other->len); \
+  } \
+  if(cpu_has_avx2()) { \
+    bitvec_##NAME##_avx2(bitvec_as_words(self), bitvec_as_words(other), self->super.count); \
+  } else { \
+    bitvec_##NAME##_generic(bitvec_as_words(self), bitvec_as_words(other), self->super.count); \
+  } \
+}
+
+#define BITVEC_SCALAR_AND(a, b) ((a) & (b))
+#define BITVEC_SCALAR_OR(a, b) ((a) | (b))
+#define BITVEC_SCALAR_XOR(a, b) ((a) ^ (b))
+#define BITVEC_SCALAR_ANDNOT(a, b) ((a) & ~(b))
+// _mm256_andnot_si256(x, y) computes ~x & y
+#define BITVEC_AVX2_ANDNOT(a, b) _mm256_andnot_si256((b), (a))
+
+BITVEC_BULK_OP(and, BITVEC_SCALAR_AND, _mm256_and_si256)
+BITVEC_BULK_OP(or, BITVEC_SCALAR_OR, _mm256_or_si256)
+BITVEC_BULK_OP(xor, BITVEC_SCALAR_XOR, _mm256_xor_si256)
+BITVEC_BULK_OP(andnot, BITVEC_SCALAR_ANDNOT, BITVEC_AVX2_ANDNOT)
@@ -0,0 +1,138 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#ifndef CRUST_TYPE_BITVEC_H_
+#define CRUST_TYPE_BITVEC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "crust-mem.h"
+#include "crust-type-vec.h"
+#include "crust-type-size_t.h"
+
+enum BitVec_error_codes {
+  BITVEC_ERROR_INDEX_OUT_OF_BOUNDS = 1,
+  BITVEC_ERROR_LENGTH_MISMATCH = 2,
+};
+
+void bitvec_panic(int error_code, size_t value);
+
+/** Number of bits in one word of BitVec. */
+#define BITVEC_WORD_BITS 64
+
+/**
+ * Vector of bits, packed into 64-bit words.
+ *
+ * Vec of words is stored in super, while len is number of bits. Bits above
+ * len in the last word are always zero, so whole words can be counted and
+ * combined without masking.
+ */
+typedef struct {
+  _Vec super;
+  size_t len;
+} BitVec;
+
+/** Return number of words required to hold given number of bits. */
+WUR MU SI size_t bitvec_words_for(size_t bits) { return (bits + BITVEC_WORD_BITS - 1) / BITVEC_WORD_BITS; }
+
+/** Create new empty bit vector with capacity for at least given number of bits. */
+WUR MU SI BitVec bitvec_with_capacity(size_t bits) {
+  return (BitVec) { .super = _vec_with_capacity(sizeof(uint64_t), bitvec_words_for(bits)), .len = 0 };
+}
+
+/** Create new empty bit vector. */
+WUR MU SI BitVec bitvec_new() { return bitvec_with_capacity(BITVEC_WORD_BITS); }
+
+/** Create new bit vector of given length with all bits cleared. */
+WUR MU SI BitVec bitvec_zeros(size_t bits) {
+  BitVec self = bitvec_with_capacity(bits);
+  self.super.count = bitvec_words_for(bits);
+  self.len = bits;
+  return self;
+}
+
+/** Free memory. It's safe to call destroy() twice. */
+MU SI void bitvec_destroy(BitVec * self) {
+  _vec_destroy(&self->super);
+  self->len = 0;
+}
+
+/** Return number of bits. */
+NN WUR MU SI size_t bitvec_len(const BitVec * self) { return self->len; }
+
+/** Return pointer to words of vector. */
+NN WUR MU SI uint64_t * bitvec_as_words(const BitVec * self) { return (uint64_t *)self->super.data; }
+
+/** Return bit by index. Panics if index is out of bounds. */
+NN WUR MU SI bool bitvec_get(const BitVec * self, size_t index) {
+  if(index >= self->len) {
+    bitvec_panic(BITVEC_ERROR_INDEX_OUT_OF_BOUNDS, index);
+  }
+  return (bitvec_as_words(self)[index / BITVEC_WORD_BITS] >> (index % BITVEC_WORD_BITS)) & 1;
+}
+
+/** Set or clear bit by index and return previous value. Panics if index is out of bounds. */
+NN MU SI bool bitvec_set(BitVec * self, size_t index, bool value) {
+  if(index >= self->len) {
+    bitvec_panic(BITVEC_ERROR_INDEX_OUT_OF_BOUNDS, index);
+  }
+  uint64_t * word = &bitvec_as_words(self)[index / BITVEC_WORD_BITS];
+  uint64_t mask = (uint64_t)1 << (index % BITVEC_WORD_BITS);
+  bool prev = (*word & mask) != 0;
+  *word = value ? (*word | mask) : (*word & ~mask);
+  return prev;
+}
+
+/** Append bit to end of vector and return its index. */
+NN MU SI size_t bitvec_push(BitVec * self, bool value) {
+  _Vec * super = &self->super;
+  size_t bit = self->len % BITVEC_WORD_BITS;
+
+  if(bit == 0) {
+    if(super->count == super->capacity) {
+      _vec_reserve(super, sizeof(uint64_t), 1);
+    }
+    ((uint64_t *)super->data)[super->count++] = 0;
+  }
+  ((uint64_t *)super->data)[super->count - 1] |= (uint64_t)value << bit;
+
+  return self->len++;
+}
+
+/** Shorten vector to given number of bits. Does nothing when vector is shorter already. */
+NN void bitvec_truncate(BitVec * self, size_t bits);
+
+/** Return number of set bits. Uses popcnt instruction when CPU has it. */
+NN WUR size_t bitvec_count_ones(const BitVec * self);
+
+/** Return number of set bits before given index, i.e. in range [0, index).
+ * Panics if index is greater than length. */
+NN WUR size_t bitvec_rank(const BitVec * self, size_t index);
+
+/** Return index of first set bit at or after given index, or None. */
+NN WUR Option_sizet bitvec_find_next_set(const BitVec * self, size_t from);
+
+/** Return index of first set bit, or None. */
+NN WUR MU SI Option_sizet bitvec_find_first_set(const BitVec * self) { return bitvec_find_next_set(self, 0); }
+
+/** Return index of n-th set bit, counting from 0, or None when vector has fewer set bits. */
+NN WUR Option_sizet bitvec_select(const BitVec * self, size_t n);
+
+// Bulk operations. Both vectors must have same length, or function panics.
+// Words are processed by 256 bits at once when CPU supports AVX2.
+
+/** self = self & other */
+NN void bitvec_and(BitVec * self, const BitVec * other);
+/** self = self | other */
+NN void bitvec_or(BitVec * self, const BitVec * other);
+/** self = self ^ other */
+NN void bitvec_xor(BitVec * self, const BitVec * other);
+/** self = self & ~other */
+NN void bitvec_andnot(BitVec * self, const BitVec * other);
+
+#endif /* CRUST_TYPE_BITVEC_H_ */
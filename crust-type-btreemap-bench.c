@@ -0,0 +1,129 @@
+#include "crust-type-btreemap.h"
+#include "crust-type-vec.h"
+#include "crust-type-int.h"
+
+#include "crust-bench.h"
+
+DEFINE_BTREEMAP_BY_VALUE(BTreeMap_int_int, btreemap_int_int, int, int, int)
+
+typedef struct {
+  int key;
+  int value;
+} BTreeMapBenchEntry;
+
+VEC_BY_VALUE_TEMPLATE(Vec_entry, vec_entry, BTreeMapBenchEntry)
+
+#define BTREEMAP_BENCH_KEYS 10000000
+#define BTREEMAP_BENCH_LOOKUPS 1000
+#define BTREEMAP_BENCH_RANGE 10000
+
+// Both maps hold even keys 0, 2, ..., 2*(1e7-1), so odd keys are misses.
+// They are built once and shared by all samples.
+static BTreeMap_int_int btreemap_bench_map;
+static Vec_entry btreemap_bench_vec;
+
+static void btreemap_bench_init(void) {
+  if(btreemap_int_int_len(&btreemap_bench_map) != 0) {
+    return;
+  }
+
+  btreemap_bench_vec = vec_entry_with_capacity(BTREEMAP_BENCH_KEYS);
+  for(int i = 0; i < BTREEMAP_BENCH_KEYS; i++) {
+    // Keys are inserted in scattered order, so leaves are filled as in real use, not half full after sequential splits
+    int key = (int)((long)i * 7919 % BTREEMAP_BENCH_KEYS) * 2;
+    (void)btreemap_int_int_insert(&btreemap_bench_map, key, i);
+    vec_entry_push(&btreemap_bench_vec, (BTreeMapBenchEntry) { .key = i * 2, .value = i });
+  }
+}
+
+/* Return index of first entry with key, which is not less than given key. */
+static size_t btreemap_bench_vec_lower_bound(const Vec_entry * vec, int key) {
+  const BTreeMapBenchEntry * entries = vec_entry_as_ptr(vec);
+  size_t low = 0, high = vec_entry_len(vec);
+  while(low < high) {
+    size_t mid = low + (high - low) / 2;
+    if(entries[mid].key < key) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+/* Return pseudo-random key in range of keys of maps. */
+static int btreemap_bench_key(uint32_t * seed) {
+  *seed = *seed * 1103515245u + 12345u;
+  return (int)((*seed >> 4) % (2 * BTREEMAP_BENCH_KEYS));
+}
+
+bench(btreemap_get_1e7, "B+tree: 1000 point lookups of random keys among 1e7 keys, half are misses") {
+  btreemap_bench_init();
+  uint32_t seed = 42;
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    long sum = 0;
+    for(int j = 0; j < BTREEMAP_BENCH_LOOKUPS; j++) {
+      const int * value = btreemap_int_int_get(&btreemap_bench_map, btreemap_bench_key(&seed));
+      sum += value ? *value : 0;
+    }
+    bench_do_not_optimize(&sum);
+  }
+}
+
+bench(btreemap_vec_get_1e7, "sorted Vec: 1000 binary searches of random keys among 1e7 keys, half are misses") {
+  btreemap_bench_init();
+  const BTreeMapBenchEntry * entries = vec_entry_as_ptr(&btreemap_bench_vec);
+  uint32_t seed = 42;
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    long sum = 0;
+    for(int j = 0; j < BTREEMAP_BENCH_LOOKUPS; j++) {
+      int key = btreemap_bench_key(&seed);
+      size_t pos = btreemap_bench_vec_lower_bound(&btreemap_bench_vec, key);
+      sum += pos < BTREEMAP_BENCH_KEYS && entries[pos].key == key ? entries[pos].value : 0;
+    }
+    bench_do_not_optimize(&sum);
+  }
+}
+
+bench(btreemap_range_1e7, "B+tree: scan 10000 entries from random key among 1e7 keys, leaf by leaf") {
+  btreemap_bench_init();
+  uint32_t seed = 42;
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    int start = btreemap_bench_key(&seed) % (2 * (BTREEMAP_BENCH_KEYS - BTREEMAP_BENCH_RANGE));
+    int end = start + 2 * BTREEMAP_BENCH_RANGE;
+    BTreeMap_int_int_Cursor cursor = btreemap_int_int_lower_bound(&btreemap_bench_map, start);
+    int * keys;
+    int * values;
+    size_t count;
+    long sum = 0;
+    while((count = btreemap_int_int_cursor_next_chunk(&cursor, &end, &keys, &values)) > 0) {
+      for(size_t j = 0; j < count; j++) {
+        sum += values[j];
+      }
+    }
+    bench_do_not_optimize(&sum);
+  }
+}
+
+bench(btreemap_vec_range_1e7, "sorted Vec: scan 10000 entries from random key among 1e7 keys") {
+  btreemap_bench_init();
+  const BTreeMapBenchEntry * entries = vec_entry_as_ptr(&btreemap_bench_vec);
+  uint32_t seed = 42;
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    int start = btreemap_bench_key(&seed) % (2 * (BTREEMAP_BENCH_KEYS - BTREEMAP_BENCH_RANGE));
+    int end = start + 2 * BTREEMAP_BENCH_RANGE;
+    long sum = 0;
+    for(size_t pos = btreemap_bench_vec_lower_bound(&btreemap_bench_vec, start); pos < BTREEMAP_BENCH_KEYS && entries[pos].key < end; pos++) {
+      sum += entries[pos].value;
+    }
+    bench_do_not_optimize(&sum);
+  }
+}
@@ -0,0 +1,171 @@
+#include "crust-type-btreemap.h"
+#include "crust-type-int.h"
+#include "crust-type-ccharp.h"
+#include "crust-type-slice.h"
+#include "crust-unittest.h"
+
+DEFINE_BTREEMAP_BY_VALUE(BTreeMap_int_int, btreemap_int_int, int, int, int)
+DEFINE_SLICE_BY_VALUE_TEMPLATE(Slice_int, slice_int, int, int)
+BTREEMAP_TO_SLICE(BTreeMap_int_int, btreemap_int_int, int, int, Slice_int, slice_int, Slice_int, slice_int)
+DEFINE_BTREEMAP_BY_VALUE(BTreeMap_ccharp_int, btreemap_ccharp_int, const char *, ccharp, int)
+
+#define BTREEMAP_TEST_KEYS 20000
+
+// Keys are inserted in pseudo-random order: 7919 is prime, so i*7919 % N visits every key once
+static int btreemap_test_key(int i) { return (int)((long)i * 7919 % BTREEMAP_TEST_KEYS); }
+
+it(btreemap_int_int_insert_get, "must insert keys in any order and find them") {
+  defer(btreemap_int_int_destroy) BTreeMap_int_int map = btreemap_int_int_new();
+
+  assert_true(btreemap_int_int_get(&map, 1) == NULL, "Empty map must not contain keys");
+
+  for(int i=0; i<BTREEMAP_TEST_KEYS; i++) {
+    int key = btreemap_test_key(i);
+    assert_true(btreemap_int_int_insert(&map, key, key*2), "btreemap_int_int_insert() must return true for new key");
+  }
+  assert_equal_int(BTREEMAP_TEST_KEYS, btreemap_int_int_len(&map), "Unexpected length of map");
+  assert_true(map.height >= 2, "Tree must have inner nodes");
+
+  for(int key=0; key<BTREEMAP_TEST_KEYS; key++) {
+    const int * value = btreemap_int_int_get(&map, key);
+    assert_true(value != NULL, "Inserted key must be found");
+    assert_equal_int(key*2, *value, "Unexpected value for key");
+  }
+  assert_true(!btreemap_int_int_contains_key(&map, -1), "Map must not contain key, which is not inserted");
+  assert_true(!btreemap_int_int_contains_key(&map, BTREEMAP_TEST_KEYS), "Map must not contain key, which is not inserted");
+
+  assert_true(!btreemap_int_int_insert(&map, 5, 42), "btreemap_int_int_insert() must return false for existing key");
+  assert_equal_int(42, *btreemap_int_int_get(&map, 5), "Value of existing key must be replaced");
+  *btreemap_int_int_get_mut(&map, 6) = 53;
+  assert_equal_int(53, *btreemap_int_int_get(&map, 6), "Value must be changed through pointer");
+}
+
+it(btreemap_int_int_cursor, "must iterate keys in order from lower bound") {
+  defer(btreemap_int_int_destroy) BTreeMap_int_int map = btreemap_int_int_new();
+  for(int i=0; i<BTREEMAP_TEST_KEYS; i++) {
+    (void)btreemap_int_int_insert(&map, btreemap_test_key(i) * 2, i);
+  }
+
+  int expected = 0;
+  for(BTreeMap_int_int_Cursor c = btreemap_int_int_first(&map); btreemap_int_int_cursor_is_valid(&c); btreemap_int_int_cursor_next(&c)) {
+    assert_equal_int(expected, btreemap_int_int_cursor_key(&c), "Keys must be visited in order");
+    expected += 2;
+  }
+  assert_equal_int(BTREEMAP_TEST_KEYS * 2, expected, "All keys must be visited");
+
+  BTreeMap_int_int_Cursor c = btreemap_int_int_lower_bound(&map, 101);
+  assert_equal_int(102, btreemap_int_int_cursor_key(&c), "Lower bound must point to first key not less than given key");
+  c = btreemap_int_int_lower_bound(&map, 102);
+  assert_equal_int(102, btreemap_int_int_cursor_key(&c), "Lower bound must point to equal key");
+  c = btreemap_int_int_lower_bound(&map, BTREEMAP_TEST_KEYS * 2);
+  assert_true(!btreemap_int_int_cursor_is_valid(&c), "Lower bound of key after last one must be at end");
+  assert_abort((void)(0 == btreemap_int_int_cursor_key(&c)), "btreemap_int_int_cursor_key() must abort at end");
+}
+
+it(btreemap_int_int_range_next, "must return range as slices of leaf entries") {
+  defer(btreemap_int_int_destroy) BTreeMap_int_int map = btreemap_int_int_new();
+  for(int i=0; i<BTREEMAP_TEST_KEYS; i++) {
+    int key = btreemap_test_key(i);
+    (void)btreemap_int_int_insert(&map, key, -key);
+  }
+
+  int end = 15000;
+  size_t chunks = 0;
+  int expected = 1000;
+  BTreeMap_int_int_Cursor c = btreemap_int_int_lower_bound(&map, 1000);
+  Slice_int keys, values;
+  while(btreemap_int_int_range_next(&c, &end, &keys, &values)) {
+    chunks++;
+    for(size_t i=0; i<slice_int_len(&keys); i++) {
+      assert_equal_int(expected, slice_int_get(&keys, i), "Keys in range must be visited in order");
+      assert_equal_int(-expected, slice_int_get(&values, i), "Values must match keys");
+      expected++;
+    }
+  }
+  assert_equal_int(15000, expected, "Range must stop before end key");
+  assert_true(chunks > 1 && chunks < 14000 / 8, "Range must be returned in chunks of whole leaves");
+}
+
+it(btreemap_int_int_remove, "must remove keys and keep order of rest") {
+  defer(btreemap_int_int_destroy) BTreeMap_int_int map = btreemap_int_int_new();
+  for(int i=0; i<BTREEMAP_TEST_KEYS; i++) {
+    int key = btreemap_test_key(i);
+    (void)btreemap_int_int_insert(&map, key, key);
+  }
+
+  // Remove all keys, except every 100th one, so leaves are merged
+  for(int key=0; key<BTREEMAP_TEST_KEYS; key++) {
+    if(key % 100 != 0) {
+      int value = -1;
+      assert_true(btreemap_int_int_remove(&map, key, &value), "btreemap_int_int_remove() must find key");
+      assert_equal_int(key, value, "btreemap_int_int_remove() must return value of key");
+    }
+  }
+  assert_true(!btreemap_int_int_remove(&map, 1, NULL), "btreemap_int_int_remove() must return false for missing key");
+  assert_equal_int(BTREEMAP_TEST_KEYS / 100, btreemap_int_int_len(&map), "Unexpected length of map");
+
+  int expected = 0;
+  for(BTreeMap_int_int_Cursor c = btreemap_int_int_first(&map); btreemap_int_int_cursor_is_valid(&c); btreemap_int_int_cursor_next(&c)) {
+    assert_equal_int(expected, btreemap_int_int_cursor_key(&c), "Rest of keys must be visited in order");
+    expected += 100;
+  }
+  assert_equal_int(BTREEMAP_TEST_KEYS, expected, "All rest of keys must be visited");
+
+  BTreeMap_int_int_Cursor c = btreemap_int_int_lower_bound(&map, 101);
+  assert_equal_int(200, btreemap_int_int_cursor_key(&c), "Lower bound must skip removed keys");
+  assert_true(btreemap_int_int_node_count(&map) <= 2 * (BTREEMAP_TEST_KEYS / 100) / (BTreeMap_int_int_LEAF_CAPACITY / 2) + 2,
+    "Leaves must be at least half full after remove");
+
+  // Remove rest of keys in pseudo-random order, so inner nodes borrow from and merge with siblings
+  for(int i=0; i<BTREEMAP_TEST_KEYS; i++) {
+    int key = btreemap_test_key(i);
+    assert_true(btreemap_int_int_remove(&map, key, NULL) == (key % 100 == 0), "btreemap_int_int_remove() must find only rest of keys");
+  }
+  assert_equal_int(0, btreemap_int_int_len(&map), "Map must be empty");
+  assert_equal_int(0, btreemap_int_int_node_count(&map), "Empty map must have no nodes");
+  assert_true(btreemap_int_int_insert(&map, 1, 1), "Empty map must be usable after remove");
+}
+
+#define BTREEMAP_TEST_WINDOW 1000
+
+it(btreemap_int_int_sliding_window, "must free nodes, when old keys are removed while new keys are inserted") {
+  defer(btreemap_int_int_destroy) BTreeMap_int_int map = btreemap_int_int_new();
+  size_t max_nodes = 0;
+
+  for(int key=0; key<1000000; key++) {
+    (void)btreemap_int_int_insert(&map, key, key);
+    if(key >= BTREEMAP_TEST_WINDOW) {
+      assert_true(btreemap_int_int_remove(&map, key - BTREEMAP_TEST_WINDOW, NULL), "btreemap_int_int_remove() must find oldest key");
+    }
+    if(key % 10000 == 0) {
+      size_t nodes = btreemap_int_int_node_count(&map);
+      max_nodes = nodes > max_nodes ? nodes : max_nodes;
+    }
+  }
+
+  assert_equal_int(BTREEMAP_TEST_WINDOW, btreemap_int_int_len(&map), "Map must contain window of keys only");
+  // Leaves are at least half full, and inner nodes add less than a leaf per leaf
+  assert_true(max_nodes <= 2 * (2 * BTREEMAP_TEST_WINDOW / (BTreeMap_int_int_LEAF_CAPACITY / 2) + 1),
+    "Number of nodes must follow number of live keys, not number of inserted keys");
+
+  int expected = 1000000 - BTREEMAP_TEST_WINDOW;
+  for(BTreeMap_int_int_Cursor c = btreemap_int_int_first(&map); btreemap_int_int_cursor_is_valid(&c); btreemap_int_int_cursor_next(&c)) {
+    assert_equal_int(expected, btreemap_int_int_cursor_key(&c), "Keys of window must be visited in order");
+    expected++;
+  }
+  assert_equal_int(1000000, expected, "All keys of window must be visited");
+}
+
+it(btreemap_ccharp_int, "must order string keys by strcmp()") {
+  defer(btreemap_ccharp_int_destroy) BTreeMap_ccharp_int map = btreemap_ccharp_int_new();
+  (void)btreemap_ccharp_int_insert(&map, "pear", 3);
+  (void)btreemap_ccharp_int_insert(&map, "apple", 1);
+  (void)btreemap_ccharp_int_insert(&map, "orange", 2);
+
+  BTreeMap_ccharp_int_Cursor c = btreemap_ccharp_int_first(&map);
+  assert_equal_charp("apple", btreemap_ccharp_int_cursor_key(&c), "Unexpected order of keys");
+  btreemap_ccharp_int_cursor_next(&c);
+  assert_equal_charp("orange", btreemap_ccharp_int_cursor_key(&c), "Unexpected order of keys");
+  btreemap_ccharp_int_cursor_next(&c);
+  assert_equal_charp("pear", btreemap_ccharp_int_cursor_key(&c), "Unexpected order of keys");
+}
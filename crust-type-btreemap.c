@@ -0,0 +1,28 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "crust-type-btreemap.h"
+
+void _btreemap_panic(int error_code, size_t value) {
+  switch(error_code) {
+    case _BTREEMAP_ERROR_CURSOR_AT_END:
+      fprintf(stderr, "ERROR: BTreeMap: Cursor is at end of map. Position: %zu.\n", value);
+    break;
+
+    case _BTREEMAP_ERROR_TOO_HIGH:
+      fprintf(stderr, "ERROR: BTreeMap: Tree is too high. Height: %zu.\n", value);
+    break;
+
+    default:
+      fprintf(stderr, "ERROR: _btreemap_panic(): Unknown error code: %d.\n", error_code);
+  }
+
+  abort();
+}
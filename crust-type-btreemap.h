@@ -0,0 +1,593 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#ifndef CRUST_TYPE_BTREEMAP_H_
+#define CRUST_TYPE_BTREEMAP_H_
+
+#include <sys/types.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "crust-mem.h"
+
+#ifdef _CRUST_TESTS
+#include "crust-unittest.h"
+#endif
+
+enum _BTreeMap_error_codes {
+  _BTREEMAP_ERROR_CURSOR_AT_END = 1,
+  _BTREEMAP_ERROR_TOO_HIGH = 2,
+};
+
+void _btreemap_panic(int error_code, size_t value);
+#ifdef _CRUST_TESTS
+it(_btreemap_panic, "must abort program using abort()") {
+  assert_abort(_btreemap_panic(_BTREEMAP_ERROR_CURSOR_AT_END, 1), "must abort");
+  assert_abort(_btreemap_panic(_BTREEMAP_ERROR_TOO_HIGH, 1), "must abort");
+  assert_abort(_btreemap_panic(12312, 1), "must abort");
+}
+#endif
+
+/** Size of node in bytes: 8 cache lines. Wide nodes keep tree shallow, while binary search in node touches few lines. */
+#define _BTREEMAP_NODE_BYTES 512
+#define _BTREEMAP_NODE_HEADER_BYTES 16
+
+/** Return number of entries of given size, which fit into node, but not less than 4. */
+#define _BTREEMAP_NODE_CAPACITY(ENTRY_SIZE) \
+  ((_BTREEMAP_NODE_BYTES - _BTREEMAP_NODE_HEADER_BYTES) / (ENTRY_SIZE) > 4 ? (_BTREEMAP_NODE_BYTES - _BTREEMAP_NODE_HEADER_BYTES) / (ENTRY_SIZE) : 4)
+
+/** Maximal height of tree. Inner nodes, except root, have at least 3 children, so 3^40 keys will not fit into memory. */
+#define _BTREEMAP_MAX_HEIGHT 40
+
+//
+// Template for BTreeMap
+//
+// B+tree: entries are stored in leaves only, leaves are linked into list in
+// order of keys, and inner nodes hold separator keys and pointers to
+// children. Separator at keys[i] of inner node is less than or equal to all
+// keys in children[i+1], and greater than all keys in children[i].
+//
+// Keys are compared with KPREFIX##_cmp(), which returns negative value,
+// 0, or positive value.
+//
+// Every node, except root, is at least half full: on remove, node, which
+// becomes less than half full, borrows entry from sibling, or is merged
+// with it and freed. Root with single child is removed, so memory usage
+// follows current number of entries, not peak.
+//
+
+#define DEFINE_BTREEMAP_STRUCT(SELFNAME, KTYPE, VTYPE) \
+enum { \
+  SELFNAME##_LEAF_CAPACITY = _BTREEMAP_NODE_CAPACITY(sizeof(KTYPE) + sizeof(VTYPE)), \
+  SELFNAME##_INNER_CAPACITY = _BTREEMAP_NODE_CAPACITY(sizeof(KTYPE) + sizeof(void *)), \
+}; \
+\
+typedef struct SELFNAME##_Leaf_s { \
+  size_t count; \
+  struct SELFNAME##_Leaf_s * next; \
+  KTYPE keys[SELFNAME##_LEAF_CAPACITY]; \
+  VTYPE values[SELFNAME##_LEAF_CAPACITY]; \
+} SELFNAME##_Leaf; \
+\
+typedef struct { \
+  size_t count; \
+  void * children[SELFNAME##_INNER_CAPACITY + 1]; \
+  KTYPE keys[SELFNAME##_INNER_CAPACITY]; \
+} SELFNAME##_Inner; \
+\
+/** Position of entry in tree. Cursor is valid until tree is changed. */ \
+typedef struct { \
+  SELFNAME##_Leaf * leaf; \
+  size_t pos; \
+} SELFNAME##_Cursor; \
+\
+typedef struct { \
+  void * root; \
+  size_t height; \
+  size_t count; \
+} SELFNAME;
+
+#define DEFINE_BTREEMAP_NEW(SELFNAME, SELFPREFIX) \
+/** Create new empty map. No memory is allocated. */ \
+WUR MU SI SELFNAME SELFPREFIX##_new() { return (SELFNAME) { .root = NULL, .height = 0, .count = 0 }; } \
+\
+/** Return number of entries. */ \
+NN WUR MU SI size_t SELFPREFIX##_len(const SELFNAME * self) { return self->count; }
+
+#define DEFINE_BTREEMAP_DESTROY(SELFNAME, SELFPREFIX) \
+MU static void SELFPREFIX##_destroy_node(void * node, size_t height) { \
+  if(height > 0) { \
+    SELFNAME##_Inner * inner = node; \
+    for(size_t i = 0; i <= inner->count; i++) { \
+      SELFPREFIX##_destroy_node(inner->children[i], height - 1); \
+    } \
+  } \
+  mem_free(node); \
+} \
+\
+/** Free memory. It's safe to call destroy() twice. */ \
+MU SI void SELFPREFIX##_destroy(SELFNAME * self) { \
+  if(self->root) { \
+    SELFPREFIX##_destroy_node(self->root, self->height); \
+  } \
+  *self = SELFPREFIX##_new(); \
+}
+
+#define DEFINE_BTREEMAP_SEARCH(SELFNAME, SELFPREFIX, KTYPE, KPREFIX) \
+/** Return index of first key, which is greater than (upper == true) or not less than (upper == false) given key. */ \
+NN WUR MU SI size_t SELFPREFIX##_search(KTYPE * keys, size_t count, KTYPE * key, bool upper) { \
+  size_t low = 0, high = count; \
+  while(low < high) { \
+    size_t mid = low + (high - low) / 2; \
+    int cmp = KPREFIX##_cmp(&keys[mid], key); \
+    if(cmp < 0 || (upper && cmp == 0)) { \
+      low = mid + 1; \
+    } else { \
+      high = mid; \
+    } \
+  } \
+  return low; \
+} \
+\
+/** Return leaf, which can contain given key. Tree must not be empty. */ \
+NN WUR MU SI SELFNAME##_Leaf * SELFPREFIX##_find_leaf(const SELFNAME * self, KTYPE * key) { \
+  void * node = self->root; \
+  for(size_t level = self->height; level > 0; level--) { \
+    SELFNAME##_Inner * inner = node; \
+    node = inner->children[SELFPREFIX##_search(inner->keys, inner->count, key, true)]; \
+  } \
+  return node; \
+}
+
+#define DEFINE_BTREEMAP_GET_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX, VTYPE) \
+/** Return pointer to value for given key, or NULL when key is not found. \
+ * Pointer is valid until map is changed. */ \
+NN WUR MU SI VTYPE * SELFPREFIX##_get_mut(const SELFNAME * self, KTYPE key) { \
+  if(!self->root) { \
+    return NULL; \
+  } \
+  SELFNAME##_Leaf * leaf = SELFPREFIX##_find_leaf(self, &key); \
+  size_t pos = SELFPREFIX##_search(leaf->keys, leaf->count, &key, false); \
+  if(pos < leaf->count && KPREFIX##_cmp(&leaf->keys[pos], &key) == 0) { \
+    return &leaf->values[pos]; \
+  } \
+  return NULL; \
+} \
+\
+/** Return pointer to value for given key, or NULL when key is not found. */ \
+NN WUR MU SI const VTYPE * SELFPREFIX##_get(const SELFNAME * self, KTYPE key) { return SELFPREFIX##_get_mut(self, key); } \
+\
+/** Return true when map contains given key. */ \
+NN WUR MU SI bool SELFPREFIX##_contains_key(const SELFNAME * self, KTYPE key) { return SELFPREFIX##_get_mut(self, key) != NULL; }
+
+#define DEFINE_BTREEMAP_INSERT_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX, VTYPE) \
+/** Insert separator and right child into inner node, which has room for them. */ \
+NN MU SI void SELFPREFIX##_inner_insert_at(SELFNAME##_Inner * inner, size_t pos, KTYPE key, void * child) { \
+  memmove(&inner->keys[pos + 1], &inner->keys[pos], (inner->count - pos) * sizeof(KTYPE)); \
+  memmove(&inner->children[pos + 2], &inner->children[pos + 1], (inner->count - pos) * sizeof(void *)); \
+  inner->keys[pos] = key; \
+  inner->children[pos + 1] = child; \
+  inner->count++; \
+} \
+\
+/** Insert entry into leaf, which has room for it. */ \
+NN MU SI void SELFPREFIX##_leaf_insert_at(SELFNAME##_Leaf * leaf, size_t pos, KTYPE key, VTYPE value) { \
+  memmove(&leaf->keys[pos + 1], &leaf->keys[pos], (leaf->count - pos) * sizeof(KTYPE)); \
+  memmove(&leaf->values[pos + 1], &leaf->values[pos], (leaf->count - pos) * sizeof(VTYPE)); \
+  leaf->keys[pos] = key; \
+  leaf->values[pos] = value; \
+  leaf->count++; \
+} \
+\
+/** Split full leaf in half while inserting entry. Return new right leaf. */ \
+NN MU static SELFNAME##_Leaf * SELFPREFIX##_leaf_split(SELFNAME##_Leaf * leaf, size_t pos, KTYPE key, VTYPE value) { \
+  SELFNAME##_Leaf * right = mem_malloc(1, sizeof(SELFNAME##_Leaf)); \
+  size_t half = (SELFNAME##_LEAF_CAPACITY + 1) / 2; \
+  /* Left leaf keeps half of entries, including new one */ \
+  size_t split = pos < half ? half - 1 : half; \
+ \
+  right->count = SELFNAME##_LEAF_CAPACITY - split; \
+  memcpy(right->keys, &leaf->keys[split], right->count * sizeof(KTYPE)); \
+  memcpy(right->values, &leaf->values[split], right->count * sizeof(VTYPE)); \
+  leaf->count = split; \
+ \
+  if(pos < half) { \
+    SELFPREFIX##_leaf_insert_at(leaf, pos, key, value); \
+  } else { \
+    SELFPREFIX##_leaf_insert_at(right, pos - split, key, value); \
+  } \
+ \
+  right->next = leaf->next; \
+  leaf->next = right; \
+  return right; \
+} \
+\
+/** Split full inner node while inserting separator and child. \
+ * Return new right node and store separator, which must go to parent, into key. */ \
+NN MU static SELFNAME##_Inner * SELFPREFIX##_inner_split(SELFNAME##_Inner * inner, size_t pos, KTYPE * key, void * child) { \
+  KTYPE keys[SELFNAME##_INNER_CAPACITY + 1]; \
+  void * children[SELFNAME##_INNER_CAPACITY + 2]; \
+  size_t count = SELFNAME##_INNER_CAPACITY; \
+ \
+  memcpy(keys, inner->keys, pos * sizeof(KTYPE)); \
+  keys[pos] = *key; \
+  memcpy(&keys[pos + 1], &inner->keys[pos], (count - pos) * sizeof(KTYPE)); \
+  memcpy(children, inner->children, (pos + 1) * sizeof(void *)); \
+  children[pos + 1] = child; \
+  memcpy(&children[pos + 2], &inner->children[pos + 1], (count - pos) * sizeof(void *)); \
+ \
+  /* Middle key goes up, left and right halves stay */ \
+  size_t mid = (count + 1) / 2; \
+  SELFNAME##_Inner * right = mem_malloc(1, sizeof(SELFNAME##_Inner)); \
+  right->count = count - mid; \
+  memcpy(right->keys, &keys[mid + 1], right->count * sizeof(KTYPE)); \
+  memcpy(right->children, &children[mid + 1], (right->count + 1) * sizeof(void *)); \
+ \
+  inner->count = mid; \
+  memcpy(inner->keys, keys, mid * sizeof(KTYPE)); \
+  memcpy(inner->children, children, (mid + 1) * sizeof(void *)); \
+ \
+  *key = keys[mid]; \
+  return right; \
+} \
+\
+/** Insert key and value. Return true when key is new, or false when value of existing key is replaced. */ \
+NN MU static bool SELFPREFIX##_insert(SELFNAME * self, KTYPE key, VTYPE value) { \
+  if(!self->root) { \
+    SELFNAME##_Leaf * leaf = mem_malloc(1, sizeof(SELFNAME##_Leaf)); \
+    leaf->count = 0; \
+    leaf->next = NULL; \
+    self->root = leaf; \
+    self->height = 0; \
+  } \
+ \
+  /* Remember path from root to leaf, so splits can go up */ \
+  SELFNAME##_Inner * path[_BTREEMAP_MAX_HEIGHT]; \
+  size_t slots[_BTREEMAP_MAX_HEIGHT]; \
+  void * node = self->root; \
+  for(size_t level = self->height; level > 0; level--) { \
+    SELFNAME##_Inner * inner = node; \
+    size_t slot = SELFPREFIX##_search(inner->keys, inner->count, &key, true); \
+    path[level - 1] = inner; \
+    slots[level - 1] = slot; \
+    node = inner->children[slot]; \
+  } \
+ \
+  SELFNAME##_Leaf * leaf = node; \
+  size_t pos = SELFPREFIX##_search(leaf->keys, leaf->count, &key, false); \
+  if(pos < leaf->count && KPREFIX##_cmp(&leaf->keys[pos], &key) == 0) { \
+    leaf->values[pos] = value; \
+    return false; \
+  } \
+ \
+  self->count++; \
+  if(leaf->count < SELFNAME##_LEAF_CAPACITY) { \
+    SELFPREFIX##_leaf_insert_at(leaf, pos, key, value); \
+    return true; \
+  } \
+ \
+  SELFNAME##_Leaf * right_leaf = SELFPREFIX##_leaf_split(leaf, pos, key, value); \
+  KTYPE separator = right_leaf->keys[0]; \
+  void * child = right_leaf; \
+ \
+  for(size_t level = 0; level < self->height; level++) { \
+    SELFNAME##_Inner * inner = path[level]; \
+    if(inner->count < SELFNAME##_INNER_CAPACITY) { \
+      SELFPREFIX##_inner_insert_at(inner, slots[level], separator, child); \
+      return true; \
+    } \
+    child = SELFPREFIX##_inner_split(inner, slots[level], &separator, child); \
+  } \
+ \
+  /* Root is split, so tree grows up */ \
+  if(self->height + 1 >= _BTREEMAP_MAX_HEIGHT) { \
+    _btreemap_panic(_BTREEMAP_ERROR_TOO_HIGH, self->height); \
+  } \
+  SELFNAME##_Inner * root = mem_malloc(1, sizeof(SELFNAME##_Inner)); \
+  root->count = 1; \
+  root->keys[0] = separator; \
+  root->children[0] = self->root; \
+  root->children[1] = child; \
+  self->root = root; \
+  self->height++; \
+  return true; \
+}
+
+#define DEFINE_BTREEMAP_REMOVE_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX, VTYPE) \
+/** Remove separator at pos and child on the right of it from inner node. */ \
+NN MU SI void SELFPREFIX##_inner_remove_at(SELFNAME##_Inner * inner, size_t pos) { \
+  memmove(&inner->keys[pos], &inner->keys[pos + 1], (inner->count - pos - 1) * sizeof(KTYPE)); \
+  memmove(&inner->children[pos + 1], &inner->children[pos + 2], (inner->count - pos - 1) * sizeof(void *)); \
+  inner->count--; \
+} \
+\
+/** Move all entries of right leaf into left leaf, unlink right leaf from list and free it. */ \
+NN MU SI void SELFPREFIX##_leaf_merge(SELFNAME##_Leaf * left, SELFNAME##_Leaf * right) { \
+  memcpy(&left->keys[left->count], right->keys, right->count * sizeof(KTYPE)); \
+  memcpy(&left->values[left->count], right->values, right->count * sizeof(VTYPE)); \
+  left->count += right->count; \
+  left->next = right->next; \
+  mem_free(right); \
+} \
+\
+/** Move separator and all children of right node into left node, then free right node. */ \
+NN MU SI void SELFPREFIX##_inner_merge(SELFNAME##_Inner * left, KTYPE separator, SELFNAME##_Inner * right) { \
+  left->keys[left->count] = separator; \
+  memcpy(&left->keys[left->count + 1], right->keys, right->count * sizeof(KTYPE)); \
+  memcpy(&left->children[left->count + 1], right->children, (right->count + 1) * sizeof(void *)); \
+  left->count += right->count + 1; \
+  mem_free(right); \
+} \
+\
+/** Refill leaf at parent->children[slot], which has less than half of entries, by borrowing entry \
+ * from sibling, or merge it with sibling, when sibling has no entries to spare. \
+ * Return true, when parent lost separator and child. */ \
+NN MU static bool SELFPREFIX##_leaf_rebalance(SELFNAME##_Inner * parent, size_t slot) { \
+  SELFNAME##_Leaf * leaf = parent->children[slot]; \
+ \
+  if(slot > 0) { \
+    SELFNAME##_Leaf * left = parent->children[slot - 1]; \
+    if(left->count <= SELFNAME##_LEAF_CAPACITY / 2) { \
+      SELFPREFIX##_leaf_merge(left, leaf); \
+      SELFPREFIX##_inner_remove_at(parent, slot - 1); \
+      return true; \
+    } \
+    /* Borrow last entry of left sibling */ \
+    left->count--; \
+    SELFPREFIX##_leaf_insert_at(leaf, 0, left->keys[left->count], left->values[left->count]); \
+    parent->keys[slot - 1] = leaf->keys[0]; \
+    return false; \
+  } \
+ \
+  SELFNAME##_Leaf * right = parent->children[slot + 1]; \
+  if(right->count <= SELFNAME##_LEAF_CAPACITY / 2) { \
+    SELFPREFIX##_leaf_merge(leaf, right); \
+    SELFPREFIX##_inner_remove_at(parent, slot); \
+    return true; \
+  } \
+  /* Borrow first entry of right sibling */ \
+  SELFPREFIX##_leaf_insert_at(leaf, leaf->count, right->keys[0], right->values[0]); \
+  right->count--; \
+  memmove(right->keys, &right->keys[1], right->count * sizeof(KTYPE)); \
+  memmove(right->values, &right->values[1], right->count * sizeof(VTYPE)); \
+  parent->keys[slot] = right->keys[0]; \
+  return false; \
+} \
+\
+/** Refill inner node at parent->children[slot], which has less than half of separators, by rotating \
+ * child through parent from sibling, or merge it with sibling. Return true, when parent lost separator and child. */ \
+NN MU static bool SELFPREFIX##_inner_rebalance(SELFNAME##_Inner * parent, size_t slot) { \
+  SELFNAME##_Inner * inner = parent->children[slot]; \
+ \
+  if(slot > 0) { \
+    SELFNAME##_Inner * left = parent->children[slot - 1]; \
+    if(left->count <= SELFNAME##_INNER_CAPACITY / 2) { \
+      SELFPREFIX##_inner_merge(left, parent->keys[slot - 1], inner); \
+      SELFPREFIX##_inner_remove_at(parent, slot - 1); \
+      return true; \
+    } \
+    /* Last child of left sibling goes to the front, its separator goes up, and old separator goes down */ \
+    memmove(&inner->keys[1], inner->keys, inner->count * sizeof(KTYPE)); \
+    memmove(&inner->children[1], inner->children, (inner->count + 1) * sizeof(void *)); \
+    inner->keys[0] = parent->keys[slot - 1]; \
+    inner->children[0] = left->children[left->count]; \
+    inner->count++; \
+    parent->keys[slot - 1] = left->keys[left->count - 1]; \
+    left->count--; \
+    return false; \
+  } \
+ \
+  SELFNAME##_Inner * right = parent->children[slot + 1]; \
+  if(right->count <= SELFNAME##_INNER_CAPACITY / 2) { \
+    SELFPREFIX##_inner_merge(inner, parent->keys[slot], right); \
+    SELFPREFIX##_inner_remove_at(parent, slot); \
+    return true; \
+  } \
+  /* First child of right sibling goes to the back, its separator goes up, and old separator goes down */ \
+  inner->keys[inner->count] = parent->keys[slot]; \
+  inner->children[inner->count + 1] = right->children[0]; \
+  inner->count++; \
+  parent->keys[slot] = right->keys[0]; \
+  memmove(right->keys, &right->keys[1], (right->count - 1) * sizeof(KTYPE)); \
+  memmove(right->children, &right->children[1], right->count * sizeof(void *)); \
+  right->count--; \
+  return false; \
+} \
+\
+/** Remove key. Return true and store value into out, when out is not NULL, if key was found, or false otherwise. \
+ * Nodes, which become less than half full, borrow from or merge with sibling, so tree shrinks with number of entries. */ \
+MU static bool SELFPREFIX##_remove(SELFNAME * self, KTYPE key, VTYPE * out) { \
+  if(!self->root) { \
+    return false; \
+  } \
+ \
+  /* Remember path from root to leaf, so merges can go up */ \
+  SELFNAME##_Inner * path[_BTREEMAP_MAX_HEIGHT]; \
+  size_t slots[_BTREEMAP_MAX_HEIGHT]; \
+  void * node = self->root; \
+  for(size_t level = self->height; level > 0; level--) { \
+    SELFNAME##_Inner * inner = node; \
+    size_t slot = SELFPREFIX##_search(inner->keys, inner->count, &key, true); \
+    path[level - 1] = inner; \
+    slots[level - 1] = slot; \
+    node = inner->children[slot]; \
+  } \
+ \
+  SELFNAME##_Leaf * leaf = node; \
+  size_t pos = SELFPREFIX##_search(leaf->keys, leaf->count, &key, false); \
+  if(pos >= leaf->count || KPREFIX##_cmp(&leaf->keys[pos], &key) != 0) { \
+    return false; \
+  } \
+ \
+  if(out) { \
+    *out = leaf->values[pos]; \
+  } \
+  leaf->count--; \
+  memmove(&leaf->keys[pos], &leaf->keys[pos + 1], (leaf->count - pos) * sizeof(KTYPE)); \
+  memmove(&leaf->values[pos], &leaf->values[pos + 1], (leaf->count - pos) * sizeof(VTYPE)); \
+  self->count--; \
+ \
+  if(self->height == 0) { \
+    /* Root leaf may have any number of entries, but empty tree has no nodes */ \
+    if(leaf->count == 0) { \
+      mem_free(leaf); \
+      self->root = NULL; \
+    } \
+    return true; \
+  } \
+ \
+  if(leaf->count >= SELFNAME##_LEAF_CAPACITY / 2) { \
+    return true; \
+  } \
+ \
+  bool shrunk = SELFPREFIX##_leaf_rebalance(path[0], slots[0]); \
+  for(size_t level = 1; shrunk && level < self->height; level++) { \
+    if(path[level - 1]->count >= SELFNAME##_INNER_CAPACITY / 2) { \
+      break; \
+    } \
+    shrunk = SELFPREFIX##_inner_rebalance(path[level], slots[level]); \
+  } \
+ \
+  /* Root with single child is removed, so tree shrinks down */ \
+  SELFNAME##_Inner * root = self->root; \
+  if(root->count == 0) { \
+    self->root = root->children[0]; \
+    self->height--; \
+    mem_free(root); \
+  } \
+  return true; \
+} \
+\
+MU static size_t SELFPREFIX##_node_count_of(const void * node, size_t height) { \
+  size_t count = 1; \
+  if(height > 0) { \
+    const SELFNAME##_Inner * inner = node; \
+    for(size_t i = 0; i <= inner->count; i++) { \
+      count += SELFPREFIX##_node_count_of(inner->children[i], height - 1); \
+    } \
+  } \
+  return count; \
+} \
+\
+/** Return number of allocated nodes. Walks whole tree, so it's intended for tests and statistics. */ \
+NN WUR MU SI size_t SELFPREFIX##_node_count(const SELFNAME * self) { \
+  return self->root ? SELFPREFIX##_node_count_of(self->root, self->height) : 0; \
+}
+
+
+#define DEFINE_BTREEMAP_CURSOR(SELFNAME, SELFPREFIX, KTYPE, VTYPE) \
+/** Move cursor to next leaf, when it is past end of leaf. */ \
+MU SI SELFNAME##_Cursor SELFPREFIX##_cursor_normalize(SELFNAME##_Cursor cursor) { \
+  while(cursor.leaf && cursor.pos >= cursor.leaf->count) { \
+    cursor.leaf = cursor.leaf->next; \
+    cursor.pos = 0; \
+  } \
+  return cursor; \
+} \
+\
+/** Return cursor at first entry of map. */ \
+NN WUR MU SI SELFNAME##_Cursor SELFPREFIX##_first(const SELFNAME * self) { \
+  void * node = self->root; \
+  for(size_t level = self->height; node && level > 0; level--) { \
+    node = ((SELFNAME##_Inner *)node)->children[0]; \
+  } \
+  return SELFPREFIX##_cursor_normalize((SELFNAME##_Cursor) { .leaf = node, .pos = 0 }); \
+} \
+\
+/** Return cursor at first entry with key, which is not less than given key. */ \
+NN WUR MU SI SELFNAME##_Cursor SELFPREFIX##_lower_bound(const SELFNAME * self, KTYPE key) { \
+  if(!self->root) { \
+    return (SELFNAME##_Cursor) { .leaf = NULL, .pos = 0 }; \
+  } \
+  SELFNAME##_Leaf * leaf = SELFPREFIX##_find_leaf(self, &key); \
+  size_t pos = SELFPREFIX##_search(leaf->keys, leaf->count, &key, false); \
+  return SELFPREFIX##_cursor_normalize((SELFNAME##_Cursor) { .leaf = leaf, .pos = pos }); \
+} \
+\
+/** Return true when cursor points to entry, or false at end of map. */ \
+NN WUR MU SI bool SELFPREFIX##_cursor_is_valid(const SELFNAME##_Cursor * cursor) { return cursor->leaf != NULL; } \
+\
+/** Return key at cursor. Panics at end of map. */ \
+NN WUR MU SI KTYPE SELFPREFIX##_cursor_key(const SELFNAME##_Cursor * cursor) { \
+  if(!cursor->leaf) { \
+    _btreemap_panic(_BTREEMAP_ERROR_CURSOR_AT_END, cursor->pos); \
+  } \
+  return cursor->leaf->keys[cursor->pos]; \
+} \
+\
+/** Return pointer to value at cursor. Panics at end of map. */ \
+NN WUR MU SI VTYPE * SELFPREFIX##_cursor_value(const SELFNAME##_Cursor * cursor) { \
+  if(!cursor->leaf) { \
+    _btreemap_panic(_BTREEMAP_ERROR_CURSOR_AT_END, cursor->pos); \
+  } \
+  return &cursor->leaf->values[cursor->pos]; \
+} \
+\
+/** Move cursor to next entry. */ \
+NN MU SI void SELFPREFIX##_cursor_next(SELFNAME##_Cursor * cursor) { \
+  if(cursor->leaf) { \
+    cursor->pos++; \
+    *cursor = SELFPREFIX##_cursor_normalize(*cursor); \
+  } \
+}
+
+#define DEFINE_BTREEMAP_RANGE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX, VTYPE) \
+/** Return entries of leaf from cursor up to end key (exclusive), or to end of leaf, then move cursor to next leaf. \
+ * When end is NULL, range is not bounded. Keys and values are stored into arrays of leaf, which are valid \
+ * until map is changed. Return number of entries, or 0 at end of range. */ \
+MU SI size_t SELFPREFIX##_cursor_next_chunk(SELFNAME##_Cursor * cursor, KTYPE * end, KTYPE * * keys, VTYPE * * values) { \
+  SELFNAME##_Leaf * leaf = cursor->leaf; \
+  if(!leaf) { \
+    return 0; \
+  } \
+ \
+  size_t start = cursor->pos; \
+  size_t stop = leaf->count; \
+  /* Whole leaf is in range, when its last key is less than end */ \
+  if(end && KPREFIX##_cmp(&leaf->keys[stop - 1], end) >= 0) { \
+    stop = start + SELFPREFIX##_search(&leaf->keys[start], stop - start, end, false); \
+    cursor->leaf = NULL; \
+    cursor->pos = 0; \
+  } else { \
+    cursor->pos = stop; \
+    *cursor = SELFPREFIX##_cursor_normalize(*cursor); \
+  } \
+ \
+  *keys = &leaf->keys[start]; \
+  *values = &leaf->values[start]; \
+  return stop - start; \
+}
+
+#define DEFINE_BTREEMAP_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX, VTYPE) \
+DEFINE_BTREEMAP_STRUCT(SELFNAME, KTYPE, VTYPE) \
+DEFINE_BTREEMAP_NEW(SELFNAME, SELFPREFIX) \
+DEFINE_BTREEMAP_DESTROY(SELFNAME, SELFPREFIX) \
+DEFINE_BTREEMAP_SEARCH(SELFNAME, SELFPREFIX, KTYPE, KPREFIX) \
+DEFINE_BTREEMAP_GET_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX, VTYPE) \
+DEFINE_BTREEMAP_INSERT_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX, VTYPE) \
+DEFINE_BTREEMAP_REMOVE_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX, VTYPE) \
+DEFINE_BTREEMAP_CURSOR(SELFNAME, SELFPREFIX, KTYPE, VTYPE) \
+DEFINE_BTREEMAP_RANGE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX, VTYPE) \
+
+#define BTREEMAP_TO_SLICE(SELFNAME, SELFPREFIX, KTYPE, VTYPE, KSLICENAME, KSLICEPREFIX, VSLICENAME, VSLICEPREFIX) \
+/** Return entries of next leaf in range as slices of keys and values. No data is copied. \
+ * When end is NULL, range is not bounded. Return false at end of range. */ \
+MU SI bool SELFPREFIX##_range_next(SELFNAME##_Cursor * cursor, KTYPE * end, KSLICENAME * keys, VSLICENAME * values) { \
+  KTYPE * key_data; \
+  VTYPE * value_data; \
+  size_t count = SELFPREFIX##_cursor_next_chunk(cursor, end, &key_data, &value_data); \
+  if(count == 0) { \
+    return false; \
+  } \
+  *keys = KSLICEPREFIX##_from_raw_parts(key_data, count); \
+  *values = VSLICEPREFIX##_from_raw_parts(value_data, count); \
+  return true; \
+}
+
+#endif /* CRUST_TYPE_BTREEMAP_H_ */
@@ -0,0 +1,127 @@
+// For fileno()
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "crust-type-bufwriter.h"
+
+#include "crust-bench.h"
+
+//
+// Write 10000 log records of 100 bytes, so records per second are
+// 10000 / (ns per iteration) * 1e9. File is truncated before each iteration.
+// Pipe is drained by background thread.
+//
+
+#define BUFWRITER_BENCH_RECORDS 10000
+#define BUFWRITER_BENCH_RECORD 100
+
+static char bufwriter_bench_record[BUFWRITER_BENCH_RECORD + 1];
+static FILE * bufwriter_bench_file = NULL;
+static int bufwriter_bench_pipe[2] = { -1, -1 };
+
+static void bufwriter_bench_init_record(void) {
+  for(int i = 0; i < BUFWRITER_BENCH_RECORD - 1; i++) {
+    bufwriter_bench_record[i] = (char)('a' + i % 26);
+  }
+  bufwriter_bench_record[BUFWRITER_BENCH_RECORD - 1] = '\n';
+}
+
+static int bufwriter_bench_init_file(void) {
+  bufwriter_bench_init_record();
+  if(!bufwriter_bench_file) {
+    bufwriter_bench_file = tmpfile();
+    if(!bufwriter_bench_file) {
+      perror("ERROR: BufWriter bench: Cannot create temporary file");
+      abort();
+    }
+  }
+  return fileno(bufwriter_bench_file);
+}
+
+static void bufwriter_bench_rewind_file(int fd) {
+  if(ftruncate(fd, 0) != 0 || lseek(fd, 0, SEEK_SET) != 0) {
+    perror("ERROR: BufWriter bench: Cannot truncate temporary file");
+    abort();
+  }
+}
+
+static void * bufwriter_bench_drain(void * arg) {
+  int fd = *(int *)arg;
+  char buf[64*1024];
+  while(read(fd, buf, sizeof(buf)) > 0) {
+  }
+  return NULL;
+}
+
+static int bufwriter_bench_init_pipe(void) {
+  bufwriter_bench_init_record();
+  if(bufwriter_bench_pipe[1] < 0) {
+    pthread_t thread;
+    if(pipe(bufwriter_bench_pipe) != 0 || pthread_create(&thread, NULL, bufwriter_bench_drain, &bufwriter_bench_pipe[0]) != 0) {
+      perror("ERROR: BufWriter bench: Cannot create pipe and reader thread");
+      abort();
+    }
+    pthread_detach(thread);
+  }
+  return bufwriter_bench_pipe[1];
+}
+
+static void bufwriter_bench_write_records(int fd) {
+  defer(bufwriter_destroy) BufWriter writer = bufwriter_new(fd);
+  for(int j = 0; j < BUFWRITER_BENCH_RECORDS; j++) {
+    (void)bufwriter_write_slice(&writer, bufwriter_bench_record, BUFWRITER_BENCH_RECORD);
+  }
+  if(!bufwriter_flush(&writer)) {
+    abort();
+  }
+}
+
+static void bufwriter_bench_write_records_unbuffered(int fd) {
+  for(int j = 0; j < BUFWRITER_BENCH_RECORDS; j++) {
+    if(write(fd, bufwriter_bench_record, BUFWRITER_BENCH_RECORD) != BUFWRITER_BENCH_RECORD) {
+      abort();
+    }
+  }
+}
+
+bench(bufwriter_file, "write 10000 records of 100 bytes to file with BufWriter") {
+  int fd = bufwriter_bench_init_file();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    bufwriter_bench_rewind_file(fd);
+    bufwriter_bench_write_records(fd);
+  }
+}
+
+bench(bufwriter_write_file, "write 10000 records of 100 bytes to file with write() per record, as baseline") {
+  int fd = bufwriter_bench_init_file();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    bufwriter_bench_rewind_file(fd);
+    bufwriter_bench_write_records_unbuffered(fd);
+  }
+}
+
+bench(bufwriter_pipe, "write 10000 records of 100 bytes to pipe with BufWriter") {
+  int fd = bufwriter_bench_init_pipe();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    bufwriter_bench_write_records(fd);
+  }
+}
+
+bench(bufwriter_write_pipe, "write 10000 records of 100 bytes to pipe with write() per record, as baseline") {
+  int fd = bufwriter_bench_init_pipe();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    bufwriter_bench_write_records_unbuffered(fd);
+  }
+}
@@ -0,0 +1,113 @@
+// For fileno()
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "crust-type-array.h"
+#include "crust-type-bufwriter.h"
+#include "crust-unittest.h"
+
+/* Read whole file from start into String. */
+static String bufwriter_test_read_file(FILE * file) {
+  String text = string_new();
+  char buf[4096];
+  ssize_t n;
+
+  lseek(fileno(file), 0, SEEK_SET);
+  while((n = read(fileno(file), buf, sizeof(buf))) > 0) {
+    for(ssize_t i = 0; i < n; i++) {
+      string_put_char(&text, buf[i]);
+    }
+  }
+
+  return text;
+}
+
+it(bufwriter_write, "must buffer small writes and keep order of text") {
+  int fds[2];
+  assert_equal_int(0, pipe(fds), "pipe() must create pipe");
+
+  {
+    defer(bufwriter_destroy) BufWriter writer = bufwriter_with_capacity(fds[1], 8);
+    Str str = str_from_charp("abc");
+    defer(string_destroy) String string = string_from_charp("de");
+
+    assert_true(bufwriter_write_str(&writer, &str), "must write Str");
+    assert_true(bufwriter_write_string(&writer, &string), "must write String");
+    assert_equal_int(5, string_len(&writer.buffer), "small writes must be buffered");
+    assert_true(bufwriter_printf(&writer, "%d;", 42), "must write formatted text");
+    assert_true(bufwriter_write_slice(&writer, "0123456789", 10), "must write bytes");
+    assert_true(bufwriter_flush(&writer), "must flush");
+  }
+  close(fds[1]);
+
+  char buf[64] = { 0 };
+  assert_equal_int(18, read(fds[0], buf, sizeof(buf) - 1), "all text must be written");
+  assert_equal_charp("abcde42;0123456789", buf, "text must be written in order");
+  close(fds[0]);
+}
+
+it(bufwriter_write_vectored, "must write buffered text and pieces together") {
+  FILE * file = tmpfile();
+
+  {
+    defer(bufwriter_destroy) BufWriter writer = bufwriter_with_capacity(fileno(file), 16);
+    assert_true(bufwriter_printf(&writer, "head;"), "must write formatted text");
+
+    // More pieces than fit into single writev()
+    Str pieces[BUFWRITER_MAX_IOVECS * 2 + 3];
+    for(size_t i = 0; i < LENGTH_OF_ARRAY(pieces); i++) {
+      pieces[i] = str_from_charp(i % 2 ? "ab" : "c");
+    }
+    assert_true(bufwriter_write_vectored(&writer, pieces, LENGTH_OF_ARRAY(pieces)), "must write pieces");
+    assert_equal_int(0, string_len(&writer.buffer), "buffer must be written together with pieces");
+  }
+
+  defer(string_destroy) String text = bufwriter_test_read_file(file);
+  assert_equal_int(5 + (BUFWRITER_MAX_IOVECS + 2) * 1 + (BUFWRITER_MAX_IOVECS + 1) * 2, string_len(&text), "all text must be written");
+  string_end_with_zero(&text);
+  assert_true(strncmp(string_as_ptr(&text), "head;cabcab", 11) == 0, "text must be written in order");
+
+  fclose(file);
+}
+
+it(bufwriter_many_records, "must write many records and large pieces without loss") {
+  FILE * file = tmpfile();
+  defer(string_destroy) String expected = string_new();
+
+  {
+    defer(bufwriter_destroy) BufWriter writer = bufwriter_with_capacity(fileno(file), 100);
+    for(int i = 0; i < 10000; i++) {
+      assert_true(bufwriter_printf(&writer, "record %d\n", i), "must write record");
+      string_printf(&expected, "record %d\n", i);
+
+      if(i % 1000 == 0) {
+        // Piece larger than threshold
+        char large[300];
+        memset(large, 'x', sizeof(large));
+        assert_true(bufwriter_write_slice(&writer, large, sizeof(large)), "must write large piece");
+        for(size_t j = 0; j < sizeof(large); j++) {
+          string_put_char(&expected, 'x');
+        }
+      }
+    }
+  }
+
+  defer(string_destroy) String text = bufwriter_test_read_file(file);
+  Str left = str_from_string(&expected);
+  Str right = str_from_string(&text);
+  assert_true(str_eq(&left, &right), "file must contain all records in order");
+
+  fclose(file);
+}
+
+it(bufwriter_error, "must stop and report error of write()") {
+  defer(bufwriter_destroy) BufWriter writer = bufwriter_with_capacity(-1, 4);
+
+  assert_true(bufwriter_write_slice(&writer, "ab", 2), "small write must be buffered");
+  assert_true(!bufwriter_write_slice(&writer, "cdef", 4), "must return false when buffer cannot be written");
+  assert_true(bufwriter_error(&writer) != 0, "must report errno");
+  assert_true(!bufwriter_flush(&writer), "must ignore writes after error");
+}
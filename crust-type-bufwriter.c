@@ -0,0 +1,159 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "crust-type-bufwriter.h"
+
+BufWriter bufwriter_with_capacity(int fd, size_t capacity) {
+  if(capacity == 0) {
+    capacity = 1;
+  }
+
+  return (BufWriter) {
+    .fd = fd,
+    // Space for '\0' of printf()
+    .buffer = string_with_capacity(capacity + 1),
+    .threshold = capacity,
+    .error = 0,
+  };
+}
+
+void bufwriter_destroy(BufWriter * self) {
+  if(string_capacity(&self->buffer) > 0) {
+    (void)bufwriter_flush(self);
+  }
+  string_destroy(&self->buffer);
+}
+
+/* Write all pieces, continuing after partial writes. Pieces are modified. Return false on error. */
+static bool bufwriter_writev_all(BufWriter * self, struct iovec * iov, size_t count) {
+  // Skip empty pieces, so writev() is not called when there is nothing to write
+  while(count > 0 && iov->iov_len == 0) {
+    iov++;
+    count--;
+  }
+
+  while(count > 0) {
+    ssize_t written = writev(self->fd, iov, (int)count);
+    if(written < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      self->error = errno;
+      return false;
+    }
+
+    // Skip written pieces and adjust partially written one
+    size_t left = (size_t)written;
+    while(count > 0 && left >= iov->iov_len) {
+      left -= iov->iov_len;
+      iov++;
+      count--;
+    }
+    if(count > 0) {
+      iov->iov_base = (char *)iov->iov_base + left;
+      iov->iov_len -= left;
+    }
+  }
+
+  return true;
+}
+
+bool bufwriter_flush(BufWriter * self) {
+  if(self->error) {
+    return false;
+  }
+
+  struct iovec iov = { .iov_base = string_as_ptr(&self->buffer), .iov_len = string_len(&self->buffer) };
+  // Text is dropped on error, so writer doesn't grow without limit
+  string_set_len_unsafe(&self->buffer, 0);
+
+  return bufwriter_writev_all(self, &iov, 1);
+}
+
+bool bufwriter_write_slice(BufWriter * self, const void * data, size_t length) {
+  if(self->error) {
+    return false;
+  }
+
+  size_t len = string_len(&self->buffer);
+  if(len + length <= self->threshold) {
+    memcpy(string_as_ptr(&self->buffer) + len, data, length);
+    string_set_len_unsafe(&self->buffer, len + length);
+    if(len + length == self->threshold) {
+      return bufwriter_flush(self);
+    }
+    return true;
+  }
+
+  if(length >= self->threshold) {
+    // Large piece is written without copying, together with buffered text
+    Str piece = str_from_raw_parts(data, length);
+    return bufwriter_write_vectored(self, &piece, 1);
+  }
+
+  if(!bufwriter_flush(self)) {
+    return false;
+  }
+  memcpy(string_as_ptr(&self->buffer), data, length);
+  string_set_len_unsafe(&self->buffer, length);
+  return true;
+}
+
+bool bufwriter_vprintf(BufWriter * self, const char * fmt, va_list ap) {
+  if(self->error) {
+    return false;
+  }
+
+  // Text is printed into buffer, which can grow above threshold for single record
+  (void)string_vprintf(&self->buffer, fmt, ap);
+
+  if(string_len(&self->buffer) >= self->threshold) {
+    return bufwriter_flush(self);
+  }
+  return true;
+}
+
+bool bufwriter_printf(BufWriter * self, const char * fmt, ...) {
+  va_list ap;
+
+  va_start(ap, fmt);
+  bool result = bufwriter_vprintf(self, fmt, ap);
+  va_end(ap);
+
+  return result;
+}
+
+bool bufwriter_write_vectored(BufWriter * self, const Str * pieces, size_t count) {
+  if(self->error) {
+    return false;
+  }
+
+  struct iovec iov[BUFWRITER_MAX_IOVECS];
+  size_t n = 0;
+
+  // Buffered text goes first
+  iov[n++] = (struct iovec) { .iov_base = string_as_ptr(&self->buffer), .iov_len = string_len(&self->buffer) };
+  string_set_len_unsafe(&self->buffer, 0);
+
+  for(size_t i = 0; i < count; i++) {
+    iov[n++] = (struct iovec) { .iov_base = (void *)str_as_ptr(&pieces[i]), .iov_len = str_len(&pieces[i]) };
+
+    if(n == BUFWRITER_MAX_IOVECS) {
+      if(!bufwriter_writev_all(self, iov, n)) {
+        return false;
+      }
+      n = 0;
+    }
+  }
+
+  return bufwriter_writev_all(self, iov, n);
+}
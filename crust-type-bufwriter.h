@@ -0,0 +1,86 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#ifndef CRUST_TYPE_BUFWRITER_H_
+#define CRUST_TYPE_BUFWRITER_H_
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/uio.h>
+
+#include "crust-mem.h"
+#include "crust-type-string.h"
+
+/** Default size of buffer of writer. */
+#define BUFWRITER_DEFAULT_CAPACITY (64*1024)
+
+/** Maximum number of pieces, which are passed to single writev(). */
+#define BUFWRITER_MAX_IOVECS 64
+
+/**
+ * Buffered writer into file descriptor.
+ *
+ * Small writes are appended to String buffer, which is written with single
+ * write() when it reaches threshold, so many records cost one syscall.
+ * Pieces, which are larger than threshold, are not copied: they are
+ * written together with buffered text by single writev().
+ *
+ * Functions return false on failed write, and error is kept, so following
+ * writes are ignored. Buffered text is written by flush() or destroy().
+ */
+typedef struct {
+  int fd;
+  String buffer;
+  /** Buffer is written, when its length reaches threshold. */
+  size_t threshold;
+  /** errno of failed write, or 0. */
+  int error;
+} BufWriter;
+
+/** Create writer with buffer of given size. File descriptor is not owned by writer. */
+WUR BufWriter bufwriter_with_capacity(int fd, size_t capacity);
+
+/** Create writer with default size of buffer. */
+WUR MU SI BufWriter bufwriter_new(int fd) { return bufwriter_with_capacity(fd, BUFWRITER_DEFAULT_CAPACITY); }
+
+/** Write buffered text and free buffer. File descriptor is not closed.
+ * Call bufwriter_flush() before, to check for errors. It's safe to call destroy() twice. */
+NN void bufwriter_destroy(BufWriter * self);
+
+/** Write buffered text. Return false on error. */
+NN bool bufwriter_flush(BufWriter * self);
+
+/** Append bytes. Return false on error. */
+NN bool bufwriter_write_slice(BufWriter * self, const void * data, size_t length);
+
+/** Append text of Str. Return false on error. */
+NN MU SI bool bufwriter_write_str(BufWriter * self, const Str * str) {
+  return bufwriter_write_slice(self, str_as_ptr(str), str_len(str));
+}
+
+/** Append text of String. Return false on error. */
+NN MU SI bool bufwriter_write_string(BufWriter * self, const String * string) {
+  return bufwriter_write_slice(self, string_as_ptr(string), string_len(string));
+}
+
+/** Append formatted text. Return false on error. */
+__attribute__ ((format (printf, 2, 3)))
+bool bufwriter_printf(BufWriter * self, const char * fmt, ...);
+
+/** Same as bufwriter_printf(), but with va_list. */
+__attribute__ ((format (printf, 2, 0)))
+bool bufwriter_vprintf(BufWriter * self, const char * fmt, va_list ap);
+
+/** Write buffered text and all pieces with as few writev() calls as possible,
+ * without copying of pieces. Return false on error. */
+NN bool bufwriter_write_vectored(BufWriter * self, const Str * pieces, size_t count);
+
+/** Return errno of failed write, or 0 when no error happened. */
+NN WUR MU SI int bufwriter_error(const BufWriter * self) { return self->error; }
+
+#endif /* CRUST_TYPE_BUFWRITER_H_ */
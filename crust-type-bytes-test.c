@@ -0,0 +1,97 @@
+#include <pthread.h>
+
+#include "crust-type-bytes.h"
+#include "crust-unittest.h"
+
+it(bytes_slice, "must share data with slices and keep it alive after parent is destroyed") {
+  Bytes parent = bytes_copy_from_slice("Hello, world", 12);
+  defer(bytes_destroy) Bytes hello = bytes_slice(&parent, 0, 5);
+  defer(bytes_destroy) Bytes world = bytes_slice(&parent, 7, 5);
+
+  assert_true(bytes_as_ptr(&hello) == bytes_as_ptr(&parent), "bytes_slice() must not copy data");
+  assert_equal_int(3, parent.shared->refcount, "Every slice must hold reference to data");
+  bytes_destroy(&parent);
+  assert_equal_int(0, bytes_len(&parent), "bytes_destroy() must clear handle");
+
+  Str hello_str = bytes_as_str(&hello);
+  Str expected = str_from_charp("Hello");
+  assert_true(str_eq(&hello_str, &expected), "Slice must outlive parent");
+  assert_equal_int('w', bytes_get(&world, 0), "Unexpected byte of slice");
+
+  assert_abort((void)(0 == bytes_slice(&world, 1, 5).len), "bytes_slice() must abort when range is out of bounds");
+  assert_abort((void)(0 == bytes_get(&world, 5)), "bytes_get() must abort when index is out of bounds");
+}
+
+it(bytes_split_to, "must cut frames from front of bytes") {
+  defer(bytes_destroy) Bytes data = bytes_copy_from_slice("\x03" "abc" "\x02" "de", 7);
+
+  size_t frames = 0;
+  while(!bytes_is_empty(&data)) {
+    size_t length = (size_t)bytes_get(&data, 0);
+    Bytes header = bytes_split_to(&data, 1);
+    bytes_destroy(&header);
+    defer(bytes_destroy) Bytes frame = bytes_split_to(&data, length);
+    assert_equal_int(frames == 0 ? 3 : 2, bytes_len(&frame), "Unexpected length of frame");
+    frames++;
+  }
+  assert_equal_int(2, frames, "Unexpected number of frames");
+  assert_abort((void)(0 == bytes_split_to(&data, 1).len), "bytes_split_to() must abort when at is out of bounds");
+}
+
+it(bytes_split_off, "must split bytes into head and tail") {
+  defer(bytes_destroy) Bytes head = bytes_from_static("key=value", 9);
+  defer(bytes_destroy) Bytes tail = bytes_split_off(&head, 4);
+
+  Bytes expected_head = bytes_from_static("key=", 4);
+  Bytes expected_tail = bytes_from_static("value", 5);
+  assert_true(bytes_eq(&head, &expected_head), "Unexpected head");
+  assert_true(bytes_eq(&tail, &expected_tail), "Unexpected tail");
+  assert_true(head.shared == NULL, "Static data must not be reference counted");
+  assert_abort((void)(0 == bytes_split_off(&head, 5).len), "bytes_split_off() must abort when at is out of bounds");
+}
+
+it(bytesmut_freeze, "must turn builder into bytes without copying") {
+  defer(bytesmut_destroy) BytesMut builder = bytesmut_new();
+  bytesmut_put_slice(&builder, "id=", 3);
+  string_put_int(bytesmut_as_string(&builder), 42);
+  const char * data = string_as_ptr(bytesmut_as_string(&builder));
+
+  defer(bytes_destroy) Bytes frozen = bytesmut_freeze(&builder);
+  assert_true(bytes_as_ptr(&frozen) == data, "bytesmut_freeze() must not copy data");
+  Bytes expected = bytes_from_static("id=42", 5);
+  assert_true(bytes_eq(&frozen, &expected), "Unexpected content of frozen bytes");
+
+  assert_equal_int(0, bytesmut_len(&builder), "Builder must be empty after freeze");
+  assert_equal_int(2, bytesmut_put_slice(&builder, "ok", 2), "Builder must be reusable after freeze");
+  defer(bytes_destroy) Bytes second = bytesmut_freeze(&builder);
+  assert_true(bytes_as_ptr(&second) != data, "Second freeze must not share data with first one");
+}
+
+#define BYTES_TEST_THREADS 4
+
+static void * bytes_test_thread(void * arg) {
+  Bytes * data = arg;
+  for(size_t i=0; i<bytes_len(data); i++) {
+    Bytes slice = bytes_slice(data, i, 1);
+    bytes_destroy(&slice);
+  }
+  bytes_destroy(data);
+  return NULL;
+}
+
+it(bytes_threads, "must release data when last handle is destroyed in other thread") {
+  Bytes data = bytes_copy_from_slice("0123456789", 10);
+
+  pthread_t threads[BYTES_TEST_THREADS];
+  Bytes handles[BYTES_TEST_THREADS];
+  for(int i=0; i<BYTES_TEST_THREADS; i++) {
+    handles[i] = bytes_clone(&data);
+    pthread_create(&threads[i], NULL, bytes_test_thread, &handles[i]);
+  }
+  bytes_destroy(&data);
+
+  for(int i=0; i<BYTES_TEST_THREADS; i++) {
+    pthread_join(threads[i], NULL);
+    assert_true(handles[i].shared == NULL, "Thread must release its handle");
+  }
+}
@@ -0,0 +1,100 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "crust-type-bytes.h"
+#include "crust-mem.h"
+
+void bytes_panic(int error_code, size_t value) {
+  switch(error_code) {
+    case BYTES_ERROR_NO_DATA:
+      fprintf(stderr, "ERROR: Bytes: Pointer to data is NULL but length is not 0. Length: %zu.\n", value);
+    break;
+
+    case BYTES_ERROR_INDEX_OUT_OF_BOUNDS:
+      fprintf(stderr, "ERROR: Bytes: Index is out of bound. Index: %zu.\n", value);
+    break;
+
+    default:
+      fprintf(stderr, "ERROR: bytes_panic(): Unknown error code: %d.\n", error_code);
+  }
+
+  abort();
+}
+
+/* Wrap buffer, which is allocated with mem_malloc(), into shared allocation with single reference. */
+static Bytes bytes_from_buffer(char * buffer, size_t length) {
+  _Bytes_shared * shared = mem_malloc(1, sizeof(_Bytes_shared));
+  shared->refcount = 1;
+  shared->buffer = buffer;
+  return (Bytes) { .shared = shared, .data = buffer, .len = length };
+}
+
+Bytes bytes_copy_from_slice(const void * data, size_t length) {
+  if(data == NULL && length != 0) {
+    bytes_panic(BYTES_ERROR_NO_DATA, length);
+  }
+  if(length == 0) {
+    return bytes_new();
+  }
+
+  char * buffer = mem_malloc(length, sizeof(char));
+  memcpy(buffer, data, length);
+  return bytes_from_buffer(buffer, length);
+}
+
+Bytes bytes_from_string(String * string) {
+  if(string->super.data == NULL || string->super.count == 0) {
+    string_destroy(string);
+    return bytes_new();
+  }
+
+  size_t length = string->super.count;
+  return bytes_from_buffer(_vec_take_data(&string->super), length);
+}
+
+void bytes_destroy(Bytes * self) {
+  if(self->shared != NULL) {
+    // Release makes reads of this handle happen before buffer is freed by other thread
+    if(__atomic_sub_fetch(&self->shared->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+      mem_free(self->shared->buffer);
+      mem_free(self->shared);
+    }
+  }
+  *self = bytes_new();
+}
+
+Bytes bytes_slice(const Bytes * self, size_t start, size_t length) {
+  if(start > self->len || length > self->len - start) {
+    bytes_panic(BYTES_ERROR_INDEX_OUT_OF_BOUNDS, start + length);
+  }
+
+  Bytes slice = bytes_clone(self);
+  slice.data += start;
+  slice.len = length;
+  return slice;
+}
+
+Bytes bytes_split_to(Bytes * self, size_t at) {
+  Bytes head = bytes_slice(self, 0, at);
+  self->data += at;
+  self->len -= at;
+  return head;
+}
+
+Bytes bytes_split_off(Bytes * self, size_t at) {
+  if(at > self->len) {
+    bytes_panic(BYTES_ERROR_INDEX_OUT_OF_BOUNDS, at);
+  }
+
+  Bytes tail = bytes_slice(self, at, self->len - at);
+  self->len = at;
+  return tail;
+}
@@ -0,0 +1,166 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#ifndef CRUST_TYPE_BYTES_H_
+#define CRUST_TYPE_BYTES_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "crust-mem.h"
+#include "crust-type-string.h"
+
+#ifdef _CRUST_TESTS
+#include "crust-unittest.h"
+#endif
+
+enum Bytes_error_codes {
+  BYTES_ERROR_NO_DATA = 1,
+  BYTES_ERROR_INDEX_OUT_OF_BOUNDS = 2,
+};
+
+void bytes_panic(int error_code, size_t value);
+#ifdef _CRUST_TESTS
+it(bytes_panic, "must abort program using abort()") {
+  assert_abort(bytes_panic(BYTES_ERROR_NO_DATA, 1), "must abort");
+  assert_abort(bytes_panic(BYTES_ERROR_INDEX_OUT_OF_BOUNDS, 1), "must abort");
+  assert_abort(bytes_panic(12312, 1), "must abort");
+}
+#endif
+
+/** Allocation, which is shared by handles of Bytes. */
+typedef struct _Bytes_shared_s {
+  size_t refcount;
+  char * buffer;
+} _Bytes_shared;
+
+/**
+ * Immutable reference counted bytes.
+ *
+ * Unlike Str, Bytes owns its data: every handle holds reference to
+ * allocation, so handle can be sent to other thread or kept after handle,
+ * which it's sliced from, is destroyed. Clone and slice increment atomic
+ * reference counter and never copy bytes. Allocation is freed with last
+ * handle.
+ */
+typedef struct {
+  /** Allocation, or NULL for static data. */
+  _Bytes_shared * shared;
+  const char * data;
+  size_t len;
+} Bytes;
+
+/**
+ * Builder of Bytes.
+ *
+ * Bytes are appended to string, so all string_put_*() and string_printf()
+ * functions can be used via bytesmut_as_string(). When message is complete,
+ * bytesmut_freeze() turns buffer into Bytes without copying.
+ */
+typedef struct {
+  String buffer;
+} BytesMut;
+
+/** Create empty bytes. No memory is allocated. */
+WUR MU SI Bytes bytes_new() {
+  return (Bytes) { .shared = NULL, .data = "", .len = 0 };
+}
+
+/** Create bytes, which refer to static data. Data is not copied and never freed. */
+WUR MU SI Bytes bytes_from_static(const void * data, size_t length) {
+  if(data == NULL && length != 0) {
+    bytes_panic(BYTES_ERROR_NO_DATA, length);
+  }
+  return (Bytes) { .shared = NULL, .data = data, .len = length };
+}
+
+/** Create bytes with copy of data. */
+WUR Bytes bytes_copy_from_slice(const void * data, size_t length);
+
+/** Create bytes with copy of text of Str. */
+NN WUR MU SI Bytes bytes_copy_from_str(const Str * str) {
+  return bytes_copy_from_slice(str_as_ptr(str), str_len(str));
+}
+
+/** Take data of string without copying. String is left empty. */
+NN WUR Bytes bytes_from_string(String * string);
+
+/** Release reference to data. It's safe to call destroy() twice. */
+NN void bytes_destroy(Bytes * self);
+
+/** Return new handle, which shares data with this one. */
+NN WUR MU SI Bytes bytes_clone(const Bytes * self) {
+  if(self->shared != NULL) {
+    __atomic_fetch_add(&self->shared->refcount, 1, __ATOMIC_RELAXED);
+  }
+  return *self;
+}
+
+NN WUR MU SI size_t bytes_len(const Bytes * self) { return self->len; }
+NN WUR MU SI bool bytes_is_empty(const Bytes * self) { return self->len == 0; }
+NN WUR MU SI const char * bytes_as_ptr(const Bytes * self) { return self->data; }
+
+/** Return view of bytes. View is valid while this handle is alive. */
+NN WUR MU SI Str bytes_as_str(const Bytes * self) { return str_from_raw_parts(self->data, self->len); }
+
+/** Return byte at index. Panics when index is out of bounds. */
+NN WUR MU SI char bytes_get(const Bytes * self, size_t index) {
+  if(index >= self->len) {
+    bytes_panic(BYTES_ERROR_INDEX_OUT_OF_BOUNDS, index);
+  }
+  return self->data[index];
+}
+
+/** Return new handle to length bytes from start. No data is copied.
+ * Panics when range is out of bounds. */
+NN WUR Bytes bytes_slice(const Bytes * self, size_t start, size_t length);
+
+/** Return new handle to first at bytes and advance this handle past them.
+ * Used to cut frames from received data. Panics when at is out of bounds. */
+NN WUR Bytes bytes_split_to(Bytes * self, size_t at);
+
+/** Return new handle to bytes from at to end and shorten this handle to at bytes.
+ * Panics when at is out of bounds. */
+NN WUR Bytes bytes_split_off(Bytes * self, size_t at);
+
+/** Return true, when both handles have same content. */
+NN WUR MU SI bool bytes_eq(const Bytes * self, const Bytes * other) {
+  return self->len == other->len && (self->len == 0 || memcmp(self->data, other->data, self->len) == 0);
+}
+
+//
+// BytesMut
+//
+
+WUR MU SI BytesMut bytesmut_with_capacity(size_t capacity) {
+  return (BytesMut) { .buffer = string_with_capacity(capacity) };
+}
+
+WUR MU SI BytesMut bytesmut_new() { return bytesmut_with_capacity(64); }
+
+MU SI void bytesmut_destroy(BytesMut * self) { string_destroy(&self->buffer); }
+
+NN WUR MU SI size_t bytesmut_len(const BytesMut * self) { return string_len(&self->buffer); }
+
+/** Return buffer, so string functions can be used to append data. */
+NN WUR MU SI String * bytesmut_as_string(BytesMut * self) { return &self->buffer; }
+
+/** Return view of bytes, which are appended so far. */
+NN WUR MU SI Str bytesmut_as_str(const BytesMut * self) { return string_as_slice(&self->buffer); }
+
+/** Append bytes and return new length. */
+NN MU SI size_t bytesmut_put_slice(BytesMut * self, const void * data, size_t length) {
+  Str str = str_from_raw_parts(data, length);
+  return string_put_str(&self->buffer, &str);
+}
+
+/** Turn appended bytes into Bytes without copying. Builder is left empty and
+ * can be reused. */
+NN WUR MU SI Bytes bytesmut_freeze(BytesMut * self) { return bytes_from_string(&self->buffer); }
+
+#endif /* CRUST_TYPE_BYTES_H_ */
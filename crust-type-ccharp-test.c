@@ -9,3 +9,12 @@ it(ccharp_default, "must return empty static string") {
   assert_equal_int(0, *s, "Unexpected value");
 }
 
+
+it(ccharp_hash, "must return same hash for equal strings") {
+  char buf[] = "foo";
+  const char * a = "foo";
+  const char * b = buf;
+  const char * c = "fop";
+  assert_true(ccharp_hash(&a) == ccharp_hash(&b), "Hash must depend on content of string only");
+  assert_true(ccharp_hash(&a) != ccharp_hash(&c), "Different strings must have different hashes");
+}
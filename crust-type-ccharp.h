@@ -12,6 +12,7 @@
 #include <stdbool.h>
 
 #include "crust-mem.h"
+#include "crust-hash.h"
 
 //
 // Type for preallocated strings
@@ -28,6 +29,16 @@ NN WUR MU SI bool ccharp_eq(const char * * left, const char * * right) {
   return *left == *right || strcmp(*left, *right) == 0;
 }
 
+/** Compare two strings using strcmp(). */
+NN WUR MU SI int ccharp_cmp(const char * * left, const char * * right) {
+  return *left == *right ? 0 : strcmp(*left, *right);
+}
+
+/** Return hash of string. */
+NN WUR MU SI size_t ccharp_hash(const char * * self) {
+  return (size_t)hash_bytes(*self, strlen(*self));
+}
+
 /** Do nothing. */
 NN MU SI void ccharp_destroy(const char * * value) { (void) value; }
 
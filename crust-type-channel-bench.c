@@ -0,0 +1,109 @@
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "crust-type-channel.h"
+#include "crust-type-vec.h"
+
+#include "crust-bench.h"
+
+CHANNEL_BY_VALUE_TEMPLATE(Channel_int, channel_int, int)
+VEC_BY_VALUE_TEMPLATE(Vec_int, vec_int, int)
+CHANNEL_TO_VEC(Channel_int, channel_int, int, Vec_int, vec_int)
+
+#define CHANNEL_BENCH_CAPACITY 1024
+#define CHANNEL_BENCH_BATCH 256
+
+typedef struct {
+  Channel_int * channel;
+  size_t messages;
+} ChannelBenchProducer;
+
+static void * channel_bench_producer(void * arg) {
+  ChannelBenchProducer * producer = arg;
+  for(size_t i = 0; i < producer->messages; i++) {
+    if(channel_int_send(producer->channel, (int)i) != CHANNEL_OK) {
+      abort();
+    }
+  }
+  channel_int_sender_drop(producer->channel);
+  return NULL;
+}
+
+/* Send b->iterations messages from given number of producers and receive them in batches,
+ * so time per iteration is inverse of throughput. */
+static void channel_bench_throughput(Bench * b, size_t producers) {
+  defer(channel_int_destroy) Channel_int channel = channel_int_with_capacity(CHANNEL_BENCH_CAPACITY);
+  defer(vec_int_destroy) Vec_int batch = vec_int_with_capacity(CHANNEL_BENCH_BATCH);
+  pthread_t threads[32];
+  ChannelBenchProducer args[32];
+
+  for(size_t i = 0; i < producers; i++) {
+    // First producer sends rest of messages
+    args[i] = (ChannelBenchProducer) { .channel = &channel, .messages = b->iterations / producers + (i == 0 ? b->iterations % producers : 0) };
+    channel_int_sender_clone(&channel);
+    pthread_create(&threads[i], NULL, &channel_bench_producer, &args[i]);
+  }
+  channel_int_sender_drop(&channel);
+
+  long long sum = 0;
+  while(channel_int_recv_batch(&channel, &batch, CHANNEL_BENCH_BATCH, CHANNEL_NO_TIMEOUT) == CHANNEL_OK) {
+    for(size_t i = 0; i < vec_int_len(&batch); i++) {
+      sum += vec_int_get(&batch, i);
+    }
+    vec_int_truncate(&batch, 0);
+  }
+  bench_do_not_optimize(&sum);
+
+  for(size_t i = 0; i < producers; i++) {
+    pthread_join(threads[i], NULL);
+  }
+}
+
+#define DEFINE_CHANNEL_THROUGHPUT_BENCH(PRODUCERS) \
+bench(channel_throughput_##PRODUCERS, "send message from " #PRODUCERS " producer(s), receive in batches of 256") { \
+  channel_bench_throughput(b, PRODUCERS); \
+}
+
+DEFINE_CHANNEL_THROUGHPUT_BENCH(1)
+DEFINE_CHANNEL_THROUGHPUT_BENCH(2)
+DEFINE_CHANNEL_THROUGHPUT_BENCH(4)
+DEFINE_CHANNEL_THROUGHPUT_BENCH(8)
+DEFINE_CHANNEL_THROUGHPUT_BENCH(16)
+DEFINE_CHANNEL_THROUGHPUT_BENCH(32)
+
+typedef struct {
+  Channel_int * ping;
+  Channel_int * pong;
+} ChannelBenchEcho;
+
+static void * channel_bench_echo(void * arg) {
+  ChannelBenchEcho * echo = arg;
+  int value;
+  while(channel_int_recv(echo->ping, &value) == CHANNEL_OK) {
+    if(channel_int_send(echo->pong, value) != CHANNEL_OK) {
+      abort();
+    }
+  }
+  return NULL;
+}
+
+bench(channel_wakeup_latency, "send message to blocked thread and wait for its reply (two wakeups)") {
+  defer(channel_int_destroy) Channel_int ping = channel_int_with_capacity(1);
+  defer(channel_int_destroy) Channel_int pong = channel_int_with_capacity(1);
+  ChannelBenchEcho echo = { .ping = &ping, .pong = &pong };
+  pthread_t thread;
+  pthread_create(&thread, NULL, &channel_bench_echo, &echo);
+  bench_reset_timer(b);
+
+  int value = 0;
+  for(size_t i = 0; i < b->iterations; i++) {
+    if(channel_int_send(&ping, (int)i) != CHANNEL_OK || channel_int_recv(&pong, &value) != CHANNEL_OK) {
+      abort();
+    }
+  }
+  bench_do_not_optimize(&value);
+
+  // Echo thread stops, when last sender of ping channel is gone
+  channel_int_sender_drop(&ping);
+  pthread_join(thread, NULL);
+}
@@ -0,0 +1,109 @@
+#include <pthread.h>
+
+#include "crust-type-channel.h"
+#include "crust-type-vec.h"
+#include "crust-unittest.h"
+
+CHANNEL_BY_VALUE_TEMPLATE(Channel_int, channel_int, int)
+VEC_BY_VALUE_TEMPLATE(Vec_int, vec_int, int)
+CHANNEL_TO_VEC(Channel_int, channel_int, int, Vec_int, vec_int)
+
+it(channel_int_try_send_try_recv, "must deliver messages in order and report full and empty channel") {
+  defer(channel_int_destroy) Channel_int channel = channel_int_with_capacity(4);
+
+  for(int i=0; i<4; i++) {
+    assert_true(channel_int_try_send(&channel, i) == CHANNEL_OK, "channel_int_try_send() must send message");
+  }
+  assert_true(channel_int_try_send(&channel, 4) == CHANNEL_FULL, "channel_int_try_send() must report full channel");
+  assert_equal_int(4, channel_int_len(&channel), "Unexpected length of channel");
+
+  int value = -1;
+  for(int i=0; i<4; i++) {
+    assert_true(channel_int_try_recv(&channel, &value) == CHANNEL_OK, "channel_int_try_recv() must receive message");
+    assert_equal_int(i, value, "Messages must be received in order");
+  }
+  assert_true(channel_int_try_recv(&channel, &value) == CHANNEL_EMPTY, "channel_int_try_recv() must report empty channel");
+}
+
+it(channel_int_recv_timeout, "must return CHANNEL_TIMEOUT when no message arrives in time") {
+  defer(channel_int_destroy) Channel_int channel = channel_int_with_capacity(4);
+  int value = -1;
+
+  assert_true(channel_int_recv_timeout(&channel, &value, 10) == CHANNEL_TIMEOUT, "channel_int_recv_timeout() must time out");
+
+  assert_true(channel_int_send(&channel, 42) == CHANNEL_OK, "channel_int_send() must send message");
+  assert_true(channel_int_recv_timeout(&channel, &value, 10) == CHANNEL_OK, "channel_int_recv_timeout() must receive message");
+  assert_equal_int(42, value, "Unexpected message");
+}
+
+it(channel_int_sender_drop, "must drain messages and then report disconnect when all senders are dropped") {
+  defer(channel_int_destroy) Channel_int channel = channel_int_with_capacity(4);
+  int value = -1;
+
+  channel_int_sender_clone(&channel);
+  assert_true(channel_int_send(&channel, 1) == CHANNEL_OK, "channel_int_send() must send message");
+  channel_int_sender_drop(&channel);
+  assert_true(channel_int_send(&channel, 2) == CHANNEL_OK, "channel_int_send() must send message");
+  channel_int_sender_drop(&channel);
+
+  assert_true(channel_int_recv(&channel, &value) == CHANNEL_OK, "channel_int_recv() must receive message after disconnect");
+  assert_equal_int(1, value, "Unexpected message");
+  assert_true(channel_int_recv(&channel, &value) == CHANNEL_OK, "channel_int_recv() must receive message after disconnect");
+  assert_equal_int(2, value, "Unexpected message");
+  assert_true(channel_int_recv(&channel, &value) == CHANNEL_DISCONNECTED, "channel_int_recv() must report disconnect");
+
+  assert_abort(channel_int_sender_drop(&channel), "channel_int_sender_drop() must panic when there are no senders");
+}
+
+it(channel_int_close, "must refuse messages after receiver closed channel") {
+  defer(channel_int_destroy) Channel_int channel = channel_int_with_capacity(4);
+
+  channel_int_close(&channel);
+  assert_true(channel_int_send(&channel, 1) == CHANNEL_DISCONNECTED, "channel_int_send() must report closed channel");
+  assert_true(channel_int_try_send(&channel, 1) == CHANNEL_DISCONNECTED, "channel_int_try_send() must report closed channel");
+}
+
+#define CHANNEL_TEST_PRODUCERS 4
+#define CHANNEL_TEST_MESSAGES 20000
+
+static void * channel_int_test_producer(void * arg) {
+  Channel_int * channel = arg;
+  for(int i=1; i<=CHANNEL_TEST_MESSAGES; i++) {
+    if(channel_int_send(channel, i) != CHANNEL_OK) {
+      abort();
+    }
+  }
+  channel_int_sender_drop(channel);
+  return NULL;
+}
+
+it(channel_int_many_producers, "must deliver all messages from many producers through small channel") {
+  defer(channel_int_destroy) Channel_int channel = channel_int_with_capacity(16);
+  pthread_t threads[CHANNEL_TEST_PRODUCERS];
+
+  for(int i=0; i<CHANNEL_TEST_PRODUCERS; i++) {
+    channel_int_sender_clone(&channel);
+    pthread_create(&threads[i], NULL, &channel_int_test_producer, &channel);
+  }
+  channel_int_sender_drop(&channel);
+
+  defer(vec_int_destroy) Vec_int batch = vec_int_new();
+  long long sum = 0;
+  size_t count = 0;
+
+  while(channel_int_recv_batch(&channel, &batch, 64, CHANNEL_NO_TIMEOUT) == CHANNEL_OK) {
+    for(size_t i=0; i<vec_int_len(&batch); i++) {
+      sum += vec_int_get(&batch, i);
+    }
+    count += vec_int_len(&batch);
+    vec_int_truncate(&batch, 0);
+  }
+
+  for(int i=0; i<CHANNEL_TEST_PRODUCERS; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  long long expected = (long long)CHANNEL_TEST_PRODUCERS * CHANNEL_TEST_MESSAGES * (CHANNEL_TEST_MESSAGES + 1) / 2;
+  assert_equal_int(CHANNEL_TEST_PRODUCERS * CHANNEL_TEST_MESSAGES, count, "All messages must be received");
+  assert_true(expected == sum, "Sum of received messages must match sum of sent messages");
+}
@@ -0,0 +1,348 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+/* For syscall() and clock_gettime(). */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+#include "crust-type-channel.h"
+#include "crust-mem.h"
+
+/* Number of polls before receiver or sender goes to sleep. */
+#define _CHANNEL_SPIN_COUNT 64
+
+void _channel_panic(int error_code, size_t value) {
+  switch(error_code) {
+    case _CHANNEL_ERROR_ZERO_CAPACITY:
+      fprintf(stderr, "ERROR: Channel: Capacity of channel must be greater than 0. Capacity: %zu.\n", value);
+    break;
+
+    case _CHANNEL_ERROR_NO_SENDERS:
+      fprintf(stderr, "ERROR: Channel: sender_drop() is called, but channel has no senders.\n");
+    break;
+
+    default:
+      fprintf(stderr, "ERROR: _channel_panic(): Unknown error code: %d.\n", error_code);
+  }
+
+  abort();
+}
+
+static inline void _channel_cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#else
+  __atomic_signal_fence(__ATOMIC_SEQ_CST);
+#endif
+}
+
+static void _channel_futex_wait(uint32_t * word, uint32_t expected, const struct timespec * timeout) {
+#ifdef __linux__
+  syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, expected, timeout, NULL, 0);
+#else
+  (void)word; (void)expected; (void)timeout;
+  sched_yield();
+#endif
+}
+
+static void _channel_futex_wake(uint32_t * word, int count) {
+#ifdef __linux__
+  syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+#else
+  (void)word; (void)count;
+#endif
+}
+
+static struct timespec _channel_deadline(long timeout_ms) {
+  struct timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  deadline.tv_sec += timeout_ms / 1000;
+  deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+  if(deadline.tv_nsec >= 1000000000L) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000L;
+  }
+  return deadline;
+}
+
+/* Return false when deadline is passed, otherwise store time left in remaining. */
+static bool _channel_time_left(const struct timespec * deadline, struct timespec * remaining) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  remaining->tv_sec = deadline->tv_sec - now.tv_sec;
+  remaining->tv_nsec = deadline->tv_nsec - now.tv_nsec;
+  if(remaining->tv_nsec < 0) {
+    remaining->tv_sec--;
+    remaining->tv_nsec += 1000000000L;
+  }
+  return remaining->tv_sec >= 0 && (remaining->tv_sec > 0 || remaining->tv_nsec > 0);
+}
+
+_Channel _channel_with_capacity(size_t element_size, size_t capacity) {
+  if(capacity == 0) {
+    _channel_panic(_CHANNEL_ERROR_ZERO_CAPACITY, capacity);
+  }
+
+  size_t rounded = 1;
+  while(rounded < capacity) {
+    if(rounded > SIZE_MAX/2) {
+      mem_panic(MEM_ERROR_INTEGER_OVERFLOW, capacity);
+    }
+    rounded *= 2;
+  }
+
+  _Channel self = {
+    .data = mem_calloc(rounded, element_size),
+    .seqs = mem_malloc(rounded, sizeof(size_t)),
+    .capacity = rounded,
+    .element_size = element_size,
+    .senders = 1,
+  };
+
+  for(size_t i=0; i<rounded; i++) {
+    self.seqs[i] = i;
+  }
+
+  return self;
+}
+
+void _channel_destroy(_Channel * self) {
+  if(self->data) {
+    mem_free(self->data);
+    mem_free(self->seqs);
+    self->data = NULL;
+    self->seqs = NULL;
+    self->capacity = 0;
+  }
+}
+
+static void _channel_wake_receiver(_Channel * self) {
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if(__atomic_load_n(&self->receiver_waiting, __ATOMIC_RELAXED)) {
+    __atomic_fetch_add(&self->recv_futex, 1, __ATOMIC_RELEASE);
+    _channel_futex_wake(&self->recv_futex, 1);
+  }
+}
+
+static void _channel_wake_senders(_Channel * self) {
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if(__atomic_load_n(&self->senders_waiting, __ATOMIC_RELAXED)) {
+    __atomic_fetch_add(&self->send_futex, 1, __ATOMIC_RELEASE);
+    _channel_futex_wake(&self->send_futex, INT32_MAX);
+  }
+}
+
+/* Reserve slot, copy message into it, and publish it. Does not wake receiver. */
+static Channel_status _channel_put(_Channel * self, const void * value) {
+  if(__atomic_load_n(&self->closed, __ATOMIC_ACQUIRE)) {
+    return CHANNEL_DISCONNECTED;
+  }
+
+  size_t mask = self->capacity - 1;
+  size_t pos = __atomic_load_n(&self->head, __ATOMIC_RELAXED);
+
+  for(;;) {
+    size_t seq = __atomic_load_n(&self->seqs[pos & mask], __ATOMIC_ACQUIRE);
+    intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+
+    if(dif == 0) {
+      if(__atomic_compare_exchange_n(&self->head, &pos, pos+1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+      // pos is updated by failed CAS
+    } else if(dif < 0) {
+      return CHANNEL_FULL;
+    } else {
+      pos = __atomic_load_n(&self->head, __ATOMIC_RELAXED);
+    }
+  }
+
+  memcpy((char *)self->data + (pos & mask) * self->element_size, value, self->element_size);
+  __atomic_store_n(&self->seqs[pos & mask], pos+1, __ATOMIC_RELEASE);
+
+  return CHANNEL_OK;
+}
+
+/* Copy message out of the slot and release the slot. Does not wake senders. */
+static Channel_status _channel_take(_Channel * self, void * out) {
+  size_t mask = self->capacity - 1;
+  size_t pos = self->tail;
+  size_t * seq = &self->seqs[pos & mask];
+
+  if(__atomic_load_n(seq, __ATOMIC_ACQUIRE) != pos+1) {
+    if(__atomic_load_n(&self->senders, __ATOMIC_ACQUIRE) != 0) {
+      return CHANNEL_EMPTY;
+    }
+    // Last sender is gone, but it could publish message before it left
+    if(__atomic_load_n(seq, __ATOMIC_ACQUIRE) != pos+1) {
+      return CHANNEL_DISCONNECTED;
+    }
+  }
+
+  memcpy(out, (char *)self->data + (pos & mask) * self->element_size, self->element_size);
+  __atomic_store_n(seq, pos + self->capacity, __ATOMIC_RELEASE);
+  __atomic_store_n(&self->tail, pos+1, __ATOMIC_RELAXED);
+
+  return CHANNEL_OK;
+}
+
+Channel_status _channel_try_send(_Channel * self, const void * value) {
+  Channel_status status = _channel_put(self, value);
+  if(status == CHANNEL_OK) {
+    _channel_wake_receiver(self);
+  }
+  return status;
+}
+
+Channel_status _channel_send(_Channel * self, const void * value) {
+  for(int spin = 0;;) {
+    Channel_status status = _channel_try_send(self, value);
+    if(status != CHANNEL_FULL) {
+      return status;
+    }
+
+    if(spin < _CHANNEL_SPIN_COUNT) {
+      spin++;
+      _channel_cpu_relax();
+      continue;
+    }
+
+    uint32_t word = __atomic_load_n(&self->send_futex, __ATOMIC_ACQUIRE);
+    __atomic_fetch_add(&self->senders_waiting, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    status = _channel_try_send(self, value);
+    if(status != CHANNEL_FULL) {
+      __atomic_fetch_sub(&self->senders_waiting, 1, __ATOMIC_RELAXED);
+      return status;
+    }
+
+    _channel_futex_wait(&self->send_futex, word, NULL);
+    __atomic_fetch_sub(&self->senders_waiting, 1, __ATOMIC_RELAXED);
+  }
+}
+
+Channel_status _channel_try_recv(_Channel * self, void * out) {
+  Channel_status status = _channel_take(self, out);
+  if(status == CHANNEL_OK) {
+    _channel_wake_senders(self);
+  }
+  return status;
+}
+
+Channel_status _channel_recv_timeout(_Channel * self, void * out, long timeout_ms) {
+  struct timespec deadline = { 0 }, remaining = { 0 };
+  if(timeout_ms >= 0) {
+    deadline = _channel_deadline(timeout_ms);
+  }
+
+  for(int spin = 0;;) {
+    Channel_status status = _channel_try_recv(self, out);
+    if(status != CHANNEL_EMPTY) {
+      return status;
+    }
+
+    if(spin < _CHANNEL_SPIN_COUNT) {
+      spin++;
+      _channel_cpu_relax();
+      continue;
+    }
+
+    uint32_t word = __atomic_load_n(&self->recv_futex, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&self->receiver_waiting, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    status = _channel_try_recv(self, out);
+    if(status != CHANNEL_EMPTY) {
+      __atomic_store_n(&self->receiver_waiting, 0, __ATOMIC_RELAXED);
+      return status;
+    }
+
+    if(timeout_ms >= 0) {
+      if(!_channel_time_left(&deadline, &remaining)) {
+        __atomic_store_n(&self->receiver_waiting, 0, __ATOMIC_RELAXED);
+        return CHANNEL_TIMEOUT;
+      }
+      _channel_futex_wait(&self->recv_futex, word, &remaining);
+    } else {
+      _channel_futex_wait(&self->recv_futex, word, NULL);
+    }
+
+    __atomic_store_n(&self->receiver_waiting, 0, __ATOMIC_RELAXED);
+  }
+}
+
+Channel_status _channel_recv_batch(_Channel * self, _Vec * out, size_t max, long timeout_ms) {
+  if(max == 0) {
+    return CHANNEL_OK;
+  }
+
+  if(out->capacity - out->count < max) {
+    _vec_reserve(out, self->element_size, max);
+  }
+
+  char * spare = (char *)out->data + out->count * self->element_size;
+
+  Channel_status status = _channel_recv_timeout(self, spare, timeout_ms);
+  if(status != CHANNEL_OK) {
+    return status;
+  }
+
+  size_t received = 1;
+  while(received < max && _channel_take(self, spare + received * self->element_size) == CHANNEL_OK) {
+    received++;
+  }
+
+  if(received > 1) {
+    _channel_wake_senders(self);
+  }
+
+  out->count += received;
+
+  return CHANNEL_OK;
+}
+
+void _channel_sender_clone(_Channel * self) {
+  __atomic_fetch_add(&self->senders, 1, __ATOMIC_RELAXED);
+}
+
+void _channel_sender_drop(_Channel * self) {
+  size_t senders = __atomic_fetch_sub(&self->senders, 1, __ATOMIC_ACQ_REL);
+
+  if(senders == 0) {
+    _channel_panic(_CHANNEL_ERROR_NO_SENDERS, 0);
+  }
+
+  if(senders == 1) {
+    // Wake receiver unconditionally, so it will notice disconnect
+    __atomic_fetch_add(&self->recv_futex, 1, __ATOMIC_RELEASE);
+    _channel_futex_wake(&self->recv_futex, 1);
+  }
+}
+
+void _channel_close(_Channel * self) {
+  __atomic_store_n(&self->closed, 1, __ATOMIC_RELEASE);
+  __atomic_fetch_add(&self->send_futex, 1, __ATOMIC_RELEASE);
+  _channel_futex_wake(&self->send_futex, INT32_MAX);
+}
+
+size_t _channel_len(const _Channel * self) {
+  size_t head = __atomic_load_n(&self->head, __ATOMIC_RELAXED);
+  size_t tail = __atomic_load_n(&self->tail, __ATOMIC_RELAXED);
+  return head > tail ? head - tail : 0;
+}
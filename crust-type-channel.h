@@ -0,0 +1,218 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#ifndef CRUST_TYPE_CHANNEL_H_
+#define CRUST_TYPE_CHANNEL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "crust-mem.h"
+#include "crust-type-vec.h"
+
+#ifdef _CRUST_TESTS
+#include "crust-unittest.h"
+#endif
+
+enum _Channel_error_codes {
+  _CHANNEL_ERROR_ZERO_CAPACITY = 1,
+  _CHANNEL_ERROR_NO_SENDERS = 2,
+};
+
+void _channel_panic(int error_code, size_t value);
+#ifdef _CRUST_TESTS
+it(_channel_panic, "must abort program using abort()") {
+  assert_abort(_channel_panic(_CHANNEL_ERROR_ZERO_CAPACITY, 0), "must abort");
+  assert_abort(_channel_panic(_CHANNEL_ERROR_NO_SENDERS, 0), "must abort");
+  assert_abort(_channel_panic(12312, 1), "must abort");
+}
+#endif
+
+/** Result of send and receive operations. */
+typedef enum Channel_status_e {
+  /** Message is sent or received. */
+  CHANNEL_OK = 0,
+  /** try_recv(): no message is available right now. */
+  CHANNEL_EMPTY = 1,
+  /** try_send(): channel is at capacity. */
+  CHANNEL_FULL = 2,
+  /** recv_timeout(): no message arrived before deadline. */
+  CHANNEL_TIMEOUT = 3,
+  /** recv(): channel is empty and all senders are dropped.
+   * send(): receiver closed the channel. */
+  CHANNEL_DISCONNECTED = 4,
+} Channel_status;
+
+/** Pass as timeout to block until message arrives. */
+#define CHANNEL_NO_TIMEOUT (-1L)
+
+/**
+ * Bounded multi-producer single-consumer channel.
+ *
+ * Senders reserve slots in ring buffer with compare-and-swap on head
+ * position and publish messages through per-slot sequence numbers, so
+ * send() is lock-free. The only receiver sleeps on futex when channel is
+ * empty, and senders sleep on another futex when channel is full.
+ *
+ * Channel is created with one sender. Call sender_clone() for every
+ * additional producer and sender_drop() when producer is done. When last
+ * sender is dropped, receiver drains remaining messages and then gets
+ * CHANNEL_DISCONNECTED. When receiver calls close(), senders get
+ * CHANNEL_DISCONNECTED.
+ *
+ * Channel is shared by pointer and must not be moved or copied after
+ * threads start to use it.
+ */
+typedef struct _Channel_s {
+  void * data;
+  size_t * seqs;
+  size_t capacity;
+  size_t element_size;
+  /* Written by senders. */
+  size_t head __attribute__((aligned(64)));
+  size_t senders;
+  uint32_t send_futex;
+  uint32_t senders_waiting;
+  uint32_t closed;
+  /* Written by receiver. */
+  size_t tail __attribute__((aligned(64)));
+  uint32_t recv_futex;
+  uint32_t receiver_waiting;
+} _Channel;
+
+/** Free buffers of the channel. No thread may use channel after that.
+ * It's safe to call destroy() twice. */
+NN void _channel_destroy(_Channel * self);
+
+/** Create new channel with room for at least given number of messages.
+ * Capacity is rounded up to power of two.
+ * Panics when capacity is 0. */
+WUR _Channel _channel_with_capacity(size_t element_size, size_t capacity);
+#ifdef _CRUST_TESTS
+it(_channel_with_capacity, "must create channel with capacity rounded up to power of two") {
+  _Channel channel = _channel_with_capacity(sizeof(int), 5);
+  assert_equal_int(8, channel.capacity, "unexpected capacity");
+  assert_equal_int(1, channel.senders, "channel must be created with one sender");
+  _channel_destroy(&channel);
+
+  assert_abort(channel = _channel_with_capacity(sizeof(int), 0), "must panic on zero capacity");
+}
+#endif
+
+/** Send message without blocking.
+ * Return CHANNEL_FULL when channel is at capacity. */
+NN WUR Channel_status _channel_try_send(_Channel * self, const void * value);
+
+/** Send message, block while channel is full. */
+NN WUR Channel_status _channel_send(_Channel * self, const void * value);
+
+/** Receive message without blocking.
+ * Return CHANNEL_EMPTY when no message is available. */
+NN WUR Channel_status _channel_try_recv(_Channel * self, void * out);
+
+/** Receive message, block until message arrives or timeout (in milliseconds) expires.
+ * Negative timeout means no timeout. */
+NN WUR Channel_status _channel_recv_timeout(_Channel * self, void * out, long timeout_ms);
+
+/** Block until at least one message arrives (or timeout expires), then
+ * append up to max messages to the end of vector without further blocking. */
+NN WUR Channel_status _channel_recv_batch(_Channel * self, _Vec * out, size_t max, long timeout_ms);
+#ifdef _CRUST_TESTS
+it(_channel_recv_batch, "must drain available messages into vector") {
+  _Channel channel = _channel_with_capacity(sizeof(int), 8);
+  for(int i=0; i<5; i++) {
+    assert_true(_channel_try_send(&channel, &i) == CHANNEL_OK, "must send");
+  }
+
+  defer(_vec_destroy) _Vec vec = _vec_with_capacity(sizeof(int), 1);
+  assert_true(_channel_recv_batch(&channel, &vec, 3, CHANNEL_NO_TIMEOUT) == CHANNEL_OK, "must receive");
+  assert_equal_int(3, vec.count, "must receive no more than max messages");
+  assert_true(_channel_recv_batch(&channel, &vec, 10, CHANNEL_NO_TIMEOUT) == CHANNEL_OK, "must receive");
+  assert_equal_int(5, vec.count, "must receive rest of messages");
+
+  for(int i=0; i<5; i++) {
+    assert_equal_int(i, ((int *)vec.data)[i], "messages must be received in order");
+  }
+
+  _channel_destroy(&channel);
+}
+#endif
+
+/** Register one more sender. */
+NN void _channel_sender_clone(_Channel * self);
+
+/** Unregister sender. When last sender is dropped, receiver is woken up.
+ * Panics when there are no senders left. */
+NN void _channel_sender_drop(_Channel * self);
+
+/** Close channel from receiver side. Blocked and future senders get CHANNEL_DISCONNECTED. */
+NN void _channel_close(_Channel * self);
+
+/** Return approximate number of messages in the channel. */
+NN WUR size_t _channel_len(const _Channel * self);
+
+//
+// Template for Channel
+//
+
+#define DEFINE_CHANNEL_STRUCT(SELFNAME) \
+typedef struct { \
+  _Channel super; \
+} SELFNAME;
+
+#define DEFINE_CHANNEL_WITH_CAPACITY(SELFNAME, SELFPREFIX, CTYPE) \
+/** Create new channel with room for at least given number of messages. */ \
+WUR MU SI SELFNAME SELFPREFIX##_with_capacity(size_t capacity) { return (SELFNAME) { .super = _channel_with_capacity(sizeof(CTYPE), capacity) }; }
+
+#define DEFINE_CHANNEL_DESTROY(SELFNAME, SELFPREFIX) \
+/** Free buffers of the channel. Remaining messages are not destroyed. */ \
+NN MU SI void SELFPREFIX##_destroy(SELFNAME * self) { _channel_destroy(&self->super); }
+
+#define DEFINE_CHANNEL_SEND_BY_VALUE(SELFNAME, SELFPREFIX, CTYPE) \
+/** Send message without blocking. */ \
+NN WUR MU SI Channel_status SELFPREFIX##_try_send(SELFNAME * self, const CTYPE value) { return _channel_try_send(&self->super, &value); } \
+/** Send message, block while channel is full. */ \
+NN WUR MU SI Channel_status SELFPREFIX##_send(SELFNAME * self, const CTYPE value) { return _channel_send(&self->super, &value); }
+
+#define DEFINE_CHANNEL_RECV_BY_VALUE(SELFNAME, SELFPREFIX, CTYPE) \
+/** Receive message without blocking. */ \
+NN WUR MU SI Channel_status SELFPREFIX##_try_recv(SELFNAME * self, CTYPE * out) { return _channel_try_recv(&self->super, out); } \
+/** Receive message, block until message arrives or timeout (in milliseconds) expires. */ \
+NN WUR MU SI Channel_status SELFPREFIX##_recv_timeout(SELFNAME * self, CTYPE * out, long timeout_ms) { return _channel_recv_timeout(&self->super, out, timeout_ms); } \
+/** Receive message, block until message arrives. */ \
+NN WUR MU SI Channel_status SELFPREFIX##_recv(SELFNAME * self, CTYPE * out) { return _channel_recv_timeout(&self->super, out, CHANNEL_NO_TIMEOUT); }
+
+#define DEFINE_CHANNEL_SENDERS(SELFNAME, SELFPREFIX) \
+/** Register one more sender. */ \
+NN MU SI void SELFPREFIX##_sender_clone(SELFNAME * self) { _channel_sender_clone(&self->super); } \
+/** Unregister sender. */ \
+NN MU SI void SELFPREFIX##_sender_drop(SELFNAME * self) { _channel_sender_drop(&self->super); } \
+/** Close channel from receiver side. */ \
+NN MU SI void SELFPREFIX##_close(SELFNAME * self) { _channel_close(&self->super); }
+
+#define DEFINE_CHANNEL_LEN(SELFNAME, SELFPREFIX) \
+/** Return approximate number of messages in the channel. */ \
+NN WUR MU SI size_t SELFPREFIX##_len(const SELFNAME * self) { return _channel_len(&self->super); }
+
+#define CHANNEL_BY_VALUE_TEMPLATE(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_CHANNEL_STRUCT(SELFNAME) \
+DEFINE_CHANNEL_WITH_CAPACITY(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_CHANNEL_DESTROY(SELFNAME, SELFPREFIX) \
+DEFINE_CHANNEL_SEND_BY_VALUE(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_CHANNEL_RECV_BY_VALUE(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_CHANNEL_SENDERS(SELFNAME, SELFPREFIX) \
+DEFINE_CHANNEL_LEN(SELFNAME, SELFPREFIX) \
+
+#define CHANNEL_TO_VEC(SELFNAME, SELFPREFIX, CTYPE, VECTYPENAME, VECPREFIX) \
+/** Block until at least one message arrives (or timeout expires), then \
+ * append up to max messages to the vector without further blocking. */ \
+NN WUR MU SI Channel_status SELFPREFIX##_recv_batch(SELFNAME * self, VECTYPENAME * out, size_t max, long timeout_ms) { \
+  return _channel_recv_batch(&self->super, &out->super, max, timeout_ms); \
+}
+
+#endif /* CRUST_TYPE_CHANNEL_H_ */
@@ -9,6 +9,10 @@
 #define CRUST_TYPE_CHAR_H_
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "crust-hash.h"
 
 static inline char char_default() {
   return '\0';
@@ -18,4 +22,12 @@ static inline bool char_eq(const char * left, const char * right) {
   return *left == *right;
 }
 
+static inline int char_cmp(const char * left, const char * right) {
+  return (*left > *right) - (*left < *right);
+}
+
+static inline size_t char_hash(const char * self) {
+  return (size_t)hash_u64((uint64_t)(unsigned char)*self);
+}
+
 #endif /* CRUST_TYPE_CHAR_H_ */
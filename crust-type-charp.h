@@ -14,6 +14,7 @@
 #include <stdbool.h>
 
 #include "crust-mem.h"
+#include "crust-hash.h"
 
 //
 // Dynamically allocated C strings
@@ -22,14 +23,14 @@
 /** Free memory allocated for string. */
 NN MU SI void charp_destroy(char * * value) {
   if(*value) {
-    free(*value);
+    mem_free(*value);
     *value = NULL;
   }
 }
 
 /** Return pointer to allocated empty string. */
 WUR MU SI char * charp_default() {
-  return calloc(1, sizeof(char));
+  return mem_calloc(1, sizeof(char));
 }
 
 /** Compare two strings using strcmp(). */
@@ -37,6 +38,16 @@ NN WUR MU SI bool charp_eq(const char * * left, const char * * right) {
   return *left == *right || strcmp(*left, *right) == 0;
 }
 
+/** Compare two strings using strcmp(). */
+NN WUR MU SI int charp_cmp(const char * * left, const char * * right) {
+  return *left == *right ? 0 : strcmp(*left, *right);
+}
+
+/** Return hash of string. */
+NN WUR MU SI size_t charp_hash(const char * * self) {
+  return (size_t)hash_bytes(*self, strlen(*self));
+}
+
 /** Allocate memory and copy string into it. */
 NN WUR MU SI char * charp_clone(const char * other) {
   size_t len = strlen(other);
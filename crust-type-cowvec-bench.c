@@ -0,0 +1,90 @@
+#include "crust-type-vec.h"
+#include "crust-type-cowvec.h"
+#include "crust-type-int.h"
+
+#include "crust-bench.h"
+
+VEC_BY_VALUE_TEMPLATE(Vec_int, vec_int, int)
+COWVEC_BY_VALUE_TEMPLATE(CowVec_int, cowvec_int, int)
+
+//
+// Fan 8 MB vector out to 64 consumers, which hold their copies at once.
+// Peak RSS is per process, so compare it by running one benchmark per
+// process, e.g.:
+//
+//   /usr/bin/time -v ./bench.out --samples 1 cowvec_int_fanout
+//   /usr/bin/time -v ./bench.out --samples 1 cowvec_vec_int_fanout
+//
+
+#define COWVEC_BENCH_LENGTH (2 * 1024 * 1024)
+#define COWVEC_BENCH_CONSUMERS 64
+
+static Vec_int cowvec_bench_vec;
+static CowVec_int cowvec_bench_cowvec;
+static bool cowvec_bench_ready = false;
+
+static void cowvec_bench_init(void) {
+  if(cowvec_bench_ready) {
+    return;
+  }
+  cowvec_bench_vec = vec_int_with_capacity(COWVEC_BENCH_LENGTH);
+  cowvec_bench_cowvec = cowvec_int_with_capacity(COWVEC_BENCH_LENGTH);
+  for(int j = 0; j < COWVEC_BENCH_LENGTH; j++) {
+    vec_int_push(&cowvec_bench_vec, j);
+    (void)cowvec_int_push(&cowvec_bench_cowvec, j);
+  }
+  cowvec_bench_ready = true;
+}
+
+bench(cowvec_int_fanout, "clone 8 MB CowVec to 64 consumers, which read one element each") {
+  cowvec_bench_init();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    CowVec_int consumers[COWVEC_BENCH_CONSUMERS];
+    int sum = 0;
+    for(int j = 0; j < COWVEC_BENCH_CONSUMERS; j++) {
+      consumers[j] = cowvec_int_clone(&cowvec_bench_cowvec);
+      sum += cowvec_int_get(&consumers[j], (size_t)j * 1000);
+    }
+    bench_do_not_optimize(&sum);
+    for(int j = 0; j < COWVEC_BENCH_CONSUMERS; j++) {
+      cowvec_int_destroy(&consumers[j]);
+    }
+  }
+}
+
+bench(cowvec_int_fanout_write, "clone 8 MB CowVec to 64 consumers, which modify one element each") {
+  cowvec_bench_init();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    CowVec_int consumers[COWVEC_BENCH_CONSUMERS];
+    for(int j = 0; j < COWVEC_BENCH_CONSUMERS; j++) {
+      consumers[j] = cowvec_int_clone(&cowvec_bench_cowvec);
+      (void)cowvec_int_set(&consumers[j], (size_t)j * 1000, -j);
+    }
+    bench_do_not_optimize(cowvec_int_as_ptr(&consumers[COWVEC_BENCH_CONSUMERS - 1]));
+    for(int j = 0; j < COWVEC_BENCH_CONSUMERS; j++) {
+      cowvec_int_destroy(&consumers[j]);
+    }
+  }
+}
+
+bench(cowvec_vec_int_fanout, "clone 8 MB Vec to 64 consumers, which read one element each, as baseline") {
+  cowvec_bench_init();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    Vec_int consumers[COWVEC_BENCH_CONSUMERS];
+    int sum = 0;
+    for(int j = 0; j < COWVEC_BENCH_CONSUMERS; j++) {
+      consumers[j] = vec_int_clone(cowvec_bench_vec);
+      sum += vec_int_get(&consumers[j], (size_t)j * 1000);
+    }
+    bench_do_not_optimize(&sum);
+    for(int j = 0; j < COWVEC_BENCH_CONSUMERS; j++) {
+      vec_int_destroy(&consumers[j]);
+    }
+  }
+}
@@ -0,0 +1,118 @@
+#include <pthread.h>
+
+#include "crust-type-cowvec.h"
+#include "crust-type-slice.h"
+#include "crust-type-array.h"
+#include "crust-type-int.h"
+#include "crust-unittest.h"
+
+COWVEC_BY_VALUE_TEMPLATE(CowVec_int, cowvec_int, int)
+DEFINE_SLICE_BY_VALUE_TEMPLATE(Slice_int, slice_int, int, int)
+COWVEC_TO_SLICE(CowVec_int, cowvec_int, int, Slice_int, slice_int)
+
+it(cowvec_int_push_get, "must push values and read them back") {
+  defer(cowvec_int_destroy) CowVec_int vec = cowvec_int_with_capacity(1);
+
+  for(int i=0; i<1000; i++) {
+    assert_equal_int(i, cowvec_int_push(&vec, i*2), "cowvec_int_push() must return index of element");
+  }
+
+  assert_equal_int(1000, cowvec_int_len(&vec), "Unexpected length after cowvec_int_push()");
+  for(int i=0; i<1000; i++) {
+    assert_equal_int(i*2, cowvec_int_get(&vec, i), "Unexpected value of item after cowvec_int_push()");
+  }
+
+  assert_abort((void)(0 == cowvec_int_get(&vec, 1000)), "cowvec_int_get() must abort on index out of bounds");
+}
+
+it(cowvec_int_clone, "must share buffer until first mutation") {
+  int data[] = { 1, 2, 3, 4 };
+  defer(cowvec_int_destroy) CowVec_int vec = cowvec_int_from_datap(data, LENGTH_OF_ARRAY(data), LENGTH_OF_ARRAY(data));
+  defer(cowvec_int_destroy) CowVec_int copy = cowvec_int_clone(&vec);
+
+  assert_true(cowvec_int_as_ptr(&vec) == cowvec_int_as_ptr(&copy), "cowvec_int_clone() must not copy data");
+  assert_equal_int(3, cowvec_int_get(&copy, 2), "Unexpected value in clone");
+
+  cowvec_int_truncate(&copy, 2);
+  assert_true(cowvec_int_is_shared(&copy), "cowvec_int_truncate() must not copy data");
+  assert_equal_int(4, cowvec_int_len(&vec), "cowvec_int_truncate() must not change length of original");
+
+  assert_equal_int(1, cowvec_int_set(&copy, 0, 42), "cowvec_int_set() must return previous value");
+  assert_true(!cowvec_int_is_shared(&copy), "cowvec_int_set() must copy shared data");
+  assert_true(!cowvec_int_is_shared(&vec), "Original must not be shared after clone is copied");
+  assert_equal_int(42, cowvec_int_get(&copy, 0), "Unexpected value in clone after cowvec_int_set()");
+  assert_equal_int(1, cowvec_int_get(&vec, 0), "cowvec_int_set() must not change original");
+  assert_equal_int(2, cowvec_int_len(&copy), "Only elements of clone must be copied");
+
+  cowvec_int_push(&vec, 5);
+  assert_equal_int(5, cowvec_int_len(&vec), "Unexpected length after cowvec_int_push()");
+  assert_equal_int(2, cowvec_int_len(&copy), "cowvec_int_push() must not change clone");
+}
+
+it(cowvec_int_get_mut, "must copy shared data before returning pointer for writing") {
+  int data[] = { 1, 2, 3 };
+  defer(cowvec_int_destroy) CowVec_int vec = cowvec_int_from_datap(data, LENGTH_OF_ARRAY(data), LENGTH_OF_ARRAY(data));
+  defer(cowvec_int_destroy) CowVec_int copy = cowvec_int_clone(&vec);
+
+  *cowvec_int_get_mut(&vec, 1) = 20;
+  assert_equal_int(20, cowvec_int_get(&vec, 1), "Unexpected value after write through cowvec_int_get_mut()");
+  assert_equal_int(2, cowvec_int_get(&copy, 1), "Write through cowvec_int_get_mut() must not change clone");
+
+  int * element = cowvec_int_get_mut(&vec, 1);
+  assert_true(element == cowvec_int_get_mut(&vec, 1), "Private data must not be copied again");
+  assert_abort((void)(NULL == cowvec_int_get_mut(&vec, 3)), "cowvec_int_get_mut() must abort on index out of bounds");
+}
+
+it(cowvec_int_as_slice, "must convert vector to slice and back") {
+  int data[] = { 1, 2, 3 };
+  Slice_int slice = slice_int_from_raw_parts(data, LENGTH_OF_ARRAY(data));
+  defer(cowvec_int_destroy) CowVec_int vec = cowvec_int_from_slice(&slice);
+  Slice_int other = cowvec_int_as_slice(&vec);
+  assert_true(slice_int_eq(&slice, &other), "Slice of vector must be equal to original slice");
+}
+
+#define COWVEC_TEST_THREADS 4
+#define COWVEC_TEST_CLONES 10000
+
+static void * cowvec_test_clone_thread(void * arg) {
+  const CowVec_int * vec = arg;
+  for(int i=0; i<COWVEC_TEST_CLONES; i++) {
+    CowVec_int copy = cowvec_int_clone(vec);
+    if(i % 100 == 0) {
+      cowvec_int_push(&copy, i);
+    }
+    cowvec_int_destroy(&copy);
+  }
+  return NULL;
+}
+
+it(cowvec_int_clone_threads, "must count references atomically when handles are cloned in many threads") {
+  int data[] = { 1, 2, 3 };
+  defer(cowvec_int_destroy) CowVec_int vec = cowvec_int_from_datap(data, LENGTH_OF_ARRAY(data), LENGTH_OF_ARRAY(data));
+
+  pthread_t threads[COWVEC_TEST_THREADS];
+  for(int i=0; i<COWVEC_TEST_THREADS; i++) {
+    pthread_create(&threads[i], NULL, cowvec_test_clone_thread, &vec);
+  }
+  for(int i=0; i<COWVEC_TEST_THREADS; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  assert_true(!cowvec_int_is_shared(&vec), "All references of clones must be released");
+  assert_equal_int(3, cowvec_int_len(&vec), "Clones must not change original");
+}
+
+it(cowstring, "must share text until first mutation") {
+  defer(cowstring_destroy) CowString s = cowstring_from_charp("Hello");
+  defer(cowstring_destroy) CowString copy = cowstring_clone(&s);
+
+  Str suffix = str_from_charp(", world");
+  assert_equal_int(12, cowstring_put_str(&copy, &suffix), "cowstring_put_str() must return new length");
+
+  Str text = cowstring_as_slice(&s);
+  Str copy_text = cowstring_as_slice(&copy);
+  Str expected = str_from_charp("Hello");
+  Str expected_copy = str_from_charp("Hello, world");
+  assert_true(str_eq(&text, &expected), "Original text must not change");
+  assert_true(str_eq(&copy_text, &expected_copy), "Unexpected text of clone");
+}
@@ -0,0 +1,99 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "crust-type-cowvec.h"
+#include "crust-mem.h"
+
+void _cowvec_panic(int error_code, size_t value) {
+  switch(error_code) {
+    case _COWVEC_ERROR_NO_DATA:
+      fprintf(stderr, "ERROR: CowVec: Pointer to data is NULL but length is not 0. Length: %zu.\n", value);
+    break;
+
+    case _COWVEC_ERROR_CAPACITY_TOO_SMALL:
+      fprintf(stderr, "ERROR: CowVec: Vector capacity is too small to hold vector data. Capacity: %zu.\n", value);
+    break;
+
+    case _COWVEC_ERROR_INDEX_OUT_OF_BOUNDS:
+      fprintf(stderr, "ERROR: CowVec: Index is out of bound. Index: %zu.\n", value);
+    break;
+
+    default:
+      fprintf(stderr, "ERROR: _cowvec_panic(): Unknown error code: %d.\n", error_code);
+  }
+
+  abort();
+}
+
+/* Allocate buffer with single reference. */
+static _CowVec_buffer * _cowvec_buffer_new(size_t element_size, size_t capacity) {
+  _CowVec_buffer * buffer = mem_malloc(1, sizeof(_CowVec_buffer) + capacity * element_size);
+  buffer->refcount = 1;
+  buffer->capacity = capacity;
+  return buffer;
+}
+
+_CowVec _cowvec_with_capacity(size_t element_size, size_t capacity) {
+  return (_CowVec) { .buffer = _cowvec_buffer_new(element_size, capacity), .count = 0 };
+}
+
+_CowVec _cowvec_from_datap(size_t element_size, const void * data, size_t length, size_t capacity) {
+  if(data == NULL && length != 0) {
+    _cowvec_panic(_COWVEC_ERROR_NO_DATA, length);
+  }
+  if(capacity < length) {
+    _cowvec_panic(_COWVEC_ERROR_CAPACITY_TOO_SMALL, capacity);
+  }
+
+  _CowVec self = _cowvec_with_capacity(element_size, capacity);
+  if(length > 0) {
+    memcpy(_cowvec_data(&self), data, length * element_size);
+  }
+  self.count = length;
+  return self;
+}
+
+void _cowvec_destroy(_CowVec * self) {
+  if(self->buffer != NULL) {
+    // Release makes writes of this handle visible to thread, which frees buffer
+    if(__atomic_sub_fetch(&self->buffer->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+      mem_free(self->buffer);
+    }
+    self->buffer = NULL;
+  }
+  self->count = 0;
+}
+
+void _cowvec_make_mut(_CowVec * self, size_t element_size, size_t additional_capacity) {
+  size_t required = self->count + additional_capacity;
+  size_t capacity = self->buffer->capacity;
+
+  if(_cowvec_is_shared(self)) {
+    // Copy only elements of this handle; other handles keep old buffer
+    if(capacity < required) {
+      capacity = required > capacity * 2 ? required : capacity * 2;
+    }
+    _CowVec_buffer * buffer = _cowvec_buffer_new(element_size, capacity);
+    memcpy((char *)buffer + sizeof(_CowVec_buffer), _cowvec_data(self), self->count * element_size);
+
+    // Other handle may drop its reference in the meantime, so buffer must be released properly
+    _CowVec old = *self;
+    _cowvec_destroy(&old);
+    self->buffer = buffer;
+    return;
+  }
+
+  if(capacity < required) {
+    capacity = required > capacity * 2 ? required : capacity * 2;
+    self->buffer = mem_realloc(self->buffer, 1, sizeof(_CowVec_buffer) + capacity * element_size);
+    self->buffer->capacity = capacity;
+  }
+}
@@ -0,0 +1,279 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#ifndef CRUST_TYPE_COWVEC_H_
+#define CRUST_TYPE_COWVEC_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "crust-mem.h"
+#include "crust-type-slice.h"
+#include "crust-type-string.h"
+
+#ifdef _CRUST_TESTS
+#include "crust-unittest.h"
+
+#include "crust-type-array.h"
+#endif
+
+enum _CowVec_error_codes {
+  _COWVEC_ERROR_NO_DATA = 1,
+  _COWVEC_ERROR_INDEX_OUT_OF_BOUNDS = 2,
+  _COWVEC_ERROR_CAPACITY_TOO_SMALL = 3,
+};
+
+void _cowvec_panic(int error_code, size_t index);
+#ifdef _CRUST_TESTS
+it(_cowvec_panic, "must abort program using abort()") {
+  assert_abort(_cowvec_panic(_COWVEC_ERROR_NO_DATA, 1), "must abort");
+  assert_abort(_cowvec_panic(_COWVEC_ERROR_INDEX_OUT_OF_BOUNDS, 1), "must abort");
+  assert_abort(_cowvec_panic(_COWVEC_ERROR_CAPACITY_TOO_SMALL, 1), "must abort");
+  assert_abort(_cowvec_panic(12312, 1), "must abort");
+}
+#endif
+
+/** Header of shared buffer. Elements follow header. Size of header is 16
+ * bytes, so elements keep alignment of malloc(). */
+typedef struct _CowVec_buffer_s {
+  size_t refcount;
+  size_t capacity;
+} _CowVec_buffer;
+
+/**
+ * Copy-on-write vector.
+ *
+ * Clone shares buffer with original and increments atomic reference
+ * counter, so clone is O(1) and costs no memory. Reads never copy. First
+ * mutation through handle, which shares buffer, copies elements into
+ * private buffer, so other handles don't see the change. Every handle has
+ * own length, so truncate() never copies.
+ *
+ * Handles can be passed to other threads. Single handle must not be used by
+ * two threads at once.
+ */
+typedef struct _CowVec_s {
+  _CowVec_buffer * buffer;
+  size_t count;
+} _CowVec;
+
+/** Release buffer and clear length. Buffer is freed with last handle.
+ * It's safe to call destroy() twice. */
+NN void _cowvec_destroy(_CowVec * self);
+
+/** Create new empty vector with given capacity. */
+WUR struct _CowVec_s _cowvec_with_capacity(size_t element_size, size_t capacity);
+#ifdef _CRUST_TESTS
+it(_cowvec_with_capacity, "must create new vector with given capacity and single reference") {
+  defer(_cowvec_destroy) _CowVec vec = _cowvec_with_capacity(sizeof(int), 4);
+  assert_equal_int(0, vec.count, "unexpected length");
+  assert_equal_int(4, vec.buffer->capacity, "unexpected capacity");
+  assert_equal_int(1, vec.buffer->refcount, "unexpected number of references");
+}
+#endif
+
+/** Create new vector by copying given data into vector.
+ * Panics when capacity is less than length of array.
+ * Panics when pointer is NULL but length is not 0. */
+WUR struct _CowVec_s _cowvec_from_datap(size_t element_size, const void * data, size_t length, size_t capacity);
+
+/** Return pointer to elements. Elements must not be modified through it,
+ * unless _cowvec_make_mut() is called before. */
+NN WUR MU SI void * _cowvec_data(const _CowVec * self) {
+  return (char *)self->buffer + sizeof(_CowVec_buffer);
+}
+
+/** Return new handle, which shares buffer with this one. */
+NN WUR MU SI struct _CowVec_s _cowvec_clone(const _CowVec * self) {
+  __atomic_fetch_add(&self->buffer->refcount, 1, __ATOMIC_RELAXED);
+  return *self;
+}
+
+/** Return true, when buffer is shared with other handles. */
+NN WUR MU SI bool _cowvec_is_shared(const _CowVec * self) {
+  return __atomic_load_n(&self->buffer->refcount, __ATOMIC_ACQUIRE) > 1;
+}
+#ifdef _CRUST_TESTS
+it(_cowvec_clone, "must share buffer and count references") {
+  int data[] = { 1, 2, 3 };
+  defer(_cowvec_destroy) _CowVec vec = _cowvec_from_datap(sizeof(int), data, LENGTH_OF_ARRAY(data), LENGTH_OF_ARRAY(data));
+  assert_true(!_cowvec_is_shared(&vec), "new vector must not be shared");
+
+  defer(_cowvec_destroy) _CowVec copy = _cowvec_clone(&vec);
+  assert_true(copy.buffer == vec.buffer, "clone must share buffer");
+  assert_true(_cowvec_is_shared(&vec), "vector must be shared after clone");
+
+  _cowvec_destroy(&copy);
+  assert_true(!_cowvec_is_shared(&vec), "vector must not be shared after clone is destroyed");
+}
+#endif
+
+/** Make buffer private, by copying it when it's shared, and make room for
+ * additional elements. Must be called before any modification. */
+NN void _cowvec_make_mut(_CowVec * self, size_t element_size, size_t additional_capacity);
+#ifdef _CRUST_TESTS
+it(_cowvec_make_mut, "must copy shared buffer before modification") {
+  int data[] = { 1, 2, 3 };
+  defer(_cowvec_destroy) _CowVec vec = _cowvec_from_datap(sizeof(int), data, LENGTH_OF_ARRAY(data), LENGTH_OF_ARRAY(data));
+  defer(_cowvec_destroy) _CowVec copy = _cowvec_clone(&vec);
+
+  _cowvec_make_mut(&copy, sizeof(int), 0);
+  assert_true(copy.buffer != vec.buffer, "shared buffer must be copied");
+  ((int *)_cowvec_data(&copy))[0] = 42;
+  assert_equal_int(1, ((int *)_cowvec_data(&vec))[0], "original must not change");
+
+  _CowVec_buffer * buffer = vec.buffer;
+  _cowvec_make_mut(&vec, sizeof(int), 0);
+  assert_true(vec.buffer == buffer, "private buffer must not be copied");
+}
+#endif
+
+//
+// Template for CowVec
+//
+
+#define DEFINE_COWVEC_STRUCT(SELFNAME) \
+typedef struct { \
+  _CowVec super; \
+} SELFNAME;
+
+#define DEFINE_COWVEC_WITH_CAPACITY(SELFNAME, SELFPREFIX, CTYPE) \
+WUR MU SI SELFNAME SELFPREFIX##_with_capacity(size_t capacity) { return (SELFNAME) { .super = _cowvec_with_capacity(sizeof(CTYPE), capacity) }; }
+
+#define DEFINE_COWVEC_NEW(SELFNAME, SELFPREFIX, CTYPE) \
+WUR MU SI SELFNAME SELFPREFIX##_new() { return (SELFNAME) { .super = _cowvec_with_capacity(sizeof(CTYPE), 8) }; }
+
+#define DEFINE_COWVEC_FROM_DATAP(SELFNAME, SELFPREFIX, CTYPE) \
+WUR MU SI SELFNAME SELFPREFIX##_from_datap(const CTYPE * data, size_t length, size_t capacity) { return (SELFNAME) { .super = _cowvec_from_datap(sizeof(CTYPE), data, length, capacity) }; }
+
+#define DEFINE_COWVEC_CLONE(SELFNAME, SELFPREFIX, CTYPE) \
+/** Return handle, which shares buffer with this one. No data is copied. */ \
+NN WUR MU SI SELFNAME SELFPREFIX##_clone(const SELFNAME * self) { return (SELFNAME) { .super = _cowvec_clone(&self->super) }; }
+
+#define DEFINE_COWVEC_DESTROY(SELFNAME, SELFPREFIX, CTYPE) \
+MU SI void SELFPREFIX##_destroy(SELFNAME * self) { _cowvec_destroy(&self->super); }
+
+#define DEFINE_COWVEC_IS_SHARED(SELFNAME, SELFPREFIX) \
+NN WUR MU SI bool SELFPREFIX##_is_shared(const SELFNAME * self) { return _cowvec_is_shared(&self->super); }
+
+#define DEFINE_COWVEC_LEN(SELFNAME, SELFPREFIX) \
+NN WUR MU SI size_t SELFPREFIX##_len(const SELFNAME * self) { return self->super.count; }
+
+#define DEFINE_COWVEC_CAPACITY(SELFNAME, SELFPREFIX) \
+NN WUR MU SI size_t SELFPREFIX##_capacity(const SELFNAME * self) { return self->super.buffer->capacity; }
+
+#define DEFINE_COWVEC_RESERVE(SELFNAME, SELFPREFIX, CTYPE) \
+NN MU SI void SELFPREFIX##_reserve(SELFNAME * self, size_t additional_capacity) { _cowvec_make_mut(&self->super, sizeof(CTYPE), additional_capacity); }
+
+#define DEFINE_COWVEC_AS_PTR(SELFNAME, SELFPREFIX, CTYPE) \
+/** Return pointer to elements for reading. */ \
+NN WUR MU SI const CTYPE * SELFPREFIX##_as_ptr(const SELFNAME * self) { return (const CTYPE *)_cowvec_data(&self->super); }
+
+#define DEFINE_COWVEC_AS_MUT_PTR(SELFNAME, SELFPREFIX, CTYPE) \
+/** Return pointer to elements for writing. Shared buffer is copied first. */ \
+NN WUR MU SI CTYPE * SELFPREFIX##_as_mut_ptr(SELFNAME * self) { \
+  _cowvec_make_mut(&self->super, sizeof(CTYPE), 0); \
+  return (CTYPE *)_cowvec_data(&self->super); \
+}
+
+#define DEFINE_COWVEC_GET(SELFNAME, SELFPREFIX, CTYPE) \
+NN WUR MU SI CTYPE SELFPREFIX##_get(const SELFNAME * self, size_t index) { \
+  if(index >= self->super.count) { \
+    _cowvec_panic(_COWVEC_ERROR_INDEX_OUT_OF_BOUNDS, index); \
+  } \
+  return SELFPREFIX##_as_ptr(self)[index]; \
+}
+
+#define DEFINE_COWVEC_GET_UNCHECKED(SELFNAME, SELFPREFIX, CTYPE) \
+NN WUR MU SI CTYPE SELFPREFIX##_get_unchecked(const SELFNAME * self, size_t index) { \
+  return SELFPREFIX##_as_ptr(self)[index]; \
+}
+
+#define DEFINE_COWVEC_GET_MUT(SELFNAME, SELFPREFIX, CTYPE) \
+/** Return pointer to element for writing. Shared buffer is copied first. */ \
+NN WUR MU SI CTYPE * SELFPREFIX##_get_mut(SELFNAME * self, size_t index) { \
+  if(index >= self->super.count) { \
+    _cowvec_panic(_COWVEC_ERROR_INDEX_OUT_OF_BOUNDS, index); \
+  } \
+  return &SELFPREFIX##_as_mut_ptr(self)[index]; \
+}
+
+#define DEFINE_COWVEC_PUSH(SELFNAME, SELFPREFIX, CTYPE) \
+NN MU SI size_t SELFPREFIX##_push(SELFNAME * self, const CTYPE value) { \
+  _cowvec_make_mut(&self->super, sizeof(CTYPE), 1); \
+  ((CTYPE *)_cowvec_data(&self->super))[self->super.count] = value; \
+  return self->super.count++; \
+}
+
+#define DEFINE_COWVEC_SET(SELFNAME, SELFPREFIX, CTYPE) \
+MU SI CTYPE SELFPREFIX##_set(SELFNAME * self, size_t index, const CTYPE value) { \
+  CTYPE * element = SELFPREFIX##_get_mut(self, index); \
+  CTYPE prev = *element; \
+  *element = value; \
+  return prev; \
+}
+
+#define DEFINE_COWVEC_TRUNCATE(SELFNAME, SELFPREFIX, CTYPE) \
+/** Shorten this handle. Buffer is not copied, because elements are not modified. */ \
+MU SI void SELFPREFIX##_truncate(SELFNAME * self, size_t length) { \
+  if(length < self->super.count) { \
+    self->super.count = length; \
+  } \
+}
+
+#define COWVEC_BY_VALUE_TEMPLATE(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_COWVEC_STRUCT(SELFNAME) \
+DEFINE_COWVEC_WITH_CAPACITY(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_COWVEC_NEW(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_COWVEC_FROM_DATAP(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_COWVEC_CLONE(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_COWVEC_DESTROY(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_COWVEC_IS_SHARED(SELFNAME, SELFPREFIX) \
+DEFINE_COWVEC_LEN(SELFNAME, SELFPREFIX) \
+DEFINE_COWVEC_CAPACITY(SELFNAME, SELFPREFIX) \
+DEFINE_COWVEC_RESERVE(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_COWVEC_AS_PTR(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_COWVEC_AS_MUT_PTR(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_COWVEC_GET(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_COWVEC_GET_UNCHECKED(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_COWVEC_GET_MUT(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_COWVEC_PUSH(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_COWVEC_SET(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_COWVEC_TRUNCATE(SELFNAME, SELFPREFIX, CTYPE) \
+
+#define COWVEC_TO_SLICE(SELFNAME, SELFPREFIX, CTYPE, SLICETYPENAME, SLICEPREFIX) \
+/** Return slice of elements. Slice is valid until this handle is modified or destroyed. */ \
+NN WUR MU SI SLICETYPENAME SELFPREFIX##_as_slice(const SELFNAME * self) { \
+  return SLICEPREFIX##_from_raw_parts(SELFPREFIX##_as_ptr(self), self->super.count); \
+} \
+/** Create vector with copy of elements of slice. */ \
+NN WUR MU SI SELFNAME SELFPREFIX##_from_slice(const SLICETYPENAME * slice) { \
+  return SELFPREFIX##_from_datap(SLICEPREFIX##_as_ptr(slice), SLICEPREFIX##_len(slice), SLICEPREFIX##_len(slice)); \
+}
+
+//
+// Copy-on-write string
+//
+
+COWVEC_BY_VALUE_TEMPLATE(CowString, cowstring, char)
+COWVEC_TO_SLICE(CowString, cowstring, char, Str, str)
+
+/** Create shared string with copy of C string. */
+NN WUR MU SI CowString cowstring_from_charp(const char * charp) {
+  return cowstring_from_datap(charp, strlen(charp), strlen(charp));
+}
+
+/** Append text of Str and return new length. Shared buffer is copied first. */
+NN MU SI size_t cowstring_put_str(CowString * self, const Str * str) {
+  size_t length = str_len(str);
+  _cowvec_make_mut(&self->super, sizeof(char), length);
+  memcpy((char *)_cowvec_data(&self->super) + self->super.count, str_as_ptr(str), length);
+  return self->super.count += length;
+}
+
+#endif /* CRUST_TYPE_COWVEC_H_ */
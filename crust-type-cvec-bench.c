@@ -0,0 +1,69 @@
+#include <pthread.h>
+
+#include "crust-type-cvec.h"
+#include "crust-type-vec.h"
+
+#include "crust-bench.h"
+
+CVEC_BY_VALUE_TEMPLATE(CVec_int, cvec_int, int)
+VEC_BY_VALUE_TEMPLATE(Vec_int, vec_int, int)
+
+#define CVEC_BENCH_MAX_THREADS 8
+
+typedef struct {
+  CVec_int * cvec;
+  Vec_int * vec;
+  pthread_mutex_t * lock;
+  size_t count;
+} CVecBenchWorker;
+
+static void * cvec_bench_push(void * arg) {
+  CVecBenchWorker * worker = arg;
+  for(size_t i = 0; i < worker->count; i++) {
+    (void)cvec_int_push(worker->cvec, (int)i);
+  }
+  return NULL;
+}
+
+static void * cvec_bench_locked_push(void * arg) {
+  CVecBenchWorker * worker = arg;
+  for(size_t i = 0; i < worker->count; i++) {
+    pthread_mutex_lock(worker->lock);
+    vec_int_push(worker->vec, (int)i);
+    pthread_mutex_unlock(worker->lock);
+  }
+  return NULL;
+}
+
+/* Push b->iterations ints from given number of threads into one vector. */
+static void cvec_bench_run(Bench * b, size_t threads, void * (*fn)(void *)) {
+  defer(cvec_int_destroy) CVec_int cvec = cvec_int_new();
+  defer(vec_int_destroy) Vec_int vec = vec_int_new();
+  pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+  pthread_t ids[CVEC_BENCH_MAX_THREADS];
+  CVecBenchWorker workers[CVEC_BENCH_MAX_THREADS];
+
+  for(size_t i = 0; i < threads; i++) {
+    workers[i] = (CVecBenchWorker) { .cvec = &cvec, .vec = &vec, .lock = &lock,
+      .count = b->iterations / threads + (i == 0 ? b->iterations % threads : 0) };
+    pthread_create(&ids[i], NULL, fn, &workers[i]);
+  }
+  for(size_t i = 0; i < threads; i++) {
+    pthread_join(ids[i], NULL);
+  }
+  bench_clobber();
+}
+
+#define DEFINE_CVEC_PUSH_BENCH(THREADS) \
+bench(cvec_push_threads_##THREADS, "push int into shared CVec from " #THREADS " thread(s)") { \
+  cvec_bench_run(b, THREADS, &cvec_bench_push); \
+} \
+\
+bench(cvec_vec_mutex_push_threads_##THREADS, "push int into shared Vec under mutex from " #THREADS " thread(s)") { \
+  cvec_bench_run(b, THREADS, &cvec_bench_locked_push); \
+}
+
+DEFINE_CVEC_PUSH_BENCH(1)
+DEFINE_CVEC_PUSH_BENCH(2)
+DEFINE_CVEC_PUSH_BENCH(4)
+DEFINE_CVEC_PUSH_BENCH(8)
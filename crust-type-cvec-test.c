@@ -0,0 +1,97 @@
+#include <pthread.h>
+
+#include "crust-type-cvec.h"
+#include "crust-type-vec.h"
+#include "crust-unittest.h"
+
+CVEC_BY_VALUE_TEMPLATE(CVec_int, cvec_int, int)
+VEC_BY_VALUE_TEMPLATE(Vec_int, vec_int, int)
+CVEC_TO_VEC(CVec_int, cvec_int, int, Vec_int, vec_int)
+
+it(cvec_int_push_get, "must push values and return them by index") {
+  defer(cvec_int_destroy) CVec_int vec = cvec_int_new();
+
+  for(int i=0; i<100; i++) {
+    assert_equal_int(i, cvec_int_push(&vec, i*2), "cvec_int_push() must return index of element");
+  }
+
+  assert_equal_int(100, cvec_int_snapshot_len(&vec), "Unexpected length after cvec_int_push()");
+  for(int i=0; i<100; i++) {
+    assert_equal_int(i*2, cvec_int_get(&vec, i), "Unexpected value of item after cvec_int_push()");
+  }
+
+  *cvec_int_get_mut(&vec, 5) = 42;
+  assert_equal_int(42, cvec_int_get_unchecked(&vec, 5), "Value must be changed through pointer");
+  assert_abort((void)(0 == cvec_int_get(&vec, 100)), "cvec_int_get() must abort on index out of bounds");
+}
+
+#define CVEC_TEST_THREADS 4
+#define CVEC_TEST_PUSHES 50000
+
+static void * cvec_int_test_writer(void * arg) {
+  CVec_int * vec = arg;
+  for(int i=0; i<CVEC_TEST_PUSHES; i++) {
+    int * item = cvec_int_get_unchecked_mut(vec, cvec_int_push(vec, i));
+    if(*item != i) {
+      abort();
+    }
+  }
+  return NULL;
+}
+
+it(cvec_int_concurrent_push, "must keep all values pushed by many threads at once") {
+  defer(cvec_int_destroy) CVec_int vec = cvec_int_new();
+  pthread_t threads[CVEC_TEST_THREADS];
+
+  for(int i=0; i<CVEC_TEST_THREADS; i++) {
+    pthread_create(&threads[i], NULL, &cvec_int_test_writer, &vec);
+  }
+  for(int i=0; i<CVEC_TEST_THREADS; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  assert_equal_int(CVEC_TEST_THREADS * CVEC_TEST_PUSHES, cvec_int_snapshot_len(&vec), "All pushes must be counted");
+
+  defer(vec_int_destroy) Vec_int flat = cvec_int_to_vec(&vec);
+  assert_equal_int(CVEC_TEST_THREADS * CVEC_TEST_PUSHES, vec_int_len(&flat), "cvec_int_to_vec() must copy all elements");
+
+  int * seen = calloc(CVEC_TEST_PUSHES, sizeof(int));
+  for(size_t i=0; i<vec_int_len(&flat); i++) {
+    seen[vec_int_get(&flat, i)]++;
+  }
+  for(int i=0; i<CVEC_TEST_PUSHES; i++) {
+    assert_equal_int(CVEC_TEST_THREADS, seen[i], "Every value must be pushed by every thread");
+  }
+  free(seen);
+}
+
+static void * cvec_int_test_nonzero_writer(void * arg) {
+  CVec_int * vec = arg;
+  for(int i=1; i<=CVEC_TEST_PUSHES; i++) {
+    (void)cvec_int_push(vec, i);
+  }
+  return NULL;
+}
+
+it(cvec_int_snapshot_len_concurrent, "must publish only written prefix while writers are active") {
+  defer(cvec_int_destroy) CVec_int vec = cvec_int_new();
+  pthread_t threads[CVEC_TEST_THREADS];
+
+  for(int i=0; i<CVEC_TEST_THREADS; i++) {
+    pthread_create(&threads[i], NULL, &cvec_int_test_nonzero_writer, &vec);
+  }
+
+  // Segments are zeroed, so zero in written prefix means that unwritten slot is published
+  size_t unwritten = 0, checked = 0;
+  for(size_t length = 0; length < CVEC_TEST_THREADS * CVEC_TEST_PUSHES; length = cvec_int_snapshot_len(&vec)) {
+    for(; checked < length; checked++) {
+      unwritten += cvec_int_get(&vec, checked) == 0;
+    }
+  }
+  for(int i=0; i<CVEC_TEST_THREADS; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  assert_equal_int(0, unwritten, "Written prefix must contain written elements only");
+  assert_equal_int(CVEC_TEST_THREADS * CVEC_TEST_PUSHES, cvec_int_snapshot_len(&vec), "All pushes must be published");
+}
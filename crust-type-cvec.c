@@ -0,0 +1,107 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "crust-type-cvec.h"
+#include "crust-mem.h"
+
+void _cvec_panic(int error_code, size_t value) {
+  switch(error_code) {
+    case _CVEC_ERROR_INDEX_OUT_OF_BOUNDS:
+      fprintf(stderr, "ERROR: CVec: Index is out of bound. Index: %zu.\n", value);
+    break;
+
+    default:
+      fprintf(stderr, "ERROR: _cvec_panic(): Unknown error code: %d.\n", error_code);
+  }
+
+  abort();
+}
+
+/* Return segment, allocate and install it when it is missing. */
+static void * _cvec_segment(_CVec * self, size_t segment) {
+  void * data = __atomic_load_n(&self->segments[segment], __ATOMIC_ACQUIRE);
+
+  if(!data) {
+    void * fresh = mem_calloc(_segvec_segment_capacity(segment), self->element_size);
+    if(__atomic_compare_exchange_n(&self->segments[segment], &data, fresh, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      data = fresh;
+    } else {
+      // Other thread installed segment first, data is updated by failed CAS
+      mem_free(fresh);
+    }
+  }
+
+  return data;
+}
+
+_CVec _cvec_with_capacity(size_t element_size, size_t capacity) {
+  _CVec self = _cvec_new(element_size);
+
+  for(size_t segment = 0; capacity > 0 && _segvec_segment_start(segment) < capacity; segment++) {
+    (void)_cvec_segment(&self, segment);
+  }
+
+  return self;
+}
+
+void _cvec_destroy(_CVec * self) {
+  for(size_t segment = 0; segment < _SEGVEC_MAX_SEGMENTS; segment++) {
+    if(self->segments[segment]) {
+      mem_free(self->segments[segment]);
+      self->segments[segment] = NULL;
+    }
+    self->written[segment] = 0;
+  }
+  self->reserved = 0;
+}
+
+size_t _cvec_push(_CVec * self, const void * value) {
+  size_t index = __atomic_fetch_add(&self->reserved, 1, __ATOMIC_RELAXED);
+  size_t segment = _segvec_segment_of(index);
+  char * data = _cvec_segment(self, segment);
+
+  memcpy(data + (index - _segvec_segment_start(segment)) * self->element_size, value, self->element_size);
+
+  // Publish value to readers, which see it when all reserved slots of segment are written
+  __atomic_fetch_add(&self->written[segment], 1, __ATOMIC_RELEASE);
+
+  return index;
+}
+
+size_t _cvec_snapshot_len(const _CVec * self) {
+  size_t length = 0;
+
+  for(size_t segment = 0; segment < _SEGVEC_MAX_SEGMENTS; segment++) {
+    length = _cvec_segment_written_end(self, segment);
+    if(length < _segvec_segment_start(segment) + _segvec_segment_capacity(segment)) {
+      break;
+    }
+  }
+
+  return length;
+}
+
+_Vec _cvec_to_vec(const _CVec * self) {
+  size_t length = _cvec_snapshot_len(self);
+  _Vec vec = _vec_with_capacity(self->element_size, length);
+
+  for(size_t segment = 0; _segvec_segment_start(segment) < length; segment++) {
+    size_t start = _segvec_segment_start(segment);
+    size_t count = _segvec_segment_capacity(segment);
+    if(start + count > length) {
+      count = length - start;
+    }
+    memcpy((char *)vec.data + start * self->element_size, self->segments[segment], count * self->element_size);
+  }
+  vec.count = length;
+
+  return vec;
+}
@@ -0,0 +1,216 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#ifndef CRUST_TYPE_CVEC_H_
+#define CRUST_TYPE_CVEC_H_
+
+#include <sys/types.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "crust-mem.h"
+#include "crust-type-vec.h"
+#include "crust-type-segvec.h"
+
+#ifdef _CRUST_TESTS
+#include "crust-unittest.h"
+#endif
+
+enum _CVec_error_codes {
+  _CVEC_ERROR_INDEX_OUT_OF_BOUNDS = 1,
+};
+
+void _cvec_panic(int error_code, size_t index);
+#ifdef _CRUST_TESTS
+it(_cvec_panic, "must abort program using abort()") {
+  assert_abort(_cvec_panic(_CVEC_ERROR_INDEX_OUT_OF_BOUNDS, 1), "must abort");
+  assert_abort(_cvec_panic(12312, 1), "must abort");
+}
+#endif
+
+/**
+ * Concurrent append-only vector.
+ *
+ * Elements are stored in same segments as in SegVec, which are
+ * never reallocated, so pointers to elements stay valid until destroy().
+ * Any number of threads can push() concurrently: slot is reserved with
+ * atomic fetch-and-add, and missing segment is allocated and installed with
+ * compare-and-swap.
+ *
+ * Push never waits for other writers: after value is copied, it increments
+ * counter of written slots of its segment. Readers compare these counters
+ * with number of reserved slots, so snapshot_len() is length of prefix,
+ * which is fully written, and elements of that prefix can be read by any
+ * thread while writers are active. Segment, which has pushes in flight, is
+ * not published until all of them are done, so snapshot_len() can lag
+ * behind, and it is exact when writers are done.
+ */
+typedef struct _CVec_s {
+  void * segments[_SEGVEC_MAX_SEGMENTS];
+  size_t element_size;
+  /** Number of reserved slots. */
+  size_t reserved;
+  /** Number of written slots in each segment. */
+  size_t written[_SEGVEC_MAX_SEGMENTS];
+} _CVec;
+
+/** Create new empty vector. No memory is allocated. */
+WUR MU SI struct _CVec_s _cvec_new(size_t element_size) { return (_CVec) { .element_size = element_size }; }
+
+/** Create new empty vector with segments preallocated for given number of elements. */
+WUR struct _CVec_s _cvec_with_capacity(size_t element_size, size_t capacity);
+
+/** Free all segments. Must not be called while other threads use vector.
+ * It's safe to call destroy() twice. */
+NN void _cvec_destroy(_CVec * self);
+
+/** Copy value into new slot at the end of vector and return index of the slot.
+ * Safe to call from many threads at once. */
+NN size_t _cvec_push(_CVec * self, const void * value);
+
+/** Return end of written part of segment: end of segment or of reserved
+ * slots, when all reserved slots of segment are written, or start of segment
+ * otherwise. */
+NN WUR MU SI size_t _cvec_segment_written_end(const _CVec * self, size_t segment) {
+  // Counter is loaded first, so it counts only slots below loaded number of reserved slots
+  size_t written = __atomic_load_n(&self->written[segment], __ATOMIC_ACQUIRE);
+  size_t reserved = __atomic_load_n(&self->reserved, __ATOMIC_ACQUIRE);
+  size_t start = _segvec_segment_start(segment);
+  size_t end = start + _segvec_segment_capacity(segment);
+
+  if(reserved < end) {
+    end = reserved;
+  }
+  if(end <= start || written != end - start) {
+    return start;
+  }
+  return end;
+}
+
+/** Return length of fully written prefix. Exact when writers are done. */
+NN WUR size_t _cvec_snapshot_len(const _CVec * self);
+
+/** Return pointer to element without bounds checking. */
+NN WUR MU SI void * _cvec_get_ptr_unchecked(const _CVec * self, size_t index) {
+  size_t segment = _segvec_segment_of(index);
+  char * data = __atomic_load_n(&self->segments[segment], __ATOMIC_ACQUIRE);
+  return data + (index - _segvec_segment_start(segment)) * self->element_size;
+}
+
+/** Return pointer to element. Panics when element is not written yet. */
+NN WUR MU SI void * _cvec_get_ptr(const _CVec * self, size_t index) {
+  if(index >= _cvec_segment_written_end(self, _segvec_segment_of(index))) {
+    _cvec_panic(_CVEC_ERROR_INDEX_OUT_OF_BOUNDS, index);
+  }
+  return _cvec_get_ptr_unchecked(self, index);
+}
+#ifdef _CRUST_TESTS
+it(_cvec_push, "must push values across segment boundaries and keep their addresses") {
+  defer(_cvec_destroy) _CVec vec = _cvec_new(sizeof(int));
+  int value = 0;
+  assert_equal_int(0, _cvec_push(&vec, &value), "must return index of pushed element");
+  int * first = _cvec_get_ptr(&vec, 0);
+
+  for(value=1; value<1000; value++) {
+    assert_equal_int(value, _cvec_push(&vec, &value), "must return index of pushed element");
+  }
+
+  assert_equal_int(1000, _cvec_snapshot_len(&vec), "unexpected length");
+  assert_true(first == _cvec_get_ptr(&vec, 0), "address of element must not change");
+  for(int i=0; i<1000; i++) {
+    assert_equal_int(i, *(int *)_cvec_get_ptr(&vec, i), "unexpected value");
+  }
+
+  assert_abort((void)(NULL == _cvec_get_ptr(&vec, 1000)), "must panic when index is out of bounds");
+}
+
+it(_cvec_snapshot_len, "must not publish segment while push into it is in flight") {
+  defer(_cvec_destroy) _CVec vec = _cvec_new(sizeof(int));
+  for(int value=0; value<100; value++) {
+    (void)_cvec_push(&vec, &value);
+  }
+
+  // Reserve slot 100 without writing it, like concurrent push does
+  vec.reserved++;
+  assert_equal_int(_segvec_segment_start(_segvec_segment_of(100)), _cvec_snapshot_len(&vec), "must stop at segment with unwritten slot");
+  assert_equal_int(0, *(int *)_cvec_get_ptr(&vec, 0), "elements of written segments must be readable");
+  assert_abort((void)(NULL == _cvec_get_ptr(&vec, 99)), "must panic when segment has unwritten slot");
+
+  vec.reserved--;
+  assert_equal_int(100, _cvec_snapshot_len(&vec), "must publish segment when all reserved slots are written");
+}
+#endif
+
+/** Copy elements into new vector with capacity equal to length.
+ * Must be called when writers are done. */
+NN WUR struct _Vec_s _cvec_to_vec(const _CVec * self);
+#ifdef _CRUST_TESTS
+it(_cvec_to_vec, "must copy elements into contiguous vector") {
+  defer(_cvec_destroy) _CVec cvec = _cvec_with_capacity(sizeof(int), 100);
+  for(int value=0; value<100; value++) {
+    (void)_cvec_push(&cvec, &value);
+  }
+
+  defer(_vec_destroy) _Vec vec = _cvec_to_vec(&cvec);
+  assert_equal_int(100, vec.count, "unexpected length");
+  assert_equal_int(100, vec.capacity, "unexpected capacity");
+  for(int i=0; i<100; i++) {
+    assert_equal_int(i, ((int *)vec.data)[i], "unexpected value");
+  }
+}
+#endif
+
+//
+// Template for CVec
+//
+
+#define DEFINE_CVEC_STRUCT(SELFNAME) \
+typedef struct { \
+  _CVec super; \
+} SELFNAME;
+
+#define DEFINE_CVEC_NEW(SELFNAME, SELFPREFIX, CTYPE) \
+/** Create new empty vector. */ \
+WUR MU SI SELFNAME SELFPREFIX##_new() { return (SELFNAME) { .super = _cvec_new(sizeof(CTYPE)) }; } \
+/** Create new empty vector with segments preallocated for given number of elements. */ \
+WUR MU SI SELFNAME SELFPREFIX##_with_capacity(size_t capacity) { return (SELFNAME) { .super = _cvec_with_capacity(sizeof(CTYPE), capacity) }; }
+
+#define DEFINE_CVEC_DESTROY(SELFNAME, SELFPREFIX) \
+/** Free all segments. Must not be called while other threads use vector. */ \
+MU SI void SELFPREFIX##_destroy(SELFNAME * self) { _cvec_destroy(&self->super); }
+
+#define DEFINE_CVEC_PUSH_BY_VALUE(SELFNAME, SELFPREFIX, CTYPE) \
+/** Append value and return its index. Safe to call from many threads at once. */ \
+NN MU SI size_t SELFPREFIX##_push(SELFNAME * self, const CTYPE value) { return _cvec_push(&self->super, &value); }
+
+#define DEFINE_CVEC_SNAPSHOT_LEN(SELFNAME, SELFPREFIX) \
+/** Return length of fully written prefix. Exact when writers are done. */ \
+NN WUR MU SI size_t SELFPREFIX##_snapshot_len(const SELFNAME * self) { return _cvec_snapshot_len(&self->super); }
+
+#define DEFINE_CVEC_GET(SELFNAME, SELFPREFIX, CTYPE) \
+/** Return item by index. Panics if item is not written yet. */ \
+NN WUR MU SI CTYPE SELFPREFIX##_get(const SELFNAME * self, size_t index) { return *(CTYPE *)_cvec_get_ptr(&self->super, index); } \
+/** Return item by index without checks. */ \
+NN WUR MU SI CTYPE SELFPREFIX##_get_unchecked(const SELFNAME * self, size_t index) { return *(CTYPE *)_cvec_get_ptr_unchecked(&self->super, index); } \
+/** Return stable pointer to item by index. Panics if item is not written yet. */ \
+NN WUR MU SI CTYPE * SELFPREFIX##_get_mut(SELFNAME * self, size_t index) { return (CTYPE *)_cvec_get_ptr(&self->super, index); } \
+/** Return stable pointer to item by index without checks. */ \
+NN WUR MU SI CTYPE * SELFPREFIX##_get_unchecked_mut(SELFNAME * self, size_t index) { return (CTYPE *)_cvec_get_ptr_unchecked(&self->super, index); }
+
+#define CVEC_BY_VALUE_TEMPLATE(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_CVEC_STRUCT(SELFNAME) \
+DEFINE_CVEC_NEW(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_CVEC_DESTROY(SELFNAME, SELFPREFIX) \
+DEFINE_CVEC_PUSH_BY_VALUE(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_CVEC_SNAPSHOT_LEN(SELFNAME, SELFPREFIX) \
+DEFINE_CVEC_GET(SELFNAME, SELFPREFIX, CTYPE) \
+
+#define CVEC_TO_VEC(SELFNAME, SELFPREFIX, CTYPE, VECTYPENAME, VECPREFIX) \
+/** Flatten into new vector. Must be called when writers are done. */ \
+NN WUR MU SI VECTYPENAME SELFPREFIX##_to_vec(const SELFNAME * self) { return (VECTYPENAME) { .super = _cvec_to_vec(&self->super) }; }
+
+#endif /* CRUST_TYPE_CVEC_H_ */
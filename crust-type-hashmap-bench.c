@@ -0,0 +1,104 @@
+#include "crust-type-hashmap.h"
+#include "crust-type-int.h"
+
+#include "crust-bench.h"
+
+DEFINE_HASHMAP_BY_VALUE(HashMap_int_int, hashmap_int_int, int, int, int)
+
+/* Number of buckets in both tables. Number of keys sets load factor. */
+#define HASHMAP_BENCH_BUCKETS ((size_t)1 << 20)
+/* Number of lookups per iteration. */
+#define HASHMAP_BENCH_LOOKUPS 1000
+
+//
+// Baseline: open addressing with linear probing over array of buckets,
+// with flag of occupied bucket, and same hash function.
+//
+
+typedef struct {
+  bool used;
+  int key;
+  int value;
+} LinearBucket;
+
+typedef struct {
+  LinearBucket * buckets;
+  size_t mask;
+} LinearMap;
+
+static LinearMap linear_map_new(size_t buckets) {
+  return (LinearMap) { .buckets = mem_calloc(buckets, sizeof(LinearBucket)), .mask = buckets - 1 };
+}
+
+static void linear_map_destroy(LinearMap * self) {
+  mem_free(self->buckets);
+  self->buckets = NULL;
+}
+
+static void linear_map_insert(LinearMap * self, int key, int value) {
+  size_t i = int_hash(&key) & self->mask;
+  while(self->buckets[i].used && self->buckets[i].key != key) {
+    i = (i + 1) & self->mask;
+  }
+  self->buckets[i] = (LinearBucket) { .used = true, .key = key, .value = value };
+}
+
+static const int * linear_map_get(const LinearMap * self, int key) {
+  size_t i = int_hash(&key) & self->mask;
+  while(self->buckets[i].used) {
+    if(self->buckets[i].key == key) {
+      return &self->buckets[i].value;
+    }
+    i = (i + 1) & self->mask;
+  }
+  return NULL;
+}
+
+/* Keys are 0..count-1. Key of lookup j visits keys in scattered order; misses use keys above count. */
+#define HASHMAP_BENCH_KEY(j, count, miss) ((int)(((size_t)(j) * 7919) % (count)) + ((miss) ? (int)(count) : 0))
+
+#define DEFINE_HASHMAP_LOAD_BENCH(LOAD, MISS, NAME_SUFFIX, DESCRIPTION) \
+bench(hashmap_get_##NAME_SUFFIX##_load_##LOAD, "Swiss table: 1000 lookups of " DESCRIPTION " at load factor 0." #LOAD) { \
+  size_t count = HASHMAP_BENCH_BUCKETS * LOAD / 1000; \
+  defer(hashmap_int_int_destroy) HashMap_int_int map = hashmap_int_int_with_capacity(count); \
+  for(size_t j = 0; j < count; j++) { \
+    (void)hashmap_int_int_insert(&map, (int)j, (int)j); \
+  } \
+  bench_reset_timer(b); \
+  \
+  for(size_t i = 0; i < b->iterations; i++) { \
+    size_t found = 0; \
+    for(size_t j = 0; j < HASHMAP_BENCH_LOOKUPS; j++) { \
+      found += hashmap_int_int_get(&map, HASHMAP_BENCH_KEY(i * HASHMAP_BENCH_LOOKUPS + j, count, MISS)) != NULL; \
+    } \
+    bench_do_not_optimize(&found); \
+  } \
+} \
+\
+bench(linear_map_get_##NAME_SUFFIX##_load_##LOAD, "linear probing: 1000 lookups of " DESCRIPTION " at load factor 0." #LOAD) { \
+  size_t count = HASHMAP_BENCH_BUCKETS * LOAD / 1000; \
+  LinearMap map = linear_map_new(HASHMAP_BENCH_BUCKETS); \
+  for(size_t j = 0; j < count; j++) { \
+    linear_map_insert(&map, (int)j, (int)j); \
+  } \
+  bench_reset_timer(b); \
+  \
+  for(size_t i = 0; i < b->iterations; i++) { \
+    size_t found = 0; \
+    for(size_t j = 0; j < HASHMAP_BENCH_LOOKUPS; j++) { \
+      found += linear_map_get(&map, HASHMAP_BENCH_KEY(i * HASHMAP_BENCH_LOOKUPS + j, count, MISS)) != NULL; \
+    } \
+    bench_do_not_optimize(&found); \
+  } \
+  linear_map_destroy(&map); \
+}
+
+// Load factor is given in thousandths, so it can be part of benchmark name
+DEFINE_HASHMAP_LOAD_BENCH(500, false, hit, "present keys")
+DEFINE_HASHMAP_LOAD_BENCH(625, false, hit, "present keys")
+DEFINE_HASHMAP_LOAD_BENCH(750, false, hit, "present keys")
+DEFINE_HASHMAP_LOAD_BENCH(875, false, hit, "present keys")
+DEFINE_HASHMAP_LOAD_BENCH(500, true, miss, "missing keys")
+DEFINE_HASHMAP_LOAD_BENCH(625, true, miss, "missing keys")
+DEFINE_HASHMAP_LOAD_BENCH(750, true, miss, "missing keys")
+DEFINE_HASHMAP_LOAD_BENCH(875, true, miss, "missing keys")
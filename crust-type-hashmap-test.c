@@ -0,0 +1,117 @@
+#include "crust-type-hashmap.h"
+#include "crust-type-int.h"
+#include "crust-type-ccharp.h"
+#include "crust-unittest.h"
+
+DEFINE_HASHMAP_BY_VALUE(HashMap_int_int, hashmap_int_int, int, int, int)
+DEFINE_HASHMAP_BY_VALUE(HashMap_ccharp_int, hashmap_ccharp_int, const char *, ccharp, int)
+
+it(hashmap_int_int_insert_get, "must insert values and find them by key") {
+  defer(hashmap_int_int_destroy) HashMap_int_int map = hashmap_int_int_new();
+
+  assert_true(hashmap_int_int_get(&map, 1) == NULL, "Empty map must not contain keys");
+
+  for(int i=0; i<1000; i++) {
+    assert_true(hashmap_int_int_insert(&map, i, i*2), "hashmap_int_int_insert() must return true for new key");
+  }
+  assert_equal_int(1000, hashmap_int_int_len(&map), "Unexpected length of map");
+
+  for(int i=0; i<1000; i++) {
+    const int * value = hashmap_int_int_get(&map, i);
+    assert_true(value != NULL, "Inserted key must be found");
+    assert_equal_int(i*2, *value, "Unexpected value for key");
+  }
+  assert_true(!hashmap_int_int_contains_key(&map, 1000), "Map must not contain key, which is not inserted");
+
+  assert_true(!hashmap_int_int_insert(&map, 5, 42), "hashmap_int_int_insert() must return false for existing key");
+  assert_equal_int(42, *hashmap_int_int_get(&map, 5), "Value of existing key must be replaced");
+  assert_equal_int(1000, hashmap_int_int_len(&map), "Length must not change when value is replaced");
+
+  *hashmap_int_int_get_mut(&map, 6) = 53;
+  assert_equal_int(53, *hashmap_int_int_get(&map, 6), "Value must be changed through pointer");
+}
+
+it(hashmap_int_int_remove, "must remove keys and reuse buckets") {
+  defer(hashmap_int_int_destroy) HashMap_int_int map = hashmap_int_int_with_capacity(100);
+  size_t capacity = hashmap_int_int_capacity(&map);
+
+  // Insert and remove many more keys than capacity, so buckets must be reclaimed
+  for(int i=0; i<10000; i++) {
+    assert_true(hashmap_int_int_insert(&map, i, i), "hashmap_int_int_insert() must return true for new key");
+    if(i >= 50) {
+      int value = -1;
+      assert_true(hashmap_int_int_remove(&map, i-50, &value), "hashmap_int_int_remove() must find key");
+      assert_equal_int(i-50, value, "hashmap_int_int_remove() must return value of key");
+    }
+  }
+
+  assert_equal_int(50, hashmap_int_int_len(&map), "Unexpected length of map");
+  assert_equal_int(capacity, hashmap_int_int_capacity(&map), "Map must not grow when number of keys is stable");
+  for(int i=0; i<10000; i++) {
+    assert_equal_int(i >= 9950, hashmap_int_int_contains_key(&map, i), "Only last keys must stay in map");
+  }
+
+  assert_true(!hashmap_int_int_remove(&map, 0, NULL), "hashmap_int_int_remove() must return false for missing key");
+}
+
+it(hashmap_int_int_entry_reserve, "must insert default value by entry() and grow by reserve()") {
+  defer(hashmap_int_int_destroy) HashMap_int_int map = hashmap_int_int_new();
+
+  hashmap_int_int_reserve(&map, 500);
+  assert_true(hashmap_int_int_capacity(&map) >= 500, "hashmap_int_int_reserve() must make room for elements");
+
+  int keys[] = { 3, 1, 3, 3, 2, 1 };
+  for(size_t i=0; i<sizeof(keys)/sizeof(keys[0]); i++) {
+    (*hashmap_int_int_entry(&map, keys[i], 0))++;
+  }
+
+  assert_equal_int(3, hashmap_int_int_len(&map), "Unexpected number of keys");
+  assert_equal_int(2, *hashmap_int_int_get(&map, 1), "Unexpected count for key");
+  assert_equal_int(1, *hashmap_int_int_get(&map, 2), "Unexpected count for key");
+  assert_equal_int(3, *hashmap_int_int_get(&map, 3), "Unexpected count for key");
+
+  int sum = 0;
+  size_t cursor = 0;
+  for(HashMap_int_int_Entry * entry; (entry = hashmap_int_int_next(&map, &cursor)); ) {
+    sum += entry->key * entry->value;
+  }
+  assert_equal_int(2*1 + 1*2 + 3*3, sum, "hashmap_int_int_next() must visit every entry once");
+}
+
+it(hashmap_int_int_find_or_insert_slot, "must find key or claim bucket for it with single probe") {
+  defer(hashmap_int_int_destroy) HashMap_int_int map = hashmap_int_int_new();
+  bool inserted = false;
+
+  // Map grows from empty table, and removed keys leave DELETED buckets to reuse
+  for(int i=0; i<1000; i++) {
+    int key = i;
+    HashMap_int_int_Entry * entry = hashmap_int_int_find_or_insert_slot(&map, &key, int_hash(&key), &inserted);
+    assert_true(inserted, "New key must be inserted");
+    assert_equal_int(i, entry->key, "Key must be copied into claimed bucket");
+    entry->value = i * 2;
+    if(i % 3 == 0) {
+      assert_true(hashmap_int_int_remove(&map, i, NULL), "Key must be removed");
+    }
+  }
+
+  for(int i=0; i<1000; i++) {
+    int key = i;
+    HashMap_int_int_Entry * entry = hashmap_int_int_find_or_insert_slot(&map, &key, int_hash(&key), &inserted);
+    assert_equal_int(i % 3 == 0, inserted, "Only removed keys must be inserted again");
+    if(inserted) {
+      entry->value = i * 2;
+    }
+    assert_equal_int(i * 2, entry->value, "Unexpected value of entry");
+  }
+  assert_equal_int(1000, hashmap_int_int_len(&map), "Unexpected length of map");
+}
+
+it(hashmap_ccharp_int, "must compare string keys by content") {
+  defer(hashmap_ccharp_int_destroy) HashMap_ccharp_int map = hashmap_ccharp_int_new();
+  char key[] = "foo";
+
+  assert_true(hashmap_ccharp_int_insert(&map, "foo", 1), "hashmap_ccharp_int_insert() must return true for new key");
+  assert_true(hashmap_ccharp_int_insert(&map, "bar", 2), "hashmap_ccharp_int_insert() must return true for new key");
+  assert_equal_int(1, *hashmap_ccharp_int_get(&map, key), "Keys must be compared by content");
+  assert_true(hashmap_ccharp_int_get(&map, "baz") == NULL, "Missing key must not be found");
+}
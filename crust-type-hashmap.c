@@ -0,0 +1,130 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "crust-type-hashmap.h"
+#include "crust-mem.h"
+
+uint8_t _hashmap_empty_group[_HASHMAP_GROUP_WIDTH] = {
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+  0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+};
+
+/* Return number of elements, which table with given number of buckets can hold. */
+static size_t _hashmap_max_load(size_t buckets) {
+  return buckets - buckets / 8;
+}
+
+size_t _hashmap_buckets_for(size_t capacity) {
+  if(capacity == 0) {
+    return 0;
+  }
+
+  size_t buckets = _HASHMAP_GROUP_WIDTH;
+  while(_hashmap_max_load(buckets) < capacity) {
+    if(buckets > SIZE_MAX / 2) {
+      mem_panic(MEM_ERROR_INTEGER_OVERFLOW, capacity);
+    }
+    buckets *= 2;
+  }
+
+  return buckets;
+}
+
+/* Allocate table with given number of buckets, which is 0 or power of two. */
+static _HashMap _hashmap_allocate(size_t slot_size, size_t buckets) {
+  if(buckets == 0) {
+    return (_HashMap) { .ctrl = _hashmap_empty_group, .slots = NULL, .bucket_mask = 0, .count = 0, .growth_left = 0 };
+  }
+
+  if((SIZE_MAX - buckets - _HASHMAP_GROUP_WIDTH) / slot_size < buckets) {
+    mem_panic(MEM_ERROR_INTEGER_OVERFLOW, buckets);
+  }
+
+  char * data = mem_malloc(buckets * slot_size + buckets + _HASHMAP_GROUP_WIDTH, sizeof(char));
+  uint8_t * ctrl = (uint8_t *)data + buckets * slot_size;
+  memset(ctrl, _HASHMAP_CTRL_EMPTY, buckets + _HASHMAP_GROUP_WIDTH);
+
+  return (_HashMap) {
+    .ctrl = ctrl,
+    .slots = data,
+    .bucket_mask = buckets - 1,
+    .count = 0,
+    .growth_left = _hashmap_max_load(buckets),
+  };
+}
+
+_HashMap _hashmap_with_capacity(size_t slot_size, size_t capacity) {
+  return _hashmap_allocate(slot_size, _hashmap_buckets_for(capacity));
+}
+
+void _hashmap_destroy(_HashMap * self) {
+  if(self->ctrl != _hashmap_empty_group) {
+    mem_free(self->slots);
+  }
+  *self = _hashmap_allocate(0, 0);
+}
+
+void _hashmap_reserve(_HashMap * self, size_t slot_size, size_t additional, _HashMap_slot_hash_fn hash) {
+  if(additional <= self->growth_left) {
+    return;
+  }
+
+  if(self->count > SIZE_MAX - additional) {
+    mem_panic(MEM_ERROR_INTEGER_OVERFLOW, additional);
+  }
+
+  // When table is half full or less, room is taken by DELETED buckets, so
+  // rehash into table of same size. Otherwise, grow table.
+  size_t required = self->count + additional;
+  size_t max_load = _hashmap_max_load(_hashmap_buckets(self));
+  if(required <= max_load / 2) {
+    required = max_load;
+  } else if(required < max_load + 1) {
+    required = max_load + 1;
+  }
+
+  _HashMap table = _hashmap_allocate(slot_size, _hashmap_buckets_for(required));
+
+  size_t buckets = _hashmap_buckets(self);
+  for(size_t index = _hashmap_next_full(self, 0); index < buckets; index = _hashmap_next_full(self, index + 1)) {
+    const char * slot = (const char *)self->slots + index * slot_size;
+    size_t h = hash(slot);
+    size_t new_index = _hashmap_find_insert_slot(&table, h);
+    _hashmap_set_ctrl(&table, new_index, _hashmap_h2(h));
+    memcpy((char *)table.slots + new_index * slot_size, slot, slot_size);
+  }
+  table.count = self->count;
+  table.growth_left -= self->count;
+
+  _hashmap_destroy(self);
+  *self = table;
+}
+
+void _hashmap_erase(_HashMap * self, size_t index) {
+  size_t index_before = (index - _HASHMAP_GROUP_WIDTH) & self->bucket_mask;
+  uint32_t empty_before = _hashmap_group_match_empty(self->ctrl + index_before);
+  uint32_t empty_after = _hashmap_group_match_empty(self->ctrl + index);
+
+  // Count FULL or DELETED buckets right before and right after this one.
+  // When they form window of group width, some probe could see this group
+  // as full and continue past it, so bucket must stay DELETED to keep that
+  // probe sequence unbroken.
+  size_t full_before = empty_before ? (size_t)__builtin_clz(empty_before << 16) : _HASHMAP_GROUP_WIDTH;
+  size_t full_after = empty_after ? (size_t)__builtin_ctz(empty_after) : _HASHMAP_GROUP_WIDTH;
+
+  if(full_before + full_after >= _HASHMAP_GROUP_WIDTH) {
+    _hashmap_set_ctrl(self, index, _HASHMAP_CTRL_DELETED);
+  } else {
+    _hashmap_set_ctrl(self, index, _HASHMAP_CTRL_EMPTY);
+    self->growth_left++;
+  }
+
+  self->count--;
+}
@@ -0,0 +1,398 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#ifndef CRUST_TYPE_HASHMAP_H_
+#define CRUST_TYPE_HASHMAP_H_
+
+#include <sys/types.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "crust-mem.h"
+
+#ifdef _CRUST_TESTS
+#include "crust-unittest.h"
+#endif
+
+//
+// Swiss table.
+//
+// Every bucket has control byte: EMPTY, DELETED, or FULL with 7 high bits
+// of hash of key (H2). Lookup loads group of 16 control bytes, compares
+// them with H2 at once, and checks keys only for matching bytes, so most
+// of probing is done without touching keys at all. Group is probed with
+// SSE2, or with plain loop when SSE2 is not available.
+//
+
+#define _HASHMAP_GROUP_WIDTH 16
+#define _HASHMAP_CTRL_EMPTY ((uint8_t)0x80)
+#define _HASHMAP_CTRL_DELETED ((uint8_t)0xFE)
+
+/** Group of control bytes for table without buckets. Lookups in empty map use it, so they need no special case. */
+extern uint8_t _hashmap_empty_group[_HASHMAP_GROUP_WIDTH];
+
+/** Return H2: 7 high bits of hash, which are stored in control byte. */
+WUR MU SI uint8_t _hashmap_h2(size_t hash) { return (uint8_t)(hash >> (sizeof(size_t)*8 - 7)); }
+
+/** Return bitmask of bytes in group, which are equal to given byte. */
+NN WUR MU SI uint32_t _hashmap_group_match(const uint8_t * group, uint8_t byte) {
+#ifdef __SSE2__
+  __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)byte)));
+#else
+  uint32_t mask = 0;
+  for(int i = 0; i < _HASHMAP_GROUP_WIDTH; i++) {
+    mask |= (uint32_t)(group[i] == byte) << i;
+  }
+  return mask;
+#endif
+}
+
+/** Return bitmask of EMPTY bytes in group. */
+NN WUR MU SI uint32_t _hashmap_group_match_empty(const uint8_t * group) {
+  return _hashmap_group_match(group, _HASHMAP_CTRL_EMPTY);
+}
+
+/** Return bitmask of EMPTY or DELETED bytes in group, i.e. bytes with high bit set. */
+NN WUR MU SI uint32_t _hashmap_group_match_empty_or_deleted(const uint8_t * group) {
+#ifdef __SSE2__
+  return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+#else
+  uint32_t mask = 0;
+  for(int i = 0; i < _HASHMAP_GROUP_WIDTH; i++) {
+    mask |= (uint32_t)(group[i] >> 7) << i;
+  }
+  return mask;
+#endif
+}
+#ifdef _CRUST_TESTS
+it(_hashmap_group_match, "must return bitmask of matching control bytes") {
+  uint8_t group[_HASHMAP_GROUP_WIDTH] = { 0x12, _HASHMAP_CTRL_EMPTY, 0x12, _HASHMAP_CTRL_DELETED };
+  for(int i = 4; i < _HASHMAP_GROUP_WIDTH; i++) {
+    group[i] = 0x7F;
+  }
+  assert_equal_int(0x5, _hashmap_group_match(group, 0x12), "unexpected bitmask for H2");
+  assert_equal_int(0x2, _hashmap_group_match_empty(group), "unexpected bitmask for EMPTY");
+  assert_equal_int(0xA, _hashmap_group_match_empty_or_deleted(group), "unexpected bitmask for EMPTY or DELETED");
+  assert_equal_int(0xFFFF, _hashmap_group_match_empty(_hashmap_empty_group), "empty group must have EMPTY bytes only");
+}
+#endif
+
+/**
+ * Core of hash map, which doesn't depend on types of key and value.
+ *
+ * Slots and control bytes are stored in single allocation. Control bytes
+ * are followed by copy of first group, so group can be loaded at any
+ * bucket without wrapping.
+ */
+typedef struct _HashMap_s {
+  uint8_t * ctrl;
+  void * slots;
+  size_t bucket_mask;
+  size_t count;
+  size_t growth_left;
+} _HashMap;
+
+/** Function, which returns hash of key in given slot. Used on resize only. */
+typedef size_t (*_HashMap_slot_hash_fn)(const void * slot);
+
+/** Return number of buckets in table, or 0 for table without buckets. */
+NN WUR MU SI size_t _hashmap_buckets(const _HashMap * self) {
+  return self->ctrl == _hashmap_empty_group ? 0 : self->bucket_mask + 1;
+}
+
+/** Return number of buckets required to hold given number of elements at maximal load of 7/8. */
+WUR size_t _hashmap_buckets_for(size_t capacity);
+#ifdef _CRUST_TESTS
+it(_hashmap_buckets_for, "must return power of two, which is not less than group width") {
+  assert_equal_int(0, _hashmap_buckets_for(0), "unexpected number of buckets");
+  assert_equal_int(16, _hashmap_buckets_for(1), "unexpected number of buckets");
+  assert_equal_int(16, _hashmap_buckets_for(14), "unexpected number of buckets");
+  assert_equal_int(32, _hashmap_buckets_for(15), "unexpected number of buckets");
+  assert_equal_int(1024, _hashmap_buckets_for(896), "unexpected number of buckets");
+  assert_equal_int(2048, _hashmap_buckets_for(897), "unexpected number of buckets");
+}
+#endif
+
+/** Create new map with room for at least given number of elements. */
+WUR struct _HashMap_s _hashmap_with_capacity(size_t slot_size, size_t capacity);
+
+/** Free memory. It's safe to call destroy() twice. */
+NN void _hashmap_destroy(_HashMap * self);
+#ifdef _CRUST_TESTS
+it(_hashmap_with_capacity, "must create table with all buckets EMPTY") {
+  defer(_hashmap_destroy) _HashMap map = _hashmap_with_capacity(sizeof(int), 20);
+  assert_equal_int(32, _hashmap_buckets(&map), "unexpected number of buckets");
+  assert_equal_int(28, map.growth_left, "unexpected room for growth");
+  for(size_t i = 0; i < 32 + _HASHMAP_GROUP_WIDTH; i++) {
+    assert_equal_int(_HASHMAP_CTRL_EMPTY, map.ctrl[i], "control byte must be EMPTY");
+  }
+
+  defer(_hashmap_destroy) _HashMap empty = _hashmap_with_capacity(sizeof(int), 0);
+  assert_equal_int(0, _hashmap_buckets(&empty), "map without capacity must not allocate buckets");
+  assert_equal_int(0, empty.growth_left, "unexpected room for growth");
+}
+#endif
+
+/** Set control byte of bucket and its copy after the end of table. */
+NN MU SI void _hashmap_set_ctrl(_HashMap * self, size_t index, uint8_t ctrl) {
+  self->ctrl[index] = ctrl;
+  self->ctrl[((index - _HASHMAP_GROUP_WIDTH) & self->bucket_mask) + _HASHMAP_GROUP_WIDTH] = ctrl;
+}
+
+/** Return index of first EMPTY or DELETED bucket in probe sequence for given hash. */
+NN WUR MU SI size_t _hashmap_find_insert_slot(const _HashMap * self, size_t hash) {
+  size_t pos = hash & self->bucket_mask;
+  size_t stride = 0;
+
+  for(;;) {
+    uint32_t mask = _hashmap_group_match_empty_or_deleted(self->ctrl + pos);
+    if(mask) {
+      return (pos + __builtin_ctz(mask)) & self->bucket_mask;
+    }
+    // Triangular probing over groups visits every group when number of buckets is power of two
+    stride += _HASHMAP_GROUP_WIDTH;
+    pos = (pos + stride) & self->bucket_mask;
+  }
+}
+
+/** Grow or rehash table, when necessary, to hold additional number of elements. */
+NN void _hashmap_reserve(_HashMap * self, size_t slot_size, size_t additional, _HashMap_slot_hash_fn hash);
+
+/** Mark slot as free. Slot becomes EMPTY when no probe sequence can pass through it, or DELETED otherwise. */
+NN void _hashmap_erase(_HashMap * self, size_t index);
+
+/** Claim given EMPTY or DELETED bucket, which is first free one in probe sequence for given hash,
+ * for new element and return its index. Grows table when it has no room left, so index can change. */
+NN MU SI size_t _hashmap_claim_insert_slot(_HashMap * self, size_t slot_size, size_t hash, size_t index, _HashMap_slot_hash_fn hash_fn) {
+  // DELETED bucket can be reused without growth, but EMPTY one consumes room
+  if(self->growth_left == 0 && self->ctrl[index] == _HASHMAP_CTRL_EMPTY) {
+    _hashmap_reserve(self, slot_size, 1, hash_fn);
+    index = _hashmap_find_insert_slot(self, hash);
+  }
+
+  self->growth_left -= self->ctrl[index] == _HASHMAP_CTRL_EMPTY;
+  _hashmap_set_ctrl(self, index, _hashmap_h2(hash));
+  self->count++;
+
+  return index;
+}
+
+/** Claim EMPTY or DELETED bucket for new element with given hash and return its index.
+ * Grows table when it has no room left. */
+NN MU SI size_t _hashmap_prepare_insert(_HashMap * self, size_t slot_size, size_t hash, _HashMap_slot_hash_fn hash_fn) {
+  return _hashmap_claim_insert_slot(self, slot_size, hash, _hashmap_find_insert_slot(self, hash), hash_fn);
+}
+
+/** Return index of first FULL bucket at or after given index, or number of buckets. */
+NN WUR MU SI size_t _hashmap_next_full(const _HashMap * self, size_t index) {
+  size_t buckets = _hashmap_buckets(self);
+  while(index < buckets && (self->ctrl[index] & 0x80)) {
+    index++;
+  }
+  return index;
+}
+
+//
+// Template for HashMap
+//
+
+#define DEFINE_HASHMAP_STRUCT(SELFNAME, KTYPE, VTYPE) \
+/** Key and value, as stored in bucket of table. */ \
+typedef struct { \
+  KTYPE key; \
+  VTYPE value; \
+} SELFNAME##_Entry; \
+\
+typedef struct { \
+  _HashMap super; \
+} SELFNAME;
+
+#define DEFINE_HASHMAP_SLOT_HASH(SELFNAME, SELFPREFIX, KPREFIX) \
+MU static size_t SELFPREFIX##_slot_hash(const void * slot) { \
+  SELFNAME##_Entry * entry = (SELFNAME##_Entry *)slot; \
+  return KPREFIX##_hash(&entry->key); \
+}
+
+#define DEFINE_HASHMAP_WITH_CAPACITY(SELFNAME, SELFPREFIX) \
+/** Create new map with room for at least given number of elements. */ \
+WUR MU SI SELFNAME SELFPREFIX##_with_capacity(size_t capacity) { return (SELFNAME) { .super = _hashmap_with_capacity(sizeof(SELFNAME##_Entry), capacity) }; }
+
+#define DEFINE_HASHMAP_NEW(SELFNAME, SELFPREFIX) \
+/** Create new empty map. No memory is allocated. */ \
+WUR MU SI SELFNAME SELFPREFIX##_new() { return SELFPREFIX##_with_capacity(0); }
+
+#define DEFINE_HASHMAP_DESTROY(SELFNAME, SELFPREFIX) \
+/** Free memory. It's safe to call destroy() twice. */ \
+MU SI void SELFPREFIX##_destroy(SELFNAME * self) { _hashmap_destroy(&self->super); }
+
+#define DEFINE_HASHMAP_LEN(SELFNAME, SELFPREFIX) \
+/** Return number of elements. */ \
+NN WUR MU SI size_t SELFPREFIX##_len(const SELFNAME * self) { return self->super.count; } \
+/** Return number of elements, which map can hold without growth. */ \
+NN WUR MU SI size_t SELFPREFIX##_capacity(const SELFNAME * self) { return self->super.count + self->super.growth_left; }
+
+#define DEFINE_HASHMAP_RESERVE(SELFNAME, SELFPREFIX) \
+/** Grow table, when necessary, to hold additional number of elements without further growth. */ \
+NN MU SI void SELFPREFIX##_reserve(SELFNAME * self, size_t additional) { \
+  if(additional > self->super.growth_left) { \
+    _hashmap_reserve(&self->super, sizeof(SELFNAME##_Entry), additional, SELFPREFIX##_slot_hash); \
+  } \
+}
+
+#define DEFINE_HASHMAP_FIND_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX) \
+/** Return pointer to entry with given key and hash, or NULL. */ \
+NN WUR MU SI SELFNAME##_Entry * SELFPREFIX##_find(const SELFNAME * self, KTYPE * key, size_t hash) { \
+  const _HashMap * super = &self->super; \
+  uint8_t h2 = _hashmap_h2(hash); \
+  size_t pos = hash & super->bucket_mask; \
+  size_t stride = 0; \
+ \
+  for(;;) { \
+    const uint8_t * group = super->ctrl + pos; \
+    for(uint32_t mask = _hashmap_group_match(group, h2); mask; mask &= mask - 1) { \
+      size_t index = (pos + __builtin_ctz(mask)) & super->bucket_mask; \
+      SELFNAME##_Entry * entry = (SELFNAME##_Entry *)super->slots + index; \
+      if(KPREFIX##_eq(&entry->key, key)) { \
+        return entry; \
+      } \
+    } \
+    if(_hashmap_group_match_empty(group)) { \
+      return NULL; \
+    } \
+    stride += _HASHMAP_GROUP_WIDTH; \
+    pos = (pos + stride) & super->bucket_mask; \
+  } \
+}
+
+#define DEFINE_HASHMAP_FIND_OR_INSERT_SLOT_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX) \
+/** Return pointer to entry with given key and hash. When key is not found, claim bucket, which \
+ * is found by same probe, copy key into it, set inserted to true, and return entry, which value \
+ * must be set by caller. Pointer is valid until map is changed. */ \
+NN WUR MU SI SELFNAME##_Entry * SELFPREFIX##_find_or_insert_slot(SELFNAME * self, KTYPE * key, size_t hash, bool * inserted) { \
+  _HashMap * super = &self->super; \
+  uint8_t h2 = _hashmap_h2(hash); \
+  size_t pos = hash & super->bucket_mask; \
+  size_t stride = 0; \
+  size_t insert_index = SIZE_MAX; \
+ \
+  for(;;) { \
+    const uint8_t * group = super->ctrl + pos; \
+    for(uint32_t mask = _hashmap_group_match(group, h2); mask; mask &= mask - 1) { \
+      size_t index = (pos + __builtin_ctz(mask)) & super->bucket_mask; \
+      SELFNAME##_Entry * entry = (SELFNAME##_Entry *)super->slots + index; \
+      if(KPREFIX##_eq(&entry->key, key)) { \
+        *inserted = false; \
+        return entry; \
+      } \
+    } \
+    /* Remember first free bucket, so insert needs no second probe */ \
+    uint32_t free_mask = insert_index == SIZE_MAX ? _hashmap_group_match_empty_or_deleted(group) : 0; \
+    if(free_mask) { \
+      insert_index = (pos + __builtin_ctz(free_mask)) & super->bucket_mask; \
+    } \
+    if(_hashmap_group_match_empty(group)) { \
+      break; \
+    } \
+    stride += _HASHMAP_GROUP_WIDTH; \
+    pos = (pos + stride) & super->bucket_mask; \
+  } \
+ \
+  size_t index = _hashmap_claim_insert_slot(super, sizeof(SELFNAME##_Entry), hash, insert_index, SELFPREFIX##_slot_hash); \
+  SELFNAME##_Entry * entry = (SELFNAME##_Entry *)super->slots + index; \
+  entry->key = *key; \
+  *inserted = true; \
+  return entry; \
+}
+
+#define DEFINE_HASHMAP_GET_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX, VTYPE) \
+/** Return pointer to value for given key, or NULL when key is not found. */ \
+NN WUR MU SI const VTYPE * SELFPREFIX##_get(const SELFNAME * self, KTYPE key) { \
+  SELFNAME##_Entry * entry = SELFPREFIX##_find(self, &key, KPREFIX##_hash(&key)); \
+  return entry ? &entry->value : NULL; \
+} \
+/** Return pointer to value for given key, or NULL when key is not found. \
+ * Pointer is valid until map is changed. */ \
+NN WUR MU SI VTYPE * SELFPREFIX##_get_mut(SELFNAME * self, KTYPE key) { \
+  SELFNAME##_Entry * entry = SELFPREFIX##_find(self, &key, KPREFIX##_hash(&key)); \
+  return entry ? &entry->value : NULL; \
+} \
+/** Return true when map contains given key. */ \
+NN WUR MU SI bool SELFPREFIX##_contains_key(const SELFNAME * self, KTYPE key) { \
+  return SELFPREFIX##_find(self, &key, KPREFIX##_hash(&key)) != NULL; \
+}
+
+#define DEFINE_HASHMAP_INSERT_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX, VTYPE) \
+/** Insert key and value. Return true when key is new, or false when value of existing key is replaced. */ \
+NN MU SI bool SELFPREFIX##_insert(SELFNAME * self, KTYPE key, VTYPE value) { \
+  bool inserted; \
+  SELFPREFIX##_find_or_insert_slot(self, &key, KPREFIX##_hash(&key), &inserted)->value = value; \
+  return inserted; \
+}
+
+#define DEFINE_HASHMAP_ENTRY_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX, VTYPE) \
+/** Return pointer to value for given key. When key is not found, insert it with default value first. \
+ * Pointer is valid until map is changed. */ \
+NN WUR MU SI VTYPE * SELFPREFIX##_entry(SELFNAME * self, KTYPE key, VTYPE default_value) { \
+  bool inserted; \
+  SELFNAME##_Entry * entry = SELFPREFIX##_find_or_insert_slot(self, &key, KPREFIX##_hash(&key), &inserted); \
+  if(inserted) { \
+    entry->value = default_value; \
+  } \
+  return &entry->value; \
+}
+
+#define DEFINE_HASHMAP_REMOVE_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX, VTYPE) \
+/** Remove key. Return true and store value into out, when out is not NULL, if key was found, or false otherwise. */ \
+MU SI bool SELFPREFIX##_remove(SELFNAME * self, KTYPE key, VTYPE * out) { \
+  SELFNAME##_Entry * entry = SELFPREFIX##_find(self, &key, KPREFIX##_hash(&key)); \
+ \
+  if(!entry) { \
+    return false; \
+  } \
+ \
+  if(out) { \
+    *out = entry->value; \
+  } \
+  _hashmap_erase(&self->super, entry - (SELFNAME##_Entry *)self->super.slots); \
+  return true; \
+}
+
+#define DEFINE_HASHMAP_NEXT(SELFNAME, SELFPREFIX) \
+/** Return next entry of map, or NULL at end. Cursor must be 0 at start. Order of entries is unspecified. */ \
+NN WUR MU SI SELFNAME##_Entry * SELFPREFIX##_next(const SELFNAME * self, size_t * cursor) { \
+  size_t index = _hashmap_next_full(&self->super, *cursor); \
+  if(index >= _hashmap_buckets(&self->super)) { \
+    *cursor = index; \
+    return NULL; \
+  } \
+  *cursor = index + 1; \
+  return (SELFNAME##_Entry *)self->super.slots + index; \
+}
+
+#define DEFINE_HASHMAP_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX, VTYPE) \
+DEFINE_HASHMAP_STRUCT(SELFNAME, KTYPE, VTYPE) \
+DEFINE_HASHMAP_SLOT_HASH(SELFNAME, SELFPREFIX, KPREFIX) \
+DEFINE_HASHMAP_WITH_CAPACITY(SELFNAME, SELFPREFIX) \
+DEFINE_HASHMAP_NEW(SELFNAME, SELFPREFIX) \
+DEFINE_HASHMAP_DESTROY(SELFNAME, SELFPREFIX) \
+DEFINE_HASHMAP_LEN(SELFNAME, SELFPREFIX) \
+DEFINE_HASHMAP_RESERVE(SELFNAME, SELFPREFIX) \
+DEFINE_HASHMAP_FIND_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX) \
+DEFINE_HASHMAP_FIND_OR_INSERT_SLOT_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX) \
+DEFINE_HASHMAP_GET_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX, VTYPE) \
+DEFINE_HASHMAP_INSERT_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX, VTYPE) \
+DEFINE_HASHMAP_ENTRY_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX, VTYPE) \
+DEFINE_HASHMAP_REMOVE_BY_VALUE(SELFNAME, SELFPREFIX, KTYPE, KPREFIX, VTYPE) \
+DEFINE_HASHMAP_NEXT(SELFNAME, SELFPREFIX) \
+
+#endif /* CRUST_TYPE_HASHMAP_H_ */
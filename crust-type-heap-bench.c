@@ -0,0 +1,32 @@
+#include "crust-type-heap.h"
+#include "crust-type-int.h"
+
+#include "crust-bench.h"
+
+DEFINE_HEAP_BY_VALUE_WITH_ARITY(BinaryHeap_int, binary_heap_int, int, int, 2)
+DEFINE_HEAP_BY_VALUE(Heap_int, heap_int, int, int)
+
+// 1e7 pushes and 1e7 pops, so heap is much larger than CPU caches
+#define HEAP_BENCH_LENGTH 10000000
+
+/* Push pseudo-random ints into heap, then pop all of them. */
+#define DEFINE_HEAP_BENCH(NAME, HEAPNAME, HEAPPREFIX, DESCRIPTION) \
+bench(NAME, DESCRIPTION) { \
+  for(size_t i = 0; i < b->iterations; i++) { \
+    defer(HEAPPREFIX##_destroy) HEAPNAME heap = HEAPPREFIX##_with_capacity(HEAP_BENCH_LENGTH); \
+    uint32_t seed = 42; \
+    for(int j = 0; j < HEAP_BENCH_LENGTH; j++) { \
+      seed = seed * 1103515245u + 12345u; \
+      HEAPPREFIX##_push(&heap, (int)(seed >> 8)); \
+    } \
+    int value; \
+    long sum = 0; \
+    while(HEAPPREFIX##_pop(&heap, &value)) { \
+      sum += value; \
+    } \
+    bench_do_not_optimize(&sum); \
+  } \
+}
+
+DEFINE_HEAP_BENCH(heap_push_pop_arity_2, BinaryHeap_int, binary_heap_int, "push 10M random ints into 2-ary heap and pop them")
+DEFINE_HEAP_BENCH(heap_push_pop_arity_4, Heap_int, heap_int, "push 10M random ints into 4-ary heap and pop them")
@@ -0,0 +1,156 @@
+#include <stdlib.h>
+
+#include "crust-type-heap.h"
+#include "crust-type-vec.h"
+#include "crust-type-slice.h"
+#include "crust-type-array.h"
+#include "crust-type-int.h"
+#include "crust-unittest.h"
+
+VEC_BY_VALUE_TEMPLATE(Vec_int, vec_int, int)
+DEFINE_SLICE_BY_VALUE_TEMPLATE(Slice_int, slice_int, int, int)
+DEFINE_HEAP_BY_VALUE(Heap_int, heap_int, int, int)
+HEAP_TO_SLICE_AND_VEC(Heap_int, heap_int, int, Slice_int, slice_int, Vec_int, vec_int)
+DEFINE_HEAP_BY_VALUE_WITH_ARITY(BinaryHeap_int, binary_heap_int, int, int, 2)
+HEAP_TO_SLICE_AND_VEC(BinaryHeap_int, binary_heap_int, int, Slice_int, slice_int, Vec_int, vec_int)
+DEFINE_HEAP_BY_VALUE_WITH_ARITY(Heap8_int, heap8_int, int, int, 8)
+
+it(heap_int_push_pop, "must pop elements in ascending order") {
+  defer(heap_int_destroy) Heap_int heap = heap_int_new();
+  int value;
+
+  assert_true(heap_int_peek(&heap) == NULL, "heap_int_peek() must return NULL for empty heap");
+  assert_true(!heap_int_pop(&heap, &value), "heap_int_pop() must return false for empty heap");
+
+  srand(42);
+  for(int i=0; i<1000; i++) {
+    heap_int_push(&heap, rand() % 100);
+  }
+  assert_equal_int(1000, heap_int_len(&heap), "Unexpected length of heap");
+
+  int prev = -1;
+  while(heap_int_pop(&heap, &value)) {
+    assert_true(prev <= value, "Elements must be popped in ascending order");
+    prev = value;
+  }
+  assert_true(heap_int_is_empty(&heap), "Heap must be empty");
+}
+
+it(heap_int_arity, "must work with arity 2 and 8") {
+  defer(binary_heap_int_destroy) BinaryHeap_int binary = binary_heap_int_new();
+  defer(heap8_int_destroy) Heap8_int wide = heap8_int_new();
+
+  for(int i=0; i<500; i++) {
+    int value = (i * 7919) % 500;
+    binary_heap_int_push(&binary, value);
+    heap8_int_push(&wide, value);
+  }
+  for(int i=0; i<500; i++) {
+    int a = -1, b = -1;
+    assert_true(binary_heap_int_pop(&binary, &a) && heap8_int_pop(&wide, &b), "Unexpected end of heap");
+    assert_equal_int(i, a, "Unexpected element of binary heap");
+    assert_equal_int(i, b, "Unexpected element of 8-ary heap");
+  }
+}
+
+it(heap_int_push_pop_single, "must push and pop element with single sift") {
+  defer(heap_int_destroy) Heap_int heap = heap_int_new();
+  assert_equal_int(5, heap_int_push_pop(&heap, 5), "Empty heap must return pushed element");
+
+  HeapHandle three = heap_int_push(&heap, 3);
+  heap_int_push(&heap, 7);
+  assert_equal_int(1, heap_int_push_pop(&heap, 1), "Element, which is smaller than top, must be returned back");
+  assert_equal_int(3, heap_int_push_pop(&heap, 9), "Top must be returned");
+  assert_true(!heap_int_contains(&heap, three), "Handle of popped element must be released");
+  assert_equal_int(7, *heap_int_peek(&heap), "Unexpected top after push_pop");
+  assert_equal_int(2, heap_int_len(&heap), "Unexpected length after push_pop");
+}
+
+it(heap_int_decrease_key, "must move element by handle") {
+  defer(heap_int_destroy) Heap_int heap = heap_int_new();
+  HeapHandle handles[10];
+  for(int i=0; i<10; i++) {
+    handles[i] = heap_int_push(&heap, 100 + i);
+  }
+
+  heap_int_decrease_key(&heap, handles[7], 1);
+  assert_equal_int(1, *heap_int_peek(&heap), "Decreased element must become top");
+  assert_equal_int(1, heap_int_get(&heap, handles[7]), "Unexpected value by handle");
+  assert_abort(heap_int_decrease_key(&heap, handles[7], 2), "decrease_key() must abort when value is increased");
+
+  heap_int_update(&heap, handles[7], 200);
+  heap_int_update(&heap, handles[9], 0);
+  int value;
+  assert_true(heap_int_pop(&heap, &value), "Unexpected empty heap");
+  assert_equal_int(0, value, "Updated element must become top");
+  assert_true(!heap_int_contains(&heap, handles[9]), "Popped element must not be in heap");
+  assert_abort((void)(0 == heap_int_get(&heap, handles[9])), "get() must abort for handle of popped element");
+
+  for(int i=0; i<8; i++) {
+    assert_true(heap_int_pop(&heap, &value), "Unexpected empty heap");
+    assert_equal_int(100 + i + (i >= 7), value, "Unexpected element");
+  }
+  assert_true(heap_int_pop(&heap, &value), "Unexpected empty heap");
+  assert_equal_int(200, value, "Increased element must be last");
+}
+
+it(heap_int_from_slice, "must build heap from slice in place and return sorted vector") {
+  int data[] = { 9, 4, 7, 1, 8, 2, 6, 3, 5, 0 };
+  Slice_int slice = slice_int_from_raw_parts(data, LENGTH_OF_ARRAY(data));
+
+  Heap_int heap = heap_int_from_slice(&slice);
+  assert_equal_int(10, heap_int_len(&heap), "Unexpected length of heap");
+  assert_equal_int(0, *heap_int_peek(&heap), "Unexpected top of heap");
+  assert_equal_int(7, heap_int_get(&heap, heap_slice_handle(2)), "Handle of element must be its index in slice");
+  heap_int_decrease_key(&heap, heap_slice_handle(2), -1);
+
+  defer(vec_int_destroy) Vec_int sorted = heap_int_into_sorted_vec(&heap);
+  assert_equal_int(10, vec_int_len(&sorted), "Unexpected length of sorted vector");
+  int expected[] = { -1, 0, 1, 2, 3, 4, 5, 6, 8, 9 };
+  for(size_t i=0; i<LENGTH_OF_ARRAY(expected); i++) {
+    assert_equal_int(expected[i], vec_int_get(&sorted, i), "Unexpected element of sorted vector");
+  }
+
+  BinaryHeap_int binary = binary_heap_int_from_slice(&slice);
+  defer(vec_int_destroy) Vec_int binary_sorted = binary_heap_int_into_sorted_vec(&binary);
+  for(size_t i=0; i<LENGTH_OF_ARRAY(data); i++) {
+    assert_equal_int(i, vec_int_get(&binary_sorted, i), "Unexpected element of sorted vector of binary heap");
+  }
+}
+
+it(heap_int_stale_handle, "must reject handle of popped element, when its slot is reused") {
+  defer(heap_int_destroy) Heap_int heap = heap_int_new();
+  HeapHandle first = heap_int_push(&heap, 1);
+  int value;
+  assert_true(heap_int_pop(&heap, &value), "Unexpected empty heap");
+
+  HeapHandle second = heap_int_push(&heap, 2);
+  assert_equal_int(first.id, second.id, "Slot of popped element must be reused");
+  assert_true(first.generation != second.generation, "Generation of reused slot must change");
+  assert_true(!heap_int_contains(&heap, first), "Stale handle must not be in heap");
+  assert_true(heap_int_contains(&heap, second), "New handle must be in heap");
+  assert_abort((void)(0 == heap_int_get(&heap, first)), "get() must abort for stale handle");
+  assert_abort(heap_int_decrease_key(&heap, first, 0), "decrease_key() must abort for stale handle");
+  assert_abort(heap_int_update(&heap, first, 0), "update() must abort for stale handle");
+  assert_equal_int(2, heap_int_get(&heap, second), "Unexpected value by new handle");
+}
+
+it(heap_int_from_slice_sizes, "must build valid heap from slices of any length") {
+  int data[40];
+  for(int length=0; length<=(int)LENGTH_OF_ARRAY(data); length++) {
+    for(int i=0; i<length; i++) {
+      data[i] = (i * 17 + 5) % length;
+    }
+    Slice_int slice = slice_int_from_raw_parts(data, (size_t)length);
+
+    Heap_int heap = heap_int_from_slice(&slice);
+    defer(vec_int_destroy) Vec_int sorted = heap_int_into_sorted_vec(&heap);
+    BinaryHeap_int binary = binary_heap_int_from_slice(&slice);
+    defer(vec_int_destroy) Vec_int binary_sorted = binary_heap_int_into_sorted_vec(&binary);
+    assert_equal_int(length, vec_int_len(&sorted), "Unexpected length of sorted vector");
+    for(int i=1; i<length; i++) {
+      assert_true(vec_int_get(&sorted, i - 1) <= vec_int_get(&sorted, i), "Elements must be sorted");
+      assert_true(vec_int_get(&binary_sorted, i - 1) <= vec_int_get(&binary_sorted, i), "Elements of binary heap must be sorted");
+    }
+  }
+}
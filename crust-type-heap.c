@@ -0,0 +1,28 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "crust-type-heap.h"
+
+void _heap_panic(int error_code, size_t value) {
+  switch(error_code) {
+    case _HEAP_ERROR_INVALID_HANDLE:
+      fprintf(stderr, "ERROR: Heap: Element with given handle is not in heap. Handle: %zu.\n", value);
+    break;
+
+    case _HEAP_ERROR_KEY_INCREASED:
+      fprintf(stderr, "ERROR: Heap: New value is greater than current value of element. Handle: %zu.\n", value);
+    break;
+
+    default:
+      fprintf(stderr, "ERROR: _heap_panic(): Unknown error code: %d.\n", error_code);
+  }
+
+  abort();
+}
@@ -0,0 +1,361 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#ifndef CRUST_TYPE_HEAP_H_
+#define CRUST_TYPE_HEAP_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "crust-mem.h"
+#include "crust-type-vec.h"
+
+#ifdef _CRUST_TESTS
+#include "crust-unittest.h"
+#endif
+
+enum _Heap_error_codes {
+  _HEAP_ERROR_INVALID_HANDLE = 1,
+  _HEAP_ERROR_KEY_INCREASED = 2,
+};
+
+void _heap_panic(int error_code, size_t value);
+#ifdef _CRUST_TESTS
+it(_heap_panic, "must abort program using abort()") {
+  assert_abort(_heap_panic(_HEAP_ERROR_INVALID_HANDLE, 1), "must abort");
+  assert_abort(_heap_panic(_HEAP_ERROR_KEY_INCREASED, 1), "must abort");
+  assert_abort(_heap_panic(12312, 1), "must abort");
+}
+#endif
+
+/** Position of element, which is not in heap. */
+#define _HEAP_NO_POSITION SIZE_MAX
+
+/** Default number of children of node: 4 children of 8-byte elements fit into cache line. */
+#define HEAP_DEFAULT_ARITY 4
+
+/**
+ * Handle of element in heap.
+ *
+ * Generation of slot is incremented, when element is pushed and when it is
+ * popped, so handle of popped element doesn't match generation of slot
+ * anymore, even when slot is reused for other element. Generation is odd
+ * while slot is occupied.
+ */
+typedef struct {
+  size_t id;
+  uint32_t generation;
+} HeapHandle;
+
+/** Slot of handle: generation and index of element in tree, or _HEAP_NO_POSITION. */
+typedef struct {
+  size_t position;
+  uint32_t generation;
+} _Heap_slot;
+
+/** Return handle of element, which has given index in slice passed to from_slice(). */
+WUR MU SI HeapHandle heap_slice_handle(size_t index) { return (HeapHandle) { .id = index, .generation = 1 }; }
+
+//
+// Template for Heap
+//
+// Min-heap: pop() returns smallest element first, according to
+// TYPEPREFIX##_cmp(). For max-heap, reverse comparison.
+//
+// Elements are stored in _Vec as complete d-ary tree: children of node i are
+// nodes ARITY*i+1 .. ARITY*i+ARITY. Larger arity makes tree shallower, so
+// push() and decrease_key() do fewer moves, while pop() compares more
+// children, which lie in same cache line.
+//
+// Every element carries id of its handle, and slots vector maps handle to
+// index of element in tree, so element can be found by handle.
+//
+
+#define DEFINE_HEAP_STRUCT(SELFNAME, CTYPE) \
+typedef struct { \
+  CTYPE value; \
+  size_t handle; \
+} SELFNAME##_Entry; \
+\
+typedef struct { \
+  /** Elements, as d-ary tree. */ \
+  _Vec entries; \
+  /** Index of element in entries and generation for every handle. */ \
+  _Vec slots; \
+  /** Handles of popped elements, which can be reused. */ \
+  _Vec free_handles; \
+} SELFNAME;
+
+#define DEFINE_HEAP_NEW(SELFNAME, SELFPREFIX, CTYPE) \
+WUR MU SI SELFNAME SELFPREFIX##_with_capacity(size_t capacity) { \
+  return (SELFNAME) { \
+    .entries = _vec_with_capacity(sizeof(SELFNAME##_Entry), capacity), \
+    .slots = _vec_with_capacity(sizeof(_Heap_slot), capacity), \
+    .free_handles = _vec_new(sizeof(size_t)), \
+  }; \
+} \
+\
+WUR MU SI SELFNAME SELFPREFIX##_new() { return SELFPREFIX##_with_capacity(8); } \
+\
+/** Free memory. It's safe to call destroy() twice. */ \
+MU SI void SELFPREFIX##_destroy(SELFNAME * self) { \
+  _vec_destroy(&self->entries); \
+  _vec_destroy(&self->slots); \
+  _vec_destroy(&self->free_handles); \
+} \
+\
+NN WUR MU SI size_t SELFPREFIX##_len(const SELFNAME * self) { return self->entries.count; } \
+NN WUR MU SI bool SELFPREFIX##_is_empty(const SELFNAME * self) { return self->entries.count == 0; }
+
+#define DEFINE_HEAP_SIFT(SELFNAME, SELFPREFIX, CTYPE, TYPEPREFIX, ARITY) \
+/** Return number of children of node. */ \
+WUR MU SI size_t SELFPREFIX##_arity() { return (ARITY); } \
+\
+/** Move element at index towards root, while it's less than its parent. Return new index. */ \
+NN MU SI size_t SELFPREFIX##_sift_up(SELFNAME * self, size_t index) { \
+  SELFNAME##_Entry * entries = self->entries.data; \
+  _Heap_slot * slots = self->slots.data; \
+  SELFNAME##_Entry entry = entries[index]; \
+  \
+  while(index > 0) { \
+    size_t parent = (index - 1) / (ARITY); \
+    if(TYPEPREFIX##_cmp(&entry.value, &entries[parent].value) >= 0) { \
+      break; \
+    } \
+    entries[index] = entries[parent]; \
+    slots[entries[index].handle].position = index; \
+    index = parent; \
+  } \
+  \
+  entries[index] = entry; \
+  slots[entry.handle].position = index; \
+  return index; \
+} \
+\
+/** Move element at index towards leaves, while it's greater than its smallest child. */ \
+NN MU SI void SELFPREFIX##_sift_down(SELFNAME * self, size_t index) { \
+  SELFNAME##_Entry * entries = self->entries.data; \
+  _Heap_slot * slots = self->slots.data; \
+  size_t count = self->entries.count; \
+  SELFNAME##_Entry entry = entries[index]; \
+  \
+  for(;;) { \
+    size_t first = index * (ARITY) + 1; \
+    if(first >= count) { \
+      break; \
+    } \
+    size_t last = first + (ARITY) < count ? first + (ARITY) : count; \
+    size_t smallest = first; \
+    for(size_t child = first + 1; child < last; child++) { \
+      if(TYPEPREFIX##_cmp(&entries[child].value, &entries[smallest].value) < 0) { \
+        smallest = child; \
+      } \
+    } \
+    if(TYPEPREFIX##_cmp(&entries[smallest].value, &entry.value) >= 0) { \
+      break; \
+    } \
+    entries[index] = entries[smallest]; \
+    slots[entries[index].handle].position = index; \
+    index = smallest; \
+  } \
+  \
+  entries[index] = entry; \
+  slots[entry.handle].position = index; \
+}
+
+#define DEFINE_HEAP_PUSH(SELFNAME, SELFPREFIX, CTYPE) \
+/** Allocate handle for new element and make generation of its slot odd. */ \
+NN WUR MU SI size_t SELFPREFIX##_new_handle(SELFNAME * self) { \
+  size_t handle; \
+  if(self->free_handles.count > 0) { \
+    handle = ((size_t *)self->free_handles.data)[--self->free_handles.count]; \
+  } else { \
+    if(self->slots.count == self->slots.capacity) { \
+      _vec_reserve(&self->slots, sizeof(_Heap_slot), 1); \
+    } \
+    handle = self->slots.count++; \
+    ((_Heap_slot *)self->slots.data)[handle] = (_Heap_slot) { .position = _HEAP_NO_POSITION, .generation = 0 }; \
+  } \
+  ((_Heap_slot *)self->slots.data)[handle].generation++; \
+  return handle; \
+} \
+\
+/** Add element and return its handle. O(log n). */ \
+NN MU SI HeapHandle SELFPREFIX##_push(SELFNAME * self, CTYPE value) { \
+  size_t handle = SELFPREFIX##_new_handle(self); \
+  if(self->entries.count == self->entries.capacity) { \
+    _vec_reserve(&self->entries, sizeof(SELFNAME##_Entry), 1); \
+  } \
+  size_t index = self->entries.count++; \
+  ((SELFNAME##_Entry *)self->entries.data)[index] = (SELFNAME##_Entry) { .value = value, .handle = handle }; \
+  SELFPREFIX##_sift_up(self, index); \
+  return (HeapHandle) { .id = handle, .generation = ((_Heap_slot *)self->slots.data)[handle].generation }; \
+}
+
+#define DEFINE_HEAP_PEEK(SELFNAME, SELFPREFIX, CTYPE) \
+/** Return pointer to smallest element, or NULL, when heap is empty.
+ * Element must not be modified through pointer. */ \
+NN WUR MU SI const CTYPE * SELFPREFIX##_peek(const SELFNAME * self) { \
+  if(self->entries.count == 0) { \
+    return NULL; \
+  } \
+  return &((SELFNAME##_Entry *)self->entries.data)[0].value; \
+}
+
+#define DEFINE_HEAP_POP(SELFNAME, SELFPREFIX, CTYPE, TYPEPREFIX) \
+/** Mark element with given handle as removed, make generation of its slot even
+ * and allow reuse of handle. */ \
+NN MU SI void SELFPREFIX##_free_handle(SELFNAME * self, size_t handle) { \
+  _Heap_slot * slot = &((_Heap_slot *)self->slots.data)[handle]; \
+  slot->position = _HEAP_NO_POSITION; \
+  slot->generation++; \
+  if(self->free_handles.count == self->free_handles.capacity) { \
+    _vec_reserve(&self->free_handles, sizeof(size_t), 1); \
+  } \
+  ((size_t *)self->free_handles.data)[self->free_handles.count++] = handle; \
+} \
+\
+/** Remove smallest element and store it into out. Return false, when heap is empty. O(log n). */ \
+NN MU SI bool SELFPREFIX##_pop(SELFNAME * self, CTYPE * out) { \
+  if(self->entries.count == 0) { \
+    return false; \
+  } \
+  SELFNAME##_Entry * entries = self->entries.data; \
+  SELFNAME##_Entry top = entries[0]; \
+  SELFPREFIX##_free_handle(self, top.handle); \
+  \
+  size_t last = --self->entries.count; \
+  if(last > 0) { \
+    entries[0] = entries[last]; \
+    SELFPREFIX##_sift_down(self, 0); \
+  } \
+  \
+  *out = top.value; \
+  return true; \
+} \
+\
+/** Push value and pop smallest element, with single sift instead of two. When
+ * value is not greater than smallest element, it's returned immediately and
+ * heap is not changed. Handle of pushed element is not returned. */ \
+NN WUR MU SI CTYPE SELFPREFIX##_push_pop(SELFNAME * self, CTYPE value) { \
+  SELFNAME##_Entry * entries = self->entries.data; \
+  if(self->entries.count == 0 || TYPEPREFIX##_cmp(&value, &entries[0].value) <= 0) { \
+    return value; \
+  } \
+  CTYPE top = entries[0].value; \
+  /* New handle is allocated first, so handle of popped element is not reused immediately */ \
+  size_t handle = SELFPREFIX##_new_handle(self); \
+  SELFPREFIX##_free_handle(self, entries[0].handle); \
+  entries[0] = (SELFNAME##_Entry) { .value = value, .handle = handle }; \
+  SELFPREFIX##_sift_down(self, 0); \
+  return top; \
+}
+
+#define DEFINE_HEAP_HANDLES(SELFNAME, SELFPREFIX, CTYPE, TYPEPREFIX) \
+/** Return index of element with given handle, or _HEAP_NO_POSITION, when handle
+ * is out of range or its generation doesn't match, i.e. element is popped. */ \
+NN WUR MU SI size_t SELFPREFIX##_find_position(const SELFNAME * self, HeapHandle handle) { \
+  if(handle.id >= self->slots.count) { \
+    return _HEAP_NO_POSITION; \
+  } \
+  const _Heap_slot * slot = &((const _Heap_slot *)self->slots.data)[handle.id]; \
+  if(slot->generation != handle.generation || (slot->generation & 1) == 0) { \
+    return _HEAP_NO_POSITION; \
+  } \
+  return slot->position; \
+} \
+\
+/** Return index of element with given handle, or panic, when handle is not in heap. */ \
+NN WUR MU SI size_t SELFPREFIX##_position(const SELFNAME * self, HeapHandle handle) { \
+  size_t position = SELFPREFIX##_find_position(self, handle); \
+  if(position == _HEAP_NO_POSITION) { \
+    _heap_panic(_HEAP_ERROR_INVALID_HANDLE, handle.id); \
+  } \
+  return position; \
+} \
+\
+/** Return true, when element with given handle is in heap. */ \
+NN WUR MU SI bool SELFPREFIX##_contains(const SELFNAME * self, HeapHandle handle) { \
+  return SELFPREFIX##_find_position(self, handle) != _HEAP_NO_POSITION; \
+} \
+\
+/** Return value of element with given handle. Panics, when handle is not in heap. */ \
+NN WUR MU SI CTYPE SELFPREFIX##_get(const SELFNAME * self, HeapHandle handle) { \
+  return ((SELFNAME##_Entry *)self->entries.data)[SELFPREFIX##_position(self, handle)].value; \
+} \
+\
+/** Replace value of element with smaller or equal one. O(log n).
+ * Panics, when handle is not in heap or when value is greater than current one. */ \
+NN MU SI void SELFPREFIX##_decrease_key(SELFNAME * self, HeapHandle handle, CTYPE value) { \
+  size_t position = SELFPREFIX##_position(self, handle); \
+  SELFNAME##_Entry * entry = &((SELFNAME##_Entry *)self->entries.data)[position]; \
+  if(TYPEPREFIX##_cmp(&value, &entry->value) > 0) { \
+    _heap_panic(_HEAP_ERROR_KEY_INCREASED, handle.id); \
+  } \
+  entry->value = value; \
+  SELFPREFIX##_sift_up(self, position); \
+} \
+\
+/** Replace value of element with any value. O(log n). Panics, when handle is not in heap. */ \
+NN MU SI void SELFPREFIX##_update(SELFNAME * self, HeapHandle handle, CTYPE value) { \
+  size_t position = SELFPREFIX##_position(self, handle); \
+  ((SELFNAME##_Entry *)self->entries.data)[position].value = value; \
+  if(SELFPREFIX##_sift_up(self, position) == position) { \
+    SELFPREFIX##_sift_down(self, position); \
+  } \
+}
+
+#define DEFINE_HEAP_BY_VALUE_WITH_ARITY(SELFNAME, SELFPREFIX, CTYPE, TYPEPREFIX, ARITY) \
+DEFINE_HEAP_STRUCT(SELFNAME, CTYPE) \
+DEFINE_HEAP_NEW(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_HEAP_SIFT(SELFNAME, SELFPREFIX, CTYPE, TYPEPREFIX, ARITY) \
+DEFINE_HEAP_PUSH(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_HEAP_PEEK(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_HEAP_POP(SELFNAME, SELFPREFIX, CTYPE, TYPEPREFIX) \
+DEFINE_HEAP_HANDLES(SELFNAME, SELFPREFIX, CTYPE, TYPEPREFIX) \
+
+/** Define heap with default arity. */
+#define DEFINE_HEAP_BY_VALUE(SELFNAME, SELFPREFIX, CTYPE, TYPEPREFIX) \
+  DEFINE_HEAP_BY_VALUE_WITH_ARITY(SELFNAME, SELFPREFIX, CTYPE, TYPEPREFIX, HEAP_DEFAULT_ARITY)
+
+#define HEAP_TO_SLICE_AND_VEC(SELFNAME, SELFPREFIX, CTYPE, SLICENAME, SLICEPREFIX, VECNAME, VECPREFIX) \
+/** Create heap from elements of slice in O(n). Handle of element is
+ * heap_slice_handle() of its index in slice. */ \
+NN WUR MU SI SELFNAME SELFPREFIX##_from_slice(const SLICENAME * slice) { \
+  size_t count = SLICEPREFIX##_len(slice); \
+  const CTYPE * data = SLICEPREFIX##_as_ptr(slice); \
+  SELFNAME self = SELFPREFIX##_with_capacity(count > 0 ? count : 1); \
+  \
+  SELFNAME##_Entry * entries = self.entries.data; \
+  _Heap_slot * slots = self.slots.data; \
+  for(size_t i = 0; i < count; i++) { \
+    entries[i] = (SELFNAME##_Entry) { .value = data[i], .handle = i }; \
+    slots[i] = (_Heap_slot) { .position = i, .generation = heap_slice_handle(i).generation }; \
+  } \
+  self.entries.count = count; \
+  self.slots.count = count; \
+  \
+  /* Sift down every inner node, from last one to root. Last inner node is parent of last element. */ \
+  for(size_t i = count >= 2 ? (count - 2) / SELFPREFIX##_arity() + 1 : 0; i-- > 0; ) { \
+    SELFPREFIX##_sift_down(&self, i); \
+  } \
+  return self; \
+} \
+\
+/** Move all elements into vector in ascending order and destroy heap. O(n log n). */ \
+NN WUR MU SI VECNAME SELFPREFIX##_into_sorted_vec(SELFNAME * self) { \
+  VECNAME vec = VECPREFIX##_with_capacity(self->entries.count > 0 ? self->entries.count : 1); \
+  CTYPE value; \
+  while(SELFPREFIX##_pop(self, &value)) { \
+    VECPREFIX##_push(&vec, value); \
+  } \
+  SELFPREFIX##_destroy(self); \
+  return vec; \
+}
+
+#endif /* CRUST_TYPE_HEAP_H_ */
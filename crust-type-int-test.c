@@ -5,3 +5,26 @@ it(int_default, "must return 0") {
   assert_equal_int(0, int_default(), "Unexpected value");
 }
 
+
+it(int_hash, "must return same hash for same values and different hashes for near values") {
+  int a = 42, b = 42, c = 43;
+  assert_true(int_hash(&a) == int_hash(&b), "Hash must depend on value only");
+  assert_true(int_hash(&a) != int_hash(&c), "Near values must have different hashes");
+
+  // Hash tables use 7 high bits of hash, so they must be spread well for small values
+  bool seen[128] = { false };
+  int distinct = 0;
+  for(int i=0; i<1024; i++) {
+    size_t high = int_hash(&i) >> (sizeof(size_t)*8 - 7);
+    distinct += !seen[high];
+    seen[high] = true;
+  }
+  assert_true(distinct > 100, "High bits of hash must depend on low bits of value");
+}
+
+it(int_cmp, "must compare integers without overflow") {
+  int a = -2000000000, b = 2000000000;
+  assert_true(int_cmp(&a, &b) < 0, "Less value must be less");
+  assert_true(int_cmp(&b, &a) > 0, "Greater value must be greater");
+  assert_true(int_cmp(&a, &a) == 0, "Equal values must be equal");
+}
@@ -9,8 +9,11 @@
 #define CRUST_TYPE_INT_H_
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include "crust-mem.h"
+#include "crust-hash.h"
 
 WUR MU SI int int_default() {
   return 0;
@@ -20,4 +23,14 @@ NN WUR MU SI bool int_eq(const int * left, const int * right) {
   return *left == *right;
 }
 
+/** Return negative value, 0, or positive value when left is less than, equal to, or greater than right. */
+NN WUR MU SI int int_cmp(const int * left, const int * right) {
+  return (*left > *right) - (*left < *right);
+}
+
+/** Return hash of integer. */
+NN WUR MU SI size_t int_hash(const int * self) {
+  return (size_t)hash_u64((uint64_t)(unsigned int)*self);
+}
+
 #endif /* CRUST_TYPE_INT_H_ */
@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "crust-type-interner.h"
+
+#include "crust-bench.h"
+
+#define INTERNER_BENCH_WORDS 10000
+
+// Words like "identifier_00042", which share long prefix, as names in source code do
+static char interner_bench_words[INTERNER_BENCH_WORDS][24];
+static Str interner_bench_strs[INTERNER_BENCH_WORDS];
+
+static void interner_bench_init(void) {
+  for(int i = 0; i < INTERNER_BENCH_WORDS; i++) {
+    snprintf(interner_bench_words[i], sizeof(interner_bench_words[i]), "identifier_%05d", i);
+    interner_bench_strs[i] = str_from_charp(interner_bench_words[i]);
+  }
+}
+
+bench(interner_intern_new, "intern 10000 distinct strings into new interner") {
+  interner_bench_init();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    defer(interner_destroy) Interner interner = interner_new();
+    for(int j = 0; j < INTERNER_BENCH_WORDS; j++) {
+      (void)interner_intern(&interner, &interner_bench_strs[j]);
+    }
+    bench_do_not_optimize(&interner);
+  }
+}
+
+bench(interner_intern_existing, "intern 10000 strings, which are interned already") {
+  interner_bench_init();
+  defer(interner_destroy) Interner interner = interner_new();
+  for(int j = 0; j < INTERNER_BENCH_WORDS; j++) {
+    (void)interner_intern(&interner, &interner_bench_strs[j]);
+  }
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    Symbol sum = 0;
+    for(int j = 0; j < INTERNER_BENCH_WORDS; j++) {
+      sum += interner_intern(&interner, &interner_bench_strs[j]);
+    }
+    bench_do_not_optimize(&sum);
+  }
+}
+
+// Comparisons of neighbour words, which differ in last chars only, are the worst case for strcmp()
+bench(interner_symbol_eq, "compare 10000 pairs of symbols") {
+  interner_bench_init();
+  defer(interner_destroy) Interner interner = interner_new();
+  Symbol symbols[INTERNER_BENCH_WORDS];
+  for(int j = 0; j < INTERNER_BENCH_WORDS; j++) {
+    symbols[j] = interner_intern(&interner, &interner_bench_strs[j]);
+  }
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    size_t equal = 0;
+    for(int j = 1; j < INTERNER_BENCH_WORDS; j++) {
+      equal += symbol_eq(&symbols[j - 1], &symbols[j]);
+    }
+    bench_do_not_optimize(&equal);
+  }
+}
+
+bench(interner_strcmp, "compare 10000 pairs of strings with strcmp(), as baseline") {
+  interner_bench_init();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    size_t equal = 0;
+    for(int j = 1; j < INTERNER_BENCH_WORDS; j++) {
+      bench_clobber();
+      equal += strcmp(interner_bench_words[j - 1], interner_bench_words[j]) == 0;
+    }
+    bench_do_not_optimize(&equal);
+  }
+}
@@ -0,0 +1,53 @@
+#include <stdio.h>
+
+#include "crust-type-interner.h"
+#include "crust-type-ccharp.h"
+#include "crust-unittest.h"
+
+it(interner_intern, "must return same symbol for equal strings") {
+  defer(interner_destroy) Interner interner = interner_new();
+  char buf[] = "foo";
+
+  Symbol foo = interner_intern_charp(&interner, "foo");
+  Symbol bar = interner_intern_charp(&interner, "bar");
+  assert_equal_int(0, foo, "Symbols must be numbered in order of interning");
+  assert_equal_int(1, bar, "Symbols must be numbered in order of interning");
+  assert_equal_int(foo, interner_intern_charp(&interner, buf), "Equal strings must have equal symbols");
+  assert_equal_int(2, interner_len(&interner), "Unexpected number of distinct strings");
+
+  Str sub = str_from_charp("foobar");
+  sub = str_slice(&sub, 3, 3);
+  assert_equal_int(bar, interner_intern(&interner, &sub), "Str must be interned by content, not by pointer");
+
+  Str empty = str_from_charp("");
+  Symbol e = interner_intern(&interner, &empty);
+  assert_equal_charp("", interner_resolve(&interner, e), "Empty string must be interned too");
+
+  assert_abort((void)(NULL == interner_resolve(&interner, 42)), "interner_resolve() must abort on unknown symbol");
+}
+
+it(interner_resolve, "must return canonical pointers, which stay valid when interner grows") {
+  defer(interner_destroy) Interner interner = interner_new();
+
+  const char * first = interner_canonical(&interner, "identifier");
+  char buf[32];
+  for(int i=0; i<100000; i++) {
+    snprintf(buf, sizeof(buf), "id%d", i);
+    (void)interner_intern_charp(&interner, buf);
+  }
+
+  assert_true(first == interner_canonical(&interner, "identifier"), "Canonical pointer must not change");
+  assert_equal_charp("identifier", first, "Canonical pointer must point to copy of string");
+  assert_equal_charp("id12345", interner_resolve(&interner, 12346), "Symbol must resolve to its string");
+
+  const char * a = interner_canonical(&interner, "id777");
+  const char * b = interner_canonical(&interner, "id777");
+  assert_true(a == b && ccharp_eq(&a, &b), "Equal canonical strings must be equal by pointer");
+
+  Symbol symbol = 0;
+  Str missing = str_from_charp("missing");
+  assert_true(!interner_lookup(&interner, &missing, &symbol), "interner_lookup() must not intern string");
+  Str known = str_from_charp("id5");
+  assert_true(interner_lookup(&interner, &known, &symbol), "interner_lookup() must find interned string");
+  assert_equal_int(6, symbol, "Unexpected symbol");
+}
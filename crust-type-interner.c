@@ -0,0 +1,108 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "crust-type-interner.h"
+
+/** Size of arena chunk. Longer strings get chunk of their own size. */
+#define INTERNER_CHUNK_SIZE 65536
+
+void interner_panic(int error_code, size_t value) {
+  switch(error_code) {
+    case INTERNER_ERROR_UNKNOWN_SYMBOL:
+      fprintf(stderr, "ERROR: Interner: Unknown symbol: %zu.\n", value);
+    break;
+
+    case INTERNER_ERROR_TOO_MANY_SYMBOLS:
+      fprintf(stderr, "ERROR: Interner: Too many symbols: %zu.\n", value);
+    break;
+
+    default:
+      fprintf(stderr, "ERROR: interner_panic(): Unknown error code: %d.\n", error_code);
+  }
+
+  abort();
+}
+
+Interner interner_with_capacity(size_t capacity) {
+  return (Interner) {
+    .map = _interner_map_with_capacity(capacity),
+    .strings = _vec_with_capacity(sizeof(Str), capacity > 0 ? capacity : 8),
+    .chunks = _vec_new(sizeof(char *)),
+    .chunk_ptr = NULL,
+    .chunk_left = 0,
+  };
+}
+
+void interner_destroy(Interner * self) {
+  for(size_t i = 0; i < self->chunks.count; i++) {
+    mem_free(((char **)self->chunks.data)[i]);
+  }
+  _vec_destroy(&self->chunks);
+  _vec_destroy(&self->strings);
+  _interner_map_destroy(&self->map);
+  self->chunk_ptr = NULL;
+  self->chunk_left = 0;
+}
+
+/* Copy string into arena, terminate it by '\0', and return copy. */
+static Str interner_copy(Interner * self, const Str * str) {
+  size_t length = str_len(str);
+
+  if(self->chunk_left < length + 1) {
+    size_t size = length + 1 > INTERNER_CHUNK_SIZE ? length + 1 : INTERNER_CHUNK_SIZE;
+    char * chunk = mem_malloc(size, sizeof(char));
+
+    if(self->chunks.count == self->chunks.capacity) {
+      _vec_reserve(&self->chunks, sizeof(char *), 1);
+    }
+    ((char **)self->chunks.data)[self->chunks.count++] = chunk;
+
+    self->chunk_ptr = chunk;
+    self->chunk_left = size;
+  }
+
+  char * copy = self->chunk_ptr;
+  if(length > 0) {
+    memcpy(copy, str_as_ptr(str), length);
+  }
+  copy[length] = '\0';
+
+  self->chunk_ptr += length + 1;
+  self->chunk_left -= length + 1;
+
+  return (Str) { .super = _slice_from_raw_parts(copy, length) };
+}
+
+Symbol interner_intern(Interner * self, const Str * str) {
+  // Single probe: bucket for new string is claimed by same lookup, which misses
+  Str key = *str;
+  bool inserted;
+  _Interner_map_Entry * entry = _interner_map_find_or_insert_slot(&self->map, &key, str_hash(&key), &inserted);
+  if(!inserted) {
+    return entry->value;
+  }
+
+  size_t symbol = self->strings.count;
+  if(symbol >= UINT32_MAX) {
+    interner_panic(INTERNER_ERROR_TOO_MANY_SYMBOLS, symbol);
+  }
+
+  // Key of map points to copy in arena, so it stays valid
+  Str copy = interner_copy(self, str);
+  if(self->strings.count == self->strings.capacity) {
+    _vec_reserve(&self->strings, sizeof(Str), 1);
+  }
+  ((Str *)self->strings.data)[self->strings.count++] = copy;
+  entry->key = copy;
+  entry->value = (Symbol)symbol;
+
+  return (Symbol)symbol;
+}
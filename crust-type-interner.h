@@ -0,0 +1,103 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#ifndef CRUST_TYPE_INTERNER_H_
+#define CRUST_TYPE_INTERNER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "crust-mem.h"
+#include "crust-hash.h"
+#include "crust-type-vec.h"
+#include "crust-type-string.h"
+#include "crust-type-hashmap.h"
+
+enum Interner_error_codes {
+  INTERNER_ERROR_UNKNOWN_SYMBOL = 1,
+  INTERNER_ERROR_TOO_MANY_SYMBOLS = 2,
+};
+
+void interner_panic(int error_code, size_t value);
+
+/** Compact id of interned string. Equal strings have equal symbols. */
+typedef uint32_t Symbol;
+
+MU SI bool symbol_eq(const Symbol * left, const Symbol * right) { return *left == *right; }
+MU SI int symbol_cmp(const Symbol * left, const Symbol * right) { return (*left > *right) - (*left < *right); }
+MU SI size_t symbol_hash(const Symbol * self) { return (size_t)hash_u64(*self); }
+
+DEFINE_HASHMAP_BY_VALUE(_Interner_map, _interner_map, Str, str, Symbol)
+
+/**
+ * String interner.
+ *
+ * Every distinct string is copied once into arena and gets symbol: index
+ * of string in order of interning. Strings in arena are terminated by '\0'
+ * and never move, so pointer returned by interner_resolve() is canonical:
+ * equal strings have equal pointers, and ccharp_eq() returns at pointer
+ * comparison. Both symbols and canonical pointers are valid until
+ * interner_destroy().
+ */
+typedef struct {
+  _Interner_map map;
+  _Vec strings;
+  _Vec chunks;
+  char * chunk_ptr;
+  size_t chunk_left;
+} Interner;
+
+/** Create new interner with room for given number of strings. */
+WUR Interner interner_with_capacity(size_t capacity);
+
+/** Create new empty interner. */
+WUR MU SI Interner interner_new() { return interner_with_capacity(0); }
+
+/** Free all strings. Symbols and canonical pointers become invalid. */
+NN void interner_destroy(Interner * self);
+
+/** Return number of distinct strings. */
+NN WUR MU SI size_t interner_len(const Interner * self) { return self->strings.count; }
+
+/** Return symbol of string. String is copied into interner when it is seen first time. */
+NN Symbol interner_intern(Interner * self, const Str * str);
+
+/** Return symbol of zero-terminated string. */
+NN MU SI Symbol interner_intern_charp(Interner * self, const char * charp) {
+  Str str = str_from_charp(charp);
+  return interner_intern(self, &str);
+}
+
+/** Return true and store symbol into out, if string is interned already, or return false. Interner is not changed. */
+NN WUR MU SI bool interner_lookup(const Interner * self, const Str * str, Symbol * out) {
+  const Symbol * symbol = _interner_map_get(&self->map, *str);
+  if(symbol) {
+    *out = *symbol;
+  }
+  return symbol != NULL;
+}
+
+/** Return interned string as Str. Panics if symbol is unknown. */
+NN WUR MU SI Str interner_resolve_str(const Interner * self, Symbol symbol) {
+  if(symbol >= self->strings.count) {
+    interner_panic(INTERNER_ERROR_UNKNOWN_SYMBOL, symbol);
+  }
+  return ((const Str *)self->strings.data)[symbol];
+}
+
+/** Return canonical zero-terminated copy of interned string. Panics if symbol is unknown. */
+NN WUR MU SI const char * interner_resolve(const Interner * self, Symbol symbol) {
+  Str str = interner_resolve_str(self, symbol);
+  return str_as_ptr(&str);
+}
+
+/** Return canonical pointer for zero-terminated string. */
+NN MU SI const char * interner_canonical(Interner * self, const char * charp) {
+  return interner_resolve(self, interner_intern_charp(self, charp));
+}
+
+#endif /* CRUST_TYPE_INTERNER_H_ */
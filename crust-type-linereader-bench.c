@@ -0,0 +1,93 @@
+// For fileno() and getline()
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "crust-type-linereader.h"
+
+#include "crust-bench.h"
+
+//
+// Read 2 GB log file of about 24M lines line by line, so lines per second
+// are 24e6 / (ns per iteration) * 1e9. File is written once into temporary
+// file, so it is read from page cache, and iostream/syscall overhead is
+// measured rather than disk.
+//
+
+#define LINEREADER_BENCH_BYTES ((size_t)2 << 30)
+
+static FILE * linereader_bench_file = NULL;
+static size_t linereader_bench_lines = 0;
+
+static int linereader_bench_init(void) {
+  if(linereader_bench_file) {
+    return fileno(linereader_bench_file);
+  }
+
+  linereader_bench_file = tmpfile();
+  if(!linereader_bench_file) {
+    perror("ERROR: LineReader bench: Cannot create temporary file");
+    abort();
+  }
+
+  size_t length = 0;
+  while(length < LINEREADER_BENCH_BYTES) {
+    int written = fprintf(linereader_bench_file, "2018-03-%02zu 12:%02zu:%02zu INFO request id=%zu path=/api/v1/items/%zu status=200 time=%zums\n",
+      1 + linereader_bench_lines % 28, linereader_bench_lines / 60 % 60, linereader_bench_lines % 60,
+      linereader_bench_lines, linereader_bench_lines * 7 % 1000, linereader_bench_lines % 97);
+    if(written < 0) {
+      perror("ERROR: LineReader bench: Cannot write temporary file");
+      abort();
+    }
+    length += (size_t)written;
+    linereader_bench_lines++;
+  }
+  fflush(linereader_bench_file);
+
+  return fileno(linereader_bench_file);
+}
+
+bench(linereader_2gb, "read 2 GB log file (about 24M lines) with LineReader") {
+  int fd = linereader_bench_init();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    lseek(fd, 0, SEEK_SET);
+    defer(linereader_destroy) LineReader reader = linereader_new(fd);
+    Str line;
+    size_t lines = 0, bytes = 0;
+    while(linereader_next(&reader, &line)) {
+      lines++;
+      bytes += str_len(&line);
+    }
+    if(lines != linereader_bench_lines) {
+      abort();
+    }
+    bench_do_not_optimize(&bytes);
+  }
+}
+
+bench(linereader_getline_2gb, "read 2 GB log file (about 24M lines) with getline(), as baseline") {
+  linereader_bench_init();
+  char * line = NULL;
+  size_t capacity = 0;
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    rewind(linereader_bench_file);
+    ssize_t length;
+    size_t lines = 0, bytes = 0;
+    while((length = getline(&line, &capacity, linereader_bench_file)) >= 0) {
+      lines++;
+      bytes += (size_t)length;
+    }
+    if(lines != linereader_bench_lines) {
+      abort();
+    }
+    bench_do_not_optimize(&bytes);
+  }
+
+  free(line);
+}
@@ -0,0 +1,78 @@
+// For fileno()
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "crust-type-linereader.h"
+#include "crust-unittest.h"
+
+/* Write text into temporary file and return it, positioned at start. */
+static FILE * linereader_test_file(const char * text, size_t length) {
+  FILE * file = tmpfile();
+  assert_true(file != NULL, "tmpfile() must create temporary file");
+  assert_equal_int(length, fwrite(text, 1, length, file), "fwrite() must write whole text");
+  fflush(file);
+  lseek(fileno(file), 0, SEEK_SET);
+  return file;
+}
+
+it(linereader_next, "must return lines without '\\n', including last line without '\\n'") {
+  const char text[] = "first\n\nthird line\nlast";
+  FILE * file = linereader_test_file(text, sizeof(text) - 1);
+  const char * expected[] = { "first", "", "third line", "last" };
+
+  defer(linereader_destroy) LineReader reader = linereader_new(fileno(file));
+  Str line;
+  size_t count = 0;
+  while(linereader_next(&reader, &line)) {
+    assert_true(count < 4, "must return expected number of lines");
+    Str e = str_from_charp(expected[count]);
+    assert_true(str_eq(&e, &line), "must return text of line");
+    count++;
+  }
+
+  assert_equal_int(4, count, "must return all lines");
+  assert_equal_int(0, linereader_error(&reader), "must finish without error");
+  assert_true(!linereader_next(&reader, &line), "must return false after end of file");
+
+  fclose(file);
+}
+
+it(linereader_small_buffer, "must return lines, which straddle buffer or are longer than buffer") {
+  defer(string_destroy) String text = string_new();
+  for(int i = 0; i < 1000; i++) {
+    // Lengths of lines vary from 0 to 99 chars
+    for(int j = 0; j < (i * 37) % 100; j++) {
+      string_put_char(&text, (char)('a' + (i + j) % 26));
+    }
+    string_put_char(&text, '\n');
+  }
+  FILE * file = linereader_test_file(string_as_ptr(&text), string_len(&text));
+
+  defer(linereader_destroy) LineReader reader = linereader_with_capacity(fileno(file), 16);
+  Str line;
+  int count = 0;
+  bool ok = true;
+  while(linereader_next(&reader, &line)) {
+    ok = ok && str_len(&line) == (size_t)((count * 37) % 100);
+    for(size_t j = 0; ok && j < str_len(&line); j++) {
+      ok = str_as_ptr(&line)[j] == (char)('a' + (count + (int)j) % 26);
+    }
+    count++;
+  }
+
+  assert_true(ok, "must return text of every line");
+  assert_equal_int(1000, count, "must return all lines");
+
+  fclose(file);
+}
+
+it(linereader_error, "must stop and report error of read()") {
+  defer(linereader_destroy) LineReader reader = linereader_new(-1);
+  Str line;
+
+  assert_true(!linereader_next(&reader, &line), "must return false on error");
+  assert_true(linereader_error(&reader) != 0, "must report errno");
+}
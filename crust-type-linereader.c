@@ -0,0 +1,92 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "crust-type-linereader.h"
+
+LineReader linereader_with_capacity(int fd, size_t capacity) {
+  return (LineReader) {
+    .fd = fd,
+    .buffer = string_with_capacity(capacity > 0 ? capacity : 1),
+    .start = 0,
+    .scanned = 0,
+    .eof = false,
+    .error = 0,
+  };
+}
+
+void linereader_destroy(LineReader * self) {
+  string_destroy(&self->buffer);
+  self->start = self->scanned = 0;
+}
+
+/* Read next block into free space of buffer. Return false at end of file or on error. */
+static bool linereader_fill(LineReader * self) {
+  String * buffer = &self->buffer;
+  char * data = string_as_ptr(buffer);
+  size_t len = string_len(buffer);
+
+  // Move incomplete line to start of buffer, or grow buffer when line fills it
+  if(self->start > 0) {
+    memmove(data, data + self->start, len - self->start);
+    len -= self->start;
+    self->start = 0;
+    string_set_len_unsafe(buffer, len);
+  } else if(len == string_capacity(buffer)) {
+    string_reserve(buffer, len);
+  }
+  data = string_as_ptr(buffer);
+
+  for(;;) {
+    ssize_t result = read(self->fd, data + len, string_capacity(buffer) - len);
+    if(result > 0) {
+      string_set_len_unsafe(buffer, len + (size_t)result);
+      return true;
+    }
+    if(result == 0) {
+      self->eof = true;
+      return false;
+    }
+    if(errno != EINTR) {
+      self->error = errno;
+      return false;
+    }
+  }
+}
+
+bool linereader_next(LineReader * self, Str * line) {
+  for(;;) {
+    const char * data = string_as_ptr(&self->buffer);
+    size_t available = string_len(&self->buffer) - self->start;
+    const char * text = data + self->start;
+
+    // memchr() of libc is vectorized already
+    const char * newline = memchr(text + self->scanned, '\n', available - self->scanned);
+    if(newline) {
+      size_t length = (size_t)(newline - text);
+      *line = str_from_raw_parts(text, length);
+      self->start += length + 1;
+      self->scanned = 0;
+      return true;
+    }
+    self->scanned = available;
+
+    if(self->eof || self->error || !linereader_fill(self)) {
+      if(self->error || available == 0) {
+        return false;
+      }
+      // Last line without '\n'
+      *line = str_from_raw_parts(string_as_ptr(&self->buffer) + self->start, available);
+      self->start += available;
+      self->scanned = 0;
+      return true;
+    }
+  }
+}
@@ -0,0 +1,57 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#ifndef CRUST_TYPE_LINEREADER_H_
+#define CRUST_TYPE_LINEREADER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "crust-mem.h"
+#include "crust-type-string.h"
+
+/** Default size of buffer of line reader. */
+#define LINEREADER_DEFAULT_CAPACITY (64*1024)
+
+/**
+ * Buffered reader of lines from file descriptor.
+ *
+ * File is read in large blocks into reusable buffer, and lines are returned
+ * as Str slices, which point into that buffer, so lines are never copied.
+ * Line, which straddles end of buffer, is moved to start of buffer before
+ * next read, and buffer grows only when single line is longer than buffer.
+ */
+typedef struct {
+  int fd;
+  String buffer;
+  /** Start of unread text in buffer. */
+  size_t start;
+  /** Number of bytes after start, which are checked for '\n' already. */
+  size_t scanned;
+  bool eof;
+  /** errno of failed read(), or 0. */
+  int error;
+} LineReader;
+
+/** Create line reader with buffer of given size. File descriptor is not owned by reader. */
+WUR LineReader linereader_with_capacity(int fd, size_t capacity);
+
+/** Create line reader with default size of buffer. */
+WUR MU SI LineReader linereader_new(int fd) { return linereader_with_capacity(fd, LINEREADER_DEFAULT_CAPACITY); }
+
+/** Free buffer. File descriptor is not closed. It's safe to call destroy() twice. */
+NN void linereader_destroy(LineReader * self);
+
+/** Store next line, without '\n', into line and return true, or return false
+ * at end of file or on error. Line is valid until next call. Last line can
+ * be without '\n'. */
+NN WUR bool linereader_next(LineReader * self, Str * line);
+
+/** Return errno of failed read(), or 0 when no error happened. */
+NN WUR MU SI int linereader_error(const LineReader * self) { return self->error; }
+
+#endif /* CRUST_TYPE_LINEREADER_H_ */
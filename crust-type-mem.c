@@ -15,6 +15,22 @@ void mem_panic(int error_code, size_t value) {
       fprintf(stderr, "ERROR: Integer overflow.\n");
     break;
 
+    case MEM_ERROR_INVALID_FREE:
+      fprintf(stderr, "ERROR: Mem: Pointer is not allocated by mem_*() functions.\n");
+    break;
+
+    case MEM_ERROR_DOUBLE_FREE:
+      fprintf(stderr, "ERROR: Mem: Block is freed twice. Size: %zu.\n", value);
+    break;
+
+    case MEM_ERROR_BUFFER_OVERFLOW:
+      fprintf(stderr, "ERROR: Mem: Write outside of block. Size: %zu.\n", value);
+    break;
+
+    case MEM_ERROR_USE_AFTER_FREE:
+      fprintf(stderr, "ERROR: Mem: Write into freed block. Size: %zu.\n", value);
+    break;
+
     default:
       fprintf(stderr, "ERROR: mem_panic(): Unknown error code: %d.\n", error_code);
   }
@@ -22,7 +38,7 @@ void mem_panic(int error_code, size_t value) {
   abort();
 }
 
-void * mem_realloc(void *ptr, size_t length, size_t element_size) {
+void * (mem_realloc)(void *ptr, size_t length, size_t element_size) {
   if(SIZE_MAX/element_size < length) {
     mem_panic(MEM_ERROR_INTEGER_OVERFLOW, 0);
   }
@@ -36,7 +52,7 @@ void * mem_realloc(void *ptr, size_t length, size_t element_size) {
   return result;
 }
 
-void * mem_calloc(size_t length, size_t element_size) {
+void * (mem_calloc)(size_t length, size_t element_size) {
   if(SIZE_MAX/element_size < length) {
     mem_panic(MEM_ERROR_INTEGER_OVERFLOW, 0);
   }
@@ -49,3 +65,266 @@ void * mem_calloc(size_t length, size_t element_size) {
 
   return result;
 }
+
+#ifdef CRUST_DEBUG_ALLOC
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Size of freed blocks, which are kept in quarantine before they are returned to libc. */
+#ifndef CRUST_DEBUG_ALLOC_QUARANTINE
+#define CRUST_DEBUG_ALLOC_QUARANTINE (8u << 20)
+#endif
+
+/* Maximum number of leaked blocks to print at exit. */
+#define MEM_DEBUG_MAX_LEAKS_TO_PRINT 32
+
+#define MEM_DEBUG_MAGIC_LIVE  UINT64_C(0x4b4c424556494c31)
+#define MEM_DEBUG_MAGIC_FREED UINT64_C(0x4b4c424545524631)
+
+/* Guard bytes around block, uninitialized memory, and freed memory. */
+#define MEM_DEBUG_GUARD 0xAB
+#define MEM_DEBUG_FRESH 0xCD
+#define MEM_DEBUG_POISON 0xDD
+
+/* Header of block. Block is linked into list of live blocks, or into quarantine when it's freed. */
+typedef struct _Mem_debug_block {
+  uint64_t magic;
+  size_t size;
+  const char * file;
+  const char * free_file;
+  int line;
+  int free_line;
+  struct _Mem_debug_block * prev;
+  struct _Mem_debug_block * next;
+} _Mem_debug_block;
+
+/* Header is padded, so data is aligned as by malloc(). */
+#define MEM_DEBUG_HEADER_SIZE ((sizeof(_Mem_debug_block) + 15) / 16 * 16)
+#define MEM_DEBUG_REDZONE_SIZE 16
+#define MEM_DEBUG_OVERHEAD (MEM_DEBUG_HEADER_SIZE + 2 * MEM_DEBUG_REDZONE_SIZE)
+
+static pthread_mutex_t mem_debug_lock = PTHREAD_MUTEX_INITIALIZER;
+static _Mem_debug_block * mem_debug_live_head = NULL;
+static size_t mem_debug_live_count = 0;
+static _Mem_debug_block * mem_debug_quarantine_head = NULL;
+static _Mem_debug_block * mem_debug_quarantine_tail = NULL;
+static size_t mem_debug_quarantine_bytes = 0;
+static bool mem_debug_report_registered = false;
+
+static unsigned char * mem_debug_data(_Mem_debug_block * block) {
+  return (unsigned char *)block + MEM_DEBUG_HEADER_SIZE + MEM_DEBUG_REDZONE_SIZE;
+}
+
+static bool mem_debug_bytes_are(const unsigned char * bytes, size_t length, unsigned char value) {
+  for(size_t i = 0; i < length; i++) {
+    if(bytes[i] != value) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void mem_debug_check_guards(_Mem_debug_block * block, const char * file, int line) {
+  unsigned char * data = mem_debug_data(block);
+  if(!mem_debug_bytes_are(data - MEM_DEBUG_REDZONE_SIZE, MEM_DEBUG_REDZONE_SIZE, MEM_DEBUG_GUARD)
+    || !mem_debug_bytes_are(data + block->size, MEM_DEBUG_REDZONE_SIZE, MEM_DEBUG_GUARD)) {
+    fprintf(stderr, "ERROR: Mem: Guard bytes of block allocated at %s:%d are damaged. Detected at %s:%d.\n",
+      block->file, block->line, file, line);
+    mem_panic(MEM_ERROR_BUFFER_OVERFLOW, block->size);
+  }
+}
+
+static void mem_debug_check_poison(_Mem_debug_block * block) {
+  if(!mem_debug_bytes_are(mem_debug_data(block), block->size, MEM_DEBUG_POISON)) {
+    fprintf(stderr, "ERROR: Mem: Block allocated at %s:%d is written after it is freed at %s:%d.\n",
+      block->file, block->line, block->free_file, block->free_line);
+    mem_panic(MEM_ERROR_USE_AFTER_FREE, block->size);
+  }
+  mem_debug_check_guards(block, block->free_file, block->free_line);
+}
+
+/* Return header of live block. Must be called with lock held. */
+static _Mem_debug_block * mem_debug_block_of(void * ptr, const char * file, int line) {
+  _Mem_debug_block * block = (_Mem_debug_block *)((unsigned char *)ptr - MEM_DEBUG_REDZONE_SIZE - MEM_DEBUG_HEADER_SIZE);
+
+  if(block->magic == MEM_DEBUG_MAGIC_FREED) {
+    fprintf(stderr, "ERROR: Mem: Block allocated at %s:%d and freed at %s:%d is freed again at %s:%d.\n",
+      block->file, block->line, block->free_file, block->free_line, file, line);
+    mem_panic(MEM_ERROR_DOUBLE_FREE, block->size);
+  }
+
+  if(block->magic != MEM_DEBUG_MAGIC_LIVE) {
+    fprintf(stderr, "ERROR: Mem: Pointer %p is not allocated by mem_*() functions. Freed at %s:%d.\n", ptr, file, line);
+    mem_panic(MEM_ERROR_INVALID_FREE, 0);
+  }
+
+  mem_debug_check_guards(block, file, line);
+
+  return block;
+}
+
+static void mem_debug_report_leaks(void) {
+  size_t count = 0, bytes = 0;
+
+  pthread_mutex_lock(&mem_debug_lock);
+  for(_Mem_debug_block * block = mem_debug_live_head; block != NULL; block = block->next) {
+    if(count < MEM_DEBUG_MAX_LEAKS_TO_PRINT) {
+      fprintf(stderr, "ERROR: Mem: Leak of %zu bytes allocated at %s:%d.\n", block->size, block->file, block->line);
+    }
+    count++;
+    bytes += block->size;
+  }
+  pthread_mutex_unlock(&mem_debug_lock);
+
+  if(count > 0) {
+    fprintf(stderr, "ERROR: Mem: %zu blocks (%zu bytes) are not freed.\n", count, bytes);
+    fflush(stdout);
+    _exit(1);
+  }
+}
+
+static void * mem_debug_alloc(size_t size, const char * file, int line) {
+  if(size > SIZE_MAX - MEM_DEBUG_OVERHEAD) {
+    mem_panic(MEM_ERROR_INTEGER_OVERFLOW, 0);
+  }
+
+  _Mem_debug_block * block = malloc(MEM_DEBUG_OVERHEAD + size);
+  if(!block) {
+    mem_panic(MEM_ERROR_OUT_OF_MEM, size);
+  }
+
+  *block = (_Mem_debug_block) { .magic = MEM_DEBUG_MAGIC_LIVE, .size = size, .file = file, .line = line };
+  unsigned char * data = mem_debug_data(block);
+  memset(data - MEM_DEBUG_REDZONE_SIZE, MEM_DEBUG_GUARD, MEM_DEBUG_REDZONE_SIZE);
+  memset(data + size, MEM_DEBUG_GUARD, MEM_DEBUG_REDZONE_SIZE);
+
+  pthread_mutex_lock(&mem_debug_lock);
+  block->next = mem_debug_live_head;
+  if(mem_debug_live_head) {
+    mem_debug_live_head->prev = block;
+  }
+  mem_debug_live_head = block;
+  mem_debug_live_count++;
+  if(!mem_debug_report_registered) {
+    mem_debug_report_registered = true;
+    atexit(mem_debug_report_leaks);
+  }
+  pthread_mutex_unlock(&mem_debug_lock);
+
+  return data;
+}
+
+void _mem_debug_free(void * ptr, const char * file, int line) {
+  if(!ptr) {
+    return;
+  }
+
+  pthread_mutex_lock(&mem_debug_lock);
+  _Mem_debug_block * block = mem_debug_block_of(ptr, file, line);
+
+  // Move block from list of live blocks to the end of quarantine
+  if(block->prev) {
+    block->prev->next = block->next;
+  } else {
+    mem_debug_live_head = block->next;
+  }
+  if(block->next) {
+    block->next->prev = block->prev;
+  }
+  mem_debug_live_count--;
+
+  block->magic = MEM_DEBUG_MAGIC_FREED;
+  block->free_file = file;
+  block->free_line = line;
+  memset(ptr, MEM_DEBUG_POISON, block->size);
+
+  block->prev = NULL;
+  block->next = NULL;
+  if(mem_debug_quarantine_tail) {
+    mem_debug_quarantine_tail->next = block;
+  } else {
+    mem_debug_quarantine_head = block;
+  }
+  mem_debug_quarantine_tail = block;
+  mem_debug_quarantine_bytes += block->size;
+
+  // Return oldest blocks to libc, when quarantine is full
+  while(mem_debug_quarantine_bytes > CRUST_DEBUG_ALLOC_QUARANTINE) {
+    _Mem_debug_block * oldest = mem_debug_quarantine_head;
+    mem_debug_check_poison(oldest);
+    mem_debug_quarantine_head = oldest->next;
+    if(!mem_debug_quarantine_head) {
+      mem_debug_quarantine_tail = NULL;
+    }
+    mem_debug_quarantine_bytes -= oldest->size;
+    oldest->magic = 0;
+    free(oldest);
+  }
+  pthread_mutex_unlock(&mem_debug_lock);
+}
+
+void * _mem_debug_realloc(void * ptr, size_t length, size_t element_size, const char * file, int line) {
+  if(SIZE_MAX/element_size < length) {
+    mem_panic(MEM_ERROR_INTEGER_OVERFLOW, 0);
+  }
+  size_t size = length * element_size;
+
+  if(ptr && length == 0) {
+    // Same as realloc() in glibc
+    _mem_debug_free(ptr, file, line);
+    return NULL;
+  }
+
+  unsigned char * data = mem_debug_alloc(size, file, line);
+
+  size_t old_size = 0;
+  if(ptr) {
+    // Block is always moved, so stale pointers to old block are detected
+    pthread_mutex_lock(&mem_debug_lock);
+    old_size = mem_debug_block_of(ptr, file, line)->size;
+    pthread_mutex_unlock(&mem_debug_lock);
+
+    memcpy(data, ptr, old_size < size ? old_size : size);
+    _mem_debug_free(ptr, file, line);
+  }
+
+  if(size > old_size) {
+    memset(data + old_size, MEM_DEBUG_FRESH, size - old_size);
+  }
+
+  return data;
+}
+
+void * _mem_debug_calloc(size_t length, size_t element_size, const char * file, int line) {
+  if(SIZE_MAX/element_size < length) {
+    mem_panic(MEM_ERROR_INTEGER_OVERFLOW, 0);
+  }
+  size_t size = length * element_size;
+
+  unsigned char * data = mem_debug_alloc(size, file, line);
+  memset(data, 0, size);
+
+  return data;
+}
+
+size_t mem_debug_live_blocks(void) {
+  pthread_mutex_lock(&mem_debug_lock);
+  size_t count = mem_debug_live_count;
+  pthread_mutex_unlock(&mem_debug_lock);
+
+  return count;
+}
+
+void mem_debug_check(void) {
+  pthread_mutex_lock(&mem_debug_lock);
+  for(_Mem_debug_block * block = mem_debug_live_head; block != NULL; block = block->next) {
+    mem_debug_check_guards(block, __FILE__, __LINE__);
+  }
+  for(_Mem_debug_block * block = mem_debug_quarantine_head; block != NULL; block = block->next) {
+    mem_debug_check_poison(block);
+  }
+  pthread_mutex_unlock(&mem_debug_lock);
+}
+#endif
@@ -13,6 +13,8 @@
 
 #ifdef _CRUST_TESTS
 #include "crust-unittest.h"
+
+#include "crust-type-charp.h"
 #endif
 
 enum Option_error_codes {
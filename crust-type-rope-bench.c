@@ -0,0 +1,69 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#include "crust-type-rope.h"
+#include "crust-type-string.h"
+
+#include "crust-bench.h"
+
+//
+// Build 1 GB of text from 100 byte records. Peak RSS of process is printed
+// to stderr at exit, so compare it by running one benchmark per process:
+//
+//   ./bench.out --samples 1 --warmup-ms 0 rope_build_1gb
+//   ./bench.out --samples 1 --warmup-ms 0 rope_string_build_1gb
+//
+
+#define ROPE_BENCH_BYTES ((size_t)1 << 30)
+#define ROPE_BENCH_RECORD 100
+
+static char rope_bench_record[ROPE_BENCH_RECORD + 1];
+static const char * rope_bench_name = NULL;
+
+static void rope_bench_print_rss(void) {
+  struct rusage usage;
+  if(getrusage(RUSAGE_SELF, &usage) == 0) {
+    fprintf(stderr, "%s: peak RSS of process: %ld KB\n", rope_bench_name, usage.ru_maxrss);
+  }
+}
+
+/* Return record and remember name of benchmark for report of peak RSS at exit. */
+static Str rope_bench_init(const char * name) {
+  if(!rope_bench_name) {
+    atexit(rope_bench_print_rss);
+  }
+  rope_bench_name = name;
+
+  for(int i = 0; i < ROPE_BENCH_RECORD - 1; i++) {
+    rope_bench_record[i] = (char)('a' + i % 26);
+  }
+  rope_bench_record[ROPE_BENCH_RECORD - 1] = '\n';
+  return str_from_raw_parts(rope_bench_record, ROPE_BENCH_RECORD);
+}
+
+bench(rope_build_1gb, "append 1 GB of 100 byte records to new Rope") {
+  Str record = rope_bench_init("rope_build_1gb");
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    defer(rope_destroy) Rope rope = rope_new();
+    for(size_t length = 0; length < ROPE_BENCH_BYTES; length += ROPE_BENCH_RECORD) {
+      (void)rope_put_str(&rope, &record);
+    }
+    bench_do_not_optimize(&rope);
+  }
+}
+
+bench(rope_string_build_1gb, "append 1 GB of 100 byte records to new String") {
+  Str record = rope_bench_init("rope_string_build_1gb");
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    defer(string_destroy) String string = string_new();
+    for(size_t length = 0; length < ROPE_BENCH_BYTES; length += ROPE_BENCH_RECORD) {
+      (void)string_put_str(&string, &record);
+    }
+    bench_do_not_optimize(string_as_ptr(&string));
+  }
+}
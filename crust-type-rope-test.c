@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "crust-type-rope.h"
+#include "crust-unittest.h"
+
+it(rope_put, "must append text to chunks") {
+  defer(rope_destroy) Rope rope = rope_new();
+
+  assert_equal_int(0, rope_put_char(&rope, 'a'), "rope_put_char() must return index of char");
+  assert_equal_int(4, rope_put_charp(&rope, "bcd"), "rope_put_charp() must return new length");
+  assert_equal_int(4, rope_put_charp(&rope, NULL), "rope_put_charp() must ignore NULL");
+  Str str = str_from_charp("ef");
+  assert_equal_int(6, rope_put_str(&rope, &str), "rope_put_str() must return new length");
+  assert_equal_int(3, rope_printf(&rope, "%d", 123), "rope_printf() must return length of printed text");
+
+  assert_equal_int(9, rope_len(&rope), "Unexpected length of rope");
+  assert_equal_int(1, rope_chunk_count(&rope), "Short text must fit into single chunk");
+
+  defer(string_destroy) String s = rope_flatten(&rope);
+  assert_equal_charp("abcdef123", string_as_ptr(&s), "Unexpected text of rope");
+  assert_equal_int(9, string_len(&s), "Unexpected length of flattened String");
+}
+
+it(rope_large, "must keep text in order when it spans many chunks") {
+  defer(rope_destroy) Rope rope = rope_new();
+  defer(string_destroy) String expected = string_new();
+
+  for(int i=0; i<100000; i++) {
+    (void)rope_printf(&rope, "line %d\n", i);
+    (void)string_printf(&expected, "line %d\n", i);
+  }
+  // Text, which is longer than maximal chunk, must get chunk of its own
+  char * big = calloc(ROPE_MAX_CHUNK_SIZE + 10, 1);
+  memset(big, 'x', ROPE_MAX_CHUNK_SIZE + 9);
+  (void)rope_put_charp(&rope, big);
+  (void)string_put_charp(&expected, big);
+  (void)rope_printf(&rope, "%s", big);
+  (void)string_printf(&expected, "%s", big);
+  free(big);
+
+  assert_true(rope_chunk_count(&rope) > 2, "Rope must use many chunks");
+  assert_equal_int(string_len(&expected), rope_len(&rope), "Unexpected length of rope");
+
+  defer(string_destroy) String s = rope_flatten(&rope);
+  assert_equal_int(string_len(&s) + 1, string_capacity(&s), "rope_flatten() must allocate exactly once");
+  assert_true(memcmp(string_as_ptr(&expected), string_as_ptr(&s), string_len(&s)) == 0, "Text must be same as with String");
+}
+
+it(rope_as_iovecs, "must expose chunks for writev() without copying") {
+  defer(rope_destroy) Rope rope = rope_new();
+  for(int i=0; i<10000; i++) {
+    (void)rope_printf(&rope, "%04d", i);
+  }
+
+  FILE * file = tmpfile();
+  int fd = fileno(file);
+  struct iovec iov[4];
+  size_t written = 0;
+  for(size_t chunk=0; chunk<rope_chunk_count(&rope); ) {
+    size_t count = rope_as_iovecs(&rope, chunk, iov, 4);
+    assert_true(iov[0].iov_base == ((RopeChunk *)rope.chunks.data)[chunk].data, "iovec must point to chunk");
+    ssize_t result = writev(fd, iov, (int)count);
+    assert_true(result > 0, "writev() must write data");
+    written += (size_t)result;
+    chunk += count;
+  }
+  assert_equal_int(rope_len(&rope), written, "All text must be written");
+
+  char buf[8] = { 0 };
+  assert_true(lseek(fd, 4*1234, SEEK_SET) == 4*1234, "lseek() must move to position");
+  assert_true(read(fd, buf, 4) == 4, "read() must read data");
+  assert_equal_charp("1234", buf, "Unexpected data in file");
+  fclose(file);
+}
@@ -0,0 +1,141 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "crust-type-rope.h"
+
+void rope_panic(int error_code, const char * value) {
+  switch(error_code) {
+    case ROPE_ERROR_BAD_FORMAT:
+      fprintf(stderr, "ERROR: Rope: Bad format string: \"%s\".\n", value);
+    break;
+
+    default:
+      fprintf(stderr, "ERROR: rope_panic(): Unknown error code: %d.\n", error_code);
+  }
+
+  abort();
+}
+
+void rope_destroy(Rope * self) {
+  for(size_t i = 0; i < self->chunks.count; i++) {
+    mem_free(((RopeChunk *)self->chunks.data)[i].data);
+  }
+  _vec_destroy(&self->chunks);
+  self->len = 0;
+}
+
+char * rope_reserve(Rope * self, size_t length) {
+  RopeChunk * chunks = self->chunks.data;
+
+  if(self->chunks.count > 0) {
+    RopeChunk * last = &chunks[self->chunks.count - 1];
+    if(last->capacity - last->len >= length) {
+      return last->data + last->len;
+    }
+  }
+
+  // Every next chunk is twice bigger than previous, up to maximal size,
+  // so number of chunks grows slowly, while unused tail of chunk is small.
+  size_t capacity = ROPE_MIN_CHUNK_SIZE;
+  if(self->chunks.count > 0) {
+    capacity = chunks[self->chunks.count - 1].capacity * 2;
+    if(capacity > ROPE_MAX_CHUNK_SIZE) {
+      capacity = ROPE_MAX_CHUNK_SIZE;
+    }
+  }
+  if(capacity < length) {
+    capacity = length;
+  }
+
+  if(self->chunks.count == self->chunks.capacity) {
+    _vec_reserve(&self->chunks, sizeof(RopeChunk), 1);
+  }
+  RopeChunk * chunk = &((RopeChunk *)self->chunks.data)[self->chunks.count++];
+  *chunk = (RopeChunk) { .data = mem_malloc(capacity, sizeof(char)), .len = 0, .capacity = capacity };
+
+  return chunk->data;
+}
+
+size_t rope_put_bytes(Rope * self, const char * data, size_t length) {
+  if(length > 0) {
+    memcpy(rope_reserve(self, length), data, length);
+    rope_commit(self, length);
+  }
+  return self->len;
+}
+
+size_t rope_vprintf(Rope * self, const char * fmt, va_list ap) {
+  // Try to print into free space of last chunk first
+  size_t room = 0;
+  char * buf = NULL;
+  if(self->chunks.count > 0) {
+    RopeChunk * last = &((RopeChunk *)self->chunks.data)[self->chunks.count - 1];
+    room = last->capacity - last->len;
+    buf = last->data + last->len;
+  }
+
+  va_list copy;
+  va_copy(copy, ap);
+  int size = vsnprintf(buf, room, fmt, copy);
+  va_end(copy);
+
+  if(size < 0) {
+    rope_panic(ROPE_ERROR_BAD_FORMAT, fmt);
+  }
+
+  // vsnprintf() needs room for '\0', which is not part of text
+  if((size_t)size >= room) {
+    buf = rope_reserve(self, (size_t)size + 1);
+    size = vsnprintf(buf, (size_t)size + 1, fmt, ap);
+    if(size < 0) {
+      rope_panic(ROPE_ERROR_BAD_FORMAT, fmt);
+    }
+  }
+
+  rope_commit(self, (size_t)size);
+  return (size_t)size;
+}
+
+size_t rope_printf(Rope * self, const char * fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  size_t size = rope_vprintf(self, fmt, ap);
+  va_end(ap);
+  return size;
+}
+
+size_t rope_as_iovecs(const Rope * self, size_t first_chunk, struct iovec * iov, size_t max) {
+  const RopeChunk * chunks = self->chunks.data;
+  size_t count = 0;
+
+  for(size_t i = first_chunk; i < self->chunks.count && count < max; i++) {
+    iov[count].iov_base = chunks[i].data;
+    iov[count].iov_len = chunks[i].len;
+    count++;
+  }
+
+  return count;
+}
+
+String rope_flatten(const Rope * self) {
+  String string = string_with_capacity(self->len + 1);
+  char * data = string_as_ptr(&string);
+  const RopeChunk * chunks = self->chunks.data;
+
+  for(size_t i = 0; i < self->chunks.count; i++) {
+    memcpy(data, chunks[i].data, chunks[i].len);
+    data += chunks[i].len;
+  }
+  *data = '\0';
+  string_set_len_unsafe(&string, self->len);
+
+  return string;
+}
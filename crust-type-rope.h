@@ -0,0 +1,109 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#ifndef CRUST_TYPE_ROPE_H_
+#define CRUST_TYPE_ROPE_H_
+
+#include <stdarg.h>
+#include <sys/uio.h>
+
+#include "crust-mem.h"
+#include "crust-type-vec.h"
+#include "crust-type-string.h"
+
+enum Rope_error_codes {
+  ROPE_ERROR_BAD_FORMAT = 1,
+};
+
+void rope_panic(int error_code, const char * value);
+
+/** Size of first chunk of rope. */
+#define ROPE_MIN_CHUNK_SIZE 4096
+/** Chunks grow twice up to this size. */
+#define ROPE_MAX_CHUNK_SIZE (1024*1024)
+
+/** Chunk of rope: allocated buffer and used part of it. */
+typedef struct {
+  char * data;
+  size_t len;
+  size_t capacity;
+} RopeChunk;
+
+/**
+ * Chunked string builder.
+ *
+ * Text is appended to last chunk. When it is full, new chunk is allocated,
+ * so appended text is never moved or copied again, unlike String, which
+ * copies whole buffer on every growth. Chunks can be written with writev()
+ * without copying, using rope_as_iovecs(), or joined into String with
+ * single allocation, using rope_flatten().
+ */
+typedef struct {
+  _Vec chunks;
+  size_t len;
+} Rope;
+
+/** Create new empty rope. No chunk is allocated. */
+WUR MU SI Rope rope_new() { return (Rope) { .chunks = _vec_new(sizeof(RopeChunk)), .len = 0 }; }
+
+/** Free all chunks. It's safe to call destroy() twice. */
+NN void rope_destroy(Rope * self);
+
+/** Return length of text in rope. */
+NN WUR MU SI size_t rope_len(const Rope * self) { return self->len; }
+
+/** Return number of chunks. */
+NN WUR MU SI size_t rope_chunk_count(const Rope * self) { return self->chunks.count; }
+
+/** Return pointer to free space of at least given size at the end of last chunk.
+ * Allocates new chunk, when necessary. Call rope_commit() after writing. */
+NN WUR char * rope_reserve(Rope * self, size_t length);
+
+/** Mark given number of bytes, written after rope_reserve(), as part of text. */
+NN MU SI void rope_commit(Rope * self, size_t length) {
+  ((RopeChunk *)self->chunks.data)[self->chunks.count - 1].len += length;
+  self->len += length;
+}
+
+/** Append bytes to rope and return new length of text. */
+NN size_t rope_put_bytes(Rope * self, const char * data, size_t length);
+
+/** Append char to rope and return its index. */
+NN MU SI size_t rope_put_char(Rope * self, char value) {
+  *rope_reserve(self, 1) = value;
+  rope_commit(self, 1);
+  return self->len - 1;
+}
+
+/** Append zero-terminated string to rope and return new length of text. NULL is ignored. */
+MU SI size_t rope_put_charp(Rope * self, const char * value) {
+  if(!value) {
+    return self->len;
+  }
+  return rope_put_bytes(self, value, strlen(value));
+}
+
+/** Append Str to rope and return new length of text. */
+NN MU SI size_t rope_put_str(Rope * self, const Str * value) {
+  return rope_put_bytes(self, str_as_ptr(value), str_len(value));
+}
+
+/** Append formatted text to rope and return its length. */
+__attribute__ ((format (printf, 2, 3)))
+size_t rope_printf(Rope * self, const char * fmt, ...);
+
+/** Same as rope_printf(), but with va_list. */
+size_t rope_vprintf(Rope * self, const char * fmt, va_list ap);
+
+/** Fill iov with chunks, starting from given chunk, and return number of filled entries.
+ * No data is copied: entries point to chunks, which are valid until rope is changed. */
+NN size_t rope_as_iovecs(const Rope * self, size_t first_chunk, struct iovec * iov, size_t max);
+
+/** Copy text of rope into new String with single allocation. String is terminated by '\0'. */
+NN WUR String rope_flatten(const Rope * self);
+
+#endif /* CRUST_TYPE_ROPE_H_ */
@@ -0,0 +1,66 @@
+#include "crust-type-segvec.h"
+#include "crust-type-vec.h"
+
+#include "crust-bench.h"
+
+SEGVEC_BY_VALUE_TEMPLATE(SegVec_int, segvec_int, int)
+VEC_BY_VALUE_TEMPLATE(Vec_int, vec_int, int)
+
+#define SEGVEC_BENCH_LENGTH 100000
+
+bench(segvec_int_push, "push 100000 ints into new segmented vector") {
+  for(size_t i = 0; i < b->iterations; i++) {
+    defer(segvec_int_destroy) SegVec_int vec = segvec_int_new();
+    for(int j = 0; j < SEGVEC_BENCH_LENGTH; j++) {
+      (void)segvec_int_push(&vec, j);
+    }
+    bench_do_not_optimize(&vec);
+  }
+}
+
+bench(segvec_vec_int_push, "push 100000 ints into new Vec") {
+  for(size_t i = 0; i < b->iterations; i++) {
+    defer(vec_int_destroy) Vec_int vec = vec_int_new();
+    for(int j = 0; j < SEGVEC_BENCH_LENGTH; j++) {
+      vec_int_push(&vec, j);
+    }
+    bench_do_not_optimize(vec_int_as_ptr(&vec));
+  }
+}
+
+// Random indices are generated with LCG, which costs same for both containers
+bench(segvec_int_random_get, "read 100000 ints at random indices of segmented vector") {
+  defer(segvec_int_destroy) SegVec_int vec = segvec_int_new();
+  for(int j = 0; j < SEGVEC_BENCH_LENGTH; j++) {
+    (void)segvec_int_push(&vec, j);
+  }
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    uint32_t seed = 42;
+    long sum = 0;
+    for(int j = 0; j < SEGVEC_BENCH_LENGTH; j++) {
+      seed = seed * 1103515245u + 12345u;
+      sum += segvec_int_get(&vec, (seed >> 8) % SEGVEC_BENCH_LENGTH);
+    }
+    bench_do_not_optimize(&sum);
+  }
+}
+
+bench(segvec_vec_int_random_get, "read 100000 ints at random indices of Vec") {
+  defer(vec_int_destroy) Vec_int vec = vec_int_new();
+  for(int j = 0; j < SEGVEC_BENCH_LENGTH; j++) {
+    vec_int_push(&vec, j);
+  }
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    uint32_t seed = 42;
+    long sum = 0;
+    for(int j = 0; j < SEGVEC_BENCH_LENGTH; j++) {
+      seed = seed * 1103515245u + 12345u;
+      sum += vec_int_get(&vec, (seed >> 8) % SEGVEC_BENCH_LENGTH);
+    }
+    bench_do_not_optimize(&sum);
+  }
+}
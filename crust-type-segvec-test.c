@@ -0,0 +1,81 @@
+#include "crust-type-segvec.h"
+#include "crust-type-slice.h"
+#include "crust-type-array.h"
+#include "crust-type-int.h"
+#include "crust-unittest.h"
+
+SEGVEC_BY_VALUE_TEMPLATE(SegVec_int, segvec_int, int)
+DEFINE_SLICE_BY_VALUE_TEMPLATE(Slice_int, slice_int, int, int)
+SEGVEC_TO_SLICE(SegVec_int, segvec_int, int, Slice_int, slice_int)
+
+it(segvec_int_push_get, "must push values and keep their addresses when vector grows") {
+  defer(segvec_int_destroy) SegVec_int vec = segvec_int_new();
+  assert_equal_int(0, segvec_int_capacity(&vec), "segvec_int_new() must not allocate memory");
+
+  assert_equal_int(0, segvec_int_push(&vec, 0), "segvec_int_push() must return index of element");
+  int * first = segvec_int_get_mut(&vec, 0);
+
+  for(int i=1; i<1000; i++) {
+    assert_equal_int(i, segvec_int_push(&vec, i*2), "segvec_int_push() must return index of element");
+  }
+
+  assert_equal_int(1000, segvec_int_len(&vec), "Unexpected length after segvec_int_push()");
+  assert_true(first == segvec_int_get_mut(&vec, 0), "Address of element must not change on growth");
+  for(int i=0; i<1000; i++) {
+    assert_equal_int(i*2, segvec_int_get(&vec, i), "Unexpected value of item after segvec_int_push()");
+  }
+
+  assert_equal_int(-1, segvec_int_get_or_default(&vec, 1000, -1), "segvec_int_get_or_default() must return default value");
+  assert_abort((void)(0 == segvec_int_get(&vec, 1000)), "segvec_int_get() must abort on index out of bounds");
+}
+
+it(segvec_int_set_truncate, "must replace values and truncate vector") {
+  int data[] = { 1, 2, 3, 4, 5 };
+  defer(segvec_int_destroy) SegVec_int vec = segvec_int_from_datap(data, LENGTH_OF_ARRAY(data), LENGTH_OF_ARRAY(data));
+
+  assert_equal_int(3, segvec_int_set(&vec, 2, 42), "segvec_int_set() must return previous value");
+  assert_equal_int(42, segvec_int_get(&vec, 2), "segvec_int_set() must change value");
+
+  segvec_int_truncate(&vec, 2);
+  assert_equal_int(2, segvec_int_len(&vec), "segvec_int_truncate() must change length");
+  segvec_int_truncate(&vec, 10);
+  assert_equal_int(2, segvec_int_len(&vec), "segvec_int_truncate() must not grow vector");
+}
+
+it(segvec_int_clone, "must create deep copy of vector") {
+  defer(segvec_int_destroy) SegVec_int vec = segvec_int_with_capacity(10);
+  for(int i=0; i<100; i++) {
+    (void)segvec_int_push(&vec, i);
+  }
+
+  defer(segvec_int_destroy) SegVec_int copy = segvec_int_clone(&vec);
+  segvec_int_set(&vec, 0, 42);
+  assert_equal_int(100, segvec_int_len(&copy), "Unexpected length of copy");
+  for(int i=0; i<100; i++) {
+    assert_equal_int(i, segvec_int_get(&copy, i), "Unexpected value in copy");
+  }
+}
+
+it(segvec_int_chunk, "must iterate all elements in order using chunk slices") {
+  defer(segvec_int_destroy) SegVec_int vec = segvec_int_new();
+  for(int i=0; i<200; i++) {
+    (void)segvec_int_push(&vec, i);
+  }
+
+  assert_equal_int(3, segvec_int_chunk_count(&vec), "Unexpected number of chunks");
+
+  int expected = 0;
+  for(size_t chunk=0; chunk<segvec_int_chunk_count(&vec); chunk++) {
+    Slice_int slice = segvec_int_chunk(&vec, chunk);
+    for(size_t i=0; i<slice_int_len(&slice); i++) {
+      assert_equal_int(expected++, slice_int_get(&slice, i), "Elements must be visited in order");
+    }
+  }
+  assert_equal_int(200, expected, "All elements must be visited");
+
+  assert_abort((void)(0 == segvec_int_chunk(&vec, 3).super.count), "segvec_int_chunk() must abort on index out of bounds");
+
+  Slice_int slice = segvec_int_chunk(&vec, 0);
+  defer(segvec_int_destroy) SegVec_int copy = segvec_int_from_slice(&slice);
+  assert_equal_int(32, segvec_int_len(&copy), "segvec_int_from_slice() must copy elements of slice");
+}
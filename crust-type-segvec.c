@@ -0,0 +1,106 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "crust-type-segvec.h"
+#include "crust-mem.h"
+
+void _segvec_panic(int error_code, size_t value) {
+  switch(error_code) {
+    case _SEGVEC_ERROR_NO_DATA:
+      fprintf(stderr, "ERROR: SegVec: Pointer to data is NULL but length is not 0. Length: %zu.\n", value);
+    break;
+
+    case _SEGVEC_ERROR_CAPACITY_TOO_SMALL:
+      fprintf(stderr, "ERROR: SegVec: Vector capacity is too small to hold vector data. Capacity: %zu.\n", value);
+    break;
+
+    case _SEGVEC_ERROR_INDEX_OUT_OF_BOUNDS:
+      fprintf(stderr, "ERROR: SegVec: Index is out of bound. Index: %zu.\n", value);
+    break;
+
+    default:
+      fprintf(stderr, "ERROR: _segvec_panic(): Unknown error code: %d.\n", error_code);
+  }
+
+  abort();
+}
+
+_SegVec _segvec_with_capacity(size_t element_size, size_t capacity) {
+  _SegVec self = { .segment_count = 0, .count = 0, .capacity = 0 };
+
+  if(capacity > 0) {
+    _segvec_reserve(&self, element_size, capacity);
+  }
+
+  return self;
+}
+
+void _segvec_reserve(_SegVec * self, size_t element_size, size_t additional_capacity) {
+  size_t required = self->count + additional_capacity;
+
+  while(self->capacity < required) {
+    size_t segment = self->segment_count;
+    self->segments[segment] = mem_calloc(_segvec_segment_capacity(segment), element_size);
+    self->segment_count++;
+    self->capacity = _segvec_segment_start(self->segment_count);
+  }
+}
+
+void _segvec_shrink_to_fit(_SegVec * self) {
+  size_t keep = _segvec_chunk_count(self);
+
+  while(self->segment_count > keep) {
+    self->segment_count--;
+    mem_free(self->segments[self->segment_count]);
+    self->segments[self->segment_count] = NULL;
+  }
+  self->capacity = _segvec_segment_start(self->segment_count);
+}
+
+void _segvec_destroy(_SegVec * self) {
+  self->count = 0;
+  _segvec_shrink_to_fit(self);
+}
+
+_SegVec _segvec_from_datap(size_t element_size, const void * data, size_t length, size_t capacity) {
+  if(data == NULL && length != 0) {
+    _segvec_panic(_SEGVEC_ERROR_NO_DATA, length);
+  }
+
+  if(capacity < length) {
+    _segvec_panic(_SEGVEC_ERROR_CAPACITY_TOO_SMALL, capacity);
+  }
+
+  _SegVec self = _segvec_with_capacity(element_size, capacity);
+
+  for(size_t segment = 0; _segvec_segment_start(segment) < length; segment++) {
+    size_t start = _segvec_segment_start(segment);
+    size_t count = _segvec_segment_capacity(segment);
+    if(start + count > length) {
+      count = length - start;
+    }
+    memcpy(self.segments[segment], (const char *)data + start * element_size, count * element_size);
+  }
+  self.count = length;
+
+  return self;
+}
+
+_SegVec _segvec_clone(const _SegVec * self, size_t element_size) {
+  _SegVec clone = _segvec_with_capacity(element_size, self->count);
+
+  for(size_t segment = 0; segment < _segvec_chunk_count(self); segment++) {
+    memcpy(clone.segments[segment], self->segments[segment], _segvec_chunk_len(self, segment) * element_size);
+  }
+  clone.count = self->count;
+
+  return clone;
+}
@@ -0,0 +1,347 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#ifndef CRUST_TYPE_SEGVEC_H_
+#define CRUST_TYPE_SEGVEC_H_
+
+#include <sys/types.h>
+#include <stdlib.h>
+
+#include "crust-mem.h"
+#include "crust-type-slice.h"
+
+#ifdef _CRUST_TESTS
+#include "crust-unittest.h"
+
+#include "crust-type-array.h"
+#endif
+
+enum _SegVec_error_codes {
+  _SEGVEC_ERROR_NO_DATA = 1,
+  _SEGVEC_ERROR_INDEX_OUT_OF_BOUNDS = 2,
+  _SEGVEC_ERROR_CAPACITY_TOO_SMALL = 3,
+};
+
+void _segvec_panic(int error_code, size_t index);
+#ifdef _CRUST_TESTS
+it(_segvec_panic, "must abort program using abort()") {
+  assert_abort(_segvec_panic(_SEGVEC_ERROR_NO_DATA, 1), "must abort");
+  assert_abort(_segvec_panic(_SEGVEC_ERROR_INDEX_OUT_OF_BOUNDS, 1), "must abort");
+  assert_abort(_segvec_panic(_SEGVEC_ERROR_CAPACITY_TOO_SMALL, 1), "must abort");
+  assert_abort(_segvec_panic(12312, 1), "must abort");
+}
+#endif
+
+//
+// Segment math, shared with CVec.
+//
+
+/** First segment holds 2^_SEGVEC_FIRST_SEGMENT_BITS elements, every next segment is twice bigger. */
+#define _SEGVEC_FIRST_SEGMENT_BITS 5
+#define _SEGVEC_MAX_SEGMENTS (sizeof(size_t)*8 - _SEGVEC_FIRST_SEGMENT_BITS)
+
+/** Return number of segment, which holds element with given index. */
+WUR MU SI size_t _segvec_segment_of(size_t index) {
+  // Bit of first segment is set again, so compiler knows that result is never negative
+  size_t biased = (index + ((size_t)1 << _SEGVEC_FIRST_SEGMENT_BITS)) | ((size_t)1 << _SEGVEC_FIRST_SEGMENT_BITS);
+  return (sizeof(size_t)*8 - 1 - __builtin_clzl(biased)) - _SEGVEC_FIRST_SEGMENT_BITS;
+}
+
+/** Return index of first element in given segment. */
+WUR MU SI size_t _segvec_segment_start(size_t segment) {
+  return (((size_t)1 << segment) - 1) << _SEGVEC_FIRST_SEGMENT_BITS;
+}
+
+/** Return number of elements in given segment. */
+WUR MU SI size_t _segvec_segment_capacity(size_t segment) {
+  return (size_t)1 << (segment + _SEGVEC_FIRST_SEGMENT_BITS);
+}
+#ifdef _CRUST_TESTS
+it(_segvec_segment_of, "must map index to segment with geometrically growing size") {
+  assert_equal_int(0, _segvec_segment_of(0), "unexpected segment");
+  assert_equal_int(0, _segvec_segment_of(31), "unexpected segment");
+  assert_equal_int(1, _segvec_segment_of(32), "unexpected segment");
+  assert_equal_int(1, _segvec_segment_of(95), "unexpected segment");
+  assert_equal_int(2, _segvec_segment_of(96), "unexpected segment");
+  assert_equal_int(96, _segvec_segment_start(2), "unexpected start of segment");
+  assert_equal_int(128, _segvec_segment_capacity(2), "unexpected capacity of segment");
+}
+#endif
+
+/**
+ * Segmented vector.
+ *
+ * Elements are stored in segments of geometrically growing size: 32, 64,
+ * 128, and so on. Growth allocates new segment and never moves existing
+ * elements, so pointers returned by get_mut() stay valid until truncate(),
+ * shrink_to_fit() or destroy(). Index is mapped to segment and offset with
+ * single count-leading-zeros instruction.
+ */
+typedef struct _SegVec_s {
+  void * segments[_SEGVEC_MAX_SEGMENTS];
+  size_t segment_count;
+  size_t count;
+  size_t capacity;
+} _SegVec;
+
+/** Free all segments and clear length and capacity.
+ * It's safe to call destroy() twice.
+ * It's safe to use vector again after destroy. */
+NN void _segvec_destroy(_SegVec * self);
+
+/** Allocate segments, if necessary, to hold additional capacity.
+ * Capacity will be equal to or greater than length+additional_capacity. */
+NN void _segvec_reserve(_SegVec * self, size_t element_size, size_t additional_capacity);
+
+/** Create new empty vector with capacity for at least given number of elements. */
+WUR struct _SegVec_s _segvec_with_capacity(size_t element_size, size_t capacity);
+#ifdef _CRUST_TESTS
+it(_segvec_with_capacity, "must create new vector with capacity rounded up to whole segments") {
+  defer(_segvec_destroy) _SegVec vec = _segvec_with_capacity(sizeof(int), 40);
+  assert_equal_int(0, vec.count, "unexpected length");
+  assert_equal_int(96, vec.capacity, "unexpected capacity");
+  assert_equal_int(2, vec.segment_count, "unexpected number of segments");
+
+  defer(_segvec_destroy) _SegVec empty = _segvec_with_capacity(sizeof(int), 0);
+  assert_equal_int(0, empty.capacity, "unexpected capacity");
+}
+#endif
+
+/** Create new empty vector. No memory is allocated. */
+WUR MU SI struct _SegVec_s _segvec_new(size_t element_size) { return _segvec_with_capacity(element_size, 0); }
+
+/** Create new vector by copying given data into vector.
+ * Panics when capacity is less than length of array.
+ * Panics when pointer is NULL but length is not 0. */
+WUR struct _SegVec_s _segvec_from_datap(size_t element_size, const void * data, size_t length, size_t capacity);
+#ifdef _CRUST_TESTS
+it(_segvec_from_datap, "must create new vector with copy of data spread over segments") {
+  int data[100];
+  for(int i=0; i<100; i++) {
+    data[i] = i;
+  }
+  defer(_segvec_destroy) _SegVec vec = _segvec_from_datap(sizeof(int), data, LENGTH_OF_ARRAY(data), LENGTH_OF_ARRAY(data));
+  assert_equal_int(100, vec.count, "unexpected length");
+  assert_equal_int(0, ((int *)vec.segments[0])[0], "unexpected value");
+  assert_equal_int(32, ((int *)vec.segments[1])[0], "unexpected value");
+  assert_equal_int(99, ((int *)vec.segments[2])[3], "unexpected value");
+
+  assert_abort(vec = _segvec_from_datap(sizeof(int), NULL, 1, 1), "must panic when pointer is NULL");
+  assert_abort(vec = _segvec_from_datap(sizeof(int), data, 10, 5), "must panic when capacity is too small");
+}
+#endif
+
+/** Free segments, which are not used by elements. */
+NN void _segvec_shrink_to_fit(_SegVec * self);
+#ifdef _CRUST_TESTS
+it(_segvec_shrink_to_fit, "must free unused segments") {
+  defer(_segvec_destroy) _SegVec vec = _segvec_with_capacity(sizeof(int), 1000);
+  vec.count = 40;
+  _segvec_shrink_to_fit(&vec);
+  assert_equal_int(2, vec.segment_count, "unexpected number of segments");
+  assert_equal_int(96, vec.capacity, "unexpected capacity");
+}
+#endif
+
+/** Create deep copy of vector with same length. Elements are copied, not cloned. */
+NN WUR struct _SegVec_s _segvec_clone(const _SegVec * self, size_t element_size);
+
+/** Return number of elements in given segment, which are in use. */
+NN WUR MU SI size_t _segvec_chunk_len(const _SegVec * self, size_t segment) {
+  size_t start = _segvec_segment_start(segment);
+  if(segment >= self->segment_count || start >= self->count) {
+    return 0;
+  }
+  size_t length = self->count - start;
+  size_t capacity = _segvec_segment_capacity(segment);
+  return length < capacity ? length : capacity;
+}
+
+/** Return number of segments, which hold elements. */
+NN WUR MU SI size_t _segvec_chunk_count(const _SegVec * self) {
+  return self->count == 0 ? 0 : _segvec_segment_of(self->count - 1) + 1;
+}
+#ifdef _CRUST_TESTS
+it(_segvec_chunk_len, "must return number of used elements in segment") {
+  defer(_segvec_destroy) _SegVec vec = _segvec_with_capacity(sizeof(int), 1000);
+  vec.count = 40;
+  assert_equal_int(2, _segvec_chunk_count(&vec), "unexpected number of chunks");
+  assert_equal_int(32, _segvec_chunk_len(&vec, 0), "unexpected length of chunk");
+  assert_equal_int(8, _segvec_chunk_len(&vec, 1), "unexpected length of chunk");
+  assert_equal_int(0, _segvec_chunk_len(&vec, 2), "unexpected length of chunk");
+}
+#endif
+
+/** Return pointer to element without bounds checking. */
+NN WUR MU SI void * _segvec_get_ptr_unchecked(const _SegVec * self, size_t element_size, size_t index) {
+  size_t segment = _segvec_segment_of(index);
+  return (char *)self->segments[segment] + (index - _segvec_segment_start(segment)) * element_size;
+}
+
+//
+// Template for SegVec
+//
+
+#define DEFINE_SEGVEC_STRUCT(SELFNAME) \
+typedef struct { \
+  _SegVec super; \
+} SELFNAME;
+
+// Common functions
+
+#define DEFINE_SEGVEC_WITH_CAPACITY(SELFNAME, SELFPREFIX, CTYPE) \
+WUR MU SI SELFNAME SELFPREFIX##_with_capacity(size_t capacity) { return (SELFNAME) { .super = _segvec_with_capacity(sizeof(CTYPE), capacity) }; }
+
+#define DEFINE_SEGVEC_NEW(SELFNAME, SELFPREFIX, CTYPE) \
+WUR MU SI SELFNAME SELFPREFIX##_new() { return (SELFNAME) { .super = _segvec_new(sizeof(CTYPE)) }; }
+
+#define DEFINE_SEGVEC_RESERVE_EXACT(SELFNAME, SELFPREFIX, CTYPE) \
+/** Capacity grows by whole segments, so reserve_exact() is same as reserve(). */ \
+NN MU SI void SELFPREFIX##_reserve_exact(SELFNAME * self, size_t additional_capacity) { _segvec_reserve(&self->super, sizeof(CTYPE), additional_capacity); }
+
+#define DEFINE_SEGVEC_RESERVE(SELFNAME, SELFPREFIX, CTYPE) \
+NN MU SI void SELFPREFIX##_reserve(SELFNAME * self, size_t additional_capacity) { _segvec_reserve(&self->super, sizeof(CTYPE), additional_capacity); }
+
+#define DEFINE_SEGVEC_SHRINK_TO_FIT(SELFNAME, SELFPREFIX) \
+NN MU SI void SELFPREFIX##_shrink_to_fit(SELFNAME * self) { _segvec_shrink_to_fit(&self->super); }
+
+#define DEFINE_SEGVEC_CAPACITY(SELFNAME, SELFPREFIX) \
+NN WUR MU SI size_t SELFPREFIX##_capacity(const SELFNAME * self) { return self->super.capacity; }
+
+#define DEFINE_SEGVEC_LEN(SELFNAME, SELFPREFIX) \
+NN WUR MU SI size_t SELFPREFIX##_len(const SELFNAME * self) { return self->super.count; }
+
+#define DEFINE_SEGVEC_GET(SELFNAME, SELFPREFIX, CTYPE) \
+NN WUR MU SI CTYPE SELFPREFIX##_get(const SELFNAME * self, size_t index) { \
+  const _SegVec * super = &self->super; \
+ \
+  if(index >= super->count) { \
+    _segvec_panic(_SEGVEC_ERROR_INDEX_OUT_OF_BOUNDS, index); \
+  } \
+ \
+  return *(CTYPE *)_segvec_get_ptr_unchecked(super, sizeof(CTYPE), index); \
+}
+
+#define DEFINE_SEGVEC_GET_MUT(SELFNAME, SELFPREFIX, CTYPE) \
+/** Return pointer to element. Pointer stays valid when vector grows. */ \
+NN WUR MU SI CTYPE * SELFPREFIX##_get_mut(const SELFNAME * self, size_t index) { \
+  const _SegVec * super = &self->super; \
+ \
+  if(index >= super->count) { \
+    _segvec_panic(_SEGVEC_ERROR_INDEX_OUT_OF_BOUNDS, index); \
+  } \
+ \
+  return (CTYPE *)_segvec_get_ptr_unchecked(super, sizeof(CTYPE), index); \
+}
+
+#define DEFINE_SEGVEC_GET_UNCHECKED(SELFNAME, SELFPREFIX, CTYPE) \
+NN WUR MU SI CTYPE SELFPREFIX##_get_unchecked(const SELFNAME * self, size_t index) { \
+  return *(CTYPE *)_segvec_get_ptr_unchecked(&self->super, sizeof(CTYPE), index); \
+}
+
+#define DEFINE_SEGVEC_GET_UNCHECKED_MUT(SELFNAME, SELFPREFIX, CTYPE) \
+NN WUR MU SI CTYPE * SELFPREFIX##_get_unchecked_mut(const SELFNAME * self, size_t index) { \
+  return (CTYPE *)_segvec_get_ptr_unchecked(&self->super, sizeof(CTYPE), index); \
+}
+
+#define DEFINE_SEGVEC_GET_OR_DEFAULT(SELFNAME, SELFPREFIX, CTYPE) \
+NN WUR MU SI CTYPE SELFPREFIX##_get_or_default(const SELFNAME * self, size_t index, CTYPE default_value) { \
+  if(index >= self->super.count) { \
+    return default_value; \
+  } \
+  return SELFPREFIX##_get_unchecked(self, index); \
+}
+
+#define DEFINE_SEGVEC_SET_LEN_UNSAFE(SELFNAME, SELFPREFIX) \
+NN MU SI void SELFPREFIX##_set_len_unsafe(SELFNAME * self, size_t length) { \
+  self->super.count = length; \
+}
+
+#define _SEGVEC_COMMON(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_SEGVEC_STRUCT(SELFNAME) \
+DEFINE_SEGVEC_WITH_CAPACITY(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_SEGVEC_NEW(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_SEGVEC_RESERVE_EXACT(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_SEGVEC_RESERVE(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_SEGVEC_SHRINK_TO_FIT(SELFNAME, SELFPREFIX) \
+DEFINE_SEGVEC_CAPACITY(SELFNAME, SELFPREFIX) \
+DEFINE_SEGVEC_LEN(SELFNAME, SELFPREFIX) \
+DEFINE_SEGVEC_GET(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_SEGVEC_GET_MUT(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_SEGVEC_GET_UNCHECKED(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_SEGVEC_GET_UNCHECKED_MUT(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_SEGVEC_GET_OR_DEFAULT(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_SEGVEC_SET_LEN_UNSAFE(SELFNAME, SELFPREFIX) \
+
+// By value
+
+#define DEFINE_SEGVEC_PUSH_BY_VALUE(SELFNAME, SELFPREFIX, CTYPE) \
+NN MU SI size_t SELFPREFIX##_push(SELFNAME * self, const CTYPE value) { \
+  _SegVec * super = &self->super; \
+ \
+  if (super->count == super->capacity) { \
+    _segvec_reserve(super, sizeof(CTYPE), 1); \
+  } \
+ \
+  *(CTYPE *)_segvec_get_ptr_unchecked(super, sizeof(CTYPE), super->count) = value; \
+ \
+  return super->count++; \
+}
+
+#define DEFINE_SEGVEC_FROM_DATAP_BY_VALUE(SELFNAME, SELFPREFIX, CTYPE) \
+WUR MU SI SELFNAME SELFPREFIX##_from_datap(const CTYPE * data, size_t length, size_t capacity) { return (SELFNAME) { .super = _segvec_from_datap(sizeof(CTYPE), data, length, capacity) }; }
+
+#define DEFINE_SEGVEC_CLONE_BY_VALUE(SELFNAME, SELFPREFIX, CTYPE) \
+WUR MU SI SELFNAME SELFPREFIX##_clone(const SELFNAME * other) { return (SELFNAME) { .super = _segvec_clone(&other->super, sizeof(CTYPE)) }; }
+
+#define DEFINE_SEGVEC_DESTROY_BY_VALUE(SELFNAME, SELFPREFIX) \
+MU SI void SELFPREFIX##_destroy(SELFNAME * self) { _segvec_destroy(&self->super); }
+
+#define DEFINE_SEGVEC_TRUNCATE_BY_VALUE(SELFNAME, SELFPREFIX) \
+MU SI void SELFPREFIX##_truncate(SELFNAME * self, size_t length) { \
+  if(length < self->super.count) { \
+    SELFPREFIX##_set_len_unsafe(self, length); \
+  } \
+}
+
+#define DEFINE_SEGVEC_SET_BY_VALUE(SELFNAME, SELFPREFIX, CTYPE) \
+MU SI CTYPE SELFPREFIX##_set(SELFNAME * self, size_t index, const CTYPE value) { \
+  CTYPE * item = SELFPREFIX##_get_mut(self, index); \
+  CTYPE prev = *item; \
+  *item = value; \
+  return prev; \
+}
+
+#define SEGVEC_BY_VALUE_TEMPLATE(SELFNAME, SELFPREFIX, CTYPE) \
+_SEGVEC_COMMON(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_SEGVEC_PUSH_BY_VALUE(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_SEGVEC_FROM_DATAP_BY_VALUE(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_SEGVEC_CLONE_BY_VALUE(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_SEGVEC_DESTROY_BY_VALUE(SELFNAME, SELFPREFIX) \
+DEFINE_SEGVEC_TRUNCATE_BY_VALUE(SELFNAME, SELFPREFIX) \
+DEFINE_SEGVEC_SET_BY_VALUE(SELFNAME, SELFPREFIX, CTYPE) \
+
+#define SEGVEC_TO_SLICE(SELFNAME, SELFPREFIX, CTYPE, SLICETYPENAME, SLICEPREFIX) \
+\
+/** Create vector from slice. Elements are copied. */ \
+NN WUR MU SI SELFNAME SELFPREFIX##_from_slice(const SLICETYPENAME * other) { \
+  return SELFPREFIX##_from_datap((const CTYPE *)SLICEPREFIX##_as_ptr(other), SLICEPREFIX##_len(other), SLICEPREFIX##_len(other)); \
+} \
+\
+/** Return number of contiguous chunks, which hold elements. */ \
+NN WUR MU SI size_t SELFPREFIX##_chunk_count(const SELFNAME * self) { return _segvec_chunk_count(&self->super); } \
+\
+/** Return elements of given chunk as slice. No data is copied. \
+ * Iterate chunks from 0 to chunk_count() to visit all elements in order. */ \
+NN WUR MU SI SLICETYPENAME SELFPREFIX##_chunk(const SELFNAME * self, size_t chunk) { \
+  if(chunk >= SELFPREFIX##_chunk_count(self)) { \
+    _segvec_panic(_SEGVEC_ERROR_INDEX_OUT_OF_BOUNDS, chunk); \
+  } \
+  return SLICEPREFIX##_from_raw_parts(self->super.segments[chunk], _segvec_chunk_len(&self->super, chunk)); \
+}
+
+#endif /* CRUST_TYPE_SEGVEC_H_ */
@@ -2,9 +2,29 @@
 #define CRUST_TYPE_SIZE_T_H_
 
 #include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "crust-type-option.h"
+#include "crust-hash.h"
 
 static inline size_t sizet_default() {
   return 0UL;
 }
 
+static inline bool sizet_eq(const size_t * left, const size_t * right) {
+  return *left == *right;
+}
+
+static inline int sizet_cmp(const size_t * left, const size_t * right) {
+  return (*left > *right) - (*left < *right);
+}
+
+/** Return hash of value. */
+static inline size_t sizet_hash(const size_t * self) {
+  return (size_t)hash_u64((uint64_t)*self);
+}
+
+DEFINE_OPTION_BY_VALUE(Option_sizet, option_sizet, size_t)
+
 #endif /* CRUST_TYPE_SIZE_T_H_ */
@@ -0,0 +1,86 @@
+#include "crust-type-slotmap.h"
+#include "crust-type-vec.h"
+
+#include "crust-bench.h"
+
+typedef struct {
+  int id;
+  double x;
+} SlotMapBenchObject;
+
+SLOTMAP_BY_VALUE_TEMPLATE(SlotMap_object, slotmap_object, SlotMapBenchObject)
+VEC_BY_VALUE_TEMPLATE(Vec_object, vec_object, SlotMapBenchObject)
+
+//
+// Find objects among 1e6 live objects. Linear scan of vector for every
+// object takes too long, so both containers are compared also on sample
+// of 1000 lookups, which are spread evenly over all objects.
+//
+
+#define SLOTMAP_BENCH_LENGTH 1000000
+#define SLOTMAP_BENCH_SAMPLES 1000
+#define SLOTMAP_BENCH_STEP (SLOTMAP_BENCH_LENGTH / SLOTMAP_BENCH_SAMPLES)
+
+static SlotMap_object slotmap_bench_map;
+static SlotHandle * slotmap_bench_handles = NULL;
+static Vec_object slotmap_bench_vec;
+
+static void slotmap_bench_init(void) {
+  if(slotmap_bench_handles) {
+    return;
+  }
+  slotmap_bench_map = slotmap_object_new();
+  slotmap_bench_vec = vec_object_with_capacity(SLOTMAP_BENCH_LENGTH);
+  slotmap_bench_handles = mem_malloc(SLOTMAP_BENCH_LENGTH, sizeof(SlotHandle));
+  for(int j = 0; j < SLOTMAP_BENCH_LENGTH; j++) {
+    SlotMapBenchObject object = { .id = j, .x = j };
+    slotmap_bench_handles[j] = slotmap_object_insert(&slotmap_bench_map, object);
+    vec_object_push(&slotmap_bench_vec, object);
+  }
+}
+
+bench(slotmap_get, "find all 1e6 objects by handles in slot map") {
+  slotmap_bench_init();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    double sum = 0;
+    for(int j = 0; j < SLOTMAP_BENCH_LENGTH; j++) {
+      sum += slotmap_object_get_mut(&slotmap_bench_map, slotmap_bench_handles[j])->x;
+    }
+    bench_do_not_optimize(&sum);
+  }
+}
+
+bench(slotmap_get_sampled, "find 1000 of 1e6 objects by handles in slot map") {
+  slotmap_bench_init();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    double sum = 0;
+    for(int j = 0; j < SLOTMAP_BENCH_LENGTH; j += SLOTMAP_BENCH_STEP) {
+      sum += slotmap_object_get_mut(&slotmap_bench_map, slotmap_bench_handles[j])->x;
+    }
+    bench_do_not_optimize(&sum);
+  }
+}
+
+bench(slotmap_vec_scan_sampled, "find 1000 of 1e6 objects by ids with linear scan of vector, as baseline") {
+  slotmap_bench_init();
+  const SlotMapBenchObject * objects = vec_object_as_ptr(&slotmap_bench_vec);
+  size_t length = vec_object_len(&slotmap_bench_vec);
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    double sum = 0;
+    for(int j = 0; j < SLOTMAP_BENCH_LENGTH; j += SLOTMAP_BENCH_STEP) {
+      for(size_t k = 0; k < length; k++) {
+        if(objects[k].id == j) {
+          sum += objects[k].x;
+          break;
+        }
+      }
+    }
+    bench_do_not_optimize(&sum);
+  }
+}
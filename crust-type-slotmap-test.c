@@ -0,0 +1,61 @@
+#include "crust-type-slotmap.h"
+#include "crust-unittest.h"
+
+typedef struct {
+  int id;
+  double x;
+} SlotMapTestObject;
+
+SLOTMAP_BY_VALUE_TEMPLATE(SlotMap_object, slotmap_object, SlotMapTestObject)
+
+it(slotmap_object_insert_get_remove, "must find values by handles and reject stale handles") {
+  defer(slotmap_object_destroy) SlotMap_object map = slotmap_object_new();
+  SlotHandle handles[100];
+
+  for(int i=0; i<100; i++) {
+    handles[i] = slotmap_object_insert(&map, (SlotMapTestObject) { .id = i, .x = i * 0.5 });
+  }
+  assert_equal_int(100, slotmap_object_len(&map), "Unexpected length of map");
+
+  for(int i=0; i<100; i+=2) {
+    SlotMapTestObject removed;
+    assert_true(slotmap_object_remove(&map, handles[i], &removed), "Remove must succeed");
+    assert_equal_int(i, removed.id, "Unexpected removed value");
+  }
+  assert_equal_int(50, slotmap_object_len(&map), "Unexpected length of map after remove");
+
+  for(int i=0; i<100; i++) {
+    SlotMapTestObject object;
+    bool found = slotmap_object_get(&map, handles[i], &object);
+    assert_true(found == (i % 2 == 1), "Only handles of live values must be found");
+    if(found) {
+      assert_equal_int(i, object.id, "Unexpected value by handle");
+    }
+  }
+
+  slotmap_object_get_mut(&map, handles[1])->id = 1001;
+  assert_equal_int(1001, slotmap_object_get_mut(&map, handles[1])->id, "Value must be modified through pointer");
+
+  SlotHandle reused = slotmap_object_insert(&map, (SlotMapTestObject) { .id = 500, .x = 0 });
+  assert_equal_int(handles[98].index, reused.index, "Last freed slot must be reused first");
+  assert_true(!slotmap_object_contains(&map, handles[98]), "Stale handle must not match reused slot");
+  assert_true(slotmap_object_contains(&map, reused), "New handle must be found");
+  assert_true(slotmap_object_get_mut(&map, (SlotHandle) { .index = 1000, .generation = 1 }) == NULL, "Handle out of range must not be found");
+}
+
+it(slotmap_object_values, "must keep values dense for iteration") {
+  defer(slotmap_object_destroy) SlotMap_object map = slotmap_object_with_capacity(4);
+  SlotHandle a = slotmap_object_insert(&map, (SlotMapTestObject) { .id = 1, .x = 0 });
+  slotmap_object_insert(&map, (SlotMapTestObject) { .id = 2, .x = 0 });
+  slotmap_object_insert(&map, (SlotMapTestObject) { .id = 3, .x = 0 });
+  assert_true(slotmap_object_remove(&map, a, NULL), "Remove must succeed");
+
+  int sum = 0;
+  SlotMapTestObject * values = slotmap_object_values(&map);
+  for(size_t i=0; i<slotmap_object_len(&map); i++) {
+    sum += values[i].id;
+    SlotHandle handle = slotmap_object_handle_at(&map, i);
+    assert_true(slotmap_object_get_mut(&map, handle) == &values[i], "Handle of value in dense array must point to it");
+  }
+  assert_equal_int(5, sum, "Dense array must hold only live values");
+}
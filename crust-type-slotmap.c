@@ -0,0 +1,112 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "crust-type-slotmap.h"
+#include "crust-mem.h"
+
+void _slotmap_panic(int error_code, size_t value) {
+  switch(error_code) {
+    case _SLOTMAP_ERROR_TOO_MANY_SLOTS:
+      fprintf(stderr, "ERROR: SlotMap: Number of slots exceeds limit of 32-bit handle. Slots: %zu.\n", value);
+    break;
+
+    default:
+      fprintf(stderr, "ERROR: _slotmap_panic(): Unknown error code: %d.\n", error_code);
+  }
+
+  abort();
+}
+
+_SlotMap _slotmap_with_capacity(size_t element_size, size_t capacity) {
+  return (_SlotMap) {
+    .slots = _vec_with_capacity(sizeof(_SlotMap_slot), capacity),
+    .values = _vec_with_capacity(element_size, capacity),
+    .value_slots = _vec_with_capacity(sizeof(uint32_t), capacity),
+    .free_head = _SLOTMAP_NONE,
+  };
+}
+
+void _slotmap_destroy(_SlotMap * self) {
+  _vec_destroy(&self->slots);
+  _vec_destroy(&self->values);
+  _vec_destroy(&self->value_slots);
+  self->free_head = _SLOTMAP_NONE;
+}
+
+SlotHandle _slotmap_insert(_SlotMap * self, size_t element_size, const void * value) {
+  uint32_t index = self->free_head;
+
+  if(index == _SLOTMAP_NONE) {
+    if(self->slots.count >= _SLOTMAP_NONE) {
+      _slotmap_panic(_SLOTMAP_ERROR_TOO_MANY_SLOTS, self->slots.count);
+    }
+    if(self->slots.count == self->slots.capacity) {
+      _vec_reserve(&self->slots, sizeof(_SlotMap_slot), 1);
+    }
+    index = (uint32_t)self->slots.count++;
+    ((_SlotMap_slot *)self->slots.data)[index].generation = 0;
+  }
+
+  _SlotMap_slot * slot = &((_SlotMap_slot *)self->slots.data)[index];
+  if(index == self->free_head) {
+    self->free_head = slot->position;
+  }
+
+  // Values and their slot indexes grow together
+  size_t position = self->values.count;
+  if(position == self->values.capacity) {
+    _vec_reserve(&self->values, element_size, 1);
+  }
+  if(position == self->value_slots.capacity) {
+    _vec_reserve(&self->value_slots, sizeof(uint32_t), 1);
+  }
+  memcpy((char *)self->values.data + position * element_size, value, element_size);
+  ((uint32_t *)self->value_slots.data)[position] = index;
+  self->values.count++;
+  self->value_slots.count++;
+
+  // Odd generation marks occupied slot
+  slot->generation++;
+  slot->position = (uint32_t)position;
+
+  return (SlotHandle) { .index = index, .generation = slot->generation };
+}
+
+bool _slotmap_remove(_SlotMap * self, size_t element_size, SlotHandle handle, void * out) {
+  char * value = _slotmap_get_ptr(self, element_size, handle);
+  if(value == NULL) {
+    return false;
+  }
+  if(out != NULL) {
+    memcpy(out, value, element_size);
+  }
+
+  _SlotMap_slot * slots = self->slots.data;
+  uint32_t * value_slots = self->value_slots.data;
+  size_t position = slots[handle.index].position;
+  size_t last = self->values.count - 1;
+
+  // Move last value into hole, so values stay dense
+  if(position != last) {
+    memcpy(value, (char *)self->values.data + last * element_size, element_size);
+    value_slots[position] = value_slots[last];
+    slots[value_slots[position]].position = (uint32_t)position;
+  }
+  self->values.count--;
+  self->value_slots.count--;
+
+  // Even generation marks free slot; handle of removed value doesn't match it anymore
+  slots[handle.index].generation++;
+  slots[handle.index].position = self->free_head;
+  self->free_head = handle.index;
+
+  return true;
+}
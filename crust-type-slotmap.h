@@ -0,0 +1,192 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#ifndef CRUST_TYPE_SLOTMAP_H_
+#define CRUST_TYPE_SLOTMAP_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "crust-mem.h"
+#include "crust-type-vec.h"
+
+#ifdef _CRUST_TESTS
+#include "crust-unittest.h"
+#endif
+
+enum _SlotMap_error_codes {
+  _SLOTMAP_ERROR_TOO_MANY_SLOTS = 1,
+};
+
+void _slotmap_panic(int error_code, size_t value);
+#ifdef _CRUST_TESTS
+it(_slotmap_panic, "must abort program using abort()") {
+  assert_abort(_slotmap_panic(_SLOTMAP_ERROR_TOO_MANY_SLOTS, 1), "must abort");
+  assert_abort(_slotmap_panic(12312, 1), "must abort");
+}
+#endif
+
+/** End of list of free slots. */
+#define _SLOTMAP_NONE UINT32_MAX
+
+/**
+ * Handle of value in slot map.
+ *
+ * Generation of slot is incremented on every insert and remove, so handle
+ * of removed value doesn't match generation of slot anymore, even when slot
+ * is reused for other value. Generation is odd while slot is occupied.
+ */
+typedef struct {
+  uint32_t index;
+  uint32_t generation;
+} SlotHandle;
+
+/** Slot: generation and position of value in dense array, or next free slot. */
+typedef struct {
+  uint32_t generation;
+  uint32_t position;
+} _SlotMap_slot;
+
+/**
+ * Slot map.
+ *
+ * Values are kept in dense array without holes, so iteration over values
+ * touches only live values. Handle points to slot, which holds position of
+ * value in dense array. Removed value is replaced by last value of dense
+ * array, and slot of last value is updated. Free slots form linked list, so
+ * insert, remove and get are O(1), and nothing is scanned or shifted.
+ */
+typedef struct {
+  /** Slots, which are indexed by handles. */
+  _Vec slots;
+  /** Dense array of values. */
+  _Vec values;
+  /** Index of slot for every value in dense array. */
+  _Vec value_slots;
+  /** First free slot, or _SLOTMAP_NONE. */
+  uint32_t free_head;
+} _SlotMap;
+
+/** Create empty slot map with room for capacity values. */
+WUR _SlotMap _slotmap_with_capacity(size_t element_size, size_t capacity);
+
+/** Free memory. It's safe to call destroy() twice. */
+NN void _slotmap_destroy(_SlotMap * self);
+
+/** Copy value into map and return its handle. */
+NN WUR SlotHandle _slotmap_insert(_SlotMap * self, size_t element_size, const void * value);
+
+/** Remove value and copy it into out, when out is not NULL. Return false,
+ * when handle is stale. */
+WUR bool _slotmap_remove(_SlotMap * self, size_t element_size, SlotHandle handle, void * out);
+
+/** Return pointer to value in dense array, or NULL, when handle is stale.
+ * Pointer is valid until next insert or remove. */
+NN WUR MU SI void * _slotmap_get_ptr(const _SlotMap * self, size_t element_size, SlotHandle handle) {
+  if(handle.index >= self->slots.count) {
+    return NULL;
+  }
+  const _SlotMap_slot * slot = &((const _SlotMap_slot *)self->slots.data)[handle.index];
+  // Free slot has even generation, and its position is link of free list
+  if(slot->generation != handle.generation || (slot->generation & 1) == 0) {
+    return NULL;
+  }
+  return (char *)self->values.data + (size_t)slot->position * element_size;
+}
+#ifdef _CRUST_TESTS
+it(_slotmap_insert_remove, "must reuse slots and reject stale handles") {
+  defer(_slotmap_destroy) _SlotMap map = _slotmap_with_capacity(sizeof(int), 2);
+  int one = 1, two = 2, out = 0;
+
+  SlotHandle first = _slotmap_insert(&map, sizeof(int), &one);
+  SlotHandle second = _slotmap_insert(&map, sizeof(int), &two);
+  assert_equal_int(2, *(int *)_slotmap_get_ptr(&map, sizeof(int), second), "Unexpected value by handle");
+
+  assert_true(_slotmap_remove(&map, sizeof(int), first, &out), "Remove must succeed");
+  assert_equal_int(1, out, "Removed value must be copied out");
+  assert_true(_slotmap_get_ptr(&map, sizeof(int), first) == NULL, "Stale handle must not be found");
+  assert_true(!_slotmap_remove(&map, sizeof(int), first, NULL), "Stale handle must not be removed twice");
+  SlotHandle forged = { .index = first.index, .generation = first.generation + 1 };
+  assert_true(_slotmap_get_ptr(&map, sizeof(int), forged) == NULL, "Handle with even generation of free slot must not be found");
+  assert_true(!_slotmap_remove(&map, sizeof(int), forged, NULL), "Free slot must not be removed");
+
+  SlotHandle third = _slotmap_insert(&map, sizeof(int), &two);
+  assert_equal_int(first.index, third.index, "Free slot must be reused");
+  assert_true(_slotmap_get_ptr(&map, sizeof(int), first) == NULL, "Stale handle must not match reused slot");
+}
+#endif
+
+//
+// Template for SlotMap
+//
+
+#define DEFINE_SLOTMAP_STRUCT(SELFNAME) \
+typedef struct { \
+  _SlotMap super; \
+} SELFNAME;
+
+#define DEFINE_SLOTMAP_NEW(SELFNAME, SELFPREFIX, CTYPE) \
+WUR MU SI SELFNAME SELFPREFIX##_with_capacity(size_t capacity) { return (SELFNAME) { .super = _slotmap_with_capacity(sizeof(CTYPE), capacity) }; } \
+WUR MU SI SELFNAME SELFPREFIX##_new() { return SELFPREFIX##_with_capacity(8); } \
+MU SI void SELFPREFIX##_destroy(SELFNAME * self) { _slotmap_destroy(&self->super); }
+
+#define DEFINE_SLOTMAP_LEN(SELFNAME, SELFPREFIX) \
+NN WUR MU SI size_t SELFPREFIX##_len(const SELFNAME * self) { return self->super.values.count; } \
+NN WUR MU SI bool SELFPREFIX##_is_empty(const SELFNAME * self) { return self->super.values.count == 0; }
+
+#define DEFINE_SLOTMAP_INSERT(SELFNAME, SELFPREFIX, CTYPE) \
+/** Insert value and return its handle. O(1). */ \
+NN MU SI SlotHandle SELFPREFIX##_insert(SELFNAME * self, CTYPE value) { return _slotmap_insert(&self->super, sizeof(CTYPE), &value); }
+
+#define DEFINE_SLOTMAP_GET(SELFNAME, SELFPREFIX, CTYPE) \
+/** Return pointer to value, or NULL, when handle is stale. Pointer is valid until next insert or remove. */ \
+NN WUR MU SI CTYPE * SELFPREFIX##_get_mut(const SELFNAME * self, SlotHandle handle) { \
+  return (CTYPE *)_slotmap_get_ptr(&self->super, sizeof(CTYPE), handle); \
+} \
+\
+/** Copy value into out. Return false, when handle is stale. */ \
+NN WUR MU SI bool SELFPREFIX##_get(const SELFNAME * self, SlotHandle handle, CTYPE * out) { \
+  CTYPE * value = SELFPREFIX##_get_mut(self, handle); \
+  if(value == NULL) { \
+    return false; \
+  } \
+  *out = *value; \
+  return true; \
+} \
+\
+NN WUR MU SI bool SELFPREFIX##_contains(const SELFNAME * self, SlotHandle handle) { \
+  return _slotmap_get_ptr(&self->super, sizeof(CTYPE), handle) != NULL; \
+}
+
+#define DEFINE_SLOTMAP_REMOVE(SELFNAME, SELFPREFIX, CTYPE) \
+/** Remove value and store it into out. Return false, when handle is stale. O(1). */ \
+MU SI bool SELFPREFIX##_remove(SELFNAME * self, SlotHandle handle, CTYPE * out) { \
+  return _slotmap_remove(&self->super, sizeof(CTYPE), handle, out); \
+}
+
+#define DEFINE_SLOTMAP_VALUES(SELFNAME, SELFPREFIX, CTYPE) \
+/** Return pointer to dense array of len() values, in no particular order.
+ * Pointer is valid until next insert or remove. */ \
+NN WUR MU SI CTYPE * SELFPREFIX##_values(const SELFNAME * self) { return (CTYPE *)self->super.values.data; } \
+\
+/** Return handle of value at given position in dense array. */ \
+NN WUR MU SI SlotHandle SELFPREFIX##_handle_at(const SELFNAME * self, size_t position) { \
+  uint32_t index = ((const uint32_t *)self->super.value_slots.data)[position]; \
+  return (SlotHandle) { .index = index, .generation = ((const _SlotMap_slot *)self->super.slots.data)[index].generation }; \
+}
+
+#define SLOTMAP_BY_VALUE_TEMPLATE(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_SLOTMAP_STRUCT(SELFNAME) \
+DEFINE_SLOTMAP_NEW(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_SLOTMAP_LEN(SELFNAME, SELFPREFIX) \
+DEFINE_SLOTMAP_INSERT(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_SLOTMAP_GET(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_SLOTMAP_REMOVE(SELFNAME, SELFPREFIX, CTYPE) \
+DEFINE_SLOTMAP_VALUES(SELFNAME, SELFPREFIX, CTYPE) \
+
+#endif /* CRUST_TYPE_SLOTMAP_H_ */
@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "crust-type-string.h"
+
+#include "crust-bench.h"
+
+bench(string_printf, "append formatted line with string and two ints into reused String") {
+  defer(string_destroy) String str = string_new();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    string_truncate(&str, 0);
+    string_printf(&str, "%s #%d: %d\n", "item", (int)i, (int)(i * 7));
+    bench_do_not_optimize(string_as_ptr(&str));
+  }
+}
+
+bench(string_printf_new, "format line with string and two ints into new String") {
+  for(size_t i = 0; i < b->iterations; i++) {
+    defer(string_destroy) String str = string_new();
+    string_printf(&str, "%s #%d: %d\n", "item", (int)i, (int)(i * 7));
+    bench_do_not_optimize(string_as_ptr(&str));
+  }
+}
+
+bench(string_printf_long, "append formatted 1 KB record with long string argument into reused String") {
+  char text[1001];
+  memset(text, 'x', sizeof(text) - 1);
+  text[sizeof(text) - 1] = '\0';
+  defer(string_destroy) String str = string_new();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    string_truncate(&str, 0);
+    string_printf(&str, "%zu: %s; %d %d\n", i, text, (int)i, (int)(i * 7));
+    bench_do_not_optimize(string_as_ptr(&str));
+  }
+}
+
+bench(string_printf_grow, "append 1000 formatted lines to new String, so it grows while formatting") {
+  for(size_t i = 0; i < b->iterations; i++) {
+    defer(string_destroy) String str = string_new();
+    for(int j = 0; j < 1000; j++) {
+      string_printf(&str, "%s #%d: %d\n", "item", j, j * 7);
+    }
+    bench_do_not_optimize(string_as_ptr(&str));
+  }
+}
+
+bench(string_put_int, "append int with string_put_int() into reused String") {
+  defer(string_destroy) String str = string_new();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    string_truncate(&str, 0);
+    string_put_int(&str, (int64_t)i * 7919);
+    bench_do_not_optimize(string_as_ptr(&str));
+  }
+}
+
+bench(string_put_charp, "append 100 short C strings to new String") {
+  for(size_t i = 0; i < b->iterations; i++) {
+    defer(string_destroy) String str = string_new();
+    for(int j = 0; j < 100; j++) {
+      string_put_charp(&str, "word ");
+    }
+    bench_do_not_optimize(string_as_ptr(&str));
+  }
+}
+
+// Doubles with full 17 digit mantissas are the hard case for shortest round-trip formatting
+bench(string_put_double, "append double with string_put_double() into reused String") {
+  defer(string_destroy) String str = string_new();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    string_truncate(&str, 0);
+    string_put_double(&str, (double)(i + 1) / 7.0);
+    bench_do_not_optimize(string_as_ptr(&str));
+  }
+}
+
+bench(string_printf_double, "append double with string_printf(\"%.17g\") into reused String, as baseline") {
+  defer(string_destroy) String str = string_new();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    string_truncate(&str, 0);
+    string_printf(&str, "%.17g", (double)(i + 1) / 7.0);
+    bench_do_not_optimize(string_as_ptr(&str));
+  }
+}
+
+bench(string_printf_int, "append int with string_printf(\"%lld\") into reused String, as baseline for string_put_int()") {
+  defer(string_destroy) String str = string_new();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    string_truncate(&str, 0);
+    string_printf(&str, "%lld", (long long)i * 7919);
+    bench_do_not_optimize(string_as_ptr(&str));
+  }
+}
+
+#define STRING_BENCH_NUMBERS 1000
+
+// Numbers are formatted once into fixed size buffers, so parsers see same text
+static char string_bench_numbers[STRING_BENCH_NUMBERS][32];
+static Str string_bench_strs[STRING_BENCH_NUMBERS];
+
+/* Fill numbers with given format: 0 for 8 digit ints, 1 for 16 digit ints, 2 for 19 digit ints, 3 for doubles. */
+static void string_bench_init_numbers(int kind) {
+  uint64_t seed = 0x9E3779B97F4A7C15ULL;
+  for(int i = 0; i < STRING_BENCH_NUMBERS; i++) {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    switch(kind) {
+      case 0:
+        snprintf(string_bench_numbers[i], sizeof(string_bench_numbers[i]), "%llu", 10000000ULL + seed % 90000000ULL);
+      break;
+
+      case 1:
+        snprintf(string_bench_numbers[i], sizeof(string_bench_numbers[i]), "%llu", 1000000000000000ULL + seed % 9000000000000000ULL);
+      break;
+
+      case 2:
+        snprintf(string_bench_numbers[i], sizeof(string_bench_numbers[i]), "%llu", 1000000000000000000ULL + seed % 9000000000000000000ULL);
+      break;
+
+      default:
+        snprintf(string_bench_numbers[i], sizeof(string_bench_numbers[i]), "%.17g", (double)(seed >> 11) / (double)(1ULL << 40));
+    }
+    string_bench_strs[i] = str_from_charp(string_bench_numbers[i]);
+  }
+}
+
+#define DEFINE_STRING_PARSE_U64_BENCH(KIND, DIGITS) \
+bench(str_parse_u64_##DIGITS##_digits, "parse 1000 ints of " #DIGITS " digits with str_parse_u64()") { \
+  string_bench_init_numbers(KIND); \
+  bench_reset_timer(b); \
+  \
+  for(size_t i = 0; i < b->iterations; i++) { \
+    uint64_t sum = 0; \
+    for(int j = 0; j < STRING_BENCH_NUMBERS; j++) { \
+      sum += option_u64_unwrap(str_parse_u64(&string_bench_strs[j])); \
+    } \
+    bench_do_not_optimize(&sum); \
+  } \
+} \
+\
+bench(strtoull_##DIGITS##_digits, "parse 1000 ints of " #DIGITS " digits with strtoull(), as baseline") { \
+  string_bench_init_numbers(KIND); \
+  bench_reset_timer(b); \
+  \
+  for(size_t i = 0; i < b->iterations; i++) { \
+    uint64_t sum = 0; \
+    for(int j = 0; j < STRING_BENCH_NUMBERS; j++) { \
+      sum += strtoull(string_bench_numbers[j], NULL, 10); \
+    } \
+    bench_do_not_optimize(&sum); \
+  } \
+}
+
+DEFINE_STRING_PARSE_U64_BENCH(0, 8)
+DEFINE_STRING_PARSE_U64_BENCH(1, 16)
+DEFINE_STRING_PARSE_U64_BENCH(2, 19)
+
+bench(str_parse_f64, "parse 1000 doubles of 17 significant digits with str_parse_f64()") {
+  string_bench_init_numbers(3);
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    double sum = 0;
+    for(int j = 0; j < STRING_BENCH_NUMBERS; j++) {
+      sum += option_f64_unwrap(str_parse_f64(&string_bench_strs[j]));
+    }
+    bench_do_not_optimize(&sum);
+  }
+}
+
+bench(strtod, "parse 1000 doubles of 17 significant digits with strtod(), as baseline") {
+  string_bench_init_numbers(3);
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    double sum = 0;
+    for(int j = 0; j < STRING_BENCH_NUMBERS; j++) {
+      sum += strtod(string_bench_numbers[j], NULL);
+    }
+    bench_do_not_optimize(&sum);
+  }
+}
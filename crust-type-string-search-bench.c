@@ -0,0 +1,111 @@
+// For memmem()
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+
+#include "crust-type-string.h"
+
+#include "crust-bench.h"
+
+//
+// Search in 1 MB of log lines. Needle occurs once, in last line, so whole
+// log is scanned, as when log is searched for rare error.
+//
+
+#define SEARCH_BENCH_BYTES (1024 * 1024)
+
+static char search_bench_log[SEARCH_BENCH_BYTES + 1];
+static size_t search_bench_len = 0;
+
+static Str search_bench_init(void) {
+  if(search_bench_len == 0) {
+    const char * levels[] = { "INFO", "DEBUG", "WARN" };
+    int line = 0;
+    for(;;) {
+      char buf[160];
+      int length = snprintf(buf, sizeof(buf), "2018-03-%02d 12:%02d:%02d %s request id=%d path=/api/v1/items/%d status=200 time=%dms\n",
+        1 + line % 28, line / 60 % 60, line % 60, levels[line % 3], line, line * 7 % 1000, line % 97);
+      if(search_bench_len + (size_t)length + 128 > SEARCH_BENCH_BYTES) {
+        break;
+      }
+      memcpy(search_bench_log + search_bench_len, buf, (size_t)length);
+      search_bench_len += (size_t)length;
+      line++;
+    }
+    search_bench_len += (size_t)snprintf(search_bench_log + search_bench_len, 128, "2018-03-28 23:59:59 ERROR request id=%d path=/api/v1/items status=503 upstream timeout\n", line);
+  }
+  return str_from_raw_parts(search_bench_log, search_bench_len);
+}
+
+#define SEARCH_BENCH_NEEDLE "status=503"
+
+bench(str_find_log, "find rare needle of 10 bytes in 1 MB log with str_find()") {
+  Str haystack = search_bench_init();
+  Str needle = str_from_charp(SEARCH_BENCH_NEEDLE);
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    Option_sizet position = str_find(&haystack, &needle);
+    bench_do_not_optimize(&position);
+  }
+}
+
+bench(memmem_log, "find rare needle of 10 bytes in 1 MB log with memmem(), as baseline") {
+  search_bench_init();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    const char * found = memmem(search_bench_log, search_bench_len, SEARCH_BENCH_NEEDLE, strlen(SEARCH_BENCH_NEEDLE));
+    bench_do_not_optimize(found);
+  }
+}
+
+bench(strstr_log, "find rare needle of 10 bytes in 1 MB log with strstr(), as baseline") {
+  search_bench_init();
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    const char * found = strstr(search_bench_log, SEARCH_BENCH_NEEDLE);
+    bench_do_not_optimize(found);
+  }
+}
+
+bench(str_rfind_log, "find needle, which occurs in first line only, in 1 MB log with str_rfind()") {
+  Str haystack = search_bench_init();
+  // Other lines have "id=" with other numbers, so whole log is scanned from end
+  Str needle = str_from_charp("id=0 ");
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    Option_sizet position = str_rfind(&haystack, &needle);
+    bench_do_not_optimize(&position);
+  }
+}
+
+bench(str_count_log, "count frequent needle in 1 MB log with str_count()") {
+  Str haystack = search_bench_init();
+  Str needle = str_from_charp("WARN");
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    size_t count = str_count(&haystack, &needle);
+    bench_do_not_optimize(&count);
+  }
+}
+
+bench(str_find_pathological, "find \"aaa...ab\" of 64 bytes in 1 MB of \"a\"") {
+  static char haystack_data[SEARCH_BENCH_BYTES];
+  char needle_data[64];
+  memset(haystack_data, 'a', sizeof(haystack_data));
+  memset(needle_data, 'a', sizeof(needle_data));
+  needle_data[sizeof(needle_data) - 1] = 'b';
+  Str haystack = str_from_raw_parts(haystack_data, sizeof(haystack_data));
+  Str needle = str_from_raw_parts(needle_data, sizeof(needle_data));
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    Option_sizet position = str_find(&haystack, &needle);
+    bench_do_not_optimize(&position);
+  }
+}
@@ -0,0 +1,409 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+// For memrchr()
+#define _GNU_SOURCE
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define _STR_X86
+#endif
+
+#include "crust-cpu.h"
+#include "crust-type-string.h"
+
+//
+// Substring search in Str.
+//
+// Candidates are filtered with SIMD: first and last bytes of needle are
+// compared with 16 or 32 positions of haystack at once, and only positions,
+// where both match, are verified with memcmp(). When too many candidates
+// fail, needle is pathological for filter (e.g. "aaa...ab" in "aaa...a"),
+// so search is continued with Knuth-Morris-Pratt algorithm, which is linear
+// in worst case. Backward search uses failure function of reversed needle.
+// Without SSE2, same filter checks one position at a time.
+//
+
+#define _STR_NOT_FOUND SIZE_MAX
+
+/* Bytes, which can be verified in vain before search switches to linear algorithm. */
+#define _STR_VERIFY_SLACK 1024
+
+/* Fill Knuth-Morris-Pratt failure function of needle, which is read from start with step 1 (forward)
+ * or -1 (backward): failure[q] is length of longest proper prefix of first q+1 bytes, which is suffix of them too. */
+static void _str_kmp_failure(const char * start, ptrdiff_t step, size_t needle_len, size_t * failure) {
+  failure[0] = 0;
+  for(size_t q = 1, k = 0; q < needle_len; q++) {
+    while(k > 0 && start[(ptrdiff_t)q * step] != start[(ptrdiff_t)k * step]) {
+      k = failure[k - 1];
+    }
+    if(start[(ptrdiff_t)q * step] == start[(ptrdiff_t)k * step]) {
+      k++;
+    }
+    failure[q] = k;
+  }
+}
+
+/* Return position of first needle in haystack at or after from, using Knuth-Morris-Pratt algorithm. */
+static size_t _str_find_fallback(const char * haystack, size_t haystack_len, const char * needle, size_t needle_len, size_t from) {
+  size_t * failure = mem_malloc(needle_len, sizeof(size_t));
+  _str_kmp_failure(needle, 1, needle_len, failure);
+
+  size_t position = _STR_NOT_FOUND;
+  size_t matched = 0;
+  for(size_t i = from; i < haystack_len; i++) {
+    while(matched > 0 && haystack[i] != needle[matched]) {
+      matched = failure[matched - 1];
+    }
+    if(haystack[i] == needle[matched]) {
+      matched++;
+    }
+    if(matched == needle_len) {
+      position = i + 1 - needle_len;
+      break;
+    }
+  }
+
+  mem_free(failure);
+  return position;
+}
+
+/* Return position of last needle in haystack. Needle is matched from its last byte to its first one,
+ * while haystack is scanned from right to left, so worst case is linear. */
+static size_t _str_rfind_fallback(const char * haystack, size_t haystack_len, const char * needle, size_t needle_len) {
+  const char * last = needle + needle_len - 1;
+  size_t * failure = mem_malloc(needle_len, sizeof(size_t));
+  _str_kmp_failure(last, -1, needle_len, failure);
+
+  size_t position = _STR_NOT_FOUND;
+  size_t matched = 0;
+  for(size_t i = haystack_len; i-- > 0; ) {
+    while(matched > 0 && haystack[i] != *(last - matched)) {
+      matched = failure[matched - 1];
+    }
+    if(haystack[i] == *(last - matched)) {
+      matched++;
+    }
+    if(matched == needle_len) {
+      position = i;
+      break;
+    }
+  }
+
+  mem_free(failure);
+  return position;
+}
+
+/* Check positions from..to, inclusive, one by one. */
+static size_t _str_find_scalar(const char * haystack, const char * needle, size_t needle_len, size_t from, size_t to) {
+  for(size_t i = from; i <= to; i++) {
+    if(haystack[i] == needle[0] && haystack[i + needle_len - 1] == needle[needle_len - 1]
+        && memcmp(haystack + i + 1, needle + 1, needle_len - 2) == 0) {
+      return i;
+    }
+  }
+  return _STR_NOT_FOUND;
+}
+
+/* Check positions to..from, inclusive, one by one, from right to left. */
+static size_t _str_rfind_scalar(const char * haystack, const char * needle, size_t needle_len, size_t from, size_t to) {
+  for(size_t i = from + 1; i-- > to; ) {
+    if(haystack[i] == needle[0] && haystack[i + needle_len - 1] == needle[needle_len - 1]
+        && memcmp(haystack + i + 1, needle + 1, needle_len - 2) == 0) {
+      return i;
+    }
+  }
+  return _STR_NOT_FOUND;
+}
+
+/* Define forward and backward search for needle of 2 or more bytes with given vector type. */
+#define _STR_DEFINE_FIND_SIMD(SUFFIX, TARGET, VTYPE, WIDTH, SET1, LOADU, CMPEQ, AND, MOVEMASK) \
+TARGET \
+static size_t _str_find_##SUFFIX(const char * haystack, size_t haystack_len, const char * needle, size_t needle_len) { \
+  const VTYPE first = SET1(needle[0]); \
+  const VTYPE last = SET1(needle[needle_len - 1]); \
+  size_t last_start = haystack_len - needle_len; \
+  size_t verified = 0; \
+  size_t i = 0; \
+  \
+  for(; i + WIDTH <= last_start + 1; i += WIDTH) { \
+    VTYPE block_first = LOADU((const VTYPE *)(haystack + i)); \
+    VTYPE block_last = LOADU((const VTYPE *)(haystack + i + needle_len - 1)); \
+    uint32_t mask = (uint32_t)MOVEMASK(AND(CMPEQ(first, block_first), CMPEQ(last, block_last))); \
+    \
+    while(mask != 0) { \
+      size_t position = i + (size_t)__builtin_ctz(mask); \
+      if(memcmp(haystack + position + 1, needle + 1, needle_len - 2) == 0) { \
+        return position; \
+      } \
+      verified += needle_len; \
+      mask &= mask - 1; \
+    } \
+    \
+    if(verified > i + _STR_VERIFY_SLACK) { \
+      return _str_find_fallback(haystack, haystack_len, needle, needle_len, i + WIDTH); \
+    } \
+  } \
+  \
+  return _str_find_scalar(haystack, needle, needle_len, i, last_start); \
+} \
+\
+TARGET \
+static size_t _str_rfind_##SUFFIX(const char * haystack, size_t haystack_len, const char * needle, size_t needle_len) { \
+  const VTYPE first = SET1(needle[0]); \
+  const VTYPE last = SET1(needle[needle_len - 1]); \
+  size_t end = haystack_len - needle_len + 1; \
+  size_t verified = 0; \
+  \
+  for(; end >= WIDTH; end -= WIDTH) { \
+    size_t i = end - WIDTH; \
+    VTYPE block_first = LOADU((const VTYPE *)(haystack + i)); \
+    VTYPE block_last = LOADU((const VTYPE *)(haystack + i + needle_len - 1)); \
+    uint32_t mask = (uint32_t)MOVEMASK(AND(CMPEQ(first, block_first), CMPEQ(last, block_last))); \
+    \
+    while(mask != 0) { \
+      size_t bit = 31 - (size_t)__builtin_clz(mask); \
+      if(memcmp(haystack + i + bit + 1, needle + 1, needle_len - 2) == 0) { \
+        return i + bit; \
+      } \
+      verified += needle_len; \
+      mask &= ~((uint32_t)1 << bit); \
+    } \
+    \
+    if(verified > haystack_len - i + _STR_VERIFY_SLACK) { \
+      /* Positions from i up are checked, so last needle must start below i */ \
+      return _str_rfind_fallback(haystack, i + needle_len - 1, needle, needle_len); \
+    } \
+  } \
+  \
+  return end == 0 ? _STR_NOT_FOUND : _str_rfind_scalar(haystack, needle, needle_len, end - 1, 0); \
+}
+
+#ifdef _STR_X86
+_STR_DEFINE_FIND_SIMD(avx2, __attribute__((target("avx2"))), __m256i, 32, _mm256_set1_epi8, _mm256_loadu_si256, _mm256_cmpeq_epi8, _mm256_and_si256, _mm256_movemask_epi8)
+#endif
+
+#ifdef __SSE2__
+_STR_DEFINE_FIND_SIMD(sse2, , __m128i, 16, _mm_set1_epi8, _mm_loadu_si128, _mm_cmpeq_epi8, _mm_and_si128, _mm_movemask_epi8)
+#else
+// "Vector" of one char: mask is 1 when both bytes match
+#define _STR_CHAR_SET1(c) (c)
+#define _STR_CHAR_LOAD(p) (*(p))
+#define _STR_CHAR_CMPEQ(a, b) ((a) == (b))
+#define _STR_CHAR_AND(a, b) ((a) & (b))
+#define _STR_CHAR_MOVEMASK(x) (x)
+_STR_DEFINE_FIND_SIMD(generic, , char, 1, _STR_CHAR_SET1, _STR_CHAR_LOAD, _STR_CHAR_CMPEQ, _STR_CHAR_AND, _STR_CHAR_MOVEMASK)
+#endif
+
+/* Return position of first needle of 2 or more bytes, which is not longer than haystack, or _STR_NOT_FOUND. */
+static size_t _str_find_vector(const char * haystack, size_t haystack_len, const char * needle, size_t needle_len) {
+#ifdef _STR_X86
+  if(cpu_has_avx2()) {
+    return _str_find_avx2(haystack, haystack_len, needle, needle_len);
+  }
+#endif
+#ifdef __SSE2__
+  return _str_find_sse2(haystack, haystack_len, needle, needle_len);
+#else
+  return _str_find_generic(haystack, haystack_len, needle, needle_len);
+#endif
+}
+
+/* Return position of last needle of 2 or more bytes, which is not longer than haystack, or _STR_NOT_FOUND. */
+static size_t _str_rfind_vector(const char * haystack, size_t haystack_len, const char * needle, size_t needle_len) {
+#ifdef _STR_X86
+  if(cpu_has_avx2()) {
+    return _str_rfind_avx2(haystack, haystack_len, needle, needle_len);
+  }
+#endif
+#ifdef __SSE2__
+  return _str_rfind_sse2(haystack, haystack_len, needle, needle_len);
+#else
+  return _str_rfind_generic(haystack, haystack_len, needle, needle_len);
+#endif
+}
+
+/* Return position of first needle in haystack, or _STR_NOT_FOUND. */
+static size_t _str_find(const char * haystack, size_t haystack_len, const char * needle, size_t needle_len) {
+  if(needle_len == 0) {
+    return 0;
+  }
+  if(needle_len > haystack_len) {
+    return _STR_NOT_FOUND;
+  }
+  if(needle_len == 1) {
+    const char * found = memchr(haystack, needle[0], haystack_len);
+    return found ? (size_t)(found - haystack) : _STR_NOT_FOUND;
+  }
+
+  return _str_find_vector(haystack, haystack_len, needle, needle_len);
+}
+
+Option_sizet str_find(const Str * self, const Str * needle) {
+  size_t position = _str_find(str_as_ptr(self), str_len(self), str_as_ptr(needle), str_len(needle));
+  return position == _STR_NOT_FOUND ? option_sizet_none() : option_sizet_some(position);
+}
+
+Option_sizet str_rfind(const Str * self, const Str * needle) {
+  const char * haystack = str_as_ptr(self);
+  size_t haystack_len = str_len(self);
+  size_t needle_len = str_len(needle);
+
+  if(needle_len > haystack_len) {
+    return option_sizet_none();
+  }
+  if(needle_len == 0) {
+    return option_sizet_some(haystack_len);
+  }
+
+  size_t position;
+  if(needle_len == 1) {
+#ifdef __GLIBC__
+    const char * found = memrchr(haystack, str_as_ptr(needle)[0], haystack_len);
+    position = found ? (size_t)(found - haystack) : _STR_NOT_FOUND;
+#else
+    // memrchr() is GNU extension
+    position = _STR_NOT_FOUND;
+    for(size_t i = haystack_len; i-- > 0; ) {
+      if(haystack[i] == str_as_ptr(needle)[0]) {
+        position = i;
+        break;
+      }
+    }
+#endif
+  } else {
+    position = _str_rfind_vector(haystack, haystack_len, str_as_ptr(needle), needle_len);
+  }
+
+  return position == _STR_NOT_FOUND ? option_sizet_none() : option_sizet_some(position);
+}
+
+Option_sizet str_find_char(const Str * self, char c) {
+  // memchr() of libc is vectorized already
+  const char * found = memchr(str_as_ptr(self), c, str_len(self));
+  return found ? option_sizet_some((size_t)(found - str_as_ptr(self))) : option_sizet_none();
+}
+
+/* Largest set, which is checked with one comparison per char of set. Larger sets use lookup table. */
+#define _STR_ANY_OF_SIMD_MAX 8
+
+#ifdef _STR_X86
+__attribute__((target("avx2")))
+static size_t _str_find_any_of_avx2(const char * haystack, size_t haystack_len, const char * set, size_t set_len) {
+  __m256i chars[_STR_ANY_OF_SIMD_MAX];
+  for(size_t j = 0; j < set_len; j++) {
+    chars[j] = _mm256_set1_epi8(set[j]);
+  }
+
+  size_t i = 0;
+  for(; i + 32 <= haystack_len; i += 32) {
+    __m256i block = _mm256_loadu_si256((const __m256i *)(haystack + i));
+    __m256i match = _mm256_cmpeq_epi8(block, chars[0]);
+    for(size_t j = 1; j < set_len; j++) {
+      match = _mm256_or_si256(match, _mm256_cmpeq_epi8(block, chars[j]));
+    }
+    uint32_t mask = (uint32_t)_mm256_movemask_epi8(match);
+    if(mask != 0) {
+      return i + (size_t)__builtin_ctz(mask);
+    }
+  }
+
+  for(; i < haystack_len; i++) {
+    if(memchr(set, haystack[i], set_len)) {
+      return i;
+    }
+  }
+  return _STR_NOT_FOUND;
+}
+#endif
+
+Option_sizet str_find_any_of(const Str * self, const Str * chars) {
+  const char * haystack = str_as_ptr(self);
+  size_t haystack_len = str_len(self);
+  const char * set = str_as_ptr(chars);
+  size_t set_len = str_len(chars);
+
+  if(set_len == 0) {
+    return option_sizet_none();
+  }
+  if(set_len == 1) {
+    return str_find_char(self, set[0]);
+  }
+
+#ifdef _STR_X86
+  if(set_len <= _STR_ANY_OF_SIMD_MAX && cpu_has_avx2()) {
+    size_t position = _str_find_any_of_avx2(haystack, haystack_len, set, set_len);
+    return position == _STR_NOT_FOUND ? option_sizet_none() : option_sizet_some(position);
+  }
+#endif
+
+  bool in_set[256] = { false };
+  for(size_t j = 0; j < set_len; j++) {
+    in_set[(unsigned char)set[j]] = true;
+  }
+  for(size_t i = 0; i < haystack_len; i++) {
+    if(in_set[(unsigned char)haystack[i]]) {
+      return option_sizet_some(i);
+    }
+  }
+  return option_sizet_none();
+}
+
+size_t str_count(const Str * self, const Str * needle) {
+  const char * haystack = str_as_ptr(self);
+  size_t haystack_len = str_len(self);
+  size_t needle_len = str_len(needle);
+
+  if(needle_len == 0) {
+    // Empty needle is found before every char and at end
+    return haystack_len + 1;
+  }
+
+  size_t count = 0;
+  size_t from = 0;
+  for(;;) {
+    size_t position = _str_find(haystack + from, haystack_len - from, str_as_ptr(needle), needle_len);
+    if(position == _STR_NOT_FOUND) {
+      return count;
+    }
+    count++;
+    from += position + needle_len;
+  }
+}
+
+StrSplit str_split(const Str * self, const Str * separator) {
+  return (StrSplit) { .rest = *self, .separator = *separator, .finished = false };
+}
+
+bool str_split_next(StrSplit * self, Str * item) {
+  if(self->finished) {
+    return false;
+  }
+
+  const char * rest = str_as_ptr(&self->rest);
+  size_t rest_len = str_len(&self->rest);
+  size_t separator_len = str_len(&self->separator);
+  size_t position = separator_len == 0
+    ? _STR_NOT_FOUND
+    : _str_find(rest, rest_len, str_as_ptr(&self->separator), separator_len);
+
+  if(position == _STR_NOT_FOUND) {
+    // Last item is rest of string, even when it's empty
+    *item = self->rest;
+    self->finished = true;
+    return true;
+  }
+
+  *item = str_from_raw_parts(rest, position);
+  self->rest = str_from_raw_parts(rest + position + separator_len, rest_len - position - separator_len);
+  return true;
+}
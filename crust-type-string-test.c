@@ -1,3 +1,9 @@
+#include <stdlib.h>
+#include <locale.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "crust-type-array.h"
 #include "crust-type-string.h"
 #include "crust-unittest.h"
 
@@ -46,6 +52,17 @@ it(string_put_string, "must append C string to String builder with checking of b
   assert_equal_charp("123! 123! 123! ", string_as_ptr(&str), "Unexpected value of string after string_put_charp()");
 }
 
+it(string_put_str, "must append text of Str to String builder with '\\0' at end") {
+  defer(string_destroy) String str = string_new();
+  Str value = str_from_raw_parts("abc! and rest", 5);
+
+  for(int i=0; i<3; i++) {
+    assert_equal_int((i+1)*5, string_put_str(&str, &value), "string_put_str() must return new length");
+  }
+
+  assert_equal_charp("abc! abc! abc! ", string_as_ptr(&str), "Unexpected value of string after string_put_str()");
+}
+
 it(string_printf, "must append formatted string to String builder with checking of bounds and with '\\0' at end") {
   defer(string_destroy) String str = string_new();
 
@@ -55,3 +72,531 @@ it(string_printf, "must append formatted string to String builder with checking
 
   assert_equal_charp("item#0 item#1 item#2 ", string_as_ptr(&str), "Unexpected value of string after string_printf()");
 }
+
+it(string_printf_spare_capacity, "must print into spare capacity and grow only when text doesn't fit") {
+  defer(string_destroy) String str = string_with_capacity(16);
+  void * data = string_as_ptr(&str);
+
+  assert_equal_int(14, string_printf(&str, "%s=%d", "answer", 1234567), "string_printf() must return length of text");
+  assert_true(data == string_as_ptr(&str), "Text, which fits, must be printed without reallocation");
+  assert_equal_int(16, string_capacity(&str), "Capacity must not change");
+
+  assert_equal_int(1, string_printf(&str, "%c", '!'), "string_printf() must return length of text");
+  assert_equal_int(15, string_len(&str), "'\\0' must fit into capacity too");
+
+  assert_equal_int(20, string_printf(&str, "%020d", 42), "string_printf() must return length of text");
+  assert_equal_charp("answer=1234567!00000000000000000042", string_as_ptr(&str), "Text must be complete after growth");
+}
+
+static size_t string_test_vprintf(String * str, const char * fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  size_t size = string_vprintf(str, fmt, ap);
+  va_end(ap);
+  return size;
+}
+
+it(string_vprintf, "must append formatted text using va_list") {
+  defer(string_destroy) String str = string_with_capacity(1);
+  assert_equal_int(11, string_test_vprintf(&str, "%s %s", "hello", "world"), "string_vprintf() must return length of text");
+  assert_equal_charp("hello world", string_as_ptr(&str), "Unexpected value of string after string_vprintf()");
+}
+
+it(string_printf_reserve_hint, "must reserve space for text before printing") {
+  defer(string_destroy) String str = string_with_capacity(1);
+  assert_equal_int(3, string_printf_reserve_hint(&str, 100, "%d", 123), "string_printf_reserve_hint() must return length of text");
+  assert_true(string_capacity(&str) >= 101, "Space for hint and '\\0' must be reserved");
+  assert_equal_charp("123", string_as_ptr(&str), "Unexpected value of string after string_printf_reserve_hint()");
+
+  defer(string_destroy) String full = string_with_capacity(16);
+  string_put_charp(&full, "0123456789ab");
+  assert_equal_int(2, string_printf_reserve_hint(&full, 2, "%d", 42), "string_printf_reserve_hint() must return length of text");
+  assert_equal_int(16, string_capacity(&full), "Capacity must not change, when hint fits into spare capacity");
+}
+
+it(str_hash, "must return same hash for equal strings") {
+  defer(string_destroy) String s = string_from_charp("foo bar");
+  Str a = str_from_string(&s);
+  Str b = str_from_charp("foo bar");
+  Str c = str_from_charp("foo baz");
+
+  assert_true(str_hash(&a) == str_hash(&b), "Hash must depend on content of string only");
+  assert_true(str_hash(&a) != str_hash(&c), "Different strings must have different hashes");
+  assert_true(string_hash(&s) == str_hash(&b), "Hash of String must be equal to hash of Str with same content");
+}
+
+it(str_cmp, "must compare strings byte by byte") {
+  Str a = str_from_charp("abc");
+  Str b = str_from_charp("abd");
+  Str prefix = str_from_charp("ab");
+
+  assert_true(str_cmp(&a, &b) < 0, "Unexpected order of strings");
+  assert_true(str_cmp(&b, &a) > 0, "Unexpected order of strings");
+  assert_true(str_cmp(&prefix, &a) < 0, "Prefix must be less than string");
+  assert_true(str_cmp(&a, &a) == 0, "String must be equal to itself");
+}
+
+it(string_put_int, "must append decimal integers") {
+  defer(string_destroy) String str = string_new();
+
+  string_put_int(&str, 0);
+  string_put_char(&str, ' ');
+  string_put_int(&str, -42);
+  string_put_char(&str, ' ');
+  string_put_int(&str, INT64_MIN);
+  string_put_char(&str, ' ');
+  string_put_int(&str, INT64_MAX);
+  string_put_char(&str, ' ');
+  assert_equal_int(67, string_put_u64(&str, UINT64_MAX), "string_put_u64() must return new length of string");
+
+  assert_equal_charp("0 -42 -9223372036854775808 9223372036854775807 18446744073709551615", string_as_ptr(&str), "Unexpected value of string after string_put_int()");
+
+  // Compare with printf() at every boundary of number of digits
+  for(uint64_t value = 1; value != 0 && value < UINT64_MAX / 10; value *= 10) {
+    char expected[64];
+    uint64_t values[] = { value - 1, value, value + 1 };
+    for(size_t i = 0; i < LENGTH_OF_ARRAY(values); i++) {
+      string_set_len_unsafe(&str, 0);
+      string_put_u64(&str, values[i]);
+      snprintf(expected, sizeof(expected), "%llu", (unsigned long long)values[i]);
+      assert_equal_charp(expected, string_as_ptr(&str), "string_put_u64() must print same digits as printf()");
+    }
+  }
+}
+
+it(string_put_u64_spare_capacity, "must print into spare capacity without reallocation") {
+  defer(string_destroy) String str = string_with_capacity(16);
+  void * data = string_as_ptr(&str);
+
+  string_put_u64(&str, 123456789012);
+  assert_equal_int(13, string_put_u64(&str, 7), "string_put_u64() must return new length of string");
+  assert_true(data == string_as_ptr(&str), "Digits, which fit, must be printed without reallocation");
+  assert_equal_int(16, string_capacity(&str), "Capacity must not change");
+}
+
+it(string_put_hex, "must append lowercase hexadecimal integers") {
+  defer(string_destroy) String str = string_new();
+
+  string_put_hex(&str, 0);
+  string_put_char(&str, ' ');
+  string_put_hex(&str, 0xDEADBEEF);
+  string_put_char(&str, ' ');
+  string_put_hex(&str, UINT64_MAX);
+
+  assert_equal_charp("0 deadbeef ffffffffffffffff", string_as_ptr(&str), "Unexpected value of string after string_put_hex()");
+}
+
+it(string_put_double, "must append shortest representation of double") {
+  defer(string_destroy) String str = string_new();
+
+  struct { double value; const char * expected; } cases[] = {
+    { 0.0, "0" }, { -0.0, "-0" }, { 1.0, "1" }, { -2.5, "-2.5" }, { 0.1, "0.1" },
+    { 0.3, "0.3" }, { 1.0/3, "0.3333333333333333" }, { 123456.789, "123456.789" },
+    { 1e20, "100000000000000000000" }, { 1e21, "1e21" }, { 1.5e300, "1.5e300" },
+    { 0.000001, "0.000001" }, { 1e-7, "1e-7" }, { 5e-324, "5e-324" },
+    { 1.7976931348623157e308, "1.7976931348623157e308" },
+    { 1.0/0.0, "inf" }, { -1.0/0.0, "-inf" }, { 0.0/0.0, "NaN" },
+  };
+
+  for(size_t i = 0; i < LENGTH_OF_ARRAY(cases); i++) {
+    string_set_len_unsafe(&str, 0);
+    string_put_double(&str, cases[i].value);
+    assert_equal_charp(cases[i].expected, string_as_ptr(&str), "Unexpected value of string after string_put_double()");
+  }
+}
+
+it(string_put_double_round_trip, "must print doubles, which are parsed back into same bits") {
+  defer(string_destroy) String str = string_new();
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+
+  for(int i = 0; i < 100000; i++) {
+    // xorshift64 over all bit patterns, so subnormal, small and huge numbers are covered
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+
+    double value;
+    memcpy(&value, &state, sizeof(value));
+    if(value != value || value - value != 0) {
+      continue; // NaN or infinity
+    }
+
+    string_set_len_unsafe(&str, 0);
+    string_put_double(&str, value);
+
+    double parsed = strtod(string_as_ptr(&str), NULL);
+    if(memcmp(&parsed, &value, sizeof(value)) != 0) {
+      assert_equal_charp("same double", string_as_ptr(&str), "string_put_double() must print double, which is parsed back into same bits");
+      break;
+    }
+  }
+}
+
+it(str_parse_u64, "must parse unsigned integers and reject bad text") {
+  Str s = str_from_charp("18446744073709551615");
+  assert_true(option_u64_unwrap(str_parse_u64(&s)) == UINT64_MAX, "must parse largest number");
+  s = str_from_charp("+000000000000000000000000042");
+  assert_true(option_u64_unwrap(str_parse_u64(&s)) == 42, "must parse leading zeros and sign");
+  s = str_from_charp("1234567890123456");
+  assert_true(option_u64_unwrap(str_parse_u64(&s)) == 1234567890123456ULL, "must parse runs of 8 digits");
+
+  const char * bad[] = { "", "+", "-1", "18446744073709551616", "99999999999999999999", "12a", " 1", "1 ", "1234567z" };
+  for(size_t i = 0; i < LENGTH_OF_ARRAY(bad); i++) {
+    s = str_from_charp(bad[i]);
+    Option_u64 result = str_parse_u64(&s);
+    assert_true(option_u64_is_none(&result), "must reject bad text");
+  }
+}
+
+it(str_parse_i64, "must parse signed integers and reject bad text") {
+  Str s = str_from_charp("-9223372036854775808");
+  assert_true(option_i64_unwrap(str_parse_i64(&s)) == INT64_MIN, "must parse smallest number");
+  s = str_from_charp("9223372036854775807");
+  assert_true(option_i64_unwrap(str_parse_i64(&s)) == INT64_MAX, "must parse largest number");
+  s = str_from_charp("-42");
+  assert_true(option_i64_unwrap(str_parse_i64(&s)) == -42, "must parse negative number");
+
+  const char * bad[] = { "", "-", "--1", "9223372036854775808", "-9223372036854775809", "1.0", "0x10" };
+  for(size_t i = 0; i < LENGTH_OF_ARRAY(bad); i++) {
+    s = str_from_charp(bad[i]);
+    Option_i64 result = str_parse_i64(&s);
+    assert_true(option_i64_is_none(&result), "must reject bad text");
+  }
+
+  // Str is not required to end with '\0'
+  s = str_from_charp("12345");
+  Str prefix = str_slice(&s, 0, 3);
+  assert_true(option_i64_unwrap(str_parse_i64(&prefix)) == 123, "must parse only text of slice");
+}
+
+/* Return true when str_parse_f64() and strtod() return same bits for text. */
+static bool str_parse_f64_matches_strtod(const char * text) {
+  Str s = str_from_charp(text);
+  double parsed = option_f64_unwrap(str_parse_f64(&s));
+  double expected = strtod(text, NULL);
+  return memcmp(&parsed, &expected, sizeof(parsed)) == 0;
+}
+
+it(str_parse_f64, "must parse doubles into correctly rounded value and reject bad text") {
+  const char * good[] = {
+    "0", "-0", "1", "-2.5", "0.1", ".5", "5.", "1e10", "1E-10", "+3.14159", "123456789012345678",
+    "9007199254740993", "2.2250738585072011e-308", "2.2250738585072014e-308", "4.9e-324", "2.4e-324",
+    "1.7976931348623157e308", "1.7976931348623159e308", "1e400", "1e-400", "0.000000000000000000000000000001",
+    "3.141592653589793238462643383279502884197", "100000000000000000000000000000000000000000000000e-30",
+    "0e999999999999", "7.0e-10", "1448997445238699",
+  };
+  for(size_t i = 0; i < LENGTH_OF_ARRAY(good); i++) {
+    assert_true(str_parse_f64_matches_strtod(good[i]), good[i]);
+  }
+
+  Str s = str_from_charp("-Infinity");
+  assert_true(option_f64_unwrap(str_parse_f64(&s)) == -HUGE_VAL, "must parse infinity");
+  s = str_from_charp("nan");
+  double nan = option_f64_unwrap(str_parse_f64(&s));
+  assert_true(nan != nan, "must parse NaN");
+
+  const char * bad[] = { "", "-", ".", "e5", "1e", "1e+", "1.2.3", "1,5", "0x1p3", "infinit", " 1", "1 " };
+  for(size_t i = 0; i < LENGTH_OF_ARRAY(bad); i++) {
+    s = str_from_charp(bad[i]);
+    Option_f64 result = str_parse_f64(&s);
+    assert_true(option_f64_is_none(&result), "must reject bad text");
+  }
+}
+
+it(str_parse_f64_locale, "must parse '.' as decimal point in any locale") {
+  // Long significand is parsed by slow path
+  const char * text = "3.141592653589793238462643383279502884197";
+  Str s = str_from_charp(text);
+  double expected = option_f64_unwrap(str_parse_f64(&s));
+
+  // Locales with ',' as decimal point are tried, when they are installed
+  const char * locales[] = { "de_DE.UTF-8", "uk_UA.UTF-8", "fr_FR.UTF-8", "ru_RU.UTF-8" };
+  for(size_t i = 0; i < LENGTH_OF_ARRAY(locales); i++) {
+    if(setlocale(LC_NUMERIC, locales[i])) {
+      double parsed = option_f64_unwrap(str_parse_f64(&s));
+      setlocale(LC_NUMERIC, "C");
+      assert_true(parsed == expected, locales[i]);
+    }
+  }
+  assert_true(expected > 3.14159 && expected < 3.1416, "must parse fraction");
+}
+
+it(str_parse_f64_random, "must parse random doubles exactly like strtod()") {
+  uint64_t state = 0x2545F4914F6CDD1DULL;
+  char text[64];
+
+  for(int i = 0; i < 100000; i++) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+
+    double value;
+    memcpy(&value, &state, sizeof(value));
+    if(value != value || value - value != 0) {
+      continue; // NaN or infinity
+    }
+
+    // Different precisions give exact, shortest, and rounded texts
+    snprintf(text, sizeof(text), "%.*g", (int)(state % 19) + 1, value);
+    if(!str_parse_f64_matches_strtod(text)) {
+      assert_equal_charp("same double as strtod()", text, "str_parse_f64() must return same double as strtod()");
+      break;
+    }
+  }
+}
+
+/* Return position of needle in haystack by brute force, for comparison. */
+static size_t str_test_naive_find(const char * haystack, size_t haystack_len, const char * needle, size_t needle_len, bool last) {
+  size_t found = SIZE_MAX;
+  for(size_t i = 0; i + needle_len <= haystack_len; i++) {
+    if(memcmp(haystack + i, needle, needle_len) == 0) {
+      found = i;
+      if(!last) {
+        break;
+      }
+    }
+  }
+  return found;
+}
+
+it(str_find, "must find first and last occurrences of substring") {
+  Str s = str_from_charp("GET /index.html HTTP/1.1 GET /favicon.ico HTTP/1.1");
+  Str needle = str_from_charp("HTTP/1.1");
+
+  assert_equal_int(16, option_sizet_unwrap(str_find(&s, &needle)), "must return position of first occurrence");
+  assert_equal_int(42, option_sizet_unwrap(str_rfind(&s, &needle)), "must return position of last occurrence");
+  assert_equal_int(2, str_count(&s, &needle), "must count occurrences");
+
+  Str missing = str_from_charp("HTTP/2");
+  Option_sizet none = str_find(&s, &missing);
+  assert_true(option_sizet_is_none(&none), "must return None when needle is not found");
+  none = str_rfind(&s, &missing);
+  assert_true(option_sizet_is_none(&none), "must return None when needle is not found");
+
+  Str empty = str_from_charp("");
+  assert_equal_int(0, option_sizet_unwrap(str_find(&s, &empty)), "must find empty needle at start");
+  assert_equal_int(str_len(&s), option_sizet_unwrap(str_rfind(&s, &empty)), "must find empty needle at end");
+
+  Str aaa = str_from_charp("aaaaaaa");
+  Str aa = str_from_charp("aa");
+  assert_equal_int(3, str_count(&aaa, &aa), "must count non-overlapping occurrences");
+}
+
+it(str_find_random, "must find same positions as brute force search") {
+  char haystack[300];
+  char needle[8];
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+
+  for(int round = 0; round < 2000; round++) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+
+    // Small alphabet gives many partial matches
+    size_t haystack_len = state % sizeof(haystack);
+    size_t needle_len = 1 + (state >> 16) % sizeof(needle);
+    for(size_t i = 0; i < haystack_len; i++) {
+      haystack[i] = (char)('a' + (state >> (i % 61)) % 3);
+    }
+    for(size_t i = 0; i < needle_len; i++) {
+      needle[i] = (char)('a' + (state >> (i * 3 + 5)) % 3);
+    }
+
+    Str s = str_from_raw_parts(haystack, haystack_len);
+    Str n = str_from_raw_parts(needle, needle_len);
+
+    Option_sizet first = str_find(&s, &n);
+    Option_sizet last = str_rfind(&s, &n);
+    if(option_sizet_unwrap_or(first, SIZE_MAX) != str_test_naive_find(haystack, haystack_len, needle, needle_len, false)
+        || option_sizet_unwrap_or(last, SIZE_MAX) != str_test_naive_find(haystack, haystack_len, needle, needle_len, true)) {
+      assert_true(false, "str_find() and str_rfind() must return same position as brute force search");
+      break;
+    }
+  }
+}
+
+it(str_find_pathological, "must find needle, which matches partially at every position") {
+  static char haystack[100000];
+  memset(haystack, 'a', sizeof(haystack));
+  haystack[sizeof(haystack) - 1] = 'b';
+
+  char needle[64];
+  memset(needle, 'a', sizeof(needle));
+  needle[sizeof(needle) - 1] = 'b';
+
+  Str s = str_from_raw_parts(haystack, sizeof(haystack));
+  Str n = str_from_raw_parts(needle, sizeof(needle));
+  assert_equal_int(sizeof(haystack) - sizeof(needle), option_sizet_unwrap(str_find(&s, &n)), "must find needle at end");
+}
+
+it(str_rfind_pathological, "must find last needle, which matches partially at every position") {
+  static char haystack[100000];
+  memset(haystack, 'a', sizeof(haystack));
+  haystack[0] = 'b';
+  haystack[5000] = 'b';
+
+  char needle[64];
+  memset(needle, 'a', sizeof(needle));
+  needle[0] = 'b';
+
+  Str s = str_from_raw_parts(haystack, sizeof(haystack));
+  Str n = str_from_raw_parts(needle, sizeof(needle));
+  assert_equal_int(5000, option_sizet_unwrap(str_rfind(&s, &n)), "must find last needle far from end");
+
+  haystack[5000] = 'a';
+  assert_equal_int(0, option_sizet_unwrap(str_rfind(&s, &n)), "must find needle at start");
+
+  haystack[0] = 'a';
+  Option_sizet none = str_rfind(&s, &n);
+  assert_true(option_sizet_is_none(&none), "must return None when needle is not found");
+}
+
+it(str_find_char, "must find first char or first char of set") {
+  Str s = str_from_charp("key = value; other: 42");
+
+  assert_equal_int(4, option_sizet_unwrap(str_find_char(&s, '=')), "must find char");
+  Option_sizet none = str_find_char(&s, '#');
+  assert_true(option_sizet_is_none(&none), "must return None when char is not found");
+
+  Str separators = str_from_charp(";:");
+  assert_equal_int(11, option_sizet_unwrap(str_find_any_of(&s, &separators)), "must find first char of set");
+
+  // Long set uses lookup table
+  Str digits = str_from_charp("0123456789");
+  assert_equal_int(20, option_sizet_unwrap(str_find_any_of(&s, &digits)), "must find first char of large set");
+
+  Str empty = str_from_charp("");
+  none = str_find_any_of(&s, &empty);
+  assert_true(option_sizet_is_none(&none), "must return None for empty set");
+}
+
+it(str_split, "must split string into parts between separators") {
+  Str s = str_from_charp("a, b, , c, ");
+  Str separator = str_from_charp(", ");
+  const char * expected[] = { "a", "b", "", "c", "" };
+
+  StrSplit split = str_split(&s, &separator);
+  Str item;
+  size_t count = 0;
+  while(str_split_next(&split, &item)) {
+    assert_true(count < LENGTH_OF_ARRAY(expected), "must return expected number of parts");
+    Str e = str_from_charp(expected[count]);
+    assert_true(str_eq(&e, &item), "must return part of string between separators");
+    count++;
+  }
+  assert_equal_int(LENGTH_OF_ARRAY(expected), count, "must return all parts");
+
+  Str empty = str_from_charp("");
+  split = str_split(&empty, &separator);
+  assert_true(str_split_next(&split, &item) && str_len(&item) == 0, "must return one empty part for empty string");
+  assert_true(!str_split_next(&split, &item), "must stop after last part");
+}
+
+/* Check UTF-8 by decoding it, for comparison. */
+static bool str_test_naive_utf8(const unsigned char * p, size_t length) {
+  for(size_t i = 0; i < length; ) {
+    size_t n = p[i] < 0x80 ? 1 : p[i] < 0xC0 ? 0 : p[i] < 0xE0 ? 2 : p[i] < 0xF0 ? 3 : p[i] < 0xF8 ? 4 : 0;
+    if(n == 0 || i + n > length) {
+      return false;
+    }
+    uint32_t c = n == 1 ? p[i] : (uint32_t)(p[i] & (0x7F >> n));
+    for(size_t j = 1; j < n; j++) {
+      if((p[i + j] & 0xC0) != 0x80) {
+        return false;
+      }
+      c = (c << 6) | (p[i + j] & 0x3F);
+    }
+    uint32_t min[] = { 0, 0, 0x80, 0x800, 0x10000 };
+    if(c < min[n] || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) {
+      return false;
+    }
+    i += n;
+  }
+  return true;
+}
+
+it(str_is_valid_utf8, "must accept valid UTF-8 and reject invalid sequences") {
+  const char * good[] = { "", "plain ASCII", "Привіт, світе", "日本語", "emoji \xF0\x9F\x98\x80", "\xEF\xBF\xBF", "\xF4\x8F\xBF\xBF" };
+  for(size_t i = 0; i < LENGTH_OF_ARRAY(good); i++) {
+    Str s = str_from_charp(good[i]);
+    assert_true(str_is_valid_utf8(&s), good[i]);
+  }
+
+  const char * bad[] = {
+    "\x80", "\xC0\xAF", "\xC1\xBF", "\xE0\x80\xAF", "\xED\xA0\x80", "\xF0\x80\x80\xAF", "\xF4\x90\x80\x80",
+    "\xF5\x80\x80\x80", "\xFF", "\xC3", "\xE6\x97", "abc\xF0\x9F\x98", "\xC3\x28",
+  };
+  for(size_t i = 0; i < LENGTH_OF_ARRAY(bad); i++) {
+    Str s = str_from_charp(bad[i]);
+    assert_true(!str_is_valid_utf8(&s), "must reject invalid sequence");
+  }
+}
+
+it(str_is_valid_utf8_random, "must validate random text same way as decoder") {
+  static const char * pieces[] = { "a", "bcdefghijklmnopq", "\xC3\xA9", "\xE6\x97\xA5", "\xF0\x9F\x98\x80", "\xED\x9F\xBF" };
+  unsigned char text[200];
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+
+  for(int round = 0; round < 20000; round++) {
+    size_t length = 0;
+    for(;;) {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      const char * piece = pieces[state % LENGTH_OF_ARRAY(pieces)];
+      size_t piece_len = strlen(piece);
+      if(length + piece_len > sizeof(text)) {
+        break;
+      }
+      memcpy(text + length, piece, piece_len);
+      length += piece_len;
+    }
+
+    // Corrupt random byte in most of rounds, so errors are found at every offset of block
+    if(round % 4 != 0) {
+      text[(state >> 8) % length] = (unsigned char)(state >> 24);
+    }
+    length -= (state >> 40) % 4;
+
+    Str s = str_from_raw_parts((const char *)text, length);
+    if(str_is_valid_utf8(&s) != str_test_naive_utf8(text, length)) {
+      assert_true(false, "str_is_valid_utf8() must return same result as decoder");
+      break;
+    }
+  }
+}
+
+it(str_chars, "must iterate over code points and count them") {
+  Str s = str_from_charp("aé日😀");
+  uint32_t expected[] = { 'a', 0xE9, 0x65E5, 0x1F600 };
+
+  assert_equal_int(4, str_utf8_len(&s), "must count code points");
+
+  StrChars chars = str_chars(&s);
+  uint32_t c;
+  size_t count = 0;
+  while(str_chars_next(&chars, &c)) {
+    assert_true(count < LENGTH_OF_ARRAY(expected) && c == expected[count], "must decode code point");
+    count++;
+  }
+  assert_equal_int(4, count, "must return all code points");
+
+  Str bad = str_from_charp("a\xFF" "b");
+  chars = str_chars(&bad);
+  assert_true(str_chars_next(&chars, &c) && c == 'a', "must decode valid code point");
+  assert_true(str_chars_next(&chars, &c) && c == STR_REPLACEMENT_CHARACTER, "must replace invalid byte");
+  assert_true(str_chars_next(&chars, &c) && c == 'b', "must continue after invalid byte");
+  assert_true(!str_chars_next(&chars, &c), "must stop at end");
+}
+
+it(string_from_utf8_checked, "must copy valid UTF-8 only") {
+  Str good = str_from_charp("Привіт");
+  Option_string result = string_from_utf8_checked(&good);
+  assert_true(option_string_is_some(&result), "must accept valid text");
+  defer(string_destroy) String str = option_string_unwrap(result);
+  assert_equal_charp("Привіт", string_as_ptr(&str), "must copy text");
+
+  Str bad = str_from_charp("\xC3\x28");
+  result = string_from_utf8_checked(&bad);
+  assert_true(option_string_is_none(&result), "must reject invalid text");
+}
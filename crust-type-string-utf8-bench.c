@@ -0,0 +1,96 @@
+#include <string.h>
+
+#include "crust-type-string.h"
+
+#include "crust-bench.h"
+
+//
+// UTF-8 benchmarks on 1 MiB corpora, so throughput in GB/s is
+// 1048576 / (ns per iteration).
+//
+
+#define UTF8_BENCH_BYTES (1024 * 1024)
+
+static char utf8_bench_ascii[UTF8_BENCH_BYTES];
+static char utf8_bench_multilingual[UTF8_BENCH_BYTES];
+static size_t utf8_bench_ascii_len = 0;
+static size_t utf8_bench_multilingual_len = 0;
+
+/* Fill buffer with copies of text, which end at character boundary. */
+static size_t utf8_bench_fill(char * buffer, const char * text) {
+  size_t text_len = strlen(text);
+  size_t length = 0;
+  while(length + text_len <= UTF8_BENCH_BYTES) {
+    memcpy(buffer + length, text, text_len);
+    length += text_len;
+  }
+  return length;
+}
+
+static void utf8_bench_init(void) {
+  if(utf8_bench_ascii_len != 0) {
+    return;
+  }
+
+  // Mostly ASCII text, e.g. source code or log, with rare non-ASCII char
+  utf8_bench_ascii_len = utf8_bench_fill(utf8_bench_ascii,
+    "2018-03-01 12:00:00 INFO request path=/api/v1/items status=200 user=\"J\xC3\xBCrgen\" time=12ms\n"
+    "int main(int argc, char ** argv) { return argc > 1 ? atoi(argv[1]) : 0; }\n");
+
+  // English, Ukrainian, Greek, Chinese, Japanese and emoji: 1, 2, 3 and 4 byte sequences
+  utf8_bench_multilingual_len = utf8_bench_fill(utf8_bench_multilingual,
+    "Hello, world! "
+    "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD1\x96\xD1\x82, \xD1\x81\xD0\xB2\xD1\x96\xD1\x82\xD0\xB5! "
+    "\xCE\x93\xCE\xB5\xCE\xB9\xCE\xAC \xCF\x83\xCE\xBF\xCF\x85 \xCE\xBA\xCF\x8C\xCF\x83\xCE\xBC\xCE\xB5! "
+    "\xE4\xBD\xA0\xE5\xA5\xBD\xEF\xBC\x8C\xE4\xB8\x96\xE7\x95\x8C\xEF\xBC\x81 "
+    "\xE3\x81\x93\xE3\x82\x93\xE3\x81\xAB\xE3\x81\xA1\xE3\x81\xAF\xE4\xB8\x96\xE7\x95\x8C "
+    "\xF0\x9F\x8C\x8D\xF0\x9F\x91\x8B\n");
+}
+
+bench(str_is_valid_utf8_ascii, "validate 1 MiB of mostly ASCII text") {
+  utf8_bench_init();
+  Str text = str_from_raw_parts(utf8_bench_ascii, utf8_bench_ascii_len);
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    bool valid = str_is_valid_utf8(&text);
+    bench_do_not_optimize(&valid);
+  }
+}
+
+bench(str_is_valid_utf8_multilingual, "validate 1 MiB of multilingual text") {
+  utf8_bench_init();
+  Str text = str_from_raw_parts(utf8_bench_multilingual, utf8_bench_multilingual_len);
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    bool valid = str_is_valid_utf8(&text);
+    bench_do_not_optimize(&valid);
+  }
+}
+
+bench(str_utf8_len_multilingual, "count code points in 1 MiB of multilingual text") {
+  utf8_bench_init();
+  Str text = str_from_raw_parts(utf8_bench_multilingual, utf8_bench_multilingual_len);
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    size_t length = str_utf8_len(&text);
+    bench_do_not_optimize(&length);
+  }
+}
+
+bench(str_chars_multilingual, "decode code points of 1 MiB of multilingual text one by one") {
+  utf8_bench_init();
+  Str text = str_from_raw_parts(utf8_bench_multilingual, utf8_bench_multilingual_len);
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    StrChars chars = str_chars(&text);
+    uint32_t code_point, sum = 0;
+    while(str_chars_next(&chars, &code_point)) {
+      sum += code_point;
+    }
+    bench_do_not_optimize(&sum);
+  }
+}
@@ -0,0 +1,330 @@
+// Copyright 2018 Volodymyr M. Lisivka <vlisivka@gmail.com>.
+// See the COPYRIGHT file at the top directory of this project.
+//
+// Licensed under the GPL License, Version 3.0 or later, at your
+// option. This file may not be copied, modified, or distributed
+// except according to those terms.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define _STR_UTF8_X86
+#endif
+
+#include "crust-cpu.h"
+#include "crust-type-string.h"
+
+//
+// UTF-8 validation and decoding.
+//
+// Validation with AVX2 uses lookup algorithm by John Keiser and Daniel
+// Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte": high
+// and low nibbles of previous byte and high nibble of current byte select
+// sets of possible errors from three 16-entry tables, and error is found
+// when all three sets share a bit. Lengths of 3 and 4 byte sequences are
+// checked separately. Blocks of ASCII skip all of that. Other CPUs, and
+// x86 CPUs without AVX2, use scalar code.
+//
+
+/* Return length of valid sequence at start of text, or 0 when sequence is invalid or truncated. */
+static size_t _str_utf8_sequence_len(const unsigned char * p, size_t length) {
+  unsigned char c = p[0];
+
+  if(c < 0x80) {
+    return 1;
+  }
+  if(c < 0xC2) {
+    // Continuation byte or overlong 2 byte sequence
+    return 0;
+  }
+  if(c < 0xE0) {
+    return length >= 2 && (p[1] & 0xC0) == 0x80 ? 2 : 0;
+  }
+  if(c < 0xF0) {
+    if(length < 3 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80) {
+      return 0;
+    }
+    // Overlong sequence or surrogate
+    if((c == 0xE0 && p[1] < 0xA0) || (c == 0xED && p[1] >= 0xA0)) {
+      return 0;
+    }
+    return 3;
+  }
+  if(c < 0xF5) {
+    if(length < 4 || (p[1] & 0xC0) != 0x80 || (p[2] & 0xC0) != 0x80 || (p[3] & 0xC0) != 0x80) {
+      return 0;
+    }
+    // Overlong sequence or code point above U+10FFFF
+    if((c == 0xF0 && p[1] < 0x90) || (c == 0xF4 && p[1] >= 0x90)) {
+      return 0;
+    }
+    return 4;
+  }
+  return 0;
+}
+
+static bool _str_is_valid_utf8_scalar(const unsigned char * p, size_t length) {
+  size_t i = 0;
+
+  while(i < length) {
+    // Skip ASCII 8 bytes at once
+    if(i + 8 <= length) {
+      uint64_t word;
+      memcpy(&word, p + i, sizeof(word));
+      if((word & 0x8080808080808080ULL) == 0) {
+        i += 8;
+        continue;
+      }
+    }
+
+    size_t sequence = _str_utf8_sequence_len(p + i, length - i);
+    if(sequence == 0) {
+      return false;
+    }
+    i += sequence;
+  }
+
+  return true;
+}
+
+#ifdef _STR_UTF8_X86
+// Bits of error sets
+#define _UTF8_TOO_SHORT   (1 << 0) // 11______ 0_______ or 11______ 11______
+#define _UTF8_TOO_LONG    (1 << 1) // 0_______ 10______
+#define _UTF8_OVERLONG_3  (1 << 2) // 11100000 100_____
+#define _UTF8_TOO_LARGE   (1 << 3) // 11110100 1001____ or higher
+#define _UTF8_SURROGATE   (1 << 4) // 11101101 101_____
+#define _UTF8_OVERLONG_2  (1 << 5) // 1100000_ 10______
+#define _UTF8_TOO_LARGE_1000 (1 << 6) // 11110101 1000____ or higher
+#define _UTF8_OVERLONG_4  (1 << 6) // 11110000 1000____
+#define _UTF8_TWO_CONTS   (1 << 7) // 10______ 10______
+#define _UTF8_CARRY (_UTF8_TOO_SHORT | _UTF8_TOO_LONG | _UTF8_TWO_CONTS)
+
+/* Table of 16 bytes, repeated in both 128-bit lanes, for _mm256_shuffle_epi8(). */
+#define _UTF8_TABLE(...) _mm256_setr_epi8(__VA_ARGS__, __VA_ARGS__)
+
+/* Return bytes of input shifted by n, with last bytes of previous block shifted in. */
+#define _UTF8_PREV(input, prev_input, n) \
+  _mm256_alignr_epi8((input), _mm256_permute2x128_si256((prev_input), (input), 0x21), 16 - (n))
+
+__attribute__((target("avx2")))
+static __m256i _str_utf8_check_block(__m256i input, __m256i prev_input) {
+  const __m256i nibble_mask = _mm256_set1_epi8(0x0F);
+
+  const __m256i byte_1_high_table = _UTF8_TABLE(
+    // 0_______ ________, ASCII in first byte
+    _UTF8_TOO_LONG, _UTF8_TOO_LONG, _UTF8_TOO_LONG, _UTF8_TOO_LONG,
+    _UTF8_TOO_LONG, _UTF8_TOO_LONG, _UTF8_TOO_LONG, _UTF8_TOO_LONG,
+    // 10______ ________, continuation in first byte
+    (char)_UTF8_TWO_CONTS, (char)_UTF8_TWO_CONTS, (char)_UTF8_TWO_CONTS, (char)_UTF8_TWO_CONTS,
+    // 1100____ ________, lead of 2 byte sequence
+    _UTF8_TOO_SHORT | _UTF8_OVERLONG_2,
+    // 1101____ ________, lead of 2 byte sequence
+    _UTF8_TOO_SHORT,
+    // 1110____ ________, lead of 3 byte sequence
+    _UTF8_TOO_SHORT | _UTF8_OVERLONG_3 | _UTF8_SURROGATE,
+    // 1111____ ________, lead of 4 byte sequence
+    (char)(_UTF8_TOO_SHORT | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000 | _UTF8_OVERLONG_4)
+  );
+
+  const __m256i byte_1_low_table = _UTF8_TABLE(
+    // ____0000 ________
+    (char)(_UTF8_CARRY | _UTF8_OVERLONG_3 | _UTF8_OVERLONG_2 | _UTF8_OVERLONG_4),
+    // ____0001 ________
+    (char)(_UTF8_CARRY | _UTF8_OVERLONG_2),
+    // ____001_ ________
+    (char)_UTF8_CARRY, (char)_UTF8_CARRY,
+    // ____0100 ________
+    (char)(_UTF8_CARRY | _UTF8_TOO_LARGE),
+    // ____0101 ________ and higher
+    (char)(_UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000),
+    (char)(_UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000),
+    (char)(_UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000),
+    (char)(_UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000),
+    (char)(_UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000),
+    (char)(_UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000),
+    (char)(_UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000),
+    (char)(_UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000),
+    // ____1101 ________
+    (char)(_UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000 | _UTF8_SURROGATE),
+    (char)(_UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000),
+    (char)(_UTF8_CARRY | _UTF8_TOO_LARGE | _UTF8_TOO_LARGE_1000)
+  );
+
+  const __m256i byte_2_high_table = _UTF8_TABLE(
+    // ________ 0_______, ASCII in second byte
+    _UTF8_TOO_SHORT, _UTF8_TOO_SHORT, _UTF8_TOO_SHORT, _UTF8_TOO_SHORT,
+    _UTF8_TOO_SHORT, _UTF8_TOO_SHORT, _UTF8_TOO_SHORT, _UTF8_TOO_SHORT,
+    // ________ 1000____
+    (char)(_UTF8_TOO_LONG | _UTF8_OVERLONG_2 | _UTF8_TWO_CONTS | _UTF8_OVERLONG_3 | _UTF8_TOO_LARGE_1000 | _UTF8_OVERLONG_4),
+    // ________ 1001____
+    (char)(_UTF8_TOO_LONG | _UTF8_OVERLONG_2 | _UTF8_TWO_CONTS | _UTF8_OVERLONG_3 | _UTF8_TOO_LARGE),
+    // ________ 101_____
+    (char)(_UTF8_TOO_LONG | _UTF8_OVERLONG_2 | _UTF8_TWO_CONTS | _UTF8_SURROGATE | _UTF8_TOO_LARGE),
+    (char)(_UTF8_TOO_LONG | _UTF8_OVERLONG_2 | _UTF8_TWO_CONTS | _UTF8_SURROGATE | _UTF8_TOO_LARGE),
+    // ________ 11______, lead in second byte
+    _UTF8_TOO_SHORT, _UTF8_TOO_SHORT, _UTF8_TOO_SHORT, _UTF8_TOO_SHORT
+  );
+
+  __m256i prev1 = _UTF8_PREV(input, prev_input, 1);
+  __m256i byte_1_high = _mm256_shuffle_epi8(byte_1_high_table, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble_mask));
+  __m256i byte_1_low = _mm256_shuffle_epi8(byte_1_low_table, _mm256_and_si256(prev1, nibble_mask));
+  __m256i byte_2_high = _mm256_shuffle_epi8(byte_2_high_table, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble_mask));
+  __m256i special_cases = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+  // Third and fourth bytes of 3 and 4 byte sequences must be continuations,
+  // which are marked with TWO_CONTS above, and nothing else can be
+  __m256i prev2 = _UTF8_PREV(input, prev_input, 2);
+  __m256i prev3 = _UTF8_PREV(input, prev_input, 3);
+  __m256i is_third_byte = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80)));
+  __m256i is_fourth_byte = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80)));
+  __m256i must_be_continuation = _mm256_and_si256(_mm256_or_si256(is_third_byte, is_fourth_byte), _mm256_set1_epi8((char)0x80));
+
+  return _mm256_xor_si256(must_be_continuation, special_cases);
+}
+
+/* Return non-zero bytes when block ends with incomplete sequence. */
+__attribute__((target("avx2")))
+static __m256i _str_utf8_is_incomplete(__m256i input) {
+  const __m256i max_value = _mm256_setr_epi8(
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1)
+  );
+  return _mm256_subs_epu8(input, max_value);
+}
+
+__attribute__((target("avx2")))
+static bool _str_is_valid_utf8_avx2(const unsigned char * p, size_t length) {
+  __m256i error = _mm256_setzero_si256();
+  __m256i prev_input = _mm256_setzero_si256();
+  __m256i prev_incomplete = _mm256_setzero_si256();
+  size_t i = 0;
+
+  for(;;) {
+    __m256i input;
+    if(i + 32 <= length) {
+      input = _mm256_loadu_si256((const __m256i *)(p + i));
+    } else if(i < length) {
+      // Pad last block with zeros, which are ASCII
+      unsigned char buf[32] = { 0 };
+      memcpy(buf, p + i, length - i);
+      input = _mm256_loadu_si256((const __m256i *)buf);
+    } else {
+      break;
+    }
+
+    if(_mm256_movemask_epi8(input) == 0) {
+      // ASCII block is valid, unless previous block ends with incomplete sequence
+      error = _mm256_or_si256(error, prev_incomplete);
+    } else {
+      error = _mm256_or_si256(error, _str_utf8_check_block(input, prev_input));
+      prev_incomplete = _str_utf8_is_incomplete(input);
+    }
+    prev_input = input;
+    i += 32;
+
+    // Stop early on invalid text
+    if(!_mm256_testz_si256(error, error)) {
+      return false;
+    }
+  }
+
+  error = _mm256_or_si256(error, prev_incomplete);
+  return _mm256_testz_si256(error, error);
+}
+
+__attribute__((target("avx2")))
+static size_t _str_utf8_len_avx2(const char * p, size_t length) {
+  size_t count = 0;
+  size_t i = 0;
+
+  // Count bytes, which are not continuations: signed byte is greater than (signed)0xBF
+  const __m256i threshold = _mm256_set1_epi8((char)0xBF);
+  for(; i + 32 <= length; i += 32) {
+    __m256i block = _mm256_loadu_si256((const __m256i *)(p + i));
+    count += (size_t)__builtin_popcount((uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(block, threshold)));
+  }
+
+  for(; i < length; i++) {
+    count += ((unsigned char)p[i] & 0xC0) != 0x80;
+  }
+
+  return count;
+}
+#endif
+
+bool str_is_valid_utf8(const Str * self) {
+  const unsigned char * p = (const unsigned char *)str_as_ptr(self);
+  size_t length = str_len(self);
+
+#ifdef _STR_UTF8_X86
+  if(cpu_has_avx2()) {
+    return _str_is_valid_utf8_avx2(p, length);
+  }
+#endif
+  return _str_is_valid_utf8_scalar(p, length);
+}
+
+size_t str_utf8_len(const Str * self) {
+  const char * p = str_as_ptr(self);
+  size_t length = str_len(self);
+
+#ifdef _STR_UTF8_X86
+  if(cpu_has_avx2()) {
+    return _str_utf8_len_avx2(p, length);
+  }
+#endif
+
+  size_t count = 0;
+  for(size_t i = 0; i < length; i++) {
+    count += ((unsigned char)p[i] & 0xC0) != 0x80;
+  }
+  return count;
+}
+
+bool str_chars_next(StrChars * self, uint32_t * code_point) {
+  const unsigned char * p = (const unsigned char *)str_as_ptr(&self->rest);
+  size_t length = str_len(&self->rest);
+
+  if(length == 0) {
+    return false;
+  }
+
+  size_t sequence = _str_utf8_sequence_len(p, length);
+  switch(sequence) {
+    case 1:
+      *code_point = p[0];
+    break;
+
+    case 2:
+      *code_point = ((uint32_t)(p[0] & 0x1F) << 6) | (p[1] & 0x3F);
+    break;
+
+    case 3:
+      *code_point = ((uint32_t)(p[0] & 0x0F) << 12) | ((uint32_t)(p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+    break;
+
+    case 4:
+      *code_point = ((uint32_t)(p[0] & 0x07) << 18) | ((uint32_t)(p[1] & 0x3F) << 12) | ((uint32_t)(p[2] & 0x3F) << 6) | (p[3] & 0x3F);
+    break;
+
+    default:
+      // Invalid byte is replaced by U+FFFD and skipped
+      *code_point = STR_REPLACEMENT_CHARACTER;
+      sequence = 1;
+  }
+
+  self->rest = str_from_raw_parts((const char *)p + sequence, length - sequence);
+  return true;
+}
+
+Option_string string_from_utf8_checked(const Str * str) {
+  if(!str_is_valid_utf8(str)) {
+    return option_string_none();
+  }
+  return option_string_some(string_from_str(str));
+}
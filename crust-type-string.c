@@ -13,29 +13,32 @@ void string_panic(int error_code, const char * value) {
   abort();
 }
 
-size_t string_printf(String * self, const char * fmt, ...) {
+size_t string_vprintf(String * self, const char * fmt, va_list ap) {
   _Vec * super = &self->super;
-  va_list ap;
 
-  // Determine required size
-  va_start(ap, fmt);
-  int size = vsnprintf(NULL, 0, fmt, ap);
-  va_end(ap);
+  // Print into spare capacity, including space for '\0', so format is parsed
+  // once when text fits, which is usual case
+  size_t room = super->capacity - super->count;
+  char * buf = room > 0 ? &((char*)super->data)[super->count] : NULL;
+
+  va_list copy;
+  va_copy(copy, ap);
+  int size = vsnprintf(buf, room, fmt, copy);
+  va_end(copy);
 
   if (size < 0) {
     string_panic(STRING_ERROR_BAD_FORMAT, fmt);
   }
 
-  // Allocate space, including space for '\0'
-  string_reserve(self, size+1);
+  // Text is truncated, so allocate space, including space for '\0', and print again
+  if ((size_t)size >= room) {
+    string_reserve(self, size+1);
 
-  // Print into buffer
-  va_start(ap, fmt);
-  size = vsnprintf(&((char*)super->data)[super->count], size+1, fmt, ap);
-  va_end(ap);
+    size = vsnprintf(&((char*)super->data)[super->count], size+1, fmt, ap);
 
-  if (size < 0) {
-    string_panic(STRING_ERROR_BAD_FORMAT, fmt);
+    if (size < 0) {
+      string_panic(STRING_ERROR_BAD_FORMAT, fmt);
+    }
   }
 
   super->count += size;
@@ -43,6 +46,31 @@ size_t string_printf(String * self, const char * fmt, ...) {
   return size; // '\0' is not counted
 }
 
+size_t string_printf(String * self, const char * fmt, ...) {
+  va_list ap;
+
+  va_start(ap, fmt);
+  size_t size = string_vprintf(self, fmt, ap);
+  va_end(ap);
+
+  return size;
+}
+
+size_t string_printf_reserve_hint(String * self, size_t hint, const char * fmt, ...) {
+  va_list ap;
+
+  // Reserve space for expected text and '\0', so text is printed in single pass
+  if(self->super.capacity - self->super.count < hint+1) {
+    _vec_reserve(&self->super, sizeof(char), hint+1);
+  }
+
+  va_start(ap, fmt);
+  size_t size = string_vprintf(self, fmt, ap);
+  va_end(ap);
+
+  return size;
+}
+
 size_t string_put_char(String * self, char value) {
   _Vec * super = &self->super;
 
@@ -68,7 +96,9 @@ size_t string_put_charp(String * self, const char * value) {
   size_t length = strlen(value);
 
   if(length > 0) {
-    _vec_reserve(super, sizeof(char), length+1);
+    if(super->capacity - super->count < length+1) {
+      _vec_reserve(super, sizeof(char), length+1);
+    }
 
     strncpy(&string_as_ptr(self)[super->count], value, length+1);
   }
@@ -76,6 +106,23 @@ size_t string_put_charp(String * self, const char * value) {
   return super->count += length; // '\0' is not counted
 }
 
+size_t string_put_str(String * self, const Str * value) {
+  _Vec * super = &self->super;
+  size_t length = str_len(value);
+
+  if(length > 0) {
+    if(super->capacity - super->count < length+1) {
+      _vec_reserve(super, sizeof(char), length+1);
+    }
+
+    char * data = string_as_ptr(self);
+    memcpy(&data[super->count], str_as_ptr(value), length);
+    data[super->count+length] = '\0';
+  }
+
+  return super->count += length; // '\0' is not counted
+}
+
 size_t string_end_with_zero(String * self) {
   _Vec * super = &self->super;
 
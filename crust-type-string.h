@@ -3,11 +3,15 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <string.h>
 #include "crust-mem.h"
+#include "crust-hash.h"
 
 #include "crust-type-vec.h"
 #include "crust-type-char.h"
+#include "crust-type-option.h"
+#include "crust-type-size_t.h"
 
 VEC_BY_VALUE_TEMPLATE(String, string, char)
 DEFINE_SLICE_BY_VALUE_TEMPLATE(Str, str, char, char)
@@ -32,15 +36,123 @@ static inline String string_from_str(const Str * str) {
 }
 
 
+/** Append formatted text and return its length. Text is printed into spare capacity
+ * first, so string is grown and text is printed again only when it doesn't fit. */
 __attribute__ ((format (printf, 2, 3)))
 size_t string_printf(String * self, const char * fmt, ...);
 
+/** Same as string_printf(), but with va_list. */
+__attribute__ ((format (printf, 2, 0)))
+size_t string_vprintf(String * self, const char * fmt, va_list ap);
+
+/** Same as string_printf(), but reserves space for hint bytes of text first,
+ * so text up to that length is printed in single pass. */
+__attribute__ ((format (printf, 3, 4)))
+size_t string_printf_reserve_hint(String * self, size_t hint, const char * fmt, ...);
+
 size_t string_put_char(String * self, char value);
 size_t string_end_with_zero(String * self);
 size_t string_put_charp(String * self, const char * value);
 size_t string_put_str(String * self, const Str * value);
 
+/** Append decimal signed integer and return new length of string. */
+size_t string_put_int(String * self, int64_t value);
+
+/** Append decimal unsigned integer and return new length of string. */
+size_t string_put_u64(String * self, uint64_t value);
+
+/** Append lowercase hexadecimal integer, without prefix, and return new length of string. */
+size_t string_put_hex(String * self, uint64_t value);
+
+/** Append shortest decimal representation of double, which is parsed back into
+ * same double, and return new length of string. Large and small numbers are
+ * printed in scientific notation, e.g. 1e30. */
+size_t string_put_double(String * self, double value);
+
 static inline Str str_from_charp(const char * charp) { return (Str) { .super = _slice_from_raw_parts( charp, strlen(charp) ) }; }
 static inline Str str_from_string(const String *string) { return (Str) { .super = _slice_from_raw_parts( string_as_ptr(string), string_len(string) ) }; }
 
+/** Compare strings byte by byte. Shorter string is less, when it is prefix of longer one. */
+static inline int str_cmp(const Str * left, const Str * right) {
+  size_t left_len = str_len(left), right_len = str_len(right);
+  size_t len = left_len < right_len ? left_len : right_len;
+  int result = len == 0 ? 0 : memcmp(str_as_ptr(left), str_as_ptr(right), len);
+  return result != 0 ? result : (left_len > right_len) - (left_len < right_len);
+}
+
+/** Return position of first occurrence of needle in string. Empty needle is found at 0. */
+NN WUR Option_sizet str_find(const Str * self, const Str * needle);
+
+/** Return position of last occurrence of needle in string. Empty needle is found at end. */
+NN WUR Option_sizet str_rfind(const Str * self, const Str * needle);
+
+/** Return position of first occurrence of char in string. */
+NN WUR Option_sizet str_find_char(const Str * self, char c);
+
+/** Return position of first char of string, which is one of given chars. */
+NN WUR Option_sizet str_find_any_of(const Str * self, const Str * chars);
+
+/** Return number of non-overlapping occurrences of needle in string. */
+NN WUR size_t str_count(const Str * self, const Str * needle);
+
+/** Iterator over parts of string between separators. Parts point into original string. */
+typedef struct {
+  Str rest;
+  Str separator;
+  bool finished;
+} StrSplit;
+
+/** Split string by separator, e.g. "a,b,,c" into "a", "b", "", "c". Empty
+ * separator doesn't split string. */
+NN WUR StrSplit str_split(const Str * self, const Str * separator);
+
+/** Store next part into item and return true, or return false when string is over. */
+NN WUR bool str_split_next(StrSplit * self, Str * item);
+
+DEFINE_OPTION_BY_VALUE(Option_i64, option_i64, int64_t)
+DEFINE_OPTION_BY_VALUE(Option_u64, option_u64, uint64_t)
+DEFINE_OPTION_BY_VALUE(Option_f64, option_f64, double)
+
+/** Parse whole Str as decimal signed integer with optional sign. Return None
+ * when text is not a number or number doesn't fit. */
+NN WUR Option_i64 str_parse_i64(const Str * str);
+
+/** Parse whole Str as decimal unsigned integer with optional '+'. Return None
+ * when text is not a number or number doesn't fit. */
+NN WUR Option_u64 str_parse_u64(const Str * str);
+
+/** Parse whole Str as double, e.g. "-1.5e-3", ".5", "inf" or "nan", into
+ * nearest double. Return None when text is not a number. */
+NN WUR Option_f64 str_parse_f64(const Str * str);
+
+/** Return true when string is valid UTF-8. */
+NN WUR bool str_is_valid_utf8(const Str * self);
+
+/** Return number of code points in valid UTF-8 string. */
+NN WUR size_t str_utf8_len(const Str * self);
+
+/** Code point, which replaces invalid bytes of UTF-8. */
+#define STR_REPLACEMENT_CHARACTER 0xFFFD
+
+/** Iterator over code points of UTF-8 string. */
+typedef struct {
+  Str rest;
+} StrChars;
+
+/** Iterate over code points of UTF-8 string. Every invalid byte is returned as U+FFFD. */
+NN WUR MU SI StrChars str_chars(const Str * self) {
+  return (StrChars) { .rest = *self };
+}
+
+/** Store next code point and return true, or return false when string is over. */
+NN WUR bool str_chars_next(StrChars * self, uint32_t * code_point);
+
+DEFINE_OPTION_BY_VALUE(Option_string, option_string, String)
+
+/** Return copy of text as String, or None when text is not valid UTF-8. */
+NN WUR Option_string string_from_utf8_checked(const Str * str);
+
+static inline size_t str_hash(const Str * str) { return (size_t)hash_bytes(str_as_ptr(str), str_len(str)); }
+static inline size_t string_hash(const String * string) { return (size_t)hash_bytes(string_as_ptr(string), string_len(string)); }
+
 #endif
@@ -35,6 +35,113 @@ void _vec_panic(int error_code, size_t value) {
   abort();
 }
 
+#ifdef CRUST_VEC_TELEMETRY
+#include <pthread.h>
+
+/* Registry of telemetry records, one per name of type. Records are never freed. */
+static VecTelemetry * vec_telemetry_head = NULL;
+static pthread_mutex_t vec_telemetry_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Return record with given name or NULL. Must be called with lock held. */
+static VecTelemetry * vec_telemetry_find(const char * name) {
+  for(VecTelemetry * t = vec_telemetry_head; t != NULL; t = t->next) {
+    if(strcmp(t->name, name) == 0) {
+      return t;
+    }
+  }
+  return NULL;
+}
+
+static void vec_telemetry_dump_at_exit(void) {
+  vec_telemetry_dump(stderr);
+}
+
+VecTelemetry * _vec_telemetry_record(const char * name, size_t element_size) {
+  pthread_mutex_lock(&vec_telemetry_lock);
+  VecTelemetry * telemetry = vec_telemetry_find(name);
+  if(!telemetry) {
+    // Table is printed once, when program exits, so it covers whole run
+    if(!vec_telemetry_head) {
+      atexit(vec_telemetry_dump_at_exit);
+    }
+    telemetry = mem_calloc(1, sizeof(VecTelemetry));
+    telemetry->name = name;
+    telemetry->element_size = element_size;
+    telemetry->next = vec_telemetry_head;
+    vec_telemetry_head = telemetry;
+  }
+  pthread_mutex_unlock(&vec_telemetry_lock);
+
+  return telemetry;
+}
+
+/* Counters are updated with relaxed atomics: they are statistics, not synchronization. */
+#define _VEC_TELEMETRY_ADD(FIELD, VALUE) __atomic_fetch_add(&(FIELD), (VALUE), __ATOMIC_RELAXED)
+#define _VEC_TELEMETRY_SUB(FIELD, VALUE) __atomic_fetch_sub(&(FIELD), (VALUE), __ATOMIC_RELAXED)
+
+static void vec_telemetry_add_capacity(VecTelemetry * telemetry, size_t bytes) {
+  size_t total = _VEC_TELEMETRY_ADD(telemetry->capacity_bytes, bytes) + bytes;
+  size_t peak = __atomic_load_n(&telemetry->peak_capacity_bytes, __ATOMIC_RELAXED);
+  while(total > peak && !__atomic_compare_exchange_n(&telemetry->peak_capacity_bytes, &peak, total, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    // peak is reloaded by failed exchange
+  }
+}
+
+_Vec _vec_telemetry_attach(_Vec vec, VecTelemetry * telemetry) {
+  vec.telemetry = telemetry;
+  _VEC_TELEMETRY_ADD(telemetry->vectors, 1);
+  _VEC_TELEMETRY_ADD(telemetry->live, 1);
+  vec_telemetry_add_capacity(telemetry, vec.capacity * telemetry->element_size);
+  return vec;
+}
+
+bool vec_telemetry_get(const char * name, VecTelemetry * out) {
+  pthread_mutex_lock(&vec_telemetry_lock);
+  VecTelemetry * t = vec_telemetry_find(name);
+  pthread_mutex_unlock(&vec_telemetry_lock);
+
+  if(!t) {
+    return false;
+  }
+
+  *out = (VecTelemetry) {
+    .name = t->name,
+    .element_size = t->element_size,
+    .vectors = __atomic_load_n(&t->vectors, __ATOMIC_RELAXED),
+    .live = __atomic_load_n(&t->live, __ATOMIC_RELAXED),
+    .reallocs = __atomic_load_n(&t->reallocs, __ATOMIC_RELAXED),
+    .bytes_moved = __atomic_load_n(&t->bytes_moved, __ATOMIC_RELAXED),
+    .shrinks = __atomic_load_n(&t->shrinks, __ATOMIC_RELAXED),
+    .capacity_bytes = __atomic_load_n(&t->capacity_bytes, __ATOMIC_RELAXED),
+    .peak_capacity_bytes = __atomic_load_n(&t->peak_capacity_bytes, __ATOMIC_RELAXED),
+    .destroyed_capacity_bytes = __atomic_load_n(&t->destroyed_capacity_bytes, __ATOMIC_RELAXED),
+    .destroyed_length_bytes = __atomic_load_n(&t->destroyed_length_bytes, __ATOMIC_RELAXED),
+  };
+  return true;
+}
+
+void vec_telemetry_dump(FILE * out) {
+  fprintf(out, "%-24s %10s %8s %10s %12s %8s %14s %14s %8s\n",
+    "type", "vectors", "live", "reallocs", "moved", "shrinks", "capacity", "peak", "slack%");
+
+  pthread_mutex_lock(&vec_telemetry_lock);
+  VecTelemetry * head = vec_telemetry_head;
+  pthread_mutex_unlock(&vec_telemetry_lock);
+
+  for(VecTelemetry * t = head; t != NULL; t = t->next) {
+    VecTelemetry sum;
+    if(!vec_telemetry_get(t->name, &sum)) {
+      continue;
+    }
+    size_t slack = sum.destroyed_capacity_bytes == 0 ? 0
+      : (sum.destroyed_capacity_bytes - sum.destroyed_length_bytes) * 100 / sum.destroyed_capacity_bytes;
+    fprintf(out, "%-24s %10zu %8zu %10zu %12zu %8zu %14zu %14zu %7zu%%\n",
+      sum.name, sum.vectors, sum.live, sum.reallocs, sum.bytes_moved, sum.shrinks,
+      sum.capacity_bytes, sum.peak_capacity_bytes, slack);
+  }
+}
+#endif
+
 _Vec _vec_with_capacity(size_t element_size, size_t capacity) {
   _Vec self = { .count = 0, .capacity = capacity, .data = mem_calloc(capacity, element_size) };
 
@@ -82,6 +189,17 @@ void _vec_reserve_exact(_Vec * self, size_t element_size, size_t additional_capa
   }
 
   if(new_capacity > self->capacity) {
+#ifdef CRUST_VEC_TELEMETRY
+    if(self->telemetry) {
+      if(self->data == NULL) {
+        // Vector is used again after destroy
+        _VEC_TELEMETRY_ADD(self->telemetry->live, 1);
+      }
+      _VEC_TELEMETRY_ADD(self->telemetry->reallocs, 1);
+      _VEC_TELEMETRY_ADD(self->telemetry->bytes_moved, self->count * element_size);
+      vec_telemetry_add_capacity(self->telemetry, (new_capacity - self->capacity) * element_size);
+    }
+#endif
     self->data = mem_realloc(self->data, new_capacity, element_size);
     self->capacity = new_capacity;
   }
@@ -104,13 +222,47 @@ void _vec_reserve(_Vec * self, size_t element_size, size_t additional_capacity)
 void _vec_shrink_to_fit(_Vec * self, size_t element_size) {
   size_t new_capacity = self->count;
 
+#ifdef CRUST_VEC_TELEMETRY
+  if(self->telemetry && self->capacity > new_capacity) {
+    _VEC_TELEMETRY_ADD(self->telemetry->shrinks, 1);
+    _VEC_TELEMETRY_SUB(self->telemetry->capacity_bytes, (self->capacity - new_capacity) * element_size);
+  }
+#endif
+
   self->data = mem_realloc(self->data, new_capacity, element_size);
   self->capacity = new_capacity;
 }
 
+#ifdef CRUST_VEC_TELEMETRY
+/* Account vector, which releases its data. */
+static void vec_telemetry_release(_Vec * self) {
+  VecTelemetry * telemetry = self->telemetry;
+  if(telemetry && self->data) {
+    _VEC_TELEMETRY_SUB(telemetry->live, 1);
+    _VEC_TELEMETRY_SUB(telemetry->capacity_bytes, self->capacity * telemetry->element_size);
+    _VEC_TELEMETRY_ADD(telemetry->destroyed_capacity_bytes, self->capacity * telemetry->element_size);
+    _VEC_TELEMETRY_ADD(telemetry->destroyed_length_bytes, self->count * telemetry->element_size);
+  }
+}
+#endif
+
+void * _vec_take_data(_Vec * self) {
+#ifdef CRUST_VEC_TELEMETRY
+  vec_telemetry_release(self);
+#endif
+  void * data = self->data;
+  self->data = NULL;
+  self->count = 0;
+  self->capacity = 0;
+  return data;
+}
+
 void _vec_destroy(_Vec * self) {
+#ifdef CRUST_VEC_TELEMETRY
+  vec_telemetry_release(self);
+#endif
   if(self->data) {
-    free(self->data);
+    mem_free(self->data);
     self->data = NULL;
     self->count = 0;
     self->capacity = 0;
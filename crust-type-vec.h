@@ -39,12 +39,73 @@ it(_vec_panic, "must abort program using abort()") {
 #endif
 
 
+#ifdef CRUST_VEC_TELEMETRY
+#include <stdio.h>
+#include <stdbool.h>
+
+/**
+ * Counters of vectors of one type. Telemetry is compiled in with
+ * -DCRUST_VEC_TELEMETRY only.
+ *
+ * Registry has one record per name of type, which is shared by template
+ * instantiations of all translation units. Constructors of template attach
+ * record to vector, so _vec_reserve(),
+ * _vec_shrink_to_fit() and _vec_destroy() can update counters of type.
+ * Vectors, which are created with _vec_*() functions directly, are not
+ * counted. Sizes are in bytes. Table of counters is printed to stderr at
+ * exit of program.
+ */
+typedef struct VecTelemetry_s {
+  const char * name;
+  size_t element_size;
+  /** Number of created vectors. */
+  size_t vectors;
+  /** Number of vectors, which are not destroyed yet. */
+  size_t live;
+  /** Number of reallocations on growth. */
+  size_t reallocs;
+  /** Bytes of elements, which are copied (or remapped) by reallocations. */
+  size_t bytes_moved;
+  size_t shrinks;
+  /** Sum of capacities of live vectors. */
+  size_t capacity_bytes;
+  size_t peak_capacity_bytes;
+  /** Capacities and lengths of vectors at destroy, for average slack. */
+  size_t destroyed_capacity_bytes;
+  size_t destroyed_length_bytes;
+
+  // Registry of records
+  struct VecTelemetry_s * next;
+} VecTelemetry;
+#endif
+
 typedef struct _Vec_s {
   void * data;
   size_t count;
   size_t capacity;
+#ifdef CRUST_VEC_TELEMETRY
+  /** Counters of type of vector, or NULL. */
+  VecTelemetry * telemetry;
+#endif
 } _Vec;
 
+#ifdef CRUST_VEC_TELEMETRY
+/** Return registry record of type with given name. Record is created at first
+ * call and is never freed. Name must be static string. */
+NN WUR VecTelemetry * _vec_telemetry_record(const char * name, size_t element_size);
+
+/** Attach counters of type to new vector and return vector. */
+WUR struct _Vec_s _vec_telemetry_attach(struct _Vec_s vec, VecTelemetry * telemetry);
+
+/** Copy counters of type with given name into out. Return false, when type
+ * is not registered. */
+NN WUR bool vec_telemetry_get(const char * name, VecTelemetry * out);
+
+/** Print table of counters for every type of vector. Called at exit of
+ * program with stderr. */
+NN void vec_telemetry_dump(FILE * out);
+#endif
+
 /** Free data pointer and clear pointer, length, and capacity.
  * It's safe to call destroy() twice.
  * It's safe to use vector again after destroy. */
@@ -103,6 +164,21 @@ it(_vec_new, "must create new empty vector with non-zero capacity") {
 }
 #endif
 
+/** Return pointer to data and leave vector empty, without freeing data.
+ * Caller becomes owner of data and must mem_free() it. */
+NN WUR void * _vec_take_data(_Vec * self);
+#ifdef _CRUST_TESTS
+it(_vec_take_data, "must return data and leave vector empty") {
+  defer(_vec_destroy) _Vec vec = _vec_with_capacity(sizeof(int), 4);
+  void * data = vec.data;
+  void * taken = _vec_take_data(&vec);
+  assert_true(taken == data, "must return data of vector");
+  assert_true(vec.data == NULL, "must clear data pointer");
+  assert_equal_int(0, vec.capacity, "must clear capacity");
+  mem_free(taken);
+}
+#endif
+
 /** Reallocate and resize array, if necessary, to hold additional capacity.
  * Capacity will be equal to or greater than length+additional_capacity. */
 NN void _vec_reserve_exact(_Vec * self, size_t element_size, size_t additional_capacity);
@@ -174,18 +250,37 @@ typedef struct { \
 
 // Common functions
 
+#ifdef CRUST_VEC_TELEMETRY
+#define DEFINE_VEC_TELEMETRY(SELFNAME, SELFPREFIX, CTYPE) \
+/** Return counters of this type of vector. Record is looked up in registry \
+ * once per translation unit. */ \
+MU SI VecTelemetry * SELFPREFIX##_telemetry() { \
+  static VecTelemetry * telemetry = NULL; \
+  VecTelemetry * record = __atomic_load_n(&telemetry, __ATOMIC_ACQUIRE); \
+  if(!record) { \
+    record = _vec_telemetry_record(#SELFNAME, sizeof(CTYPE)); \
+    __atomic_store_n(&telemetry, record, __ATOMIC_RELEASE); \
+  } \
+  return record; \
+}
+#define _VEC_TELEMETRY_ATTACH(SELFPREFIX, VEC) _vec_telemetry_attach((VEC), SELFPREFIX##_telemetry())
+#else
+#define DEFINE_VEC_TELEMETRY(SELFNAME, SELFPREFIX, CTYPE)
+#define _VEC_TELEMETRY_ATTACH(SELFPREFIX, VEC) (VEC)
+#endif
+
 #define DEFINE_VEC_WITH_CAPACITY(SELFNAME, SELFPREFIX, CTYPE) \
-WUR MU SI SELFNAME SELFPREFIX##_with_capacity(size_t capacity) { return (SELFNAME) { .super = _vec_with_capacity(sizeof(CTYPE), capacity) }; }
+WUR MU SI SELFNAME SELFPREFIX##_with_capacity(size_t capacity) { return (SELFNAME) { .super = _VEC_TELEMETRY_ATTACH(SELFPREFIX, _vec_with_capacity(sizeof(CTYPE), capacity)) }; }
 #ifdef _CRUST_TESTS
 #endif
 
 #define DEFINE_VEC_NEW(SELFNAME, SELFPREFIX, CTYPE) \
-WUR MU SI SELFNAME SELFPREFIX##_new() { return (SELFNAME) { .super = _vec_new(sizeof(CTYPE)) }; }
+WUR MU SI SELFNAME SELFPREFIX##_new() { return (SELFNAME) { .super = _VEC_TELEMETRY_ATTACH(SELFPREFIX, _vec_new(sizeof(CTYPE))) }; }
 #ifdef _CRUST_TESTS
 #endif
 
 #define DEFINE_VEC_FROM_RAW_PARTS_UNSAFE(SELFNAME, SELFPREFIX, CTYPE) \
-WUR MU SI SELFNAME SELFPREFIX##_from_raw_parts_unsafe(CTYPE * data, size_t length, size_t capacity) { return (SELFNAME) { .super = _vec_from_raw_parts_unsafe(data, length, capacity) }; }
+WUR MU SI SELFNAME SELFPREFIX##_from_raw_parts_unsafe(CTYPE * data, size_t length, size_t capacity) { return (SELFNAME) { .super = _VEC_TELEMETRY_ATTACH(SELFPREFIX, _vec_from_raw_parts_unsafe(data, length, capacity)) }; }
 #ifdef _CRUST_TESTS
 #endif
 
@@ -283,6 +378,7 @@ NN MU SI void SELFPREFIX##_set_len_unsafe(SELFNAME * self, size_t length) { \
 
 #define _VEC_COMMON(SELFNAME, SELFPREFIX, CTYPE) \
 DEFINE_VEC_STRUCT(SELFNAME) \
+DEFINE_VEC_TELEMETRY(SELFNAME, SELFPREFIX, CTYPE) \
 DEFINE_VEC_WITH_CAPACITY(SELFNAME, SELFPREFIX, CTYPE) \
 DEFINE_VEC_NEW(SELFNAME, SELFPREFIX, CTYPE) \
 DEFINE_VEC_FROM_RAW_PARTS_UNSAFE(SELFNAME, SELFPREFIX, CTYPE) \
@@ -317,7 +413,7 @@ NN MU SI size_t SELFPREFIX##_push(SELFNAME * self, const CTYPE value) { \
 #endif
 
 #define DEFINE_VEC_FROM_DATAP_BY_VALUE(SELFNAME, SELFPREFIX, CTYPE) \
-WUR MU SI SELFNAME SELFPREFIX##_from_datap(const CTYPE * data, size_t length, size_t capacity) { return (SELFNAME) { .super = _vec_from_datap(sizeof(CTYPE), data, length, capacity) }; }
+WUR MU SI SELFNAME SELFPREFIX##_from_datap(const CTYPE * data, size_t length, size_t capacity) { return (SELFNAME) { .super = _VEC_TELEMETRY_ATTACH(SELFPREFIX, _vec_from_datap(sizeof(CTYPE), data, length, capacity)) }; }
 #ifdef _CRUST_TESTS
 #endif
 
@@ -384,7 +480,7 @@ MU SI size_t SELFPREFIX##_push(SELFNAME * self, const CTYPE value) { \
 
 #define DEFINE_VEC_FROM_DATAP_BY_REFERENCE(SELFNAME, SELFPREFIX, CTYPE, TYPEPREFIX) \
 WUR MU SI SELFNAME SELFPREFIX##_from_datap(const CTYPE * data, size_t length, size_t capacity) { \
-  SELFNAME self={ .super = _vec_with_capacity(sizeof(CTYPE), capacity) }; \
+  SELFNAME self={ .super = _VEC_TELEMETRY_ATTACH(SELFPREFIX, _vec_with_capacity(sizeof(CTYPE), capacity)) }; \
   for(size_t i=0; i<length; i++) { \
     SELFPREFIX##_push(&self, data[i]); \
   } \
@@ -394,7 +490,7 @@ WUR MU SI SELFNAME SELFPREFIX##_from_datap(const CTYPE * data, size_t length, si
 #endif
 
 #define DEFINE_VEC_DATAP_SHALLOW_BY_REFERENCE(SELFNAME, SELFPREFIX, CTYPE, TYPEPREFIX) \
-WUR MU SI SELFNAME SELFPREFIX##_from_datap_shallow(const CTYPE * data, size_t length, size_t capacity) { return (SELFNAME) { .super = _vec_from_datap(sizeof(CTYPE), data, length, capacity) }; }
+WUR MU SI SELFNAME SELFPREFIX##_from_datap_shallow(const CTYPE * data, size_t length, size_t capacity) { return (SELFNAME) { .super = _VEC_TELEMETRY_ATTACH(SELFPREFIX, _vec_from_datap(sizeof(CTYPE), data, length, capacity)) }; }
 #ifdef _CRUST_TESTS
 #endif
 
@@ -0,0 +1,94 @@
+#include "crust-type-vec.h"
+#include "crust-type-slice.h"
+#include "crust-type-array.h"
+#include "crust-type-int.h"
+
+#include "crust-bench.h"
+
+VEC_BY_VALUE_TEMPLATE(Vec_int, vec_int, int)
+DEFINE_SLICE_BY_VALUE_TEMPLATE(Slice_int, slice_int, int, int)
+VEC_TO_SLICE(Vec_int, vec_int, int, Slice_int, slice_int)
+
+#define VEC_BENCH_LENGTH 1000
+
+bench(vec_int_push, "push 1000 ints into new vector") {
+  for(size_t i = 0; i < b->iterations; i++) {
+    defer(vec_int_destroy) Vec_int vec = vec_int_new();
+    for(int j = 0; j < VEC_BENCH_LENGTH; j++) {
+      vec_int_push(&vec, j);
+    }
+    bench_do_not_optimize(vec_int_as_ptr(&vec));
+  }
+}
+
+bench(vec_int_push_reserved, "push 1000 ints into vector with capacity for 1000 ints") {
+  for(size_t i = 0; i < b->iterations; i++) {
+    defer(vec_int_destroy) Vec_int vec = vec_int_with_capacity(VEC_BENCH_LENGTH);
+    for(int j = 0; j < VEC_BENCH_LENGTH; j++) {
+      vec_int_push(&vec, j);
+    }
+    bench_do_not_optimize(vec_int_as_ptr(&vec));
+  }
+}
+
+bench(vec_int_get, "read 1000 ints by index with bounds checking") {
+  defer(vec_int_destroy) Vec_int vec = vec_int_with_capacity(VEC_BENCH_LENGTH);
+  for(int j = 0; j < VEC_BENCH_LENGTH; j++) {
+    vec_int_push(&vec, j);
+  }
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    long sum = 0;
+    for(size_t j = 0; j < VEC_BENCH_LENGTH; j++) {
+      sum += vec_int_get(&vec, j);
+    }
+    bench_do_not_optimize(&sum);
+  }
+}
+
+bench(slice_int_contains, "search for missing int in slice of 1000 ints") {
+  defer(vec_int_destroy) Vec_int vec = vec_int_with_capacity(VEC_BENCH_LENGTH);
+  for(int j = 0; j < VEC_BENCH_LENGTH; j++) {
+    vec_int_push(&vec, j);
+  }
+  Slice_int slice = vec_int_as_slice(&vec);
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    bench_clobber();
+    bool found = slice_int_contains(&slice, -1);
+    bench_do_not_optimize(&found);
+  }
+}
+
+bench(slice_int_eq, "compare two equal slices of 1000 ints") {
+  defer(vec_int_destroy) Vec_int left = vec_int_with_capacity(VEC_BENCH_LENGTH);
+  defer(vec_int_destroy) Vec_int right = vec_int_with_capacity(VEC_BENCH_LENGTH);
+  for(int j = 0; j < VEC_BENCH_LENGTH; j++) {
+    vec_int_push(&left, j);
+    vec_int_push(&right, j);
+  }
+  Slice_int left_slice = vec_int_as_slice(&left), right_slice = vec_int_as_slice(&right);
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    bench_clobber();
+    bool equal = slice_int_eq(&left_slice, &right_slice);
+    bench_do_not_optimize(&equal);
+  }
+}
+
+bench(slice_int_reverse, "reverse slice of 1000 ints in place") {
+  defer(vec_int_destroy) Vec_int vec = vec_int_with_capacity(VEC_BENCH_LENGTH);
+  for(int j = 0; j < VEC_BENCH_LENGTH; j++) {
+    vec_int_push(&vec, j);
+  }
+  Slice_int slice = vec_int_as_slice(&vec);
+  bench_reset_timer(b);
+
+  for(size_t i = 0; i < b->iterations; i++) {
+    slice_int_reverse(&slice);
+    bench_do_not_optimize(slice_int_as_ptr(&slice));
+  }
+}
@@ -410,3 +410,34 @@ it(slice_int_debug, "must return String builder with content of slice") {
 
   assert_equal_charp("Slice_int={1, 2, 3, 4, 5, }", string_as_ptr(&str), "slice_int_debug() must return content of slice");
 }
+
+#ifdef CRUST_VEC_TELEMETRY
+VEC_BY_VALUE_TEMPLATE(Vec_telemetry_long, vec_telemetry_long, long)
+
+it(vec_telemetry, "must count reallocations, capacity, and slack per type of vector") {
+  Vec_telemetry_long vec = vec_telemetry_long_with_capacity(2);
+  for(long i=0; i<11; i++) {
+    vec_telemetry_long_push(&vec, i);
+  }
+
+  // Instantiations of same type in all translation units share registry record
+  assert_true(vec.super.telemetry == _vec_telemetry_record("Vec_telemetry_long", sizeof(long)), "Vector must use registry record of its type");
+
+  VecTelemetry telemetry;
+  assert_true(vec_telemetry_get("Vec_telemetry_long", &telemetry), "Type of vector must be registered");
+  assert_equal_int(1, telemetry.vectors, "Unexpected number of vectors");
+  assert_equal_int(1, telemetry.live, "Unexpected number of live vectors");
+  assert_true(telemetry.reallocs > 0, "Growth must be counted");
+  assert_equal_int(vec_telemetry_long_capacity(&vec) * sizeof(long), telemetry.capacity_bytes, "Unexpected capacity");
+
+  vec_telemetry_long_shrink_to_fit(&vec);
+  vec_telemetry_long_destroy(&vec);
+  assert_true(vec_telemetry_get("Vec_telemetry_long", &telemetry), "Type of vector must be registered");
+  assert_equal_int(0, telemetry.live, "Destroyed vector must not be live");
+  assert_equal_int(0, telemetry.capacity_bytes, "Capacity of destroyed vector must be released");
+  assert_equal_int(1, telemetry.shrinks, "Shrink must be counted");
+  assert_equal_int(11 * sizeof(long), telemetry.destroyed_length_bytes, "Unexpected length at destroy");
+  assert_true(telemetry.peak_capacity_bytes > 11 * sizeof(long), "Unexpected peak capacity");
+  assert_true(!vec_telemetry_get("Unknown", &telemetry), "Unknown type must not be found");
+}
+#endif
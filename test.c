@@ -11,9 +11,27 @@
 #include "crust-type-ccharp.h"
 #include "crust-type-string.h"
 #include "crust-mem.h"
+#include "crust-hash.h"
 #include "crust-type-option.h"
 #include "crust-type-slice.h"
 #include "crust-type-vec.h"
+#include "crust-type-channel.h"
+#include "crust-type-cvec.h"
+#include "crust-type-segvec.h"
+#include "crust-type-bitvec.h"
+#include "crust-type-hashmap.h"
+#include "crust-type-btreemap.h"
+#include "crust-type-interner.h"
+#include "crust-type-rope.h"
+#include "crust-type-linereader.h"
+#include "crust-type-bufwriter.h"
+#include "crust-type-aio.h"
+#include "crust-type-cowvec.h"
+#include "crust-type-bytes.h"
+#include "crust-iter.h"
+#include "crust-type-heap.h"
+#include "crust-type-slotmap.h"
+#include "crust-bench.h"
 
 
 int main(void) {